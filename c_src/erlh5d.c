@@ -46,36 +46,6 @@
 static herr_t convert_space_status( H5D_space_status_t,  char* ) ;
 
 
-
-// Describes data, typically to be written in a dataset.
-struct DataDescriptor
-{
-
-  // Number of dimensions of the data:
-  unsigned int dimension_count ;
-
-  // Type of an atomic element in the data:
-  cell_type type ;
-
-  // List length (number of tuples):
-  unsigned int len ;
-
-  // Size of each tuple:
-  int size ;
-
-  // Not allowed in C: ERL_NIF_TERM * error_term = NULL ;
-  ERL_NIF_TERM error_term ;
-
-} ;
-
-
-// Forward declarations:
-bool detect_type( ERL_NIF_TERM data_list, ErlNifEnv* env,
-  struct DataDescriptor * detected_desc ) ;
-
-cell_type detect_cell_type( ERL_NIF_TERM term, ErlNifEnv* env ) ;
-
-
 // Converts space status into a string.
 static herr_t convert_space_status( H5D_space_status_t space_status,
   char* space_status_str )
@@ -98,52 +68,151 @@ static herr_t convert_space_status( H5D_space_status_t space_status,
 
 
 
+/*
+ * Returns the dataset creation property list to be used in order to create a
+ * dataset of specified type in specified dataspace: either the specified one,
+ * or, if the dataspace is extendible or filters (ex: compression) were set,
+ * yet no chunking was requested (whereas HDF5 requires it then), a chunked
+ * copy of it, which is then to be closed by the caller.
+ *
+ * Default chunks span all the non-first dimensions, and about
+ * DEFAULT_CHUNK_BYTES along the first one.
+ *
+ * Returns a negative value on failure.
+ *
+ */
+static hid_t prepare_creation_proplist( hid_t dcpl_id, hid_t type_id,
+  hid_t dataspace_id )
+{
+
+  int rank = H5Sget_simple_extent_ndims( dataspace_id ) ;
+
+  if ( rank <= 0 )
+	return dcpl_id ;
+
+  if ( H5Pget_layout( dcpl_id ) == H5D_CHUNKED )
+	return dcpl_id ;
+
+  hsize_t dims[ H5S_MAX_RANK ] ;
+  hsize_t maxdims[ H5S_MAX_RANK ] ;
+
+  if ( H5Sget_simple_extent_dims( dataspace_id, dims, maxdims ) < 0 )
+	return -1 ;
+
+  bool extendible = false ;
+
+  int i ;
+
+  for ( i = 0; i < rank; i++ )
+  {
+
+	if ( maxdims[i] != dims[i] )
+	  extendible = true ;
+
+  }
+
+  if ( ! extendible && H5Pget_nfilters( dcpl_id ) <= 0 )
+	return dcpl_id ;
+
+  hsize_t chunk_dims[ H5S_MAX_RANK ] ;
+
+  // Number of cells in a slice along the first dimension:
+  hsize_t row_cells = 1 ;
+
+  for ( i = 1; i < rank; i++ )
+  {
+
+	chunk_dims[i] = ( dims[i] > 0 ) ? dims[i] : 1 ;
+	row_cells *= chunk_dims[i] ;
+
+  }
+
+  size_t cell_size = H5Tget_size( type_id ) ;
+
+  if ( cell_size == 0 )
+	return -1 ;
+
+  chunk_dims[0] = DEFAULT_CHUNK_BYTES / ( row_cells * cell_size ) ;
+
+  if ( chunk_dims[0] == 0 )
+	chunk_dims[0] = 1 ;
+
+  // Chunks may not exceed fixed maximum dimensions:
+  for ( i = 0; i < rank; i++ )
+  {
+
+	if ( maxdims[i] != H5S_UNLIMITED && chunk_dims[i] > maxdims[i]
+	  && maxdims[i] > 0 )
+	  chunk_dims[i] = maxdims[i] ;
+
+  }
+
+  hid_t chunked_dcpl_id = H5Pcopy( dcpl_id ) ;
+
+  if ( chunked_dcpl_id < 0 )
+	return -1 ;
+
+  if ( H5Pset_chunk( chunked_dcpl_id, rank, chunk_dims ) < 0 )
+  {
+	H5Pclose( chunked_dcpl_id ) ;
+	return -1 ;
+  }
+
+  return chunked_dcpl_id ;
+
+}
+
+
+
 // Creates a new simple dataset, and opens it for access.
 ERL_NIF_TERM h5dcreate( ErlNifEnv* env, int argc, const ERL_NIF_TERM argv[] )
 {
 
-  ERL_NIF_TERM ret;
-  Handle* dcpl_res;
   char ds_name[ MAXBUFLEN ];
   hid_t file_id;
   hid_t type_id;
   hid_t dataspace_id;
-  hid_t ds_id;
+  hid_t ds_id = -1;
+  hid_t user_dcpl_id;
   hid_t dcpl_id;
 
   // Parses arguments:
   check( argc == 5, "Incorrect number of arguments");
 
-  check( enif_get_int( env, argv[0], &file_id ),
+  check( get_handle_id( env, argv[0], FILE_HANDLE, &file_id ),
 	"Cannot get file resource from argv" ) ;
 
   check( enif_get_string( env, argv[1], ds_name, sizeof(ds_name),
 	  ERL_NIF_LATIN1), "Cannot get dataset name from argv" ) ;
 
-  check( enif_get_int( env, argv[2], &type_id ),
+  check( get_handle_id( env, argv[2], DATATYPE_HANDLE, &type_id ),
 	"Cannot get datatype resource from argv" ) ;
 
-  check( enif_get_int( env, argv[3], &dataspace_id ),
+  check( get_handle_id( env, argv[3], DATASPACE_HANDLE, &dataspace_id ),
 	"Cannot get dataspace resource from argv" ) ;
 
-  check( enif_get_resource( env, argv[4], resource_type, (void**) &dcpl_res ),
+  check( ! get_proplist( env, argv[4], H5P_DATASET_CREATE, &user_dcpl_id ),
 	"Cannot get properties resource from argv" ) ;
 
-  dcpl_id = dcpl_res->id ;
+  dcpl_id = prepare_creation_proplist( user_dcpl_id, type_id,
+	dataspace_id ) ;
+
+  check( dcpl_id >= 0, "Failed to prepare dataset creation properties." ) ;
 
   // Creates a new file, using default properties:
   ds_id = H5Dcreate( file_id, ds_name, type_id, dataspace_id,
 	/* Link creation property list */ H5P_DEFAULT, dcpl_id,
 	/* Dataset access property list */ H5P_DEFAULT ) ;
 
-  check( ds_id > 0, "Failed to create dataset." ) ;
+  if ( dcpl_id != user_dcpl_id )
+	H5Pclose( dcpl_id ) ;
 
-  ret = enif_make_int( env, ds_id ) ;
+  check( ds_id > 0, "Failed to create dataset." ) ;
 
-  return enif_make_tuple2( env, atom_ok, ret ) ;
+  return make_handle( env, DATASET_HANDLE, ds_id ) ;
 
  error:
-  if( ds_id )
+  if( ds_id > 0 )
 	H5Dclose( ds_id ) ;
 
   return error_tuple( env, "Cannot create dataset" ) ;
@@ -164,7 +233,10 @@ ERL_NIF_TERM h5dcreate( ErlNifEnv* env, int argc, const ERL_NIF_TERM argv[] )
  * and
  *
  * -spec h5dopen( HDF5File::file_handle(), DatasetName::string(),
- *   DatasetAccessPropList ) -> { 'ok', dataset_handle() } | error().
+ *   dataset_access_proplist() ) -> { 'ok', dataset_handle() } | error().
+ *
+ * The access property list (ex: with a chunk cache set by
+ * h5pset_chunk_cache/4) only applies to this opening of the dataset.
  *
  */
 ERL_NIF_TERM h5dopen( ErlNifEnv* env, int argc, const ERL_NIF_TERM argv[] )
@@ -183,17 +255,12 @@ ERL_NIF_TERM h5dopen( ErlNifEnv* env, int argc, const ERL_NIF_TERM argv[] )
   case 3:
 	{
 
-	  /*
-	   * Actually an atom like 'H5P_DATASET_ACCESS' should be specified here
-	   * (hence h5dopen/3 currently not functional)
-	   *
-	   */
-	  hid_t class_id ;
-	  if( ! enif_get_int( env, argv[2], &class_id ) )
+	  // A property list created by h5pcreate( 'H5P_DATASET_ACCESS' ), still
+	  // owned by the caller, to be closed with h5pclose/1:
+	  if ( get_proplist( env, argv[2], H5P_DATASET_ACCESS, &ds_proplist ) )
 		return error_tuple( env,
-		  "Cannot get dataset property list from argv" ) ;
+		  "Cannot get dataset access property list from argv" ) ;
 
-	  ds_proplist = H5Pcreate( class_id ) ;
 	}
 	break ;
 
@@ -204,7 +271,7 @@ ERL_NIF_TERM h5dopen( ErlNifEnv* env, int argc, const ERL_NIF_TERM argv[] )
 
   hid_t file_id ;
 
-  if ( ! enif_get_int( env, argv[0], &file_id ) )
+  if ( ! get_handle_id( env, argv[0], FILE_HANDLE, &file_id ) )
 	return error_tuple( env, "Cannot get file resource from argv" ) ;
 
   char ds_name[ MAXBUFLEN ] ;
@@ -217,9 +284,7 @@ ERL_NIF_TERM h5dopen( ErlNifEnv* env, int argc, const ERL_NIF_TERM argv[] )
   if ( ds_id <= 0 )
 	return error_tuple( env, "Failed to open dataset" ) ;
 
-  ERL_NIF_TERM ret = enif_make_int( env, ds_id ) ;
-
-  return enif_make_tuple2( env, atom_ok, ret ) ;
+  return make_handle( env, DATASET_HANDLE, ds_id ) ;
 
 }
 
@@ -229,14 +294,14 @@ ERL_NIF_TERM h5dopen( ErlNifEnv* env, int argc, const ERL_NIF_TERM argv[] )
 ERL_NIF_TERM h5dclose( ErlNifEnv* env, int argc, const ERL_NIF_TERM argv[] )
 {
 
-  hid_t ds_id ;
+  Handle* ds_handle ;
 
   // Parse arguments:
   check( argc == 1, "Incorrect number of arguments" ) ;
-  check( enif_get_int( env, argv[0], &ds_id ),
+  check( get_handle( env, argv[0], DATASET_HANDLE, &ds_handle ),
 	"Cannot get dataset handle from argv" ) ;
 
-  check( ! H5Dclose( ds_id ), "Failed to close dataset.") ;
+  check( close_handle( ds_handle ) >= 0, "Failed to close dataset.") ;
   return atom_ok ;
 
  error:
@@ -259,7 +324,7 @@ ERL_NIF_TERM h5d_get_space_status( ErlNifEnv* env, int argc,
   // Parses arguments:
   check( argc == 1, "Incorrect number of arguments" ) ;
 
-  check( enif_get_int( env, argv[0], &ds_id ),
+  check( get_handle_id( env, argv[0], DATASET_HANDLE, &ds_id ),
 	"Cannot get dataset resource from argv" ) ;
 
   check( !H5Dget_space_status( ds_id, &space_status ),
@@ -275,9 +340,6 @@ ERL_NIF_TERM h5d_get_space_status( ErlNifEnv* env, int argc,
   return enif_make_tuple2( env, atom_ok, ret ) ;
 
  error:
-  if ( ds_id )
-	H5Dclose( ds_id ) ;
-
   return error_tuple( env, "Cannot get dataspace status" ) ;
 
 }
@@ -297,12 +359,12 @@ ERL_NIF_TERM h5d_get_storage_size( ErlNifEnv* env, int argc,
 
   check( argc == 1, "Incorrect number of arguments" ) ;
 
-  check( enif_get_int( env, argv[0], &ds_id ),
+  check( get_handle_id( env, argv[0], DATASET_HANDLE, &ds_id ),
 	"Cannot get dataset resource from argv" ) ;
 
   size = H5Dget_storage_size( ds_id ) ;
 
-  ret = enif_make_int64( env, size ) ;
+  ret = enif_make_uint64( env, (ErlNifUInt64) size ) ;
 
   return enif_make_tuple2( env, atom_ok, ret ) ;
 
@@ -322,14 +384,14 @@ ERL_NIF_TERM h5dget_type( ErlNifEnv* env, int argc, const ERL_NIF_TERM argv[] )
 
   hid_t ds_id ;
 
-  check( enif_get_int(env, argv[0], &ds_id ),
+  check( get_handle_id( env, argv[0], DATASET_HANDLE, &ds_id ),
 	"Cannot get dataset resource from argv" ) ;
 
   hid_t type_id = H5Dget_type( ds_id ) ;
 
-  ERL_NIF_TERM ret = enif_make_int( env, type_id ) ;
+  check( type_id >= 0, "Failed to get type." ) ;
 
-  return enif_make_tuple2( env, atom_ok, ret ) ;
+  return make_handle( env, DATATYPE_HANDLE, type_id ) ;
 
  error:
   return error_tuple( env, "Cannot determine storage size" ) ;
@@ -340,87 +402,103 @@ ERL_NIF_TERM h5dget_type( ErlNifEnv* env, int argc, const ERL_NIF_TERM argv[] )
 
 
 /*
- * Corresponds to h5dwrite/2, i.e. a writing of the data on the full dataset of
- * the file (hence the sizes of the data and of the dataset must exactly match):
+ * Decodes, in a single pass, specified data list, as described by specified
+ * descriptor, into a newly-allocated buffer of cells of specified type (to be
+ * freed by the caller), each cell being checked against the range of that type.
  *
- * -spec h5dwrite_2( dataset_handle(), data() ) -> 'ok' | error().
+ * Returns NULL on success, otherwise an error message (then no buffer is to be
+ * freed).
  *
  */
-ERL_NIF_TERM h5dwrite_2( ErlNifEnv* env, int argc, const ERL_NIF_TERM argv[] )
+static const char * decode_data_list( ErlNifEnv* env, cell_type type,
+  const struct DataDescriptor* desc, ERL_NIF_TERM data_list, void** buffer,
+  hsize_t* element_count )
 {
 
-  // Parses the two arguments:
+  if ( type == UNKNOWN_TYPE )
+	return "Unsupported cell type of dataset for writing" ;
 
-  hid_t dataset_id ;
+  *buffer = NULL ;
+  *element_count = 0 ;
 
-  if ( ! enif_get_int( env, argv[0], &dataset_id ) )
-	return error_tuple( env, "Cannot get dataset handle from argv" ) ;
+  hsize_t capacity = 0 ;
 
-  ERL_NIF_TERM data_list = argv[1] ;
+  const char * error = decode_cell_list( env, type, &data_list,
+	desc->tuple_size, buffer, &capacity, element_count,
+	/* no slicing */ (hsize_t) -1 ) ;
 
-  struct DataDescriptor detected_desc ;
+  if ( error && *buffer )
+	enif_free( *buffer ) ;
 
-  if ( ! detect_type( data_list, env, &detected_desc )  )
-	return detected_desc.error_term ;
+  return error ;
 
-  /*
-   * Allocates space for the intermediate array used to feed HDF:
-   * (on the heap rather than on the stack, as it can be big)
-   */
+}
 
-  // Clearer than a switch, as needing blocks:
-  if ( detected_desc.dimension_count == 1 )
-  {
 
-	switch( detected_desc.type )
-	{
 
-	case INTEGER:
-	  return write_ints_to_array( dataset_id, env, detected_desc.len,
-		data_list, /* using the full file dataspace */ H5S_ALL ) ;
-	  break ;
+/*
+ * Writes specified data list, as described by specified descriptor, into
+ * specified dataset, using specified selection within the file dataspace
+ * (possibly H5S_ALL).
+ *
+ * The cells are converted directly to the type of the cells of the dataset,
+ * each being checked against the range of that type.
+ *
+ */
+ERL_NIF_TERM write_data_list( Handle* dataset, ErlNifEnv* env,
+  const struct DataDescriptor* desc, ERL_NIF_TERM data_list,
+  hid_t file_dataspace_id )
+{
+
+  void * buffer_for_hdf ;
+  hsize_t element_count ;
 
-	case FLOAT:
-	  return write_floats_to_array( dataset_id, env, detected_desc.len,
-		data_list, /* using the full file dataspace */ H5S_ALL ) ;
-	  break ;
+  const char * error = decode_data_list( env, dataset->cells, desc, data_list,
+	&buffer_for_hdf, &element_count ) ;
 
-	default:
-	  return error_tuple( env, "Unsupported datatype for 1D writing" ) ;
+  if ( error )
+	return error_tuple( env, (char *) error ) ;
 
-	}
+  // Finally, writes the translated data to the dataset:
+  ERL_NIF_TERM res = write_buffer_to_dataset( dataset, env,
+	get_native_cell_type( dataset->cells ), element_count, buffer_for_hdf,
+	file_dataspace_id, HSIZE_UNDEF ) ;
 
-  }
-  else if ( detected_desc.dimension_count == 2 )
-  {
+  enif_free( buffer_for_hdf ) ;
 
-	switch( detected_desc.type )
-	{
+  return res ;
 
-	case INTEGER:
-	  return write_int_tuples_to_array( dataset_id, env, detected_desc.len,
-		detected_desc.size, data_list,
-		/* using the full file dataspace */ H5S_ALL ) ;
-	  break ;
+}
 
-	case FLOAT:
-	  return write_float_tuples_to_array( dataset_id, env, detected_desc.len,
-		detected_desc.size, data_list,
-		/* using the full file dataspace */ H5S_ALL ) ;
-	  break ;
 
-	default:
-	  return error_tuple( env, "Unsupported datatype for 2D writing" ) ;
 
-	}
+/*
+ * Corresponds to h5dwrite/2, i.e. a writing of the data on the full dataset of
+ * the file (hence the sizes of the data and of the dataset must exactly match):
+ *
+ * -spec h5dwrite_2( dataset_handle(), data() ) -> 'ok' | error().
+ *
+ */
+ERL_NIF_TERM h5dwrite_2( ErlNifEnv* env, int argc, const ERL_NIF_TERM argv[] )
+{
 
-  }
-  else
-  {
+  // Parses the two arguments:
 
-	return error_tuple( env, "Unsupported datatype dimension for writing" ) ;
+  Handle * dataset ;
 
-  }
+  if ( ! get_handle( env, argv[0], DATASET_HANDLE, &dataset )
+	|| dataset->id < 0 )
+	return error_tuple( env, "Cannot get dataset handle from argv" ) ;
+
+  ERL_NIF_TERM data_list = argv[1] ;
+
+  struct DataDescriptor detected_desc ;
+
+  if ( ! detect_type( data_list, env, &detected_desc )  )
+	return detected_desc.error_term ;
+
+  return write_data_list( dataset, env, &detected_desc,
+	data_list, /* using the full file dataspace */ H5S_ALL ) ;
 
 }
 
@@ -442,14 +520,15 @@ ERL_NIF_TERM h5dwrite_3( ErlNifEnv* env, int argc, const ERL_NIF_TERM argv[] )
 
   // Parses the three arguments:
 
-  hid_t dataset_id ;
+  Handle * dataset ;
 
-  if ( ! enif_get_int( env, argv[0], &dataset_id ) )
+  if ( ! get_handle( env, argv[0], DATASET_HANDLE, &dataset )
+	|| dataset->id < 0 )
 	return error_tuple( env, "Cannot get dataset handle from argv" ) ;
 
   hid_t dataspace_id ;
 
-  if ( ! enif_get_int( env, argv[1], &dataspace_id ) )
+  if ( ! get_handle_id( env, argv[1], DATASPACE_HANDLE, &dataspace_id ) )
 	return error_tuple( env, "Cannot get dataspace handle from argv" ) ;
 
   ERL_NIF_TERM data_list = argv[2] ;
@@ -459,79 +538,24 @@ ERL_NIF_TERM h5dwrite_3( ErlNifEnv* env, int argc, const ERL_NIF_TERM argv[] )
   if ( ! detect_type( data_list, env, &detected_desc ) )
 	return detected_desc.error_term ;
 
-  /*
-   * Allocates space for the intermediate array used to feed HDF:
-   * (on the heap rather than on the stack, as can be big)
-   */
-
-
-  // Clearer than a switch, as needing blocks:
-  if ( detected_desc.dimension_count == 1 )
-  {
-
-	switch( detected_desc.type )
-	{
-
-	case INTEGER:
-	  return write_ints_to_array( dataset_id, env, detected_desc.len,
-		data_list, dataspace_id ) ;
-	  break ;
-
-	case FLOAT:
-	  return write_floats_to_array( dataset_id, env, detected_desc.len,
-		data_list, dataspace_id ) ;
-	  break ;
-
-	default:
-	  return error_tuple( env, "Unsupported datatype for 1D writing" ) ;
-
-	}
-
-  }
-  else if ( detected_desc.dimension_count == 2 )
-  {
-
-	switch( detected_desc.type )
-	{
-
-	case INTEGER:
-	  return write_int_tuples_to_array( dataset_id, env, detected_desc.len,
-		detected_desc.size, data_list, dataspace_id ) ;
-	  break ;
-
-	case FLOAT:
-	  return write_float_tuples_to_array( dataset_id, env, detected_desc.len,
-		detected_desc.size, data_list, dataspace_id ) ;
-	  break ;
-
-	default:
-	  return error_tuple( env, "Unsupported datatype for 2D writing" ) ;
-
-	}
-
-  }
-  else
-  {
-
-	return error_tuple( env, "Unsupported datatype dimension for writing" ) ;
-
-  }
+  return write_data_list( dataset, env, &detected_desc,
+	data_list, dataspace_id ) ;
 
 }
 
 
 
 /*
- * Detects the dimension (in [1,2]) and type (in [ 'INTEGER', 'FLOAT' ]) of the
- * elements aggregated in the specified data list.
- *
- * This list is assumed to contain either directly atomic, homogeneous elements,
- * or tuples of all the same size, whose elements have all the same type (hence
- * checking the first element of the first tuple is sufficient).
+ * Detects the shape of the elements aggregated in the specified data list,
+ * i.e. either directly atomic elements, or tuples of all the same size.
  *
  * Said differently, the data_list is either [ T ] or [ tuple(T) ], with T ::
  * integer() | float().
  *
+ * Only the first element is inspected (in constant time): the length of the
+ * list, the arity of each tuple and the type of each cell are then checked
+ * while decoding it, in a single pass (see decode_cell_list/8).
+ *
  * Returns whether the execution is a success, and fills specified data
  * descriptor.
  *
@@ -542,163 +566,41 @@ bool detect_type( ERL_NIF_TERM data_list, ErlNifEnv* env,
   struct DataDescriptor* detected_desc )
 {
 
-  /*
-   * The input array will be of type, in C, in: int[U], double[U], int[U][V] or
-   * double[U][V].
-   *
-   */
-
-  /*
-   * Gets the dimensions of input data: length of list is U (i.e. there are U
-   * data elements), and size of tuples is V (possibly 1, if no tuple at all).
-   *
-   * All tuples are expected to be of the same size (same number of elements, V)
-   * and homogeneous (all their elements are of the same type, typically native
-   * int or double).
-   *
-   */
-
-  if ( ! enif_get_list_length( env, data_list, &(detected_desc->len) ) )
-  {
-
-	// Probably not a list then:
-	detected_desc->error_term = error_tuple( env,
-	  "Cannot get length of input list" ) ;
-
-	return false ;
-
-  }
-
-  //printf( "List length (U): %u\n", &detected_desc.len ) ;
-
-  if ( detected_desc->len == 0 )
-  {
-
-	detected_desc->error_term = error_tuple( env, "Empty input list" ) ;
-
-	return false ;
-
-  }
-
-
-  /*
-   * Determines once for all the size of tuples (i.e. V), based on the first
-   * element found:
-   *
-   * Note: we could/should check that all tuples have the same size and that
-   * their elements are all of the same type (better done optionally and
-   * Erlang-level)
-   *
-   */
-
   ERL_NIF_TERM head, tail ;
 
-  // Unlikely to fail:
   if ( ! enif_get_list_cell( env, data_list, &head, &tail ) )
   {
 
-	 detected_desc->error_term = error_tuple( env,
-	   "Cannot get first element of input list." ) ;
+	detected_desc->error_term = error_tuple( env,
+	  enif_is_empty_list( env, data_list ) ?
+	  "Empty input list" : "Cannot get length of input list" ) ;
 
-	 return false ;
+	return false ;
 
   }
 
-
   const ERL_NIF_TERM * terms ;
 
-  if ( ! enif_get_tuple( env, head, &(detected_desc->size), &terms ) )
+  if ( ! enif_get_tuple( env, head, &(detected_desc->tuple_size), &terms ) )
   {
 
-	/*
-	 * No tuple found at first position, hence here we should have a
-	 * mono-dimensional list of (atomic) elements:
-	 *
-	 */
-
-	detected_desc->dimension_count = 1 ;
-
-	detected_desc->type = detect_cell_type( head, env ) ;
-
-	if ( detected_desc->type == UNKNOWN_TYPE )
-	{
-
-	  detected_desc->error_term = error_tuple( env,
-		"Unknown cell type detected" ) ;
-
-	  return false ;
-
-	}
-
-	// detected_desc->len already set.
-	detected_desc->size = 1 ;
+	// No tuple found at first position, hence a list of (atomic) elements:
+	detected_desc->tuple_size = 0 ;
 
 	return true ;
 
   }
 
-  /*
-   * Here we found a tuple, are in dimension at least two, we suppose exactly
-   * two:
-   *
-   */
-  detected_desc->dimension_count = 2 ;
-
-  detected_desc->type = detect_cell_type( terms[0], env ) ;
-
-  // All fields filled.
-
-  // No error here:
-  return true ;
-
-}
-
-
-
-// Returns the type of specified cell.
-cell_type detect_cell_type( ERL_NIF_TERM term, ErlNifEnv* env )
-{
-
-  /*
-   * Let's determine now the type of the cell elements, by assuming it is first
-   * a floating-point value (a native double), then a (native) integer:
-   *
-   */
-
-  int integer_value ;
-
-  if ( enif_get_int( env, term, &integer_value ) )
+  if ( detected_desc->tuple_size == 0 )
   {
 
-	//printf( "Detected integer %i.\n", integer_value ) ;
-	return INTEGER ;
-
-  }
-
-  double floating_point_value ;
-
-  if ( enif_get_double( env, term, &floating_point_value ) )
-  {
+	detected_desc->error_term = error_tuple( env, "Empty tuple in input list" ) ;
 
-	//printf( "Detected float (double) %f.\n", floating_point_value ) ;
-	return FLOAT ;
+	return false ;
 
   }
 
-  // Last possibility: a 'nan' or 'inf' atom:
-
-  char atom_string[ 4 ] ;
-
-  if ( enif_get_atom( env, term, atom_string, 4, ERL_NIF_LATIN1 ) == 0 )
-	return UNKNOWN_TYPE ;
-
-  if ( strcmp( atom_string, "nan" ) == 0 )
-	return FLOAT ;
-
-  if ( strcmp( atom_string, "inf" ) == 0 )
-	return FLOAT ;
-
-  return UNKNOWN_TYPE ;
+  return true ;
 
 }
 
@@ -743,26 +645,1092 @@ ERL_NIF_TERM h5dwrite( ErlNifEnv* env, int argc, const ERL_NIF_TERM argv[] )
 
 
 
-// Returns an identifier for a copy of the dataspace for a dataset.
-ERL_NIF_TERM h5dget_space( ErlNifEnv* env, int argc, const ERL_NIF_TERM argv[] )
+/*
+ * Writes specified binary into file, using a target dataspace if specified.
+ *
+ * The binary is expected to contain already packed, contiguous cells of the
+ * specified (memory) type (ex: <<X:64/float-native, ...>> for
+ * 'H5T_NATIVE_DOUBLE'); its bytes are handed over directly to HDF5, with no
+ * per-element conversion nor intermediate copy.
+ *
+ * This implementation corresponds to h5dwrite_binary/{3,4}:
+ *
+ * -spec h5dwrite_binary( dataset_handle(), datatype_name(), binary() ) ->
+ *                        'ok' | error().
+ *
+ * and
+ *
+ * -spec h5dwrite_binary( dataset_handle(), dataspace_handle(),
+ *                        datatype_name(), binary() ) -> 'ok' | error().
+ *
+ */
+ERL_NIF_TERM h5dwrite_binary( ErlNifEnv* env, int argc,
+  const ERL_NIF_TERM argv[] )
 {
 
-  // Parses arguments
-  check( argc == 1, "Incorrect number of arguments" ) ;
+  // Selection in the file; by default, the full file dataspace:
+  hid_t file_dataspace_id = H5S_ALL ;
 
-  hid_t dataset_id ;
+  // Index of the cell type argument:
+  int type_index ;
 
-  check( enif_get_int( env, argv[0], &dataset_id ),
-	"Cannot get dataset resource from argv" ) ;
+  switch ( argc )
+  {
 
-  hid_t space_id = H5Dget_space( dataset_id ) ;
+  case 3:
+	type_index = 1 ;
+	break ;
 
-  check( space_id >= 0, "Failed to get space." ) ;
+  case 4:
+	if ( ! get_handle_id( env, argv[1], DATASPACE_HANDLE,
+		&file_dataspace_id ) )
+	  return error_tuple( env, "Cannot get dataspace handle from argv" ) ;
+	type_index = 2 ;
+	break ;
 
-  ERL_NIF_TERM ret = enif_make_int( env, space_id ) ;
+  default:
+	return error_tuple( env, "Invalid arity for h5dwrite_binary" ) ;
+
+  }
+
+  Handle * dataset ;
+
+  if ( ! get_handle( env, argv[0], DATASET_HANDLE, &dataset )
+	|| dataset->id < 0 )
+	return error_tuple( env, "Cannot get dataset handle from argv" ) ;
+
+  hid_t dataset_id = dataset->id ;
+
+  char type_name[ MAXBUFLEN ] ;
+
+  if ( ! enif_get_atom( env, argv[type_index], type_name, sizeof( type_name ),
+	  ERL_NIF_LATIN1 ) )
+	return error_tuple( env, "Cannot get cell type from argv" ) ;
+
+  hid_t mem_type_id ;
+
+  if ( convert_type( type_name, &mem_type_id ) )
+	return error_tuple( env, "Unsupported cell type" ) ;
+
+  ErlNifBinary data ;
+
+  if ( ! enif_inspect_binary( env, argv[type_index+1], &data ) )
+	return error_tuple( env, "Cannot get binary data from argv" ) ;
+
+  size_t cell_size = H5Tget_size( mem_type_id ) ;
+
+  if ( cell_size == 0 )
+	return error_tuple( env, "Cannot determine cell size" ) ;
+
+  if ( data.size == 0 )
+	return error_tuple( env, "Empty input binary" ) ;
+
+  if ( data.size % cell_size != 0 )
+	return error_tuple( env,
+	  "Binary size is not a multiple of the cell size" ) ;
+
+  hsize_t element_count = data.size / cell_size ;
+
+  // Checks beforehand that the selection matches, for a clearer error report:
+  hssize_t selected_count = get_selected_count( dataset_id,
+	file_dataspace_id ) ;
+
+  if ( selected_count < 0 )
+	return error_tuple( env, "Cannot determine the size of the selection" ) ;
+
+  if ( (hsize_t) selected_count != element_count )
+	return error_tuple( env,
+	  "Binary cell count does not match the target selection" ) ;
+
+  return write_buffer_to_dataset( dataset, env, mem_type_id, element_count,
+	data.data, file_dataspace_id, HSIZE_UNDEF ) ;
+
+}
+
+
+
+/*
+ * Reads the cells selected by specified file dataspace (or the full dataset,
+ * if 'H5S_ALL' is specified) from specified dataset, and returns them as a
+ * binary of contiguous cells of the specified (memory) type.
+ *
+ * HDF5 reads directly into the buffer of the returned binary (no per-element
+ * term is created, and no extra copy is done).
+ *
+ * -spec h5dread_binary( dataset_handle(), dataspace_handle() | 'H5S_ALL',
+ *                       datatype_name() ) -> { 'ok', binary() } | error().
+ *
+ */
+ERL_NIF_TERM h5dread_binary( ErlNifEnv* env, int argc,
+  const ERL_NIF_TERM argv[] )
+{
+
+  if ( argc != 3 )
+	return error_tuple( env, "Incorrect number of arguments" ) ;
+
+  hid_t dataset_id ;
+
+  if ( ! get_handle_id( env, argv[0], DATASET_HANDLE, &dataset_id ) )
+	return error_tuple( env, "Cannot get dataset handle from argv" ) ;
+
+  hid_t file_dataspace_id ;
+
+  if ( ! get_file_dataspace( env, argv[1], &file_dataspace_id ) )
+	return error_tuple( env, "Cannot get dataspace handle from argv" ) ;
+
+  char type_name[ MAXBUFLEN ] ;
+
+  if ( ! enif_get_atom( env, argv[2], type_name, sizeof( type_name ),
+	  ERL_NIF_LATIN1 ) )
+	return error_tuple( env, "Cannot get cell type from argv" ) ;
+
+  hid_t mem_type_id ;
+
+  if ( convert_type( type_name, &mem_type_id ) )
+	return error_tuple( env, "Unsupported cell type" ) ;
+
+  size_t cell_size = H5Tget_size( mem_type_id ) ;
+
+  if ( cell_size == 0 )
+	return error_tuple( env, "Cannot determine cell size" ) ;
+
+  hssize_t selected_count = get_selected_count( dataset_id,
+	file_dataspace_id ) ;
+
+  if ( selected_count < 0 )
+	return error_tuple( env, "Cannot determine the size of the selection" ) ;
+
+  ErlNifBinary data ;
+
+  if ( ! enif_alloc_binary( selected_count * cell_size, &data ) )
+	return error_tuple( env, "Cannot allocate binary" ) ;
+
+  if ( selected_count > 0 && ! read_buffer_from_dataset( dataset_id,
+	  mem_type_id, selected_count, data.data, file_dataspace_id ) )
+  {
+	enif_release_binary( &data ) ;
+	return error_tuple( env, "Failed to read dataset" ) ;
+  }
+
+  // Ownership of the binary is transferred to the returned term:
+  return enif_make_tuple2( env, atom_ok, enif_make_binary( env, &data ) ) ;
+
+}
+
+
+
+/*
+ * Selects, in a copy of the dataspace of specified dataset, the block (of any
+ * rank) starting at specified offset and having specified dimensions (both
+ * tuples having as many elements as the dataset has dimensions).
+ *
+ * Returns that file dataspace (to be closed by the caller) and sets
+ * cell_count, or returns a negative value and sets error_message.
+ *
+ */
+static hid_t select_block( ErlNifEnv* env, hid_t dataset_id,
+  ERL_NIF_TERM offset_term, ERL_NIF_TERM dims_term, hsize_t* cell_count,
+  const char** error_message )
+{
+
+  hid_t file_dataspace_id = H5Dget_space( dataset_id ) ;
+
+  if ( file_dataspace_id < 0 )
+  {
+	*error_message = "Cannot get the dataspace of the dataset" ;
+	return -1 ;
+  }
+
+  hsize_t extent[ H5S_MAX_RANK ] ;
+  hsize_t offset[ H5S_MAX_RANK ] ;
+  hsize_t dims[ H5S_MAX_RANK ] ;
+
+  int rank = H5Sget_simple_extent_dims( file_dataspace_id, extent, NULL ) ;
+
+  if ( rank < 1 )
+  {
+	*error_message = "Cannot get the dimensions of the dataset" ;
+	goto error ;
+  }
+
+  if ( ! get_dimension_tuple( env, offset_term, rank, offset ) )
+  {
+	*error_message = "Offset does not match the rank of the dataset" ;
+	goto error ;
+  }
+
+  if ( ! get_dimension_tuple( env, dims_term, rank, dims ) )
+  {
+	*error_message = "Block dimensions do not match the rank of the dataset" ;
+	goto error ;
+  }
+
+  *cell_count = 1 ;
+
+  int i ;
+
+  for ( i = 0; i < rank; i++ )
+  {
+
+	if ( dims[i] > extent[i] || offset[i] > extent[i] - dims[i] )
+	{
+	  *error_message = "Block exceeds the extent of the dataset" ;
+	  goto error ;
+	}
+
+	*cell_count *= dims[i] ;
+
+  }
+
+  if ( *cell_count == 0 )
+  {
+	*error_message = "Empty block" ;
+	goto error ;
+  }
+
+  if ( H5Sselect_hyperslab( file_dataspace_id, H5S_SELECT_SET, offset, NULL,
+	  dims, NULL ) < 0 )
+  {
+	*error_message = "Block selection failed" ;
+	goto error ;
+  }
+
+  return file_dataspace_id ;
+
+ error:
+  H5Sclose( file_dataspace_id ) ;
+  return -1 ;
+
+}
+
+
+
+/*
+ * Writes specified shaped binary, i.e. a {Dims, Binary} pair, at specified
+ * offset of specified dataset, whatever its rank.
+ *
+ * The binary contains the packed cells of the specified (memory) type, in
+ * row-major order (the last dimension varying fastest), like for
+ * h5dwrite_binary/3; no nested term is walked.
+ *
+ * -spec h5dwrite_block( dataset_handle(), Offset::size_tuple(),
+ *                       datatype_name(), shaped_binary() ) -> 'ok' | error().
+ *
+ */
+ERL_NIF_TERM h5dwrite_block( ErlNifEnv* env, int argc,
+  const ERL_NIF_TERM argv[] )
+{
+
+  if ( argc != 4 )
+	return error_tuple( env, "Incorrect number of arguments" ) ;
+
+  Handle * dataset ;
+
+  if ( ! get_handle( env, argv[0], DATASET_HANDLE, &dataset )
+	|| dataset->id < 0 )
+	return error_tuple( env, "Cannot get dataset handle from argv" ) ;
+
+  hid_t dataset_id = dataset->id ;
+
+  char type_name[ MAXBUFLEN ] ;
+
+  if ( ! enif_get_atom( env, argv[2], type_name, sizeof( type_name ),
+	  ERL_NIF_LATIN1 ) )
+	return error_tuple( env, "Cannot get cell type from argv" ) ;
+
+  hid_t mem_type_id ;
+
+  if ( convert_type( type_name, &mem_type_id ) )
+	return error_tuple( env, "Unsupported cell type" ) ;
+
+  int arity ;
+  const ERL_NIF_TERM * block ;
+  ErlNifBinary data ;
+
+  if ( ! enif_get_tuple( env, argv[3], &arity, &block ) || arity != 2
+	|| ! enif_inspect_binary( env, block[1], &data ) )
+	return error_tuple( env, "Cannot get shaped binary from argv" ) ;
+
+  const char * error_message ;
+  hsize_t cell_count ;
+
+  hid_t file_dataspace_id = select_block( env, dataset_id, argv[1], block[0],
+	&cell_count, &error_message ) ;
+
+  if ( file_dataspace_id < 0 )
+	return error_tuple( env, (char *) error_message ) ;
+
+  ERL_NIF_TERM ret ;
+
+  if ( data.size != cell_count * H5Tget_size( mem_type_id ) )
+	ret = error_tuple( env, "Binary size does not match the block dimensions" ) ;
+  else
+	ret = write_buffer_to_dataset( dataset, env, mem_type_id, cell_count,
+	  data.data, file_dataspace_id, HSIZE_UNDEF ) ;
+
+  H5Sclose( file_dataspace_id ) ;
+
+  return ret ;
+
+}
+
+
+
+/*
+ * Reads the block of specified dimensions starting at specified offset of
+ * specified dataset (whatever its rank), and returns it as a shaped binary,
+ * i.e. a {Dims, Binary} pair, Binary containing the packed cells of the
+ * specified (memory) type in row-major order.
+ *
+ * -spec h5dread_block( dataset_handle(), Offset::size_tuple(),
+ *                      Dims::size_tuple(), datatype_name() ) ->
+ *                        { 'ok', shaped_binary() } | error().
+ *
+ */
+ERL_NIF_TERM h5dread_block( ErlNifEnv* env, int argc,
+  const ERL_NIF_TERM argv[] )
+{
+
+  if ( argc != 4 )
+	return error_tuple( env, "Incorrect number of arguments" ) ;
+
+  hid_t dataset_id ;
+
+  if ( ! get_handle_id( env, argv[0], DATASET_HANDLE, &dataset_id ) )
+	return error_tuple( env, "Cannot get dataset handle from argv" ) ;
+
+  char type_name[ MAXBUFLEN ] ;
+
+  if ( ! enif_get_atom( env, argv[3], type_name, sizeof( type_name ),
+	  ERL_NIF_LATIN1 ) )
+	return error_tuple( env, "Cannot get cell type from argv" ) ;
+
+  hid_t mem_type_id ;
+
+  if ( convert_type( type_name, &mem_type_id ) )
+	return error_tuple( env, "Unsupported cell type" ) ;
+
+  const char * error_message ;
+  hsize_t cell_count ;
+
+  hid_t file_dataspace_id = select_block( env, dataset_id, argv[1], argv[2],
+	&cell_count, &error_message ) ;
+
+  if ( file_dataspace_id < 0 )
+	return error_tuple( env, (char *) error_message ) ;
+
+  ErlNifBinary data ;
+
+  if ( ! enif_alloc_binary( cell_count * H5Tget_size( mem_type_id ), &data ) )
+  {
+	H5Sclose( file_dataspace_id ) ;
+	return error_tuple( env, "Cannot allocate binary" ) ;
+  }
+
+  bool read = read_buffer_from_dataset( dataset_id, mem_type_id, cell_count,
+	data.data, file_dataspace_id ) ;
+
+  H5Sclose( file_dataspace_id ) ;
+
+  if ( ! read )
+  {
+	enif_release_binary( &data ) ;
+	return error_tuple( env, "Failed to read dataset" ) ;
+  }
+
+  ERL_NIF_TERM block = enif_make_tuple2( env, argv[2],
+	enif_make_binary( env, &data ) ) ;
+
+  return enif_make_tuple2( env, atom_ok, block ) ;
+
+}
+
+
+
+/*
+ * Selects, in a copy of the dataspace of specified dataset, the points whose
+ * coordinates are packed in specified binary (see select_points/5).
+ *
+ * Returns that file dataspace (to be closed by the caller) and sets
+ * point_count, or returns a negative value and sets error_message.
+ *
+ */
+static hid_t select_dataset_points( ErlNifEnv* env, hid_t dataset_id,
+  ERL_NIF_TERM coords_term, hsize_t* point_count, const char** error_message )
+{
+
+  hid_t file_dataspace_id = H5Dget_space( dataset_id ) ;
+
+  if ( file_dataspace_id < 0 )
+  {
+	*error_message = "Cannot get the dataspace of the dataset" ;
+	return -1 ;
+  }
+
+  *point_count = select_points( env, file_dataspace_id, H5S_SELECT_SET,
+	coords_term, error_message ) ;
+
+  if ( *point_count == 0 )
+  {
+	H5Sclose( file_dataspace_id ) ;
+	return -1 ;
+  }
+
+  return file_dataspace_id ;
+
+}
+
+
+
+/*
+ * Writes the cells packed in specified binary at the scattered points whose
+ * coordinates are packed in specified binary, in a single H5Dwrite/6 call (the
+ * n-th cell being written at the n-th point).
+ *
+ * -spec h5dwrite_points( dataset_handle(), Coords::binary(), datatype_name(),
+ *                        Values::binary() ) -> 'ok' | error().
+ *
+ */
+ERL_NIF_TERM h5dwrite_points( ErlNifEnv* env, int argc,
+  const ERL_NIF_TERM argv[] )
+{
+
+  if ( argc != 4 )
+	return error_tuple( env, "Incorrect number of arguments" ) ;
+
+  Handle * dataset ;
+
+  if ( ! get_handle( env, argv[0], DATASET_HANDLE, &dataset )
+	|| dataset->id < 0 )
+	return error_tuple( env, "Cannot get dataset handle from argv" ) ;
+
+  hid_t dataset_id = dataset->id ;
+
+  char type_name[ MAXBUFLEN ] ;
+
+  if ( ! enif_get_atom( env, argv[2], type_name, sizeof( type_name ),
+	  ERL_NIF_LATIN1 ) )
+	return error_tuple( env, "Cannot get cell type from argv" ) ;
+
+  hid_t mem_type_id ;
+
+  if ( convert_type( type_name, &mem_type_id ) )
+	return error_tuple( env, "Unsupported cell type" ) ;
+
+  ErlNifBinary data ;
+
+  if ( ! enif_inspect_binary( env, argv[3], &data ) )
+	return error_tuple( env, "Cannot get binary data from argv" ) ;
+
+  const char * error_message ;
+  hsize_t point_count ;
+
+  hid_t file_dataspace_id = select_dataset_points( env, dataset_id, argv[1],
+	&point_count, &error_message ) ;
+
+  if ( file_dataspace_id < 0 )
+	return error_tuple( env, (char *) error_message ) ;
+
+  ERL_NIF_TERM ret ;
+
+  if ( data.size != point_count * H5Tget_size( mem_type_id ) )
+	ret = error_tuple( env, "Binary size does not match the number of points" ) ;
+  else
+	ret = write_buffer_to_dataset( dataset, env, mem_type_id, point_count,
+	  data.data, file_dataspace_id, HSIZE_UNDEF ) ;
+
+  H5Sclose( file_dataspace_id ) ;
+
+  return ret ;
+
+}
+
+
+
+/*
+ * Reads the cells at the scattered points whose coordinates are packed in
+ * specified binary, in a single H5Dread/6 call, and returns them as a binary of
+ * packed cells of the specified (memory) type, in the order of the points.
+ *
+ * -spec h5dread_points( dataset_handle(), Coords::binary(), datatype_name() ) ->
+ *                        { 'ok', binary() } | error().
+ *
+ */
+ERL_NIF_TERM h5dread_points( ErlNifEnv* env, int argc,
+  const ERL_NIF_TERM argv[] )
+{
+
+  if ( argc != 3 )
+	return error_tuple( env, "Incorrect number of arguments" ) ;
+
+  hid_t dataset_id ;
+
+  if ( ! get_handle_id( env, argv[0], DATASET_HANDLE, &dataset_id ) )
+	return error_tuple( env, "Cannot get dataset handle from argv" ) ;
+
+  char type_name[ MAXBUFLEN ] ;
+
+  if ( ! enif_get_atom( env, argv[2], type_name, sizeof( type_name ),
+	  ERL_NIF_LATIN1 ) )
+	return error_tuple( env, "Cannot get cell type from argv" ) ;
+
+  hid_t mem_type_id ;
+
+  if ( convert_type( type_name, &mem_type_id ) )
+	return error_tuple( env, "Unsupported cell type" ) ;
+
+  const char * error_message ;
+  hsize_t point_count ;
+
+  hid_t file_dataspace_id = select_dataset_points( env, dataset_id, argv[1],
+	&point_count, &error_message ) ;
+
+  if ( file_dataspace_id < 0 )
+	return error_tuple( env, (char *) error_message ) ;
+
+  ErlNifBinary data ;
+
+  if ( ! enif_alloc_binary( point_count * H5Tget_size( mem_type_id ), &data ) )
+  {
+	H5Sclose( file_dataspace_id ) ;
+	return error_tuple( env, "Cannot allocate binary" ) ;
+  }
+
+  bool read = read_buffer_from_dataset( dataset_id, mem_type_id, point_count,
+	data.data, file_dataspace_id ) ;
+
+  H5Sclose( file_dataspace_id ) ;
+
+  if ( ! read )
+  {
+	enif_release_binary( &data ) ;
+	return error_tuple( env, "Failed to read dataset" ) ;
+  }
+
+  return enif_make_tuple2( env, atom_ok, enif_make_binary( env, &data ) ) ;
+
+}
+
+
+
+/*
+ * Reads the cells selected by the file dataspace specified in argv[1] from the
+ * dataset specified in argv[0], as cells of the memory type named in argv[2]
+ * (any numeric one, ex: 'H5T_NATIVE_UINT16'), into a newly-allocated
+ * buffer (if at least one cell is selected) that is then to be freed by the
+ * caller.
+ *
+ * Returns whether the operation succeeded; on failure, error_term is set.
+ *
+ */
+bool read_selection( ErlNifEnv* env, const ERL_NIF_TERM argv[],
+  cell_type* type, void** buffer, hsize_t* element_count,
+  ERL_NIF_TERM* error_term )
+{
+
+  hid_t dataset_id ;
+
+  if ( ! get_handle_id( env, argv[0], DATASET_HANDLE, &dataset_id ) )
+  {
+	*error_term = error_tuple( env, "Cannot get dataset handle from argv" ) ;
+	return false ;
+  }
+
+  hid_t file_dataspace_id ;
+
+  if ( ! get_file_dataspace( env, argv[1], &file_dataspace_id ) )
+  {
+	*error_term = error_tuple( env, "Cannot get dataspace handle from argv" ) ;
+	return false ;
+  }
+
+  char type_name[ MAXBUFLEN ] ;
+
+  if ( ! enif_get_atom( env, argv[2], type_name, sizeof( type_name ),
+	  ERL_NIF_LATIN1 ) )
+  {
+	*error_term = error_tuple( env, "Cannot get cell type from argv" ) ;
+	return false ;
+  }
+
+  hid_t mem_type_id ;
+
+  if ( convert_type( type_name, &mem_type_id ) )
+  {
+	*error_term = error_tuple( env, "Unsupported cell type" ) ;
+	return false ;
+  }
+
+  *type = get_cell_type( mem_type_id ) ;
+
+  if ( *type == UNKNOWN_TYPE )
+  {
+	*error_term = error_tuple( env, "Unsupported cell type for list reading" ) ;
+	return false ;
+  }
+
+  hssize_t selected_count = get_selected_count( dataset_id,
+	file_dataspace_id ) ;
+
+  if ( selected_count < 0 )
+  {
+	*error_term = error_tuple( env,
+	  "Cannot determine the size of the selection" ) ;
+	return false ;
+  }
+
+  *element_count = selected_count ;
+  *buffer = NULL ;
+
+  if ( selected_count == 0 )
+	return true ;
+
+  *buffer = enif_alloc( selected_count * H5Tget_size( mem_type_id ) ) ;
+
+  if ( ! *buffer )
+  {
+	*error_term = error_tuple( env,
+	  "Cannot allocate intermediate array memory" ) ;
+	return false ;
+  }
+
+  if ( ! read_buffer_from_dataset( dataset_id, mem_type_id, selected_count,
+	  *buffer, file_dataspace_id ) )
+  {
+	enif_free( *buffer ) ;
+	*error_term = error_tuple( env, "Failed to read dataset" ) ;
+	return false ;
+  }
+
+  return true ;
+
+}
+
+
+
+/*
+ * Reads the cells selected by specified file dataspace (or the full dataset,
+ * if 'H5S_ALL' is specified) from specified dataset, and returns them as a
+ * flat list, in the order of the selection.
+ *
+ * Only the selected elements are read from the file, hence the cost of this
+ * call depends on the size of the selection, not on the one of the dataset.
+ *
+ * Supported memory types are the numeric ones (see convert_type/2).
+ *
+ * -spec h5dread( dataset_handle(), dataspace_handle() | 'H5S_ALL',
+ *                datatype_name() ) -> { 'ok', [ integer() | float() ] } |
+ *                                     error().
+ *
+ */
+ERL_NIF_TERM h5dread( ErlNifEnv* env, int argc, const ERL_NIF_TERM argv[] )
+{
+
+  if ( argc != 3 )
+	return error_tuple( env, "Incorrect number of arguments" ) ;
+
+  cell_type type ;
+  void * buffer ;
+  hsize_t selected_count ;
+  ERL_NIF_TERM error_term ;
+
+  if ( ! read_selection( env, argv, &type, &buffer, &selected_count,
+	  &error_term ) )
+	return error_term ;
+
+  if ( selected_count == 0 )
+	return enif_make_tuple2( env, atom_ok, enif_make_list( env, 0 ) ) ;
+
+  ERL_NIF_TERM ret = make_cell_list( env, type, buffer, 0, selected_count,
+	enif_make_list( env, 0 ) ) ;
+
+  enif_free( buffer ) ;
 
   return enif_make_tuple2( env, atom_ok, ret ) ;
 
+}
+
+
+
+/*
+ * Extends specified (extendible) dataset along its first dimension by
+ * specified number of rows, and returns (in tail_dataspace_id, to be closed by
+ * the caller) a file dataspace selecting exactly these new rows, and (in
+ * row_cells) the number of cells per row.
+ *
+ * old_rows is set to the number of rows before the extension, so that it can
+ * be restored if needed.
+ *
+ * Returns NULL on success, otherwise an error message.
+ *
+ */
+const char * extend_dataset( hid_t dataset_id, hsize_t new_rows,
+  hid_t* tail_dataspace_id, hsize_t* row_cells, hsize_t* old_rows )
+{
+
+  hid_t space_id = H5Dget_space( dataset_id ) ;
+
+  if ( space_id < 0 )
+	return "Cannot get dataset dataspace" ;
+
+  int rank = H5Sget_simple_extent_ndims( space_id ) ;
+
+  hsize_t dims[ H5S_MAX_RANK ] ;
+
+  if ( rank <= 0 || H5Sget_simple_extent_dims( space_id, dims, NULL ) < 0 )
+  {
+	H5Sclose( space_id ) ;
+	return "Cannot get dataset dimensions" ;
+  }
+
+  H5Sclose( space_id ) ;
+
+  *old_rows = dims[0] ;
+
+  *row_cells = 1 ;
+
+  int i ;
+
+  for ( i = 1; i < rank; i++ )
+	*row_cells *= dims[i] ;
+
+  dims[0] += new_rows ;
+
+  if ( H5Dset_extent( dataset_id, dims ) < 0 )
+	return "Cannot extend dataset (not chunked, or maximum size reached?)" ;
+
+  // Selects the newly-added rows in the extended dataspace:
+  space_id = H5Dget_space( dataset_id ) ;
+
+  if ( space_id < 0 )
+	return "Cannot get extended dataset dataspace" ;
+
+  hsize_t start[ H5S_MAX_RANK ] ;
+  hsize_t count[ H5S_MAX_RANK ] ;
+
+  start[0] = *old_rows ;
+  count[0] = new_rows ;
+
+  for ( i = 1; i < rank; i++ )
+  {
+	start[i] = 0 ;
+	count[i] = dims[i] ;
+  }
+
+  if ( H5Sselect_hyperslab( space_id, H5S_SELECT_SET, start, NULL, count,
+	  NULL ) < 0 )
+  {
+	H5Sclose( space_id ) ;
+	return "Cannot select the new rows" ;
+  }
+
+  *tail_dataspace_id = space_id ;
+
+  return NULL ;
+
+}
+
+
+
+// Restores the number of rows of specified dataset, after a failed append.
+void shrink_dataset( hid_t dataset_id, hsize_t rows )
+{
+
+  hid_t space_id = H5Dget_space( dataset_id ) ;
+
+  if ( space_id < 0 )
+	return ;
+
+  hsize_t dims[ H5S_MAX_RANK ] ;
+
+  if ( H5Sget_simple_extent_dims( space_id, dims, NULL ) >= 0 )
+  {
+	dims[0] = rows ;
+	H5Dset_extent( dataset_id, dims ) ;
+  }
+
+  H5Sclose( space_id ) ;
+
+}
+
+
+
+/*
+ * Appends specified rows at the end (along the first dimension) of specified
+ * extendible dataset, i.e. extends it and writes these rows in the new tail,
+ * in a single call whose cost depends only on the number of appended rows.
+ *
+ * Rows are specified like for h5dwrite/2: as a list of cells for a
+ * monodimensional dataset, or as a list of tuples (one per row) otherwise.
+ *
+ * -spec h5dappend( dataset_handle(), data() ) -> 'ok' | error().
+ *
+ */
+ERL_NIF_TERM h5dappend( ErlNifEnv* env, int argc, const ERL_NIF_TERM argv[] )
+{
+
+  if ( argc != 2 )
+	return error_tuple( env, "Incorrect number of arguments" ) ;
+
+  Handle * dataset ;
+
+  if ( ! get_handle( env, argv[0], DATASET_HANDLE, &dataset )
+	|| dataset->id < 0 )
+	return error_tuple( env, "Cannot get dataset handle from argv" ) ;
+
+  hid_t dataset_id = dataset->id ;
+
+  ERL_NIF_TERM data_list = argv[1] ;
+
+  struct DataDescriptor detected_desc ;
+
+  if ( ! detect_type( data_list, env, &detected_desc ) )
+	return detected_desc.error_term ;
+
+  // Decoded first, as the number of rows is needed to extend the dataset:
+  void * buffer ;
+  hsize_t element_count ;
+
+  const char * error = decode_data_list( env, dataset->cells, &detected_desc,
+	data_list, &buffer, &element_count ) ;
+
+  if ( error )
+	return error_tuple( env, (char *) error ) ;
+
+  hsize_t given_row_cells = ( detected_desc.tuple_size == 0 ) ?
+	1 : detected_desc.tuple_size ;
+
+  hid_t tail_dataspace_id ;
+  hsize_t row_cells ;
+  hsize_t old_rows ;
+
+  error = extend_dataset( dataset_id, element_count / given_row_cells,
+	&tail_dataspace_id, &row_cells, &old_rows ) ;
+
+  if ( error )
+  {
+	enif_free( buffer ) ;
+	return error_tuple( env, (char *) error ) ;
+  }
+
+  if ( row_cells != given_row_cells )
+  {
+	enif_free( buffer ) ;
+	H5Sclose( tail_dataspace_id ) ;
+	shrink_dataset( dataset_id, old_rows ) ;
+	return error_tuple( env, "Row size does not match the dataset" ) ;
+  }
+
+  ERL_NIF_TERM res = write_buffer_to_dataset( dataset, env,
+	get_native_cell_type( dataset->cells ), element_count, buffer,
+	tail_dataspace_id, old_rows ) ;
+
+  enif_free( buffer ) ;
+
+  H5Sclose( tail_dataspace_id ) ;
+
+  // Only if the rows could not be written (not on a zone map failure):
+  if ( res != atom_ok )
+	shrink_dataset( dataset_id, old_rows ) ;
+
+  return res ;
+
+}
+
+
+
+/*
+ * Appends specified rows, packed in a binary of cells of the specified
+ * (memory) type, at the end of specified extendible dataset (see h5dappend/2).
+ *
+ * -spec h5dappend_binary( dataset_handle(), datatype_name(), binary() ) ->
+ *                         'ok' | error().
+ *
+ */
+ERL_NIF_TERM h5dappend_binary( ErlNifEnv* env, int argc,
+  const ERL_NIF_TERM argv[] )
+{
+
+  if ( argc != 3 )
+	return error_tuple( env, "Incorrect number of arguments" ) ;
+
+  Handle * dataset ;
+
+  if ( ! get_handle( env, argv[0], DATASET_HANDLE, &dataset )
+	|| dataset->id < 0 )
+	return error_tuple( env, "Cannot get dataset handle from argv" ) ;
+
+  hid_t dataset_id = dataset->id ;
+
+  char type_name[ MAXBUFLEN ] ;
+
+  if ( ! enif_get_atom( env, argv[1], type_name, sizeof( type_name ),
+	  ERL_NIF_LATIN1 ) )
+	return error_tuple( env, "Cannot get cell type from argv" ) ;
+
+  hid_t mem_type_id ;
+
+  if ( convert_type( type_name, &mem_type_id ) )
+	return error_tuple( env, "Unsupported cell type" ) ;
+
+  ErlNifBinary data ;
+
+  if ( ! enif_inspect_binary( env, argv[2], &data ) )
+	return error_tuple( env, "Cannot get binary data from argv" ) ;
+
+  size_t cell_size = H5Tget_size( mem_type_id ) ;
+
+  if ( cell_size == 0 || data.size == 0 || data.size % cell_size != 0 )
+	return error_tuple( env,
+	  "Binary size is not a (non-null) multiple of the cell size" ) ;
+
+  hsize_t cell_count = data.size / cell_size ;
+
+  // Determines first the size of a row, to know how many rows are appended:
+  hid_t space_id = H5Dget_space( dataset_id ) ;
+
+  if ( space_id < 0 )
+	return error_tuple( env, "Cannot get dataset dataspace" ) ;
+
+  int rank = H5Sget_simple_extent_ndims( space_id ) ;
+
+  hsize_t dims[ H5S_MAX_RANK ] ;
+
+  if ( rank <= 0 || H5Sget_simple_extent_dims( space_id, dims, NULL ) < 0 )
+  {
+	H5Sclose( space_id ) ;
+	return error_tuple( env, "Cannot get dataset dimensions" ) ;
+  }
+
+  H5Sclose( space_id ) ;
+
+  hsize_t row_cells = 1 ;
+
+  int i ;
+
+  for ( i = 1; i < rank; i++ )
+	row_cells *= dims[i] ;
+
+  if ( row_cells == 0 || cell_count % row_cells != 0 )
+	return error_tuple( env, "Binary does not contain whole rows" ) ;
+
+  hid_t tail_dataspace_id ;
+  hsize_t old_rows ;
+
+  const char * error = extend_dataset( dataset_id, cell_count / row_cells,
+	&tail_dataspace_id, &row_cells, &old_rows ) ;
+
+  if ( error )
+	return error_tuple( env, (char *) error ) ;
+
+  ERL_NIF_TERM res = write_buffer_to_dataset( dataset, env, mem_type_id,
+	cell_count, data.data, tail_dataspace_id, old_rows ) ;
+
+  H5Sclose( tail_dataspace_id ) ;
+
+  // Only if the rows could not be written (not on a zone map failure):
+  if ( res != atom_ok )
+	shrink_dataset( dataset_id, old_rows ) ;
+
+  return res ;
+
+}
+
+
+
+/*
+ * Flushes all the buffers of specified dataset to disk, so that, in SWMR mode,
+ * readers can see the rows written so far. Requires HDF5 1.10 or later.
+ *
+ * -spec h5dflush( dataset_handle() ) -> 'ok' | error().
+ *
+ */
+ERL_NIF_TERM h5dflush( ErlNifEnv* env, int argc, const ERL_NIF_TERM argv[] )
+{
+
+#if H5_VERSION_GE(1,10,0)
+
+  hid_t ds_id ;
+
+  check( argc == 1, "Incorrect number of arguments" ) ;
+
+  check( get_handle_id( env, argv[0], DATASET_HANDLE, &ds_id ),
+	"Cannot get dataset handle from argv" ) ;
+
+  check( H5Dflush( ds_id ) >= 0, "Failed to flush dataset." ) ;
+
+  return atom_ok ;
+
+ error:
+  return error_tuple( env, "Cannot flush dataset" ) ;
+
+#else
+
+  return error_tuple( env, "Flushing datasets requires HDF5 1.10 or later" ) ;
+
+#endif
+
+}
+
+
+
+/*
+ * Refreshes the metadata of specified dataset (typically opened by a SWMR
+ * reader), so that rows appended by the writer since the dataset was opened
+ * (or last refreshed) become visible, with no need to reopen the file.
+ * Requires HDF5 1.10 or later.
+ *
+ * -spec h5drefresh( dataset_handle() ) -> 'ok' | error().
+ *
+ */
+ERL_NIF_TERM h5drefresh( ErlNifEnv* env, int argc, const ERL_NIF_TERM argv[] )
+{
+
+#if H5_VERSION_GE(1,10,0)
+
+  hid_t ds_id ;
+
+  check( argc == 1, "Incorrect number of arguments" ) ;
+
+  check( get_handle_id( env, argv[0], DATASET_HANDLE, &ds_id ),
+	"Cannot get dataset handle from argv" ) ;
+
+  check( H5Drefresh( ds_id ) >= 0, "Failed to refresh dataset." ) ;
+
+  return atom_ok ;
+
+ error:
+  return error_tuple( env, "Cannot refresh dataset" ) ;
+
+#else
+
+  return error_tuple( env,
+	"Refreshing datasets requires HDF5 1.10 or later" ) ;
+
+#endif
+
+}
+
+
+
+// Returns an identifier for a copy of the dataspace for a dataset.
+ERL_NIF_TERM h5dget_space( ErlNifEnv* env, int argc, const ERL_NIF_TERM argv[] )
+{
+
+  // Parses arguments
+  check( argc == 1, "Incorrect number of arguments" ) ;
+
+  hid_t dataset_id ;
+
+  check( get_handle_id( env, argv[0], DATASET_HANDLE, &dataset_id ),
+	"Cannot get dataset resource from argv" ) ;
+
+  hid_t space_id = H5Dget_space( dataset_id ) ;
+
+  check( space_id >= 0, "Failed to get space." ) ;
+
+  return make_handle( env, DATASPACE_HANDLE, space_id ) ;
+
  error:
   return error_tuple( env, "Cannot get space id" ) ;
 
@@ -0,0 +1,1102 @@
+/* This file is part of erlhdf5 */
+
+/* erlhdf5 is free software: you can redistribute it and/or modify */
+/* it under the terms of the GNU Lesser General Public License as */
+/* published by the Free Software Foundation, either version 3 of */
+/* the License, or (at your option) any later version. */
+
+/* erlhdf5 is distributed in the hope that it will be useful, */
+/* but WITHOUT ANY WARRANTY; without even the implied warranty of */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the */
+/* GNU Lesser General Public License for more details. */
+
+/* You should have received a copy of the GNU Lesser General Public */
+/* License along with erlhdf5.  If not, see */
+/* <http://www.gnu.org/licenses/>. */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+// For nanosleep:
+#include <time.h>
+
+#include "hdf5.h"
+
+#include "erl_nif.h"
+
+#include "dbg.h"
+
+#include "erlhdf5.h"
+
+
+/*
+ * Write-behind append buffers.
+ *
+ * Many processes appending small batches of rows to the same dataset would
+ * otherwise each trigger an extension of the dataset and an H5Dwrite with its
+ * own selection (hence, on chunked and compressed datasets, as many chunk
+ * rewrites).
+ *
+ * An append buffer (h5d_create_buffer/4) instead accumulates the appended rows
+ * in a contiguous in-memory block, without taking the HDF5 lock; this block is
+ * written in a single extension and hyperslab write once a threshold (in rows
+ * or in bytes) is reached, once its oldest row has waited for the maximum
+ * delay of the buffer, or when explicitly flushed (h5d_flush_buffer/1).
+ *
+ * Flushes hold the HDF5 lock while swapping the block with a spare one and
+ * writing it, so that blocks are written in the order they were filled, and
+ * appenders are only blocked for the swap.
+ *
+ * Delays are enforced by a flusher thread, checking periodically the buffers
+ * having pending rows; such a buffer is kept referenced by the flusher until
+ * flushed, so that its rows cannot be lost if the buffer is garbage-collected
+ * meanwhile.
+ *
+ */
+
+
+// Period, in milliseconds, at which the flusher checks the pending buffers:
+#define FLUSHER_TICK_MSEC 10
+
+// Maximum delay meaning that only the threshold and explicit flushes apply:
+#define NO_MAX_DELAY -1
+
+// Maximum number of cells decoded from a list on a normal scheduler:
+#define SCHEDULER_DECODE_CELLS 4096
+
+// Maximum size of a binary of rows copied on a normal scheduler:
+#define SCHEDULER_COPY_BYTES ( 1024 * 1024 )
+
+
+typedef struct AppendBuffer
+{
+
+  // The target (extendible) dataset, kept referenced for as long as this
+  // buffer exists:
+  Handle * dataset ;
+
+  // Type of the cells, and their size:
+  cell_type type ;
+  size_t cell_size ;
+
+  // Number of cells per row:
+  hsize_t row_cells ;
+
+  // Number of buffered cells triggering a flush:
+  hsize_t max_cells ;
+
+  // Maximum delay (in milliseconds) before a buffered row is written, or
+  // NO_MAX_DELAY:
+  ErlNifTime max_delay ;
+
+  // Protects all the fields below:
+  ErlNifMutex * mutex ;
+
+  // The block being filled, its capacity and its number of cells:
+  void * block ;
+  hsize_t capacity ;
+  hsize_t cells ;
+
+  // A block left by the last flush, reused by the next one:
+  void * spare ;
+  hsize_t spare_capacity ;
+
+  // Statistics, for h5d_buffer_info/1:
+  unsigned long flushes ;
+  hsize_t written_rows ;
+  hsize_t failed_rows ;
+
+  // Whether this buffer is referenced by the flusher (then its deadline, and
+  // its links in the list of the flusher, are protected by flusher_mutex):
+  bool registered ;
+  ErlNifTime deadline ;
+  struct AppendBuffer * previous ;
+  struct AppendBuffer * next ;
+
+} AppendBuffer ;
+
+
+static ErlNifResourceType * append_buffer_type = NULL ;
+
+
+// The buffers having pending rows and a maximum delay:
+static AppendBuffer * pending_buffers = NULL ;
+
+static ErlNifMutex * flusher_mutex = NULL ;
+
+static bool flusher_stop_requested = false ;
+
+static bool flusher_running = false ;
+
+static ErlNifTid flusher_tid ;
+
+
+static ERL_NIF_TERM atom_rows ;
+static ERL_NIF_TERM atom_bytes ;
+
+
+static ERL_NIF_TERM append_large_rows( ErlNifEnv* env, int argc,
+  const ERL_NIF_TERM argv[] ) ;
+
+
+
+/*
+ * Appends specified block of rows (of specified cells) to specified dataset,
+ * the HDF5 lock being held.
+ *
+ * Returns NULL on success, otherwise an error message (the rows could then not
+ * be written, and the dataset is left with its previous rows).
+ *
+ */
+static const char * write_rows( Handle* dataset, cell_type type,
+  hsize_t row_cells, const void* block, hsize_t cells )
+{
+
+  hid_t dataset_id = dataset->id ;
+
+  if ( dataset_id < 0 )
+	return "Dataset of the buffer already closed" ;
+
+  hid_t tail_dataspace_id = -1 ;
+  hsize_t dataset_row_cells ;
+  hsize_t old_rows ;
+
+  const char * error = extend_dataset( dataset_id, cells / row_cells,
+	&tail_dataspace_id, &dataset_row_cells, &old_rows ) ;
+
+  if ( error )
+	return error ;
+
+  if ( dataset_row_cells != row_cells )
+	error = "Row size of the dataset changed" ;
+  else
+  {
+
+	hid_t mem_dataspace_id = H5Screate_simple( /* rank */ 1, &cells,
+	  /* max dims */ NULL ) ;
+
+	if ( mem_dataspace_id < 0 )
+	  error = "Cannot create a memory dataspace" ;
+	else
+	{
+
+	  hid_t mem_type_id = get_native_cell_type( type ) ;
+
+	  herr_t status = H5Dwrite( dataset_id, mem_type_id, mem_dataspace_id,
+		tail_dataspace_id, H5P_DEFAULT, block ) ;
+
+	  // A failed update of the zone map does not fail the write:
+	  update_zone_map( dataset, tail_dataspace_id, old_rows, mem_type_id,
+		block, /* written */ status >= 0 ) ;
+
+	  if ( status < 0 )
+		error = "Failed to write buffered rows into dataset" ;
+
+	}
+
+	if ( mem_dataspace_id >= 0 )
+	  H5Sclose( mem_dataspace_id ) ;
+
+  }
+
+  H5Sclose( tail_dataspace_id ) ;
+
+  if ( error )
+	shrink_dataset( dataset_id, old_rows ) ;
+
+  return error ;
+
+}
+
+
+
+/*
+ * Writes the buffered rows of specified buffer, if any, the HDF5 lock being
+ * held.
+ *
+ * Sets *unregistered to true if the reference that the flusher had on the
+ * buffer is to be released by the caller (once done with the buffer).
+ *
+ * Returns NULL on success, otherwise an error message (the rows of the block
+ * are then lost).
+ *
+ */
+static const char * flush_buffer( AppendBuffer * buffer, bool * unregistered )
+{
+
+  enif_mutex_lock( buffer->mutex ) ;
+
+  void * block = buffer->block ;
+  hsize_t capacity = buffer->capacity ;
+  hsize_t cells = buffer->cells ;
+
+  if ( cells > 0 )
+  {
+
+	buffer->block = buffer->spare ;
+	buffer->capacity = buffer->spare_capacity ;
+	buffer->cells = 0 ;
+
+	buffer->spare = NULL ;
+	buffer->spare_capacity = 0 ;
+
+  }
+
+  if ( buffer->registered )
+  {
+
+	enif_mutex_lock( flusher_mutex ) ;
+
+	if ( buffer->previous )
+	  buffer->previous->next = buffer->next ;
+	else
+	  pending_buffers = buffer->next ;
+
+	if ( buffer->next )
+	  buffer->next->previous = buffer->previous ;
+
+	enif_mutex_unlock( flusher_mutex ) ;
+
+	buffer->registered = false ;
+	*unregistered = true ;
+
+  }
+
+  enif_mutex_unlock( buffer->mutex ) ;
+
+  if ( cells == 0 )
+	return NULL ;
+
+  // Appenders may now go on filling the other block:
+
+  hsize_t rows = cells / buffer->row_cells ;
+
+  const char * error = write_rows( buffer->dataset, buffer->type,
+	buffer->row_cells, block, cells ) ;
+
+  enif_mutex_lock( buffer->mutex ) ;
+
+  buffer->flushes++ ;
+
+  if ( error )
+	buffer->failed_rows += rows ;
+  else
+	buffer->written_rows += rows ;
+
+  // Keeps the written block as spare, unless one was already left meanwhile:
+  if ( ! buffer->spare )
+  {
+	buffer->spare = block ;
+	buffer->spare_capacity = capacity ;
+	block = NULL ;
+  }
+
+  enif_mutex_unlock( buffer->mutex ) ;
+
+  if ( block )
+	enif_free( block ) ;
+
+  return error ;
+
+}
+
+
+
+// Rows left in a garbage-collected buffer, written by the executor:
+typedef struct
+{
+
+  // The target dataset, whose reference is transferred from the buffer:
+  Handle * dataset ;
+
+  cell_type type ;
+  hsize_t row_cells ;
+
+  void * block ;
+  hsize_t cells ;
+
+} FinalFlush ;
+
+
+
+/*
+ * Writes the rows left in a garbage-collected buffer, the HDF5 lock being held
+ * (as an executor task, see append_buffer_destructor/2).
+ *
+ */
+static void write_final_flush( void* arg )
+{
+
+  FinalFlush * flush = (FinalFlush *) arg ;
+
+  write_rows( flush->dataset, flush->type, flush->row_cells, flush->block,
+	flush->cells ) ;
+
+  // Any close of the dataset is then deferred, as the HDF5 lock is held:
+  enif_release_resource( flush->dataset ) ;
+
+  enif_free( flush->block ) ;
+  enif_free( flush ) ;
+
+}
+
+
+
+// Called whenever an append buffer is garbage-collected.
+static void append_buffer_destructor( ErlNifEnv* env, void* obj )
+{
+
+  AppendBuffer * buffer = (AppendBuffer *) obj ;
+
+  /*
+   * Being registered to the flusher, a buffer with a maximum delay cannot be
+   * collected before its pending rows are written (unless the flusher has
+   * been stopped); otherwise the pending rows are handed over, with the
+   * reference to the dataset, to the executor, as no HDF5 I/O shall be done
+   * from the (typically scheduler) thread running this destructor.
+   *
+   */
+  FinalFlush * flush = ( buffer->cells > 0 && buffer->dataset ) ?
+	enif_alloc( sizeof( FinalFlush ) ) : NULL ;
+
+  if ( flush )
+  {
+
+	flush->dataset = buffer->dataset ;
+	flush->type = buffer->type ;
+	flush->row_cells = buffer->row_cells ;
+	flush->block = buffer->block ;
+	flush->cells = buffer->cells ;
+
+	buffer->dataset = NULL ;
+	buffer->block = NULL ;
+
+	if ( ! submit_task_job( write_final_flush, flush ) )
+	{
+
+	  // Executor already stopped (unloading), hence no concurrent HDF5 call:
+	  hdf5_lock() ;
+	  write_final_flush( flush ) ;
+	  hdf5_unlock() ;
+
+	}
+
+  }
+
+  if ( buffer->block )
+	enif_free( buffer->block ) ;
+
+  if ( buffer->spare )
+	enif_free( buffer->spare ) ;
+
+  if ( buffer->mutex )
+	enif_mutex_destroy( buffer->mutex ) ;
+
+  if ( buffer->dataset )
+	enif_release_resource( buffer->dataset ) ;
+
+}
+
+
+
+/*
+ * Main loop of the flusher thread: writes the buffers whose oldest pending row
+ * has waited for their maximum delay.
+ *
+ */
+static void * flusher_loop( void * arg )
+{
+
+  struct timespec tick = { 0, FLUSHER_TICK_MSEC * 1000000L } ;
+
+  while ( true )
+  {
+
+	nanosleep( &tick, NULL ) ;
+
+	while ( true )
+	{
+
+	  enif_mutex_lock( flusher_mutex ) ;
+
+	  if ( flusher_stop_requested )
+	  {
+		enif_mutex_unlock( flusher_mutex ) ;
+		return NULL ;
+	  }
+
+	  ErlNifTime now = enif_monotonic_time( ERL_NIF_MSEC ) ;
+
+	  AppendBuffer * due = pending_buffers ;
+
+	  while ( due && due->deadline > now )
+		due = due->next ;
+
+	  // Registered, hence still referenced; kept for the flush:
+	  if ( due )
+		enif_keep_resource( due ) ;
+
+	  enif_mutex_unlock( flusher_mutex ) ;
+
+	  if ( ! due )
+		break ;
+
+	  bool unregistered = false ;
+
+	  hdf5_lock() ;
+	  flush_buffer( due, &unregistered ) ;
+	  hdf5_unlock() ;
+
+	  if ( unregistered )
+		enif_release_resource( due ) ;
+
+	  enif_release_resource( due ) ;
+
+	}
+
+  }
+
+}
+
+
+
+/*
+ * Opens the resource types used by the append buffers, and starts their
+ * flusher thread.
+ *
+ * Returns 0 on success, -1 on failure.
+ *
+ */
+int open_buffer_resource_types( ErlNifEnv* env )
+{
+
+  append_buffer_type = enif_open_resource_type( env, "erlhdf5",
+	"AppendBuffer", append_buffer_destructor,
+	ERL_NIF_RT_CREATE | ERL_NIF_RT_TAKEOVER, NULL ) ;
+
+  if ( ! append_buffer_type )
+	return -1 ;
+
+  atom_rows = enif_make_atom( env, "rows" ) ;
+  atom_bytes = enif_make_atom( env, "bytes" ) ;
+
+  flusher_mutex = enif_mutex_create( "erlhdf5_flusher" ) ;
+
+  if ( ! flusher_mutex )
+	return -1 ;
+
+  flusher_stop_requested = false ;
+
+  if ( enif_thread_create( "erlhdf5_flusher", &flusher_tid, flusher_loop,
+	  NULL, NULL ) != 0 )
+	return -1 ;
+
+  flusher_running = true ;
+
+  return 0 ;
+
+}
+
+
+
+/*
+ * Stops the flusher thread, and releases the buffers it was still keeping
+ * (their pending rows are then written when they are explicitly flushed, or
+ * when they are garbage-collected).
+ *
+ */
+void buffer_flusher_stop()
+{
+
+  if ( ! flusher_running )
+	return ;
+
+  enif_mutex_lock( flusher_mutex ) ;
+  flusher_stop_requested = true ;
+  enif_mutex_unlock( flusher_mutex ) ;
+
+  enif_thread_join( flusher_tid, NULL ) ;
+
+  flusher_running = false ;
+
+  while ( true )
+  {
+
+	enif_mutex_lock( flusher_mutex ) ;
+
+	AppendBuffer * buffer = pending_buffers ;
+
+	// Registered, hence still referenced; kept while being unregistered:
+	if ( buffer )
+	  enif_keep_resource( buffer ) ;
+
+	enif_mutex_unlock( flusher_mutex ) ;
+
+	if ( ! buffer )
+	  break ;
+
+	// Same lock order as flush_buffer/2, which may unregister it meanwhile:
+	enif_mutex_lock( buffer->mutex ) ;
+
+	bool unregistered = buffer->registered ;
+
+	if ( unregistered )
+	{
+
+	  enif_mutex_lock( flusher_mutex ) ;
+
+	  if ( buffer->previous )
+		buffer->previous->next = buffer->next ;
+	  else
+		pending_buffers = buffer->next ;
+
+	  if ( buffer->next )
+		buffer->next->previous = buffer->previous ;
+
+	  enif_mutex_unlock( flusher_mutex ) ;
+
+	  buffer->registered = false ;
+
+	}
+
+	enif_mutex_unlock( buffer->mutex ) ;
+
+	if ( unregistered )
+	  enif_release_resource( buffer ) ;
+
+	enif_release_resource( buffer ) ;
+
+  }
+
+}
+
+
+
+/*
+ * Creates a write-behind buffer appending rows at the end (along the first
+ * dimension) of specified extendible dataset, as cells of specified type.
+ *
+ * The buffered rows are written once the threshold, {'rows', Count} or
+ * {'bytes', Size}, is reached, or once the oldest of them has waited for
+ * MaxDelay milliseconds (unless it is 'infinity').
+ *
+ * -spec h5d_create_buffer( dataset_handle(), CellType::datatype_name(),
+ *                          Threshold::buffer_threshold(),
+ *                          MaxDelay::non_neg_integer() | 'infinity' ) ->
+ *                                 { 'ok', append_buffer() } | error().
+ *
+ */
+ERL_NIF_TERM h5d_create_buffer( ErlNifEnv* env, int argc,
+  const ERL_NIF_TERM argv[] )
+{
+
+  if ( argc != 4 )
+	return error_tuple( env, "Incorrect number of arguments" ) ;
+
+  Handle * dataset ;
+
+  if ( ! get_handle( env, argv[0], DATASET_HANDLE, &dataset )
+	|| dataset->id < 0 )
+	return error_tuple( env, "Cannot get dataset handle from argv" ) ;
+
+  char type_name[ MAXBUFLEN ] ;
+
+  if ( ! enif_get_atom( env, argv[1], type_name, sizeof( type_name ),
+	  ERL_NIF_LATIN1 ) )
+	return error_tuple( env, "Cannot get cell type from argv" ) ;
+
+  hid_t mem_type_id ;
+
+  if ( convert_type( type_name, &mem_type_id ) )
+	return error_tuple( env, "Unsupported cell type" ) ;
+
+  cell_type type = get_cell_type( mem_type_id ) ;
+
+  if ( type == UNKNOWN_TYPE )
+	return error_tuple( env, "Unsupported cell type for an append buffer" ) ;
+
+  int arity ;
+  const ERL_NIF_TERM * threshold ;
+  hsize_t threshold_value ;
+
+  if ( ! enif_get_tuple( env, argv[2], &arity, &threshold ) || arity != 2
+	|| ! get_hsize( env, threshold[1], &threshold_value )
+	|| threshold_value == 0
+	|| ! ( enif_is_identical( threshold[0], atom_rows )
+	  || enif_is_identical( threshold[0], atom_bytes ) ) )
+	return error_tuple( env, "Cannot get threshold from argv" ) ;
+
+  ErlNifSInt64 max_delay = NO_MAX_DELAY ;
+  char delay_atom[ 16 ] ;
+
+  if ( ! ( enif_get_int64( env, argv[3], &max_delay ) && max_delay >= 0 )
+	&& ! ( enif_get_atom( env, argv[3], delay_atom, sizeof( delay_atom ),
+		ERL_NIF_LATIN1 ) && strcmp( delay_atom, "infinity" ) == 0 ) )
+	return error_tuple( env, "Cannot get maximum delay from argv" ) ;
+
+  // Rows are appended along the first dimension:
+  hid_t space_id = H5Dget_space( dataset->id ) ;
+
+  if ( space_id < 0 )
+	return error_tuple( env, "Cannot get the dataspace of the dataset" ) ;
+
+  hsize_t dims[ H5S_MAX_RANK ] ;
+  hsize_t maxdims[ H5S_MAX_RANK ] ;
+
+  int rank = H5Sget_simple_extent_dims( space_id, dims, maxdims ) ;
+
+  H5Sclose( space_id ) ;
+
+  if ( rank < 1 )
+	return error_tuple( env, "Cannot get the dimensions of the dataset" ) ;
+
+  if ( maxdims[0] != H5S_UNLIMITED && maxdims[0] <= dims[0] )
+	return error_tuple( env,
+	  "Dataset not extendible along its first dimension" ) ;
+
+  hsize_t row_cells = 1 ;
+
+  int i ;
+
+  for ( i = 1; i < rank; i++ )
+	row_cells *= dims[i] ;
+
+  if ( row_cells == 0 )
+	return error_tuple( env, "Empty rows" ) ;
+
+  size_t cell_size = get_cell_size( type ) ;
+
+  hsize_t max_rows = threshold_value ;
+
+  if ( enif_is_identical( threshold[0], atom_bytes ) )
+  {
+
+	max_rows = threshold_value / ( row_cells * cell_size ) ;
+
+	if ( max_rows == 0 )
+	  max_rows = 1 ;
+
+  }
+
+  AppendBuffer * buffer = enif_alloc_resource( append_buffer_type,
+	sizeof( AppendBuffer ) ) ;
+
+  if ( ! buffer )
+	return error_tuple( env, "Cannot allocate append buffer" ) ;
+
+  memset( buffer, 0, sizeof( AppendBuffer ) ) ;
+
+  buffer->mutex = enif_mutex_create( "erlhdf5_append_buffer" ) ;
+
+  if ( ! buffer->mutex )
+  {
+	enif_release_resource( buffer ) ;
+	return error_tuple( env, "Cannot create the lock of the append buffer" ) ;
+  }
+
+  enif_keep_resource( dataset ) ;
+  buffer->dataset = dataset ;
+
+  buffer->type = type ;
+  buffer->cell_size = cell_size ;
+  buffer->row_cells = row_cells ;
+  buffer->max_cells = max_rows * row_cells ;
+  buffer->max_delay = max_delay ;
+
+  ERL_NIF_TERM buffer_term = enif_make_resource( env, buffer ) ;
+
+  enif_release_resource( buffer ) ;
+
+  return enif_make_tuple2( env, atom_ok, buffer_term ) ;
+
+}
+
+
+
+/*
+ * Ensures that the block being filled in specified buffer (whose lock is held)
+ * can hold specified number of cells.
+ *
+ * Returns whether the operation succeeded.
+ *
+ */
+static bool reserve_cells( AppendBuffer * buffer, hsize_t cells )
+{
+
+  if ( cells <= buffer->capacity && buffer->block )
+	return true ;
+
+  // The size of the block in bytes must not wrap:
+  hsize_t max_capacity = SIZE_MAX / buffer->cell_size ;
+
+  if ( cells > max_capacity )
+	return false ;
+
+  hsize_t capacity = ( buffer->capacity > 0 ) ? buffer->capacity : cells ;
+
+  while ( capacity < cells )
+	capacity = ( capacity > max_capacity / 2 ) ? max_capacity : capacity * 2 ;
+
+  void * block = enif_realloc( buffer->block, capacity * buffer->cell_size ) ;
+
+  if ( ! block )
+	return false ;
+
+  buffer->block = block ;
+  buffer->capacity = capacity ;
+
+  return true ;
+
+}
+
+
+
+/*
+ * Gets the rows specified by data (a list like for h5dappend/2, or a binary of
+ * packed rows), for specified buffer, without taking its lock: a binary is
+ * used as is, whereas a list is decoded into a private, newly-allocated block
+ * (*decoded, then to be freed by the caller).
+ *
+ * If bounded, *too_large is set (and nothing is to be freed) if the rows are
+ * too large to be handled on a normal scheduler.
+ *
+ * Returns NULL on success, otherwise an error message (then nothing is to be
+ * freed).
+ *
+ */
+static const char * get_rows( ErlNifEnv* env, const AppendBuffer * buffer,
+  ERL_NIF_TERM data, bool bounded, const void** rows, hsize_t* cells,
+  void** decoded, bool* too_large )
+{
+
+  *decoded = NULL ;
+  *too_large = false ;
+
+  hsize_t row_bytes = buffer->row_cells * buffer->cell_size ;
+
+  ErlNifBinary binary ;
+
+  if ( enif_inspect_binary( env, data, &binary ) )
+  {
+
+	if ( binary.size == 0 || binary.size % row_bytes != 0 )
+	  return "Binary size is not a multiple of the row size" ;
+
+	if ( bounded && binary.size > SCHEDULER_COPY_BYTES )
+	{
+	  *too_large = true ;
+	  return NULL ;
+	}
+
+	*rows = binary.data ;
+	*cells = binary.size / buffer->cell_size ;
+
+	return NULL ;
+
+  }
+
+  struct DataDescriptor desc ;
+
+  if ( ! detect_type( data, env, &desc ) )
+	return "Data is not a non-empty list" ;
+
+  if ( desc.tuple_size > 0 && (hsize_t) desc.tuple_size != buffer->row_cells )
+	return "Row size does not match the dataset" ;
+
+  hsize_t capacity = 0 ;
+  hsize_t index = 0 ;
+
+  const char * error = decode_cell_list( env, buffer->type, &data,
+	desc.tuple_size, decoded, &capacity, &index,
+	bounded ? SCHEDULER_DECODE_CELLS : (hsize_t) -1 ) ;
+
+  if ( ! error && ! enif_is_empty_list( env, data ) )
+	*too_large = true ;
+  else if ( ! error && index % buffer->row_cells != 0 )
+	error = "Partial row in appended data" ;
+
+  if ( error || *too_large )
+  {
+
+	if ( *decoded )
+	  enif_free( *decoded ) ;
+
+	*decoded = NULL ;
+
+	return error ;
+
+  }
+
+  *rows = *decoded ;
+  *cells = index ;
+
+  return NULL ;
+
+}
+
+
+
+// Flushes specified buffer (argv[0]) once its threshold has been reached.
+static ERL_NIF_TERM flush_reached_buffer( ErlNifEnv* env, int argc,
+  const ERL_NIF_TERM argv[] )
+{
+
+  AppendBuffer * buffer ;
+
+  if ( ! enif_get_resource( env, argv[0], append_buffer_type,
+	  (void**) &buffer ) )
+	return error_tuple( env, "Cannot get append buffer" ) ;
+
+  bool unregistered = false ;
+
+  hdf5_lock() ;
+  const char * error = flush_buffer( buffer, &unregistered ) ;
+  hdf5_unlock() ;
+
+  if ( unregistered )
+	enif_release_resource( buffer ) ;
+
+  return error ? error_tuple( env, (char *) error ) : atom_ok ;
+
+}
+
+
+
+/*
+ * Appends specified rows (argv[1]) to specified buffer (argv[0]); if bounded,
+ * rows too large to be handled on a normal scheduler are appended by a
+ * rescheduled, unbounded call, on a dirty CPU scheduler (when available).
+ *
+ */
+static ERL_NIF_TERM append_rows( ErlNifEnv* env, const ERL_NIF_TERM argv[],
+  bool bounded )
+{
+
+  AppendBuffer * buffer ;
+
+  if ( ! enif_get_resource( env, argv[0], append_buffer_type,
+	  (void**) &buffer ) )
+	return error_tuple( env, "Cannot get append buffer from argv" ) ;
+
+  const void * rows ;
+  hsize_t cells ;
+  void * decoded ;
+  bool too_large ;
+
+  // Decoded before taking the lock of the buffer, which flushes also take:
+  const char * error = get_rows( env, buffer, argv[1], bounded, &rows, &cells,
+	&decoded, &too_large ) ;
+
+  if ( error )
+	return error_tuple( env, (char *) error ) ;
+
+  if ( too_large )
+	return enif_schedule_nif( env, "h5d_buffer_append", ERLHDF5_DIRTY_CPU,
+	  append_large_rows, 2, argv ) ;
+
+  enif_mutex_lock( buffer->mutex ) ;
+
+  if ( ! reserve_cells( buffer, buffer->cells + cells ) )
+  {
+
+	enif_mutex_unlock( buffer->mutex ) ;
+
+	if ( decoded )
+	  enif_free( decoded ) ;
+
+	return error_tuple( env, "Cannot allocate append buffer memory" ) ;
+
+  }
+
+  bool was_empty = ( buffer->cells == 0 ) ;
+
+  memcpy( (char *) buffer->block + buffer->cells * buffer->cell_size, rows,
+	cells * buffer->cell_size ) ;
+
+  buffer->cells += cells ;
+
+  // The first pending row starts the delay, the flusher then keeping the buffer
+  // (unless it has been stopped, the library being unloaded):
+  if ( was_empty && buffer->max_delay != NO_MAX_DELAY && ! buffer->registered )
+  {
+
+	enif_mutex_lock( flusher_mutex ) ;
+
+	if ( ! flusher_stop_requested )
+	{
+
+	  enif_keep_resource( buffer ) ;
+
+	  buffer->deadline = enif_monotonic_time( ERL_NIF_MSEC )
+		+ buffer->max_delay ;
+
+	  buffer->previous = NULL ;
+	  buffer->next = pending_buffers ;
+
+	  if ( pending_buffers )
+		pending_buffers->previous = buffer ;
+
+	  pending_buffers = buffer ;
+
+	  buffer->registered = true ;
+
+	}
+
+	enif_mutex_unlock( flusher_mutex ) ;
+
+  }
+
+  bool reached = ( buffer->cells >= buffer->max_cells ) ;
+
+  enif_mutex_unlock( buffer->mutex ) ;
+
+  if ( decoded )
+	enif_free( decoded ) ;
+
+  if ( reached )
+	return enif_schedule_nif( env, "h5d_buffer_append", ERLHDF5_DIRTY_IO,
+	  flush_reached_buffer, 1, argv ) ;
+
+  return atom_ok ;
+
+}
+
+
+
+// Appends rows too large for a normal scheduler (see append_rows/3).
+static ERL_NIF_TERM append_large_rows( ErlNifEnv* env, int argc,
+  const ERL_NIF_TERM argv[] )
+{
+
+  return append_rows( env, argv, /* bounded */ false ) ;
+
+}
+
+
+
+/*
+ * Appends specified rows (as a list, like for h5dappend/2, or as a binary of
+ * packed rows) to specified buffer.
+ *
+ * The rows are only copied in memory (the HDF5 lock is not taken), unless the
+ * threshold of the buffer is reached, in which case the whole block is
+ * written (on a dirty I/O scheduler, when available), the result of that write
+ * being then returned.
+ *
+ * Only small lists and binaries are handled on the calling (normal) scheduler;
+ * larger ones are handled on a dirty CPU scheduler, when available.
+ *
+ * -spec h5d_buffer_append( append_buffer(), data() | binary() ) ->
+ *                          'ok' | error().
+ *
+ */
+ERL_NIF_TERM h5d_buffer_append( ErlNifEnv* env, int argc,
+  const ERL_NIF_TERM argv[] )
+{
+
+  if ( argc != 2 )
+	return error_tuple( env, "Incorrect number of arguments" ) ;
+
+  return append_rows( env, argv, /* bounded */ true ) ;
+
+}
+
+
+
+/*
+ * Writes now the rows pending in specified buffer (if any).
+ *
+ * Expected to be called with the HDF5 lock held.
+ *
+ * -spec h5d_flush_buffer( append_buffer() ) -> 'ok' | error().
+ *
+ */
+ERL_NIF_TERM h5d_flush_buffer( ErlNifEnv* env, int argc,
+  const ERL_NIF_TERM argv[] )
+{
+
+  if ( argc != 1 )
+	return error_tuple( env, "Incorrect number of arguments" ) ;
+
+  AppendBuffer * buffer ;
+
+  if ( ! enif_get_resource( env, argv[0], append_buffer_type,
+	  (void**) &buffer ) )
+	return error_tuple( env, "Cannot get append buffer from argv" ) ;
+
+  bool unregistered = false ;
+
+  const char * error = flush_buffer( buffer, &unregistered ) ;
+
+  // The buffer remains referenced by argv[0]:
+  if ( unregistered )
+	enif_release_resource( buffer ) ;
+
+  return error ? error_tuple( env, (char *) error ) : atom_ok ;
+
+}
+
+
+
+/*
+ * Reports the occupancy of specified buffer, and the outcome of its flushes so
+ * far, as a list of properties: pending rows and bytes, rows of the threshold,
+ * number of flushes, and rows written and lost (failed writes).
+ *
+ * -spec h5d_buffer_info( append_buffer() ) ->
+ *                        { 'ok', [ { atom(), non_neg_integer() } ] } | error().
+ *
+ */
+ERL_NIF_TERM h5d_buffer_info( ErlNifEnv* env, int argc,
+  const ERL_NIF_TERM argv[] )
+{
+
+  if ( argc != 1 )
+	return error_tuple( env, "Incorrect number of arguments" ) ;
+
+  AppendBuffer * buffer ;
+
+  if ( ! enif_get_resource( env, argv[0], append_buffer_type,
+	  (void**) &buffer ) )
+	return error_tuple( env, "Cannot get append buffer from argv" ) ;
+
+  enif_mutex_lock( buffer->mutex ) ;
+
+  hsize_t pending_rows = buffer->cells / buffer->row_cells ;
+  hsize_t pending_bytes = buffer->cells * buffer->cell_size ;
+  hsize_t max_rows = buffer->max_cells / buffer->row_cells ;
+  unsigned long flushes = buffer->flushes ;
+  hsize_t written_rows = buffer->written_rows ;
+  hsize_t failed_rows = buffer->failed_rows ;
+
+  enif_mutex_unlock( buffer->mutex ) ;
+
+  ERL_NIF_TERM properties[] = {
+
+	enif_make_tuple2( env, atom_rows,
+	  enif_make_uint64( env, pending_rows ) ),
+
+	enif_make_tuple2( env, atom_bytes,
+	  enif_make_uint64( env, pending_bytes ) ),
+
+	enif_make_tuple2( env, enif_make_atom( env, "max_rows" ),
+	  enif_make_uint64( env, max_rows ) ),
+
+	enif_make_tuple2( env, enif_make_atom( env, "flushes" ),
+	  enif_make_uint64( env, flushes ) ),
+
+	enif_make_tuple2( env, enif_make_atom( env, "written_rows" ),
+	  enif_make_uint64( env, written_rows ) ),
+
+	enif_make_tuple2( env, enif_make_atom( env, "failed_rows" ),
+	  enif_make_uint64( env, failed_rows ) )
+
+  } ;
+
+  return enif_make_tuple2( env, atom_ok, enif_make_list_from_array( env,
+	  properties, NUM_OF( properties ) ) ) ;
+
+}
@@ -0,0 +1,565 @@
+/* This file is part of erlhdf5 */
+
+/* erlhdf5 is free software: you can redistribute it and/or modify */
+/* it under the terms of the GNU Lesser General Public License as */
+/* published by the Free Software Foundation, either version 3 of */
+/* the License, or (at your option) any later version. */
+
+/* erlhdf5 is distributed in the hope that it will be useful, */
+/* but WITHOUT ANY WARRANTY; without even the implied warranty of */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the */
+/* GNU Lesser General Public License for more details. */
+
+/* You should have received a copy of the GNU Lesser General Public */
+/* License along with erlhdf5.  If not, see */
+/* <http://www.gnu.org/licenses/>. */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "hdf5.h"
+
+#include "erl_nif.h"
+
+#include "dbg.h"
+
+#include "erlhdf5.h"
+
+
+/*
+ * Downsampled reads of series (i.e. monodimensional datasets), typically for
+ * plotting: a range of cells is cut into a given number of buckets of
+ * consecutive cells, and only a few points per bucket are returned.
+ *
+ * The range is streamed through the scanner of erlh5d_scan.c, hence memory use
+ * depends only on the number of buckets, not on the size of the range:
+ *
+ * - 'minmax' returns the minimum and the maximum of each bucket (in index
+ * order), so that no peak is lost
+ *
+ * - 'mean' returns the mean of each bucket, at its middle
+ *
+ * - 'lttb' returns the first and last cells, and the cell of each bucket
+ * in-between forming the largest triangle with the point kept for the previous
+ * bucket and the centroid of the next bucket (Largest-Triangle-Three-Buckets);
+ * it takes two passes over the range: one to compute the centroids of the
+ * buckets, one to select the points
+ *
+ * NaN cells are skipped, and buckets having only NaN cells yield no point.
+ *
+ */
+
+
+// Maximum number of buckets of a downsampled read:
+#define MAX_DOWNSAMPLING_BUCKETS ( 1 << 16 )
+
+
+typedef enum
+{
+  DOWNSAMPLE_MINMAX,
+  DOWNSAMPLE_MEAN,
+  DOWNSAMPLE_LTTB
+} downsampling_mode ;
+
+
+typedef struct
+{
+
+  // Number of non-NaN cells in this bucket:
+  hsize_t filled ;
+
+  // Sums of their values and of their positions:
+  double sum ;
+  double position_sum ;
+
+  double min ;
+  double max ;
+  hsize_t min_at ;
+  hsize_t max_at ;
+
+  // For LTTB, the centroid of the next non-empty bucket, if any:
+  bool has_next ;
+  double next_at ;
+  double next_value ;
+
+  // For LTTB, the point selected so far, and its area:
+  bool selected ;
+  hsize_t at ;
+  double value ;
+  double area ;
+
+} Bucket ;
+
+
+typedef struct
+{
+
+  downsampling_mode mode ;
+
+  // Number of cells in the range, and of buckets:
+  hsize_t count ;
+  hsize_t buckets ;
+
+  /*
+   * Positions from first (included) to first + inner_count (excluded) are cut
+   * into inner_buckets buckets, starting from bucket first: all of them,
+   * except with LTTB, whose first and last cells have their own bucket.
+   *
+   */
+  hsize_t first ;
+  hsize_t inner_count ;
+  hsize_t inner_buckets ;
+
+  Bucket * bucket ;
+
+  // For the LTTB selection pass: the bucket being selected, and the point kept
+  // for the previous ones:
+  bool selecting ;
+  hsize_t current ;
+  bool has_previous ;
+  double previous_at ;
+  double previous_value ;
+
+} Downsampling ;
+
+
+
+/*
+ * Returns the position of the first cell of specified inner bucket.
+ *
+ */
+static inline hsize_t bucket_start( const Downsampling* d, hsize_t inner )
+{
+
+  return ( inner * d->inner_count + d->inner_buckets - 1 ) / d->inner_buckets
+	+ d->first ;
+
+}
+
+
+
+/*
+ * Folds specified run of cells, starting at specified position, into
+ * specified bucket.
+ *
+ */
+static void fold_bucket( Bucket* bucket, const double* cells, size_t count,
+  hsize_t position )
+{
+
+  size_t i ;
+
+  for ( i = 0; i < count; i++ )
+  {
+
+	double value = cells[i] ;
+
+	if ( value != value )
+	  continue ;
+
+	if ( bucket->filled == 0 || value < bucket->min )
+	{
+	  bucket->min = value ;
+	  bucket->min_at = position + i ;
+	}
+
+	if ( bucket->filled == 0 || value > bucket->max )
+	{
+	  bucket->max = value ;
+	  bucket->max_at = position + i ;
+	}
+
+	bucket->filled++ ;
+	bucket->sum += value ;
+	bucket->position_sum += position + i ;
+
+  }
+
+}
+
+
+
+/*
+ * Selects, among specified run of cells of specified bucket, the one forming
+ * the largest triangle with the previously kept point and the next centroid.
+ *
+ */
+static void select_in_bucket( Downsampling* d, hsize_t index,
+  const double* cells, size_t count, hsize_t position )
+{
+
+  // Entering a new bucket: the selection in the previous one is final.
+  if ( index != d->current )
+  {
+
+	Bucket * done = d->bucket + d->current ;
+
+	if ( done->selected )
+	{
+	  d->has_previous = true ;
+	  d->previous_at = done->at ;
+	  d->previous_value = done->value ;
+	}
+
+	d->current = index ;
+
+  }
+
+  Bucket * bucket = d->bucket + index ;
+
+  double a_at = d->previous_at ;
+  double a_value = d->previous_value ;
+  double c_at = bucket->next_at ;
+  double c_value = bucket->next_value ;
+
+  size_t i ;
+
+  for ( i = 0; i < count; i++ )
+  {
+
+	double value = cells[i] ;
+
+	if ( value != value )
+	  continue ;
+
+	double at = (double) ( position + i ) ;
+
+	// Twice the area of the triangle (a, point, c):
+	double area = ( d->has_previous && bucket->has_next ) ?
+	  fabs( ( a_at - c_at ) * ( value - a_value )
+		- ( a_at - at ) * ( c_value - a_value ) ) : 0.0 ;
+
+	if ( ! bucket->selected || area > bucket->area )
+	{
+	  bucket->selected = true ;
+	  bucket->at = position + i ;
+	  bucket->value = value ;
+	  bucket->area = area ;
+	}
+
+  }
+
+}
+
+
+
+/*
+ * Folds specified cells into their buckets (or, for the selection pass of LTTB,
+ * selects among them).
+ *
+ */
+static const char * downsample_cells( const double* cells, size_t count,
+  hsize_t position, void* state )
+{
+
+  Downsampling * d = (Downsampling *) state ;
+
+  size_t i = 0 ;
+
+  while ( i < count )
+  {
+
+	hsize_t at = position + i ;
+	hsize_t index ;
+	hsize_t end ;
+
+	if ( at < d->first )
+	{
+	  index = 0 ;
+	  end = d->first ;
+	}
+	else if ( at >= d->first + d->inner_count )
+	{
+	  index = d->buckets - 1 ;
+	  end = d->count ;
+	}
+	else
+	{
+
+	  hsize_t inner = ( at - d->first ) * d->inner_buckets / d->inner_count ;
+
+	  index = d->first + inner ;
+	  end = bucket_start( d, inner + 1 ) ;
+
+	}
+
+	size_t run = ( end - at < count - i ) ? end - at : count - i ;
+
+	if ( ! d->selecting )
+	  fold_bucket( d->bucket + index, cells + i, run, at ) ;
+	else if ( index >= d->first && index < d->first + d->inner_buckets )
+	  select_in_bucket( d, index, cells + i, run, at ) ;
+
+	i += run ;
+
+  }
+
+  return NULL ;
+
+}
+
+
+
+/*
+ * Prepares the selection pass of LTTB, once all centroids are known.
+ *
+ */
+static void prepare_selection( Downsampling* d )
+{
+
+  bool has_next = false ;
+  double next_at = 0.0 ;
+  double next_value = 0.0 ;
+
+  hsize_t i ;
+
+  for ( i = d->buckets; i > 0; i-- )
+  {
+
+	Bucket * bucket = d->bucket + i - 1 ;
+
+	bucket->has_next = has_next ;
+	bucket->next_at = next_at ;
+	bucket->next_value = next_value ;
+
+	if ( bucket->filled )
+	{
+	  has_next = true ;
+	  next_at = bucket->position_sum / bucket->filled ;
+	  next_value = bucket->sum / bucket->filled ;
+	}
+
+  }
+
+  Bucket * first = d->bucket ;
+
+  d->selecting = true ;
+  d->current = 0 ;
+  d->has_previous = ( first->filled > 0 ) ;
+  d->previous_at = first->min_at ;
+  d->previous_value = first->min ;
+
+}
+
+
+
+/*
+ * Returns the {Index, Value} tuple of specified point.
+ *
+ */
+static ERL_NIF_TERM make_point( ErlNifEnv* env, hsize_t start, hsize_t at,
+  double value )
+{
+
+  return enif_make_tuple2( env, enif_make_uint64( env, start + at ),
+	make_double_term( env, value ) ) ;
+
+}
+
+
+
+/*
+ * Returns the list of the points kept by specified downsampling, in index
+ * order, the range starting at specified index.
+ *
+ */
+static ERL_NIF_TERM make_points( ErlNifEnv* env, const Downsampling* d,
+  hsize_t start )
+{
+
+  ERL_NIF_TERM list = enif_make_list( env, 0 ) ;
+
+  hsize_t i ;
+
+  // Built from the end, to be in order:
+  for ( i = d->buckets; i > 0; i-- )
+  {
+
+	const Bucket * bucket = d->bucket + i - 1 ;
+
+	if ( bucket->filled == 0 )
+	  continue ;
+
+	switch ( d->mode )
+	{
+
+	case DOWNSAMPLE_MINMAX:
+	  if ( bucket->min_at < bucket->max_at )
+	  {
+		list = enif_make_list_cell( env,
+		  make_point( env, start, bucket->max_at, bucket->max ), list ) ;
+		list = enif_make_list_cell( env,
+		  make_point( env, start, bucket->min_at, bucket->min ), list ) ;
+	  }
+	  else
+	  {
+		list = enif_make_list_cell( env,
+		  make_point( env, start, bucket->min_at, bucket->min ), list ) ;
+
+		if ( bucket->max_at != bucket->min_at )
+		  list = enif_make_list_cell( env,
+			make_point( env, start, bucket->max_at, bucket->max ), list ) ;
+	  }
+	  break ;
+
+	case DOWNSAMPLE_MEAN:
+	{
+	  hsize_t middle = ( bucket_start( d, i - 1 ) + bucket_start( d, i ) - 1 )
+		/ 2 ;
+
+	  list = enif_make_list_cell( env,
+		make_point( env, start, middle, bucket->sum / bucket->filled ),
+		list ) ;
+	  break ;
+	}
+
+	case DOWNSAMPLE_LTTB:
+	  // The first and last buckets hold a single cell:
+	  if ( bucket->selected )
+		list = enif_make_list_cell( env,
+		  make_point( env, start, bucket->at, bucket->value ), list ) ;
+	  else
+		list = enif_make_list_cell( env,
+		  make_point( env, start, bucket->min_at, bucket->min ), list ) ;
+	  break ;
+
+	}
+
+  }
+
+  return list ;
+
+}
+
+
+
+/*
+ * Reads a downsampled version of specified range of specified series (a
+ * monodimensional dataset), as at most Buckets points (twice as many with
+ * 'minmax'), in index order.
+ *
+ * -spec h5d_read_downsampled( dataset_handle(),
+ *        { Start::size(), Count::size() } | 'all', Buckets::pos_integer(),
+ *        'minmax' | 'mean' | 'lttb' ) ->
+ *          { 'ok', [ { Index::size(), float() | 'inf' } ] } | error().
+ *
+ */
+ERL_NIF_TERM h5d_read_downsampled( ErlNifEnv* env, int argc,
+  const ERL_NIF_TERM argv[] )
+{
+
+  if ( argc != 4 )
+	return error_tuple( env, "Incorrect number of arguments" ) ;
+
+  hid_t dataset_id ;
+
+  if ( ! get_handle_id( env, argv[0], DATASET_HANDLE, &dataset_id ) )
+	return error_tuple( env, "Cannot get dataset handle from argv" ) ;
+
+  Downsampling d ;
+
+  if ( ! get_hsize( env, argv[2], &d.buckets ) || d.buckets == 0
+	|| d.buckets > MAX_DOWNSAMPLING_BUCKETS )
+	return error_tuple( env, "Invalid number of buckets" ) ;
+
+  char mode[ MAXBUFLEN ] ;
+
+  if ( ! enif_get_atom( env, argv[3], mode, sizeof( mode ), ERL_NIF_LATIN1 ) )
+	return error_tuple( env, "Cannot get downsampling mode from argv" ) ;
+
+  if ( strcmp( mode, "minmax" ) == 0 )
+	d.mode = DOWNSAMPLE_MINMAX ;
+  else if ( strcmp( mode, "mean" ) == 0 )
+	d.mode = DOWNSAMPLE_MEAN ;
+  else if ( strcmp( mode, "lttb" ) == 0 )
+	d.mode = DOWNSAMPLE_LTTB ;
+  else
+	return error_tuple( env, "Unknown downsampling mode" ) ;
+
+  if ( d.mode == DOWNSAMPLE_LTTB && d.buckets < 3 )
+	return error_tuple( env, "LTTB requires at least 3 buckets" ) ;
+
+  hsize_t start ;
+  const char * error_message = NULL ;
+
+  hid_t file_dataspace_id = select_series_range( env, dataset_id, argv[1],
+	&start, &d.count, &error_message ) ;
+
+  if ( file_dataspace_id < 0 )
+	return error_tuple( env, (char *) error_message ) ;
+
+  ERL_NIF_TERM ret ;
+  d.bucket = NULL ;
+
+  if ( d.count == 0 )
+  {
+	ret = enif_make_tuple2( env, atom_ok, enif_make_list( env, 0 ) ) ;
+	H5Sclose( file_dataspace_id ) ;
+	return ret ;
+  }
+
+  // With no more cells than buckets, LTTB would keep them all anyway:
+  if ( d.buckets > d.count )
+	d.buckets = d.count ;
+
+  if ( d.mode == DOWNSAMPLE_LTTB && d.buckets == d.count )
+	d.mode = DOWNSAMPLE_MEAN ;
+
+  if ( d.mode == DOWNSAMPLE_LTTB )
+  {
+	d.first = 1 ;
+	d.inner_count = d.count - 2 ;
+	d.inner_buckets = d.buckets - 2 ;
+  }
+  else
+  {
+	d.first = 0 ;
+	d.inner_count = d.count ;
+	d.inner_buckets = d.buckets ;
+  }
+
+  d.selecting = false ;
+
+  size_t bucket_size = d.buckets * sizeof( Bucket ) ;
+
+  d.bucket = (Bucket *) enif_alloc( bucket_size ) ;
+
+  if ( d.bucket == NULL )
+  {
+	error_message = "Cannot allocate buckets" ;
+	goto end ;
+  }
+
+  memset( d.bucket, 0, bucket_size ) ;
+
+  error_message = scan_selection( dataset_id, file_dataspace_id,
+	downsample_cells, &d ) ;
+
+  if ( error_message == NULL && d.mode == DOWNSAMPLE_LTTB )
+  {
+
+	prepare_selection( &d ) ;
+
+	error_message = scan_selection( dataset_id, file_dataspace_id,
+	  downsample_cells, &d ) ;
+
+  }
+
+  if ( error_message == NULL )
+	ret = enif_make_tuple2( env, atom_ok, make_points( env, &d, start ) ) ;
+
+ end:
+  if ( error_message )
+	ret = error_tuple( env, (char *) error_message ) ;
+
+  if ( d.bucket )
+	enif_free( d.bucket ) ;
+
+  H5Sclose( file_dataspace_id ) ;
+
+  return ret ;
+
+}
@@ -26,6 +26,9 @@
 #include <stdio.h>
 #include <stdlib.h>
 
+// For SIZE_MAX:
+#include <stdint.h>
+
 // For isinf, isnan:
 #include <math.h>
 
@@ -45,7 +48,7 @@ int convert_array_to_nif_array( ErlNifEnv* env, hsize_t size, hsize_t *arr_from,
 
   for( i = 0; i < size; i++ )
   {
-	arr_to[i] = enif_make_int( env, arr_from[i] ) ;
+	arr_to[i] = enif_make_uint64( env, (ErlNifUInt64) arr_from[i] ) ;
   }
 
   return 0 ;
@@ -82,28 +85,31 @@ int convert_double_array_to_nif_array( ErlNifEnv* env, hsize_t size,
 
 	//printf( "read: double -> nif: %f / %e\n", arr_from[i], arr_from[i] ) ;
 
-	if ( isinf( arr_from[i] ) )
-	{
+	arr_to[i] = make_double_term( env, arr_from[i] ) ;
 
-	  //printf( "Infinite value detected.\n" ) ;
-	  arr_to[i] = enif_make_atom( env, "inf" ) ;
+  }
 
-	}
-	else if ( isnan( arr_from[i] ) )
-	{
+  return 0 ;
 
-	  //printf( "Nan value detected.\n" ) ;
-	  arr_to[i] = enif_make_atom( env, "nan" ) ;
+}
 
-	}
-	else
-	{
-	  arr_to[i] = enif_make_double( env, arr_from[i] ) ;
-	}
 
-  }
 
-  return 0 ;
+/*
+ * Converts specified C double into an Erlang-level float, managing the mapping
+ * of infinite and nan values (to the 'inf' and 'nan' atoms).
+ *
+ */
+ERL_NIF_TERM make_double_term( ErlNifEnv* env, double value )
+{
+
+  if ( isinf( value ) )
+	return enif_make_atom( env, "inf" ) ;
+
+  if ( isnan( value ) )
+	return enif_make_atom( env, "nan" ) ;
+
+  return enif_make_double( env, value ) ;
 
 }
 
@@ -113,15 +119,12 @@ int convert_nif_to_hsize_array( ErlNifEnv* env, hsize_t size,
   const ERL_NIF_TERM* arr_from, hsize_t *arr_to )
 {
 
-  int n, i ;
+  int i ;
 
   for( i = 0; i < size; i++ )
   {
-	check( enif_get_int( env, arr_from[i], &n ),
+	check( get_hsize( env, arr_from[i], arr_to + i ),
 	  "Error getting array element" ) ;
-
-	arr_to[i] = (hsize_t) n ;
-
   }
 
   return 0 ;
@@ -133,240 +136,79 @@ int convert_nif_to_hsize_array( ErlNifEnv* env, hsize_t size,
 
 
 
-
-
 /*
- * Helper to translate [ integer() ] terms into a C-array of ints for injecting
- * (writing) that (in-memory) data in specified (in-file) dataspace.
+ * Reads specified term as a (64-bit) HDF5 size, offset or dimension.
+ *
+ * Returns whether the term is a non-negative integer fitting in an hsize_t.
  *
  */
-ERL_NIF_TERM write_ints_to_array( hid_t dataset_id, ErlNifEnv* env,
-  unsigned int list_length, ERL_NIF_TERM int_list, hid_t file_dataspace_id )
+bool get_hsize( ErlNifEnv* env, ERL_NIF_TERM term, hsize_t * value )
 {
 
-  // Temporary variable, used to match HDF5 expected types:
-  hsize_t element_count = list_length ;
-
-  int * buffer_for_hdf = enif_alloc( list_length * sizeof( int ) ) ;
-
-  if ( ! buffer_for_hdf )
-	return error_tuple( env, "Cannot allocate intermediate array memory" ) ;
-
-  // Flat index (as the array is monodimensional):
-  unsigned int global = 0 ;
-
-  ERL_NIF_TERM head, tail ;
-
-  // Goes through each list element, and unpacks it:
-  while ( enif_get_list_cell( env, int_list, &head, &tail ) )
-  {
-
-	if ( ! enif_get_int( env, head, buffer_for_hdf + global ) )
-	{
-	  enif_free( buffer_for_hdf ) ;
-	  return error_tuple( env, "Cell does not contain an integer" ) ;
-	}
-
-	//printf( "element =%i\n", *( buffer_for_hdf + global ) ) ;
-
-	global++ ;
-
-	int_list = tail ;
-
-  }
-
-  // Just one dimension:
-  hid_t mem_dataspace_id = H5Screate_simple( /* rank */ 1, &element_count,
-	/* max dims */ NULL ) ;
-
-  if ( mem_dataspace_id < 0 )
-	return error_tuple( env, "Cannot create a memory dataspace" ) ;
-
-
-  // Finally, writes the translated data to the dataset:
-  if( H5Dwrite(
-	  /* target */ dataset_id,
-	  /* cell type */ H5T_NATIVE_INT,
-	  /* memory and selection dataspace */ mem_dataspace_id,
-	  /* selection within the file dataset's dataspace */ file_dataspace_id,
-	  /* default data transfer properties */ H5P_DEFAULT,
-	  /* source location */ buffer_for_hdf ) < 0 )
+  ErlNifUInt64 n ;
 
-  {
-	enif_free( buffer_for_hdf ) ;
-	return error_tuple( env, "Failed to write into int dataset" ) ;
-  }
+  if ( ! enif_get_uint64( env, term, &n ) )
+	return false ;
 
-  enif_free( buffer_for_hdf ) ;
+  *value = (hsize_t) n ;
 
-  return atom_ok ;
+  return true ;
 
 }
 
 
 
 /*
- * Helper to translate [ tuple( integer() ) ] terms into a C-array of ints for
- * injecting (writing) that (in-memory) data in specified (in-file) dataspace.
+ * Gets from specified term a tuple of exactly rank (non-negative) dimensions,
+ * or offsets.
+ *
+ * Returns whether the operation succeeded.
  *
  */
-ERL_NIF_TERM write_int_tuples_to_array( hid_t dataset_id, ErlNifEnv* env,
-  unsigned int list_length, int tuple_size, ERL_NIF_TERM tuple_list,
-  hid_t file_dataspace_id )
+bool get_dimension_tuple( ErlNifEnv* env, ERL_NIF_TERM term, int rank,
+  hsize_t* dims )
 {
 
-  hsize_t element_count = list_length * tuple_size ;
-
-  int * buffer_for_hdf = enif_alloc( element_count * sizeof( int ) ) ;
-
-  if ( ! buffer_for_hdf )
-	return error_tuple( env, "Cannot allocate intermediate array memory" ) ;
-
-  // Flat index (as if the array was monodimensional):
-  unsigned int global = 0 ;
-
-  ERL_NIF_TERM head, tail ;
-
-  const ERL_NIF_TERM * tuple_elements ;
-
-  // Goes through each list element, and unpacks it:
-  while ( enif_get_list_cell( env, tuple_list, &head, &tail ) )
-  {
-
-	int this_tuple_size ;
-
-	if ( ! enif_get_tuple( env, head, &this_tuple_size, &tuple_elements ) )
-	{
-	  enif_free( buffer_for_hdf ) ;
-	  return error_tuple( env, "Cannot get tuples from the input list" ) ;
-	}
-
-	//printf( "Found tuple size: %u\n", this_tuple_size ) ;
-
-	if ( this_tuple_size != tuple_size )
-	{
-	  enif_free( buffer_for_hdf ) ;
-	  return error_tuple( env, "Non-uniform tuple size detected" ) ;
-	}
-
-	unsigned int i ;
+  int arity ;
+  const ERL_NIF_TERM * terms ;
 
-	// Iterates through the elements of this tuple and stores them:
-	for( i = 0; i < tuple_size; i++ )
-	{
-
-	  if ( ! enif_get_int( env, tuple_elements[i], buffer_for_hdf + global ) )
-	  {
-		enif_free( buffer_for_hdf ) ;
-		return error_tuple( env, "Cell does not contain an integer" ) ;
-	  }
-
-	  //printf( "element =%i\n", *( buffer_for_hdf + global ) ) ;
-
-	  global++ ;
-
-	}
-
-	tuple_list = tail ;
-
-  }
-
-  // Just one dimension:
-  hid_t mem_dataspace_id = H5Screate_simple( /* rank */ 1, &element_count,
-	/* max dims */ NULL ) ;
-
-  if ( mem_dataspace_id < 0 )
-	return error_tuple( env, "Cannot create a memory dataspace" ) ;
-
-
-  // Finally, writes the translated data to the dataset:
-  if( H5Dwrite(
-	  /* target */ dataset_id,
-	  /* cell type */ H5T_NATIVE_INT,
-	  /* memory and selection dataspace */ mem_dataspace_id,
-	  /* selection within the file dataset's dataspace */ file_dataspace_id,
-	  /* default data transfer properties */ H5P_DEFAULT,
-	  /* source location */ buffer_for_hdf ) < 0 )
+  if ( ! enif_get_tuple( env, term, &arity, &terms ) || arity != rank )
+	return false ;
 
-  {
-	enif_free( buffer_for_hdf ) ;
-	return error_tuple( env, "Failed to write into int dataset" ) ;
-  }
+  int i ;
 
-  enif_free( buffer_for_hdf ) ;
+  for ( i = 0; i < rank; i++ )
+	if ( ! get_hsize( env, terms[i], dims + i ) )
+	  return false ;
 
-  return atom_ok ;
+  return true ;
 
 }
 
 
 
 /*
- * Helper to translate [ float() ] terms into a C-array of doubles for injecting
- * (writing) that (in-memory) data in specified (in-file) dataspace.
+ * Reads specified term as an in-memory size (ex: a cache or buffer size).
+ *
+ * Returns whether the term is a non-negative integer fitting in a size_t
+ * (which may be narrower than 64 bits).
  *
  */
-ERL_NIF_TERM write_floats_to_array( hid_t dataset_id, ErlNifEnv* env,
-  unsigned int list_length, ERL_NIF_TERM float_list, hid_t file_dataspace_id )
+bool get_size( ErlNifEnv* env, ERL_NIF_TERM term, size_t * value )
 {
 
-  //printf( "Writing now float array (len=%u, elem_size=%lu)\n",
-  //	list_length, sizeof( double ) ) ;
-
-  // Temporary variable, used to match HDF5 expected types:
-  hsize_t element_count = list_length ;
+  ErlNifUInt64 n ;
 
-  double * buffer_for_hdf = (double *) enif_alloc(
-	list_length * sizeof( double ) ) ;
-
-  if ( ! buffer_for_hdf )
-	return error_tuple( env, "Cannot allocate intermediate array memory" ) ;
-
-  // Flat index (the array is monodimensional):
-  unsigned int global = 0 ;
-
-  ERL_NIF_TERM head, tail ;
-
-  // Goes through each list element (float), and unpacks it:
-  while ( enif_get_list_cell( env, float_list, &head, &tail ) )
-  {
-
-	if ( ! convert_float_value_to_c( head, buffer_for_hdf + global, env ) )
-	  return error_tuple( env, "Unable to convert float to C double" ) ;
-
-	//printf( "write element =%f\n", *( buffer_for_hdf + global ) );
-
-	global++ ;
-
-	float_list = tail ;
-
-  }
-
-  // Just one dimension:
-  hid_t mem_dataspace_id = H5Screate_simple( /* rank */ 1, &element_count,
-	/* max dims */ NULL ) ;
+  if ( ! enif_get_uint64( env, term, &n ) || n > (ErlNifUInt64) SIZE_MAX )
+	return false ;
 
-  if ( mem_dataspace_id < 0 )
-	return error_tuple( env, "Cannot create a memory dataspace" ) ;
+  *value = (size_t) n ;
 
-  // Finally, writes the translated data to the dataset:
-  if( H5Dwrite(
-	  /* target */ dataset_id,
-	  /* cell type */ H5T_NATIVE_DOUBLE,
-	  /* memory and selection dataspace */ mem_dataspace_id,
-	  /* selection within the file dataset's dataspace */ file_dataspace_id,
-	  /* default data transfer properties */ H5P_DEFAULT,
-	  /* source location */ buffer_for_hdf ) < 0 )
-  {
-	enif_free( buffer_for_hdf ) ;
-	return error_tuple( env, "Failed to write into double dataset" ) ;
-  }
+  return true ;
 
-  enif_free( buffer_for_hdf ) ;
+}
 
-  return atom_ok ;
 
-}
 
 
 
@@ -414,96 +256,139 @@ bool convert_float_value_to_c( ERL_NIF_TERM floatTerm, double * target,
 
 
 /*
- * Helper to translate [ tuple( float() ) ] terms into a C-array of doubles for
- * injecting (writing) that (in-memory) data in specified (in-file) dataspace.
+ * Writes specified in-memory buffer, made of element_count contiguous cells of
+ * the specified (memory) type, into specified (in-file) dataspace of specified
+ * (open) dataset, which had specified number of rows before (HSIZE_UNDEF
+ * unless the write appends rows to it).
+ *
+ * The buffer is handed over as is to HDF5 (no conversion nor copy is
+ * performed here), and it remains owned by the caller; the zone map of the
+ * dataset, if any, is updated as well.
+ *
+ * Returns an error tuple only if the cells could not be written (the failure
+ * to update a zone map just leaving its zones unknown).
  *
  */
-ERL_NIF_TERM write_float_tuples_to_array( hid_t dataset_id, ErlNifEnv* env,
-  unsigned int list_length, int tuple_size, ERL_NIF_TERM tuple_list,
-  hid_t file_dataspace_id )
+ERL_NIF_TERM write_buffer_to_dataset( Handle* dataset, ErlNifEnv* env,
+  hid_t mem_type_id, hsize_t element_count, const void* buffer,
+  hid_t file_dataspace_id, hsize_t old_rows )
 {
 
-  //printf( "Writing now float array (len=%u, size=%i, elem_size=%lu)\n",
-  //	list_length, tuple_size, sizeof( double ) ) ;
+  // Just one dimension:
+  hid_t mem_dataspace_id = H5Screate_simple( /* rank */ 1, &element_count,
+	/* max dims */ NULL ) ;
 
-  hsize_t element_count = list_length * tuple_size ;
+  if ( mem_dataspace_id < 0 )
+	return error_tuple( env, "Cannot create a memory dataspace" ) ;
 
-  double * buffer_for_hdf = (double *) enif_alloc(
-	element_count * sizeof( double ) ) ;
+  herr_t status = H5Dwrite(
+	  /* target */ dataset->id,
+	  /* cell type */ mem_type_id,
+	  /* memory and selection dataspace */ mem_dataspace_id,
+	  /* selection within the file dataset's dataspace */ file_dataspace_id,
+	  /* default data transfer properties */ H5P_DEFAULT,
+	  /* source location */ buffer ) ;
 
-  if ( ! buffer_for_hdf )
-	return error_tuple( env, "Cannot allocate intermediate array memory" ) ;
+  H5Sclose( mem_dataspace_id ) ;
 
-  // Flat index (as if the array was monodimensional):
-  unsigned int global = 0 ;
+  update_zone_map( dataset, file_dataspace_id, old_rows, mem_type_id, buffer,
+	/* written */ status >= 0 ) ;
 
-  ERL_NIF_TERM head, tail ;
+  if ( status < 0 )
+	return error_tuple( env, "Failed to write buffer into dataset" ) ;
 
-  const ERL_NIF_TERM * tuple_elements ;
+  return atom_ok ;
 
-  // Go through each list element (tuple), and unpack it:
-  while ( enif_get_list_cell( env, tuple_list, &head, &tail ) )
-  {
+}
+
+
+
+/*
+ * Returns the number of elements selected by specified file dataspace in
+ * specified dataset (H5S_ALL meaning the full extent of the dataset), or a
+ * negative value on failure.
+ *
+ */
+hssize_t get_selected_count( hid_t dataset_id, hid_t file_dataspace_id )
+{
+
+  if ( file_dataspace_id != H5S_ALL )
+	return H5Sget_select_npoints( file_dataspace_id ) ;
+
+  hid_t dataset_space_id = H5Dget_space( dataset_id ) ;
 
-	int this_tuple_size ;
+  if ( dataset_space_id < 0 )
+	return -1 ;
 
-	if ( ! enif_get_tuple( env, head, &this_tuple_size, &tuple_elements ) )
-	{
-	  enif_free( buffer_for_hdf ) ;
-	  return error_tuple( env, "Cannot get tuples from the input list" ) ;
-	}
+  hssize_t count = H5Sget_simple_extent_npoints( dataset_space_id ) ;
 
-	//printf( "Found tuple size: %u\n", this_tuple_size ) ;
+  H5Sclose( dataset_space_id ) ;
 
-	if ( this_tuple_size != tuple_size )
-	{
-	  enif_free( buffer_for_hdf ) ;
-	  return error_tuple( env, "Non-uniform tuple size detected" ) ;
-	}
+  return count ;
+
+}
 
-	unsigned int i ;
 
-	// Iterates through the elements of this tuple and stores them:
-	for( i = 0; i < tuple_size; i++ )
-	{
 
-	  if ( ! convert_float_value_to_c( tuple_elements[i], 
-		  buffer_for_hdf + global, env ) )
-		return error_tuple( env, "Unable to convert float to C double" ) ;
+/*
+ * Gets from specified term a file dataspace: either the 'H5S_ALL' atom (the
+ * full extent of the dataset) or a dataspace handle.
+ *
+ * Returns whether the operation succeeded.
+ *
+ */
+bool get_file_dataspace( ErlNifEnv* env, ERL_NIF_TERM term,
+  hid_t* file_dataspace_id )
+{
 
-	  //printf( "write element =%f\n", *( buffer_for_hdf + global ) );
+  char atom_string[ 8 ] ;
 
-	  global++ ;
+  if ( enif_get_atom( env, term, atom_string, sizeof( atom_string ),
+	  ERL_NIF_LATIN1 ) )
+  {
 
-	}
+	if ( strcmp( atom_string, "H5S_ALL" ) != 0 )
+	  return false ;
 
-	// Recurses:
-	tuple_list = tail ;
+	*file_dataspace_id = H5S_ALL ;
+	return true ;
 
   }
 
+  return get_handle_id( env, term, DATASPACE_HANDLE, file_dataspace_id ) ;
+
+}
+
+
+
+/*
+ * Reads from specified (in-file) dataspace element_count contiguous cells of
+ * the specified (memory) type into specified, caller-allocated buffer.
+ *
+ * Returns whether the operation succeeded.
+ *
+ */
+bool read_buffer_from_dataset( hid_t dataset_id, hid_t mem_type_id,
+  hsize_t element_count, void* buffer, hid_t file_dataspace_id )
+{
+
   // Just one dimension:
   hid_t mem_dataspace_id = H5Screate_simple( /* rank */ 1, &element_count,
 	/* max dims */ NULL ) ;
 
   if ( mem_dataspace_id < 0 )
-	return error_tuple( env, "Cannot create a memory dataspace" ) ;
+	return false ;
 
-  // Finally, writes the translated data to the dataset:
-  if( H5Dwrite(
-	  /* target */ dataset_id,
-	  /* cell type */ H5T_NATIVE_DOUBLE,
+  herr_t status = H5Dread(
+	  /* source */ dataset_id,
+	  /* cell type */ mem_type_id,
 	  /* memory and selection dataspace */ mem_dataspace_id,
 	  /* selection within the file dataset's dataspace */ file_dataspace_id,
 	  /* default data transfer properties */ H5P_DEFAULT,
-	  /* source location */ buffer_for_hdf ) < 0 )
-  {
-	enif_free( buffer_for_hdf ) ;
-	return error_tuple( env, "Failed to write into double dataset" ) ;
-  }
+	  /* target location */ buffer ) ;
 
-  enif_free( buffer_for_hdf ) ;
+  H5Sclose( mem_dataspace_id ) ;
 
-  return atom_ok ;
+  return status >= 0 ;
 
 }
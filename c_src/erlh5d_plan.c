@@ -0,0 +1,440 @@
+/* This file is part of erlhdf5 */
+
+/* erlhdf5 is free software: you can redistribute it and/or modify */
+/* it under the terms of the GNU Lesser General Public License as */
+/* published by the Free Software Foundation, either version 3 of */
+/* the License, or (at your option) any later version. */
+
+/* erlhdf5 is distributed in the hope that it will be useful, */
+/* but WITHOUT ANY WARRANTY; without even the implied warranty of */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the */
+/* GNU Lesser General Public License for more details. */
+
+/* You should have received a copy of the GNU Lesser General Public */
+/* License along with erlhdf5.  If not, see */
+/* <http://www.gnu.org/licenses/>. */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "hdf5.h"
+
+#include "erl_nif.h"
+
+#include "dbg.h"
+
+#include "erlhdf5.h"
+
+
+/*
+ * Prepared write plans.
+ *
+ * Writers pushing repeatedly blocks of the same shape (ex: a row of samples at
+ * each tick) would otherwise pay, at each h5dwrite/3, the detection of the
+ * type of the data, the allocation of a staging buffer, the creation of a
+ * memory dataspace and of a file selection.
+ *
+ * A plan (h5d_prepare_write/3) does all that once: it owns a staging buffer, a
+ * memory dataspace and a copy of the file dataspace of its dataset, so that
+ * each h5d_exec_write/3 just fills the buffer, moves the hyperslab to the
+ * specified offset and calls H5Dwrite.
+ *
+ * All accesses to a plan are done with the HDF5 lock held, hence a plan may be
+ * shared between processes.
+ *
+ */
+
+
+typedef struct
+{
+
+  // The target dataset, kept referenced for as long as this plan exists:
+  Handle * dataset ;
+
+  // Type of the cells, and the corresponding predefined (hence never closed)
+  // HDF5 memory type:
+  cell_type type ;
+  hid_t mem_type_id ;
+  size_t cell_size ;
+
+  // Rank of the dataset, and dimensions of a block:
+  int rank ;
+  hsize_t shape[ H5S_MAX_RANK ] ;
+
+  // Number of cells of a block, and the staging buffer holding them:
+  hsize_t cell_count ;
+  void * buffer ;
+
+  // Flat dataspace describing the staging buffer:
+  hid_t mem_dataspace_id ;
+
+  // Copy of the dataspace of the dataset, on which the hyperslab of each write
+  // is selected, and its extent when it was last fetched:
+  hid_t file_dataspace_id ;
+  hsize_t extent[ H5S_MAX_RANK ] ;
+
+} WritePlan ;
+
+
+static ErlNifResourceType * write_plan_type = NULL ;
+
+
+
+// Called whenever a write plan is garbage-collected.
+static void write_plan_destructor( ErlNifEnv* env, void* obj )
+{
+
+  WritePlan * plan = (WritePlan *) obj ;
+
+  if ( plan->mem_dataspace_id >= 0 )
+	release_hdf5_object( DATASPACE_HANDLE, plan->mem_dataspace_id ) ;
+
+  if ( plan->file_dataspace_id >= 0 )
+	release_hdf5_object( DATASPACE_HANDLE, plan->file_dataspace_id ) ;
+
+  if ( plan->buffer )
+	enif_free( plan->buffer ) ;
+
+  if ( plan->dataset )
+	enif_release_resource( plan->dataset ) ;
+
+}
+
+
+
+/*
+ * Opens the resource types used by the write plans.
+ *
+ * Returns 0 on success, -1 on failure.
+ *
+ */
+int open_plan_resource_types( ErlNifEnv* env )
+{
+
+  write_plan_type = enif_open_resource_type( env, "erlhdf5", "WritePlan",
+	write_plan_destructor, ERL_NIF_RT_CREATE | ERL_NIF_RT_TAKEOVER, NULL ) ;
+
+  return write_plan_type ? 0 : -1 ;
+
+}
+
+
+
+/*
+ * Fetches again the dataspace of the dataset of specified plan, typically
+ * after the dataset has been extended.
+ *
+ * Returns whether the operation succeeded.
+ *
+ */
+static bool refresh_file_dataspace( WritePlan * plan )
+{
+
+  hid_t file_dataspace_id = H5Dget_space( plan->dataset->id ) ;
+
+  if ( file_dataspace_id < 0 )
+	return false ;
+
+  if ( H5Sget_simple_extent_dims( file_dataspace_id, plan->extent, NULL )
+	!= plan->rank )
+  {
+	H5Sclose( file_dataspace_id ) ;
+	return false ;
+  }
+
+  if ( plan->file_dataspace_id >= 0 )
+	H5Sclose( plan->file_dataspace_id ) ;
+
+  plan->file_dataspace_id = file_dataspace_id ;
+
+  return true ;
+
+}
+
+
+
+/*
+ * Fills the staging buffer of specified plan from specified list, either of
+ * cells or of tuples of cells, which must contain exactly the number of cells
+ * of a block (in row-major order).
+ *
+ * Returns NULL on success, otherwise an error message.
+ *
+ */
+static const char * fill_plan_buffer( ErlNifEnv* env, WritePlan * plan,
+  ERL_NIF_TERM list )
+{
+
+  ERL_NIF_TERM head, tail ;
+
+  if ( ! enif_get_list_cell( env, list, &head, &tail ) )
+	return "Data is not a non-empty list" ;
+
+  // Bare cells or tuples, as determined by the first element:
+  int tuple_size ;
+  const ERL_NIF_TERM * cells ;
+
+  if ( ! enif_get_tuple( env, head, &tuple_size, &cells ) )
+	tuple_size = 0 ;
+
+  hsize_t index = 0 ;
+
+  const char * error = encode_cell_list( env, plan->type, &list, tuple_size,
+	plan->buffer, &index, /* no slicing */ (hsize_t) -1, plan->cell_count ) ;
+
+  if ( error )
+	return error ;
+
+  if ( enif_is_list( env, list ) && ! enif_is_empty_list( env, list ) )
+	return "More cells than in a block of the plan" ;
+
+  if ( ! enif_is_empty_list( env, list ) )
+	return "Data is not a proper list" ;
+
+  if ( index != plan->cell_count )
+	return "Fewer cells than in a block of the plan" ;
+
+  return NULL ;
+
+}
+
+
+
+/*
+ * Prepares the repeated writing of blocks of the specified shape and cell type
+ * into specified dataset (see h5d_exec_write/3).
+ *
+ * -spec h5d_prepare_write( dataset_handle(), CellType::datatype_name(),
+ *                          Shape::dimensions() ) ->
+ *                                 { 'ok', write_plan() } | error().
+ *
+ */
+ERL_NIF_TERM h5d_prepare_write( ErlNifEnv* env, int argc,
+  const ERL_NIF_TERM argv[] )
+{
+
+  if ( argc != 3 )
+	return error_tuple( env, "Incorrect number of arguments" ) ;
+
+  Handle * dataset ;
+
+  if ( ! get_handle( env, argv[0], DATASET_HANDLE, &dataset )
+	|| dataset->id < 0 )
+	return error_tuple( env, "Cannot get dataset handle from argv" ) ;
+
+  char type_name[ MAXBUFLEN ] ;
+
+  if ( ! enif_get_atom( env, argv[1], type_name, sizeof( type_name ),
+	  ERL_NIF_LATIN1 ) )
+	return error_tuple( env, "Cannot get cell type from argv" ) ;
+
+  hid_t mem_type_id ;
+
+  if ( convert_type( type_name, &mem_type_id ) )
+	return error_tuple( env, "Unsupported cell type" ) ;
+
+  cell_type type = get_cell_type( mem_type_id ) ;
+
+  if ( type == UNKNOWN_TYPE )
+	return error_tuple( env, "Unsupported cell type for a write plan" ) ;
+
+  WritePlan * plan = enif_alloc_resource( write_plan_type,
+	sizeof( WritePlan ) ) ;
+
+  if ( ! plan )
+	return error_tuple( env, "Cannot allocate write plan" ) ;
+
+  // So that the destructor can be called at any point from now:
+  plan->dataset = NULL ;
+  plan->buffer = NULL ;
+  plan->mem_dataspace_id = -1 ;
+  plan->file_dataspace_id = -1 ;
+
+  enif_keep_resource( dataset ) ;
+  plan->dataset = dataset ;
+
+  plan->type = type ;
+  plan->mem_type_id = mem_type_id ;
+  plan->cell_size = get_cell_size( type ) ;
+
+  const char * error_message = NULL ;
+
+  plan->file_dataspace_id = H5Dget_space( dataset->id ) ;
+
+  if ( plan->file_dataspace_id < 0 )
+  {
+	error_message = "Cannot get the dataspace of the dataset" ;
+	goto error ;
+  }
+
+  plan->rank = H5Sget_simple_extent_dims( plan->file_dataspace_id,
+	plan->extent, NULL ) ;
+
+  if ( plan->rank < 1 )
+  {
+	error_message = "Cannot get the dimensions of the dataset" ;
+	goto error ;
+  }
+
+  if ( ! get_dimension_tuple( env, argv[2], plan->rank, plan->shape ) )
+  {
+	error_message = "Shape does not match the rank of the dataset" ;
+	goto error ;
+  }
+
+  plan->cell_count = 1 ;
+
+  int i ;
+
+  for ( i = 0; i < plan->rank; i++ )
+	plan->cell_count *= plan->shape[i] ;
+
+  if ( plan->cell_count == 0 )
+  {
+	error_message = "Empty block shape" ;
+	goto error ;
+  }
+
+  plan->buffer = enif_alloc( plan->cell_count * plan->cell_size ) ;
+
+  if ( ! plan->buffer )
+  {
+	error_message = "Cannot allocate staging buffer" ;
+	goto error ;
+  }
+
+  plan->mem_dataspace_id = H5Screate_simple( /* rank */ 1, &plan->cell_count,
+	/* max dims */ NULL ) ;
+
+  if ( plan->mem_dataspace_id < 0 )
+  {
+	error_message = "Cannot create a memory dataspace" ;
+	goto error ;
+  }
+
+  ERL_NIF_TERM plan_term = enif_make_resource( env, plan ) ;
+
+  enif_release_resource( plan ) ;
+
+  return enif_make_tuple2( env, atom_ok, plan_term ) ;
+
+ error:
+  // The HDF5 lock being held, closes directly what the destructor would defer:
+  if ( plan->file_dataspace_id >= 0 )
+	H5Sclose( plan->file_dataspace_id ) ;
+
+  plan->file_dataspace_id = -1 ;
+
+  // Destroys the plan:
+  enif_release_resource( plan ) ;
+  return error_tuple( env, (char *) error_message ) ;
+
+}
+
+
+
+/*
+ * Writes specified block of data, whose top-left corner in the dataset is at
+ * specified offset, according to specified write plan.
+ *
+ * The data is either a list (of cells or of tuples of cells, holding in
+ * row-major order exactly the cells of a block) or a binary of exactly a block
+ * of packed cells (written with no conversion nor copy).
+ *
+ * -spec h5d_exec_write( write_plan(), Offset::dimensions(),
+ *                       data() | binary() ) -> 'ok' | error().
+ *
+ */
+ERL_NIF_TERM h5d_exec_write( ErlNifEnv* env, int argc,
+  const ERL_NIF_TERM argv[] )
+{
+
+  if ( argc != 3 )
+	return error_tuple( env, "Incorrect number of arguments" ) ;
+
+  WritePlan * plan ;
+
+  if ( ! enif_get_resource( env, argv[0], write_plan_type, (void**) &plan ) )
+	return error_tuple( env, "Cannot get write plan from argv" ) ;
+
+  if ( plan->dataset->id < 0 )
+	return error_tuple( env, "Dataset of the write plan already closed" ) ;
+
+  hsize_t offset[ H5S_MAX_RANK ] ;
+
+  if ( ! get_dimension_tuple( env, argv[1], plan->rank, offset ) )
+	return error_tuple( env, "Offset does not match the rank of the dataset" ) ;
+
+  int i ;
+
+  // Rejected first, so that the ends of the block computed below cannot wrap:
+  for ( i = 0; i < plan->rank; i++ )
+	if ( offset[i] > HSIZE_UNDEF - plan->shape[i] )
+	  return error_tuple( env, "Block exceeds the extent of the dataset" ) ;
+
+  // The dataset may have been extended since the extent was last fetched:
+  for ( i = 0; i < plan->rank; i++ )
+	if ( offset[i] + plan->shape[i] > plan->extent[i] )
+	{
+
+	  if ( ! refresh_file_dataspace( plan ) )
+		return error_tuple( env, "Cannot get the dataspace of the dataset" ) ;
+
+	  break ;
+
+	}
+
+  for ( i = 0; i < plan->rank; i++ )
+	if ( offset[i] + plan->shape[i] > plan->extent[i] )
+	  return error_tuple( env, "Block exceeds the extent of the dataset" ) ;
+
+  const void * source ;
+
+  ErlNifBinary data ;
+
+  if ( enif_inspect_binary( env, argv[2], &data ) )
+  {
+
+	if ( data.size != plan->cell_count * plan->cell_size )
+	  return error_tuple( env,
+		"Binary size does not match a block of the plan" ) ;
+
+	source = data.data ;
+
+  }
+  else
+  {
+
+	const char * error_message = fill_plan_buffer( env, plan, argv[2] ) ;
+
+	if ( error_message )
+	  return error_tuple( env, (char *) error_message ) ;
+
+	source = plan->buffer ;
+
+  }
+
+  if ( H5Sselect_hyperslab( plan->file_dataspace_id, H5S_SELECT_SET, offset,
+	  /* stride */ NULL, /* count */ plan->shape, /* block */ NULL ) < 0 )
+	return error_tuple( env, "Cannot select the block in the dataset" ) ;
+
+  herr_t status = H5Dwrite(
+	  /* target */ plan->dataset->id,
+	  /* cell type */ plan->mem_type_id,
+	  /* memory and selection dataspace */ plan->mem_dataspace_id,
+	  /* selection within the file dataset's dataspace */
+	  plan->file_dataspace_id,
+	  /* default data transfer properties */ H5P_DEFAULT,
+	  /* source location */ source ) ;
+
+  // Blocks being written within the extent, they may overwrite cells:
+  update_zone_map( plan->dataset, plan->file_dataspace_id, HSIZE_UNDEF,
+	plan->mem_type_id, source, /* written */ status >= 0 ) ;
+
+  if ( status < 0 )
+	return error_tuple( env, "Failed to write block into dataset" ) ;
+
+  return atom_ok ;
+
+}
@@ -0,0 +1,1257 @@
+/* This file is part of erlhdf5 */
+
+/* erlhdf5 is free software: you can redistribute it and/or modify */
+/* it under the terms of the GNU Lesser General Public License as */
+/* published by the Free Software Foundation, either version 3 of */
+/* the License, or (at your option) any later version. */
+
+/* erlhdf5 is distributed in the hope that it will be useful, */
+/* but WITHOUT ANY WARRANTY; without even the implied warranty of */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the */
+/* GNU Lesser General Public License for more details. */
+
+/* You should have received a copy of the GNU Lesser General Public */
+/* License along with erlhdf5.  If not, see */
+/* <http://www.gnu.org/licenses/>. */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+
+#include "hdf5.h"
+
+#include "erl_nif.h"
+
+#include "dbg.h"
+
+#include "erlhdf5.h"
+
+
+/*
+ * Streaming scans of dataset selections.
+ *
+ * Analytical queries (ex: the mean of a day of samples) would otherwise read
+ * their whole selection into Erlang terms, only to fold them in Erlang.
+ *
+ * Here the selection is read piece by piece into a fixed-size buffer of
+ * doubles (HDF5 converting the cells of any numeric type), and each piece is
+ * handed over to a scan function, which folds it into its own state; memory
+ * use is thus bounded, whatever the size of the selection.
+ *
+ * Hyperslab (and full) selections are cut into slabs of consecutive rows (i.e.
+ * along the first dimension), aligned on the chunks of the dataset if it is
+ * chunked, so that each chunk is read (and decompressed) only once; point
+ * selections are cut into batches of points.
+ *
+ * Pieces are handed over in the order of the selection, so that the position of
+ * a cell within the selection is known to the scan function.
+ *
+ */
+
+
+// Maximum number of cells read at once (i.e. 512 KiB of doubles):
+#define SCAN_BUFFER_CELLS ( 64 * 1024 )
+
+
+// Number of independent accumulators, so that the loops can be vectorized:
+#define AGGREGATE_LANES 8
+
+
+
+/*
+ * Determines how many rows (i.e. elements along the first dimension) of
+ * specified dataset are to be read per slab, and the alignment of the first
+ * slab, so that slabs span whole chunks whenever possible.
+ *
+ */
+static void get_slab_rows( hid_t dataset_id, int rank, hsize_t row_cells,
+  hsize_t* slab_rows, hsize_t* alignment )
+{
+
+  *slab_rows = SCAN_BUFFER_CELLS / row_cells ;
+
+  // Rows larger than the buffer are still read one at a time:
+  if ( *slab_rows == 0 )
+	*slab_rows = 1 ;
+
+  *alignment = 1 ;
+
+  hid_t dcpl_id = H5Dget_create_plist( dataset_id ) ;
+
+  if ( dcpl_id < 0 )
+	return ;
+
+  hsize_t chunk_dims[ H5S_MAX_RANK ] ;
+
+  if ( H5Pget_layout( dcpl_id ) == H5D_CHUNKED
+	&& H5Pget_chunk( dcpl_id, rank, chunk_dims ) == rank
+	&& *slab_rows >= chunk_dims[0] )
+  {
+
+	*slab_rows -= *slab_rows % chunk_dims[0] ;
+	*alignment = chunk_dims[0] ;
+
+  }
+
+  H5Pclose( dcpl_id ) ;
+
+}
+
+
+
+/*
+ * Reads the cells selected by specified file dataspace into specified buffer,
+ * and hands them over to specified scan function.
+ *
+ */
+static const char * scan_piece( hid_t dataset_id, hid_t piece_space_id,
+  double* buffer, hsize_t* position, scan_function scan, void* state )
+{
+
+  hssize_t count = H5Sget_select_npoints( piece_space_id ) ;
+
+  if ( count < 0 )
+	return "Cannot determine the size of the selection" ;
+
+  if ( count == 0 )
+	return NULL ;
+
+  if ( ! read_buffer_from_dataset( dataset_id, H5T_NATIVE_DOUBLE, count,
+	  buffer, piece_space_id ) )
+	return "Failed to read dataset" ;
+
+  const char * error_message = scan( buffer, count, *position, state ) ;
+
+  *position += count ;
+
+  return error_message ;
+
+}
+
+
+
+/*
+ * Scans the hyperslab (or full) selection of specified dataspace, slab by slab.
+ *
+ */
+static const char * scan_slabs( hid_t dataset_id, hid_t space_id,
+  scan_function scan, void* state )
+{
+
+  hsize_t extent[ H5S_MAX_RANK ] ;
+
+  int rank = H5Sget_simple_extent_dims( space_id, extent, NULL ) ;
+
+  if ( rank < 1 )
+	return "Cannot get the dimensions of the dataset" ;
+
+  hsize_t start[ H5S_MAX_RANK ] ;
+  hsize_t end[ H5S_MAX_RANK ] ;
+
+  if ( H5Sget_select_bounds( space_id, start, end ) < 0 )
+	return "Cannot get the bounds of the selection" ;
+
+  hsize_t row_cells = 1 ;
+  int i ;
+
+  for ( i = 1; i < rank; i++ )
+	row_cells *= extent[i] ;
+
+  hsize_t slab_rows ;
+  hsize_t alignment ;
+
+  get_slab_rows( dataset_id, rank, row_cells, &slab_rows, &alignment ) ;
+
+  double * buffer = (double *) enif_alloc( slab_rows * row_cells
+	* sizeof( double ) ) ;
+
+  if ( buffer == NULL )
+	return "Cannot allocate scan buffer" ;
+
+  // A full selection is just replaced by each slab, otherwise intersected:
+  bool all = ( H5Sget_select_type( space_id ) == H5S_SEL_ALL ) ;
+
+  hsize_t offset[ H5S_MAX_RANK ] = { 0 } ;
+  hsize_t count[ H5S_MAX_RANK ] ;
+
+  for ( i = 1; i < rank; i++ )
+	count[i] = extent[i] ;
+
+  hsize_t position = 0 ;
+  const char * error_message = NULL ;
+
+  hsize_t row ;
+
+  for ( row = start[0] - start[0] % alignment ; row <= end[0] ;
+		row += slab_rows )
+  {
+
+	hid_t slab_space_id = H5Scopy( space_id ) ;
+
+	if ( slab_space_id < 0 )
+	{
+	  error_message = "Cannot copy dataspace" ;
+	  break ;
+	}
+
+	offset[0] = row ;
+	count[0] = ( extent[0] - row < slab_rows ) ? extent[0] - row : slab_rows ;
+
+	if ( H5Sselect_hyperslab( slab_space_id,
+		all ? H5S_SELECT_SET : H5S_SELECT_AND, offset, NULL, count,
+		NULL ) < 0 )
+	  error_message = "Slab selection failed" ;
+	else
+	  error_message = scan_piece( dataset_id, slab_space_id, buffer,
+		&position, scan, state ) ;
+
+	H5Sclose( slab_space_id ) ;
+
+	if ( error_message )
+	  break ;
+
+  }
+
+  enif_free( buffer ) ;
+
+  return error_message ;
+
+}
+
+
+
+/*
+ * Scans the point selection of specified dataspace, batch by batch.
+ *
+ */
+static const char * scan_points( hid_t dataset_id, hid_t space_id,
+  hsize_t point_count, scan_function scan, void* state )
+{
+
+  int rank = H5Sget_simple_extent_ndims( space_id ) ;
+
+  if ( rank < 1 )
+	return "Cannot get the dimensions of the dataset" ;
+
+  hsize_t batch_points = ( point_count < SCAN_BUFFER_CELLS ) ?
+	point_count : SCAN_BUFFER_CELLS ;
+
+  double * buffer = (double *) enif_alloc( batch_points * sizeof( double ) ) ;
+
+  hsize_t * coords = (hsize_t *) enif_alloc( batch_points * rank
+	* sizeof( hsize_t ) ) ;
+
+  const char * error_message = NULL ;
+
+  if ( buffer == NULL || coords == NULL )
+  {
+	error_message = "Cannot allocate scan buffer" ;
+	goto end ;
+  }
+
+  hsize_t position = 0 ;
+
+  while ( position < point_count && error_message == NULL )
+  {
+
+	hsize_t batch = point_count - position ;
+
+	if ( batch > batch_points )
+	  batch = batch_points ;
+
+	if ( H5Sget_select_elem_pointlist( space_id, position, batch,
+		coords ) < 0 )
+	{
+	  error_message = "Cannot get the selected points" ;
+	  break ;
+	}
+
+	hid_t batch_space_id = H5Scopy( space_id ) ;
+
+	if ( batch_space_id < 0 )
+	{
+	  error_message = "Cannot copy dataspace" ;
+	  break ;
+	}
+
+	if ( H5Sselect_elements( batch_space_id, H5S_SELECT_SET, batch,
+		coords ) < 0 )
+	  error_message = "Point selection failed" ;
+	else
+	  error_message = scan_piece( dataset_id, batch_space_id, buffer,
+		&position, scan, state ) ;
+
+	H5Sclose( batch_space_id ) ;
+
+  }
+
+ end:
+  if ( buffer )
+	enif_free( buffer ) ;
+
+  if ( coords )
+	enif_free( coords ) ;
+
+  return error_message ;
+
+}
+
+
+
+/*
+ * Scans the cells selected by specified file dataspace (H5S_ALL meaning the
+ * full extent) of specified dataset, handing them over as doubles, piece by
+ * piece and in the order of the selection, to specified scan function.
+ *
+ * Returns NULL on success, otherwise an error message (either from this scan
+ * or from the scan function, which stops it).
+ *
+ */
+const char * scan_selection( hid_t dataset_id, hid_t file_dataspace_id,
+  scan_function scan, void* state )
+{
+
+  // Works on a copy, so that the selection of the caller is left as is:
+  hid_t space_id = ( file_dataspace_id == H5S_ALL ) ?
+	H5Dget_space( dataset_id ) : H5Scopy( file_dataspace_id ) ;
+
+  if ( space_id < 0 )
+	return "Cannot get the dataspace of the dataset" ;
+
+  const char * error_message = NULL ;
+
+  hssize_t selected_count = H5Sget_select_npoints( space_id ) ;
+
+  if ( selected_count < 0 )
+	error_message = "Cannot determine the size of the selection" ;
+  else if ( selected_count > 0 )
+  {
+
+	switch ( H5Sget_select_type( space_id ) )
+	{
+
+	case H5S_SEL_ALL:
+	case H5S_SEL_HYPERSLABS:
+	  error_message = scan_slabs( dataset_id, space_id, scan, state ) ;
+	  break ;
+
+	case H5S_SEL_POINTS:
+	  error_message = scan_points( dataset_id, space_id, selected_count,
+		scan, state ) ;
+	  break ;
+
+	default:
+	  error_message = "Unsupported selection" ;
+	  break ;
+
+	}
+
+  }
+
+  H5Sclose( space_id ) ;
+
+  return error_message ;
+
+}
+
+
+
+/*
+ * Selects, in a copy of the dataspace of specified series (a monodimensional
+ * dataset), the range of cells specified by specified term: either
+ * {Start, Count} or 'all'.
+ *
+ * Returns that file dataspace (to be closed by the caller) and sets start and
+ * count, or returns a negative value and sets error_message.
+ *
+ */
+hid_t select_series_range( ErlNifEnv* env, hid_t dataset_id,
+  ERL_NIF_TERM range_term, hsize_t* start, hsize_t* count,
+  const char** error_message )
+{
+
+  hid_t file_dataspace_id = H5Dget_space( dataset_id ) ;
+
+  if ( file_dataspace_id < 0 )
+  {
+	*error_message = "Cannot get the dataspace of the dataset" ;
+	return -1 ;
+  }
+
+  hsize_t extent ;
+
+  if ( H5Sget_simple_extent_ndims( file_dataspace_id ) != 1
+	|| H5Sget_simple_extent_dims( file_dataspace_id, &extent, NULL ) != 1 )
+  {
+	*error_message = "Not a series (monodimensional dataset)" ;
+	goto error ;
+  }
+
+  *start = 0 ;
+  *count = extent ;
+
+  char range_atom[ 4 ] ;
+  int arity ;
+  const ERL_NIF_TERM * range ;
+
+  if ( enif_get_atom( env, range_term, range_atom, sizeof( range_atom ),
+	  ERL_NIF_LATIN1 ) )
+  {
+
+	if ( strcmp( range_atom, "all" ) != 0 )
+	{
+	  *error_message = "Cannot get range from argv" ;
+	  goto error ;
+	}
+
+  }
+  else if ( ! enif_get_tuple( env, range_term, &arity, &range ) || arity != 2
+	|| ! get_hsize( env, range[0], start )
+	|| ! get_hsize( env, range[1], count ) )
+  {
+	*error_message = "Cannot get range from argv" ;
+	goto error ;
+  }
+  else if ( *start > extent || *count > extent - *start )
+  {
+	*error_message = "Range exceeds the extent of the dataset" ;
+	goto error ;
+  }
+
+  herr_t status = ( *count == 0 ) ? H5Sselect_none( file_dataspace_id )
+	: H5Sselect_hyperslab( file_dataspace_id, H5S_SELECT_SET, start, NULL,
+	  count, NULL ) ;
+
+  if ( status < 0 )
+  {
+	*error_message = "Range selection failed" ;
+	goto error ;
+  }
+
+  return file_dataspace_id ;
+
+ error:
+  H5Sclose( file_dataspace_id ) ;
+  return -1 ;
+
+}
+
+
+
+// Predicate scans:
+
+
+typedef enum
+{
+  PREDICATE_GT,
+  PREDICATE_GE,
+  PREDICATE_LT,
+  PREDICATE_LE,
+  PREDICATE_EQ,
+  PREDICATE_NE,
+  PREDICATE_BETWEEN,
+  PREDICATE_OUTSIDE,
+  PREDICATE_IS_NAN,
+  PREDICATE_IS_INF,
+  PREDICATE_NOT_FINITE
+} predicate_type ;
+
+
+typedef struct
+{
+
+  predicate_type type ;
+
+  // Operands (the second one only for ranges):
+  double a ;
+  double b ;
+
+  // Index of the first cell of the range:
+  hsize_t start ;
+
+  // Whether matches are reported as ranges rather than as indexes:
+  bool ranges ;
+
+  // Current run of matches (for ranges), empty if its length is zero:
+  hsize_t run_start ;
+  hsize_t run_length ;
+
+  // Packed, native uint64 indexes (or start and length of ranges) so far:
+  ErlNifBinary output ;
+  size_t output_size ;
+
+} PredicateScan ;
+
+
+// Number of cells whose predicate is evaluated at once:
+#define PREDICATE_BLOCK_CELLS 4096
+
+
+// Evaluates specified test on each of the cells of the current block:
+#define EVALUATE( test )                         \
+  for ( i = 0; i < count; i++ )                  \
+  {                                              \
+	double v = cells[i] ;                        \
+	mask[i] = ( test ) ;                         \
+  }
+
+
+
+/*
+ * Evaluates the predicate of specified scan on each of specified cells, setting
+ * accordingly specified mask; each loop has no branch, so that comparisons can
+ * be vectorized.
+ *
+ */
+static void evaluate_predicate( const PredicateScan* scan, const double* cells,
+  size_t count, unsigned char* mask )
+{
+
+  const double a = scan->a ;
+  const double b = scan->b ;
+
+  size_t i ;
+
+  switch ( scan->type )
+  {
+
+  case PREDICATE_GT:
+	EVALUATE( v > a ) ;
+	break ;
+
+  case PREDICATE_GE:
+	EVALUATE( v >= a ) ;
+	break ;
+
+  case PREDICATE_LT:
+	EVALUATE( v < a ) ;
+	break ;
+
+  case PREDICATE_LE:
+	EVALUATE( v <= a ) ;
+	break ;
+
+  case PREDICATE_EQ:
+	EVALUATE( v == a ) ;
+	break ;
+
+  case PREDICATE_NE:
+	EVALUATE( ( v == v ) & ( v != a ) ) ;
+	break ;
+
+  case PREDICATE_BETWEEN:
+	EVALUATE( ( v >= a ) & ( v <= b ) ) ;
+	break ;
+
+  case PREDICATE_OUTSIDE:
+	EVALUATE( ( v < a ) | ( v > b ) ) ;
+	break ;
+
+  case PREDICATE_IS_NAN:
+	EVALUATE( v != v ) ;
+	break ;
+
+  case PREDICATE_IS_INF:
+	EVALUATE( ( v == INFINITY ) | ( v == -INFINITY ) ) ;
+	break ;
+
+  case PREDICATE_NOT_FINITE:
+	EVALUATE( ( v != v ) | ( v == INFINITY ) | ( v == -INFINITY ) ) ;
+	break ;
+
+  }
+
+}
+
+
+
+/*
+ * Appends specified value to the output of specified scan.
+ *
+ */
+static bool output_uint64( PredicateScan* scan, uint64_t value )
+{
+
+  if ( scan->output_size + sizeof( value ) > scan->output.size
+	&& ! enif_realloc_binary( &scan->output, 2 * scan->output.size ) )
+	return false ;
+
+  memcpy( scan->output.data + scan->output_size, &value, sizeof( value ) ) ;
+  scan->output_size += sizeof( value ) ;
+
+  return true ;
+
+}
+
+
+
+/*
+ * Appends the current run of matches of specified scan, if any, to its output.
+ *
+ */
+static bool output_run( PredicateScan* scan )
+{
+
+  if ( scan->run_length == 0 )
+	return true ;
+
+  return output_uint64( scan, scan->run_start )
+	&& output_uint64( scan, scan->run_length ) ;
+
+}
+
+
+
+/*
+ * Reports the cells among specified ones that match the predicate of the
+ * specified scan.
+ *
+ */
+static const char * scan_predicate( const double* cells, size_t count,
+  hsize_t position, void* state )
+{
+
+  PredicateScan * scan = (PredicateScan *) state ;
+
+  unsigned char mask[ PREDICATE_BLOCK_CELLS ] ;
+
+  size_t done ;
+
+  for ( done = 0; done < count; done += PREDICATE_BLOCK_CELLS )
+  {
+
+	size_t block = ( count - done < PREDICATE_BLOCK_CELLS ) ?
+	  count - done : PREDICATE_BLOCK_CELLS ;
+
+	evaluate_predicate( scan, cells + done, block, mask ) ;
+
+	hsize_t index = scan->start + position + done ;
+
+	size_t i ;
+
+	for ( i = 0; i < block; i++ )
+	{
+
+	  if ( ! mask[i] )
+		continue ;
+
+	  if ( ! scan->ranges )
+	  {
+		if ( ! output_uint64( scan, index + i ) )
+		  return "Cannot allocate matches" ;
+	  }
+	  else if ( scan->run_length > 0
+		&& scan->run_start + scan->run_length == index + i )
+		scan->run_length++ ;
+	  else
+	  {
+		if ( ! output_run( scan ) )
+		  return "Cannot allocate matches" ;
+
+		scan->run_start = index + i ;
+		scan->run_length = 1 ;
+	  }
+
+	}
+
+  }
+
+  return NULL ;
+
+}
+
+
+
+/*
+ * Tells whether some of the specified number of cells of a zone having
+ * specified summary may match the predicate of specified scan (if not, the
+ * zone can be skipped).
+ *
+ */
+static bool zone_may_match( const PredicateScan* scan, const Zone* zone,
+  hsize_t cells )
+{
+
+  if ( zone->count < 0 )
+	return true ;
+
+  const double a = scan->a ;
+  const double b = scan->b ;
+
+  // Except for NaN tests, zones having only NaN cells cannot match:
+  bool some = zone->count > 0 ;
+
+  switch ( scan->type )
+  {
+
+  case PREDICATE_GT:
+	return some && zone->max > a ;
+
+  case PREDICATE_GE:
+	return some && zone->max >= a ;
+
+  case PREDICATE_LT:
+	return some && zone->min < a ;
+
+  case PREDICATE_LE:
+	return some && zone->min <= a ;
+
+  case PREDICATE_EQ:
+	return some && zone->min <= a && zone->max >= a ;
+
+  case PREDICATE_NE:
+	return some && ! ( zone->min == a && zone->max == a ) ;
+
+  case PREDICATE_BETWEEN:
+	return some && zone->max >= a && zone->min <= b ;
+
+  case PREDICATE_OUTSIDE:
+	return some && ! ( zone->min >= a && zone->max <= b ) ;
+
+  case PREDICATE_IS_NAN:
+	return zone->count < cells ;
+
+  case PREDICATE_IS_INF:
+	return some && ( isinf( zone->min ) || isinf( zone->max ) ) ;
+
+  case PREDICATE_NOT_FINITE:
+	return zone->count < cells || isinf( zone->min ) || isinf( zone->max ) ;
+
+  }
+
+  return true ;
+
+}
+
+
+
+/*
+ * Scans, for specified predicate scan, the range of specified series from
+ * scan->start to specified end, reading only the runs of consecutive zones
+ * (see erlh5d_zonemap.c) that may match.
+ *
+ * Returns NULL on success, otherwise an error message.
+ *
+ */
+static const char * scan_zones( hid_t dataset_id, hid_t file_dataspace_id,
+  const ZoneMap* map, hsize_t end, PredicateScan* scan )
+{
+
+  const hsize_t range_start = scan->start ;
+
+  hsize_t i ;
+  hsize_t run = 0 ;
+
+  for ( i = 0; i <= map->count; i++ )
+  {
+
+	if ( i < map->count )
+	{
+
+	  hsize_t zone_start = ( map->first + i ) * map->zone_rows ;
+	  hsize_t zone_end = zone_start + map->zone_rows ;
+
+	  if ( zone_end > map->rows )
+		zone_end = map->rows ;
+
+	  if ( zone_may_match( scan, map->zones + i,
+		  ( zone_end - zone_start ) * map->row_cells ) )
+		continue ;
+
+	}
+
+	// Scans the run of zones [run, i[, clipped to the range:
+	if ( run < i )
+	{
+
+	  hsize_t start = ( map->first + run ) * map->zone_rows ;
+	  hsize_t stop = ( map->first + i ) * map->zone_rows ;
+
+	  if ( start < range_start )
+		start = range_start ;
+
+	  if ( stop > end )
+		stop = end ;
+
+	  hsize_t count = stop - start ;
+
+	  if ( H5Sselect_hyperslab( file_dataspace_id, H5S_SELECT_SET, &start,
+		  NULL, &count, NULL ) < 0 )
+		return "Range selection failed" ;
+
+	  scan->start = start ;
+
+	  const char * error_message = scan_selection( dataset_id,
+		file_dataspace_id, scan_predicate, scan ) ;
+
+	  if ( error_message )
+		return error_message ;
+
+	}
+
+	run = i + 1 ;
+
+  }
+
+  return NULL ;
+
+}
+
+
+
+/*
+ * Gets from specified term the predicate of specified scan.
+ *
+ * Returns whether the operation succeeded.
+ *
+ */
+static bool get_predicate( ErlNifEnv* env, ERL_NIF_TERM term,
+  PredicateScan* scan )
+{
+
+  static const struct
+  {
+	const char * name ;
+	predicate_type type ;
+	int operands ;
+  } predicates[] = {
+	{ "gt",         PREDICATE_GT,         1 },
+	{ "ge",         PREDICATE_GE,         1 },
+	{ "lt",         PREDICATE_LT,         1 },
+	{ "le",         PREDICATE_LE,         1 },
+	{ "eq",         PREDICATE_EQ,         1 },
+	{ "ne",         PREDICATE_NE,         1 },
+	{ "between",    PREDICATE_BETWEEN,    2 },
+	{ "outside",    PREDICATE_OUTSIDE,    2 },
+	{ "is_nan",     PREDICATE_IS_NAN,     0 },
+	{ "is_inf",     PREDICATE_IS_INF,     0 },
+	{ "not_finite", PREDICATE_NOT_FINITE, 0 }
+  } ;
+
+  int arity = 1 ;
+  const ERL_NIF_TERM * elements = &term ;
+
+  if ( ! enif_is_atom( env, term )
+	&& ! enif_get_tuple( env, term, &arity, &elements ) )
+	return false ;
+
+  char name[ MAXBUFLEN ] ;
+
+  if ( arity < 1 || ! enif_get_atom( env, elements[0], name, sizeof( name ),
+	  ERL_NIF_LATIN1 ) )
+	return false ;
+
+  size_t i ;
+
+  for ( i = 0; i < NUM_OF( predicates ); i++ )
+  {
+
+	if ( strcmp( name, predicates[i].name ) != 0 )
+	  continue ;
+
+	if ( arity != predicates[i].operands + 1 )
+	  return false ;
+
+	scan->type = predicates[i].type ;
+
+	double * operands[] = { &scan->a, &scan->b } ;
+	int j ;
+
+	for ( j = 0; j < predicates[i].operands; j++ )
+	{
+
+	  ErlNifSInt64 integer ;
+
+	  if ( enif_get_int64( env, elements[ j + 1 ], &integer ) )
+		*operands[j] = (double) integer ;
+	  else if ( ! enif_get_double( env, elements[ j + 1 ], operands[j] ) )
+		return false ;
+
+	}
+
+	return true ;
+
+  }
+
+  return false ;
+
+}
+
+
+
+/*
+ * Scans specified range of specified series (a monodimensional dataset) for the
+ * cells matching specified predicate, and returns their indexes, as a binary of
+ * packed, native unsigned 64-bit integers (hence usable as coordinates, see
+ * h5dread_points/3); with 'ranges', each run of consecutive matching cells is
+ * reported as its first index and its length instead.
+ *
+ * If the series has a zone map (see erlh5d_zonemap.c), the zones whose summary
+ * rules out any match are skipped, their chunks being neither read nor
+ * decompressed.
+ *
+ * This implementation corresponds to h5d_scan/{3,4}:
+ *
+ * -spec h5d_scan( dataset_handle(), series_range(), predicate() ) ->
+ *                 { 'ok', binary() } | error().
+ *
+ * and
+ *
+ * -spec h5d_scan( dataset_handle(), series_range(), predicate(),
+ *                 'indexes' | 'ranges' ) -> { 'ok', binary() } | error().
+ *
+ */
+ERL_NIF_TERM h5d_scan( ErlNifEnv* env, int argc, const ERL_NIF_TERM argv[] )
+{
+
+  if ( argc != 3 && argc != 4 )
+	return error_tuple( env, "Incorrect number of arguments" ) ;
+
+  Handle * dataset ;
+
+  if ( ! get_handle( env, argv[0], DATASET_HANDLE, &dataset )
+	|| dataset->id < 0 )
+	return error_tuple( env, "Cannot get dataset handle from argv" ) ;
+
+  hid_t dataset_id = dataset->id ;
+
+  PredicateScan scan ;
+
+  if ( ! get_predicate( env, argv[2], &scan ) )
+	return error_tuple( env, "Invalid predicate" ) ;
+
+  scan.ranges = false ;
+
+  if ( argc == 4 )
+  {
+
+	char format[ MAXBUFLEN ] ;
+
+	if ( ! enif_get_atom( env, argv[3], format, sizeof( format ),
+		ERL_NIF_LATIN1 ) )
+	  return error_tuple( env, "Cannot get output format from argv" ) ;
+
+	if ( strcmp( format, "ranges" ) == 0 )
+	  scan.ranges = true ;
+	else if ( strcmp( format, "indexes" ) != 0 )
+	  return error_tuple( env, "Unknown output format" ) ;
+
+  }
+
+  const char * error_message ;
+  hsize_t count ;
+
+  hid_t file_dataspace_id = select_series_range( env, dataset_id, argv[1],
+	&scan.start, &count, &error_message ) ;
+
+  if ( file_dataspace_id < 0 )
+	return error_tuple( env, (char *) error_message ) ;
+
+  scan.run_start = 0 ;
+  scan.run_length = 0 ;
+  scan.output_size = 0 ;
+
+  if ( ! enif_alloc_binary( 1024, &scan.output ) )
+  {
+	H5Sclose( file_dataspace_id ) ;
+	return error_tuple( env, "Cannot allocate matches" ) ;
+  }
+
+  ZoneMap map ;
+
+  error_message = read_zone_map( dataset, scan.start, scan.start + count,
+	&map ) ;
+
+  if ( error_message == NULL && map.zones != NULL )
+  {
+	error_message = scan_zones( dataset_id, file_dataspace_id, &map,
+	  scan.start + count, &scan ) ;
+	enif_free( map.zones ) ;
+  }
+  else if ( error_message == NULL )
+	error_message = scan_selection( dataset_id, file_dataspace_id,
+	  scan_predicate, &scan ) ;
+
+  H5Sclose( file_dataspace_id ) ;
+
+  if ( error_message == NULL && ! output_run( &scan ) )
+	error_message = "Cannot allocate matches" ;
+
+  if ( error_message == NULL
+	&& ! enif_realloc_binary( &scan.output, scan.output_size ) )
+	error_message = "Cannot allocate matches" ;
+
+  if ( error_message )
+  {
+	enif_release_binary( &scan.output ) ;
+	return error_tuple( env, (char *) error_message ) ;
+  }
+
+  return enif_make_tuple2( env, atom_ok, enif_make_binary( env,
+	  &scan.output ) ) ;
+
+}
+
+
+
+// Aggregates:
+
+
+// The aggregates that can be requested, as flags:
+enum
+{
+  AGGREGATE_SUM       = 1 << 0,
+  AGGREGATE_MIN       = 1 << 1,
+  AGGREGATE_MAX       = 1 << 2,
+  AGGREGATE_MEAN      = 1 << 3,
+  AGGREGATE_COUNT     = 1 << 4,
+  AGGREGATE_NAN_COUNT = 1 << 5
+} ;
+
+
+typedef struct
+{
+
+  // Number of cells scanned, NaN ones included:
+  hsize_t count ;
+
+  hsize_t nan_count ;
+
+  // Of the non-NaN cells:
+  double sum ;
+  double min ;
+  double max ;
+
+} Aggregates ;
+
+
+
+/*
+ * Folds specified cells into specified aggregates.
+ *
+ * NaN cells are counted, yet otherwise ignored (as all comparisons with them
+ * are false, they cannot be minimum nor maximum); each lane keeps its own
+ * accumulators, so that the main loop has no dependency between consecutive
+ * cells, and can be vectorized.
+ *
+ */
+static const char * aggregate_cells( const double* cells, size_t count,
+  hsize_t position, void* state )
+{
+
+  Aggregates * aggregates = (Aggregates *) state ;
+
+  double sum[ AGGREGATE_LANES ] ;
+  double min[ AGGREGATE_LANES ] ;
+  double max[ AGGREGATE_LANES ] ;
+  hsize_t nan_count[ AGGREGATE_LANES ] ;
+
+  size_t lane ;
+
+  for ( lane = 0; lane < AGGREGATE_LANES; lane++ )
+  {
+	sum[lane] = 0.0 ;
+	min[lane] = INFINITY ;
+	max[lane] = -INFINITY ;
+	nan_count[lane] = 0 ;
+  }
+
+  size_t body = count - count % AGGREGATE_LANES ;
+  size_t i ;
+
+  for ( i = 0; i < body; i += AGGREGATE_LANES )
+  {
+
+	for ( lane = 0; lane < AGGREGATE_LANES; lane++ )
+	{
+
+	  double value = cells[ i + lane ] ;
+	  bool is_nan = ( value != value ) ;
+
+	  nan_count[lane] += is_nan ;
+	  sum[lane] += is_nan ? 0.0 : value ;
+	  min[lane] = ( value < min[lane] ) ? value : min[lane] ;
+	  max[lane] = ( value > max[lane] ) ? value : max[lane] ;
+
+	}
+
+  }
+
+  for ( ; i < count; i++ )
+  {
+
+	double value = cells[i] ;
+	bool is_nan = ( value != value ) ;
+
+	nan_count[0] += is_nan ;
+	sum[0] += is_nan ? 0.0 : value ;
+	min[0] = ( value < min[0] ) ? value : min[0] ;
+	max[0] = ( value > max[0] ) ? value : max[0] ;
+
+  }
+
+  for ( lane = 0; lane < AGGREGATE_LANES; lane++ )
+  {
+
+	aggregates->nan_count += nan_count[lane] ;
+	aggregates->sum += sum[lane] ;
+
+	if ( min[lane] < aggregates->min )
+	  aggregates->min = min[lane] ;
+
+	if ( max[lane] > aggregates->max )
+	  aggregates->max = max[lane] ;
+
+  }
+
+  aggregates->count += count ;
+
+  return NULL ;
+
+}
+
+
+
+/*
+ * Gets from specified list of aggregate names the corresponding flags.
+ *
+ * Returns whether the operation succeeded.
+ *
+ */
+static bool get_aggregate_flags( ErlNifEnv* env, ERL_NIF_TERM list,
+  int* flags )
+{
+
+  ERL_NIF_TERM head ;
+  char name[ MAXBUFLEN ] ;
+
+  *flags = 0 ;
+
+  while ( enif_get_list_cell( env, list, &head, &list ) )
+  {
+
+	if ( ! enif_get_atom( env, head, name, sizeof( name ), ERL_NIF_LATIN1 ) )
+	  return false ;
+
+	if ( strcmp( name, "sum" ) == 0 )
+	  *flags |= AGGREGATE_SUM ;
+	else if ( strcmp( name, "min" ) == 0 )
+	  *flags |= AGGREGATE_MIN ;
+	else if ( strcmp( name, "max" ) == 0 )
+	  *flags |= AGGREGATE_MAX ;
+	else if ( strcmp( name, "mean" ) == 0 )
+	  *flags |= AGGREGATE_MEAN ;
+	else if ( strcmp( name, "count" ) == 0 )
+	  *flags |= AGGREGATE_COUNT ;
+	else if ( strcmp( name, "nan_count" ) == 0 )
+	  *flags |= AGGREGATE_NAN_COUNT ;
+	else
+	  return false ;
+
+  }
+
+  return enif_is_empty_list( env, list ) ;
+
+}
+
+
+
+/*
+ * Adds to specified map the specified value, associated to the atom of
+ * specified name.
+ *
+ */
+static ERL_NIF_TERM put_value( ErlNifEnv* env, ERL_NIF_TERM map,
+  const char* name, ERL_NIF_TERM value )
+{
+
+  ERL_NIF_TERM new_map ;
+
+  enif_make_map_put( env, map, enif_make_atom( env, name ), value, &new_map ) ;
+
+  return new_map ;
+
+}
+
+
+
+/*
+ * Computes, in a single streaming pass, the specified aggregates of the cells
+ * selected by specified file dataspace of specified dataset, and returns them
+ * as a map.
+ *
+ * Cells are read as doubles, whatever their type; NaN cells are only counted
+ * (by count and nan_count); min, max and mean are 'undefined' if there is no
+ * non-NaN cell.
+ *
+ * -spec h5d_aggregate( dataset_handle(), file_dataspace(), [ aggregate() ] ) ->
+ *        { 'ok', #{ aggregate() => number() | 'inf' | 'nan' | 'undefined' } }
+ *        | error().
+ *
+ */
+ERL_NIF_TERM h5d_aggregate( ErlNifEnv* env, int argc,
+  const ERL_NIF_TERM argv[] )
+{
+
+  if ( argc != 3 )
+	return error_tuple( env, "Incorrect number of arguments" ) ;
+
+  hid_t dataset_id ;
+
+  if ( ! get_handle_id( env, argv[0], DATASET_HANDLE, &dataset_id ) )
+	return error_tuple( env, "Cannot get dataset handle from argv" ) ;
+
+  hid_t file_dataspace_id ;
+
+  if ( ! get_file_dataspace( env, argv[1], &file_dataspace_id ) )
+	return error_tuple( env, "Cannot get dataspace handle from argv" ) ;
+
+  int flags ;
+
+  if ( ! get_aggregate_flags( env, argv[2], &flags ) )
+	return error_tuple( env, "Invalid list of aggregates" ) ;
+
+  Aggregates aggregates = { 0, 0, 0.0, INFINITY, -INFINITY } ;
+
+  const char * error_message = scan_selection( dataset_id, file_dataspace_id,
+	aggregate_cells, &aggregates ) ;
+
+  if ( error_message )
+	return error_tuple( env, (char *) error_message ) ;
+
+  hsize_t value_count = aggregates.count - aggregates.nan_count ;
+
+  ERL_NIF_TERM undefined = enif_make_atom( env, "undefined" ) ;
+
+  ERL_NIF_TERM map = enif_make_new_map( env ) ;
+
+  if ( flags & AGGREGATE_SUM )
+	map = put_value( env, map, "sum",
+	  make_double_term( env, aggregates.sum ) ) ;
+
+  if ( flags & AGGREGATE_MIN )
+	map = put_value( env, map, "min", value_count ?
+	  make_double_term( env, aggregates.min ) : undefined ) ;
+
+  if ( flags & AGGREGATE_MAX )
+	map = put_value( env, map, "max", value_count ?
+	  make_double_term( env, aggregates.max ) : undefined ) ;
+
+  if ( flags & AGGREGATE_MEAN )
+	map = put_value( env, map, "mean", value_count ?
+	  make_double_term( env, aggregates.sum / value_count ) : undefined ) ;
+
+  if ( flags & AGGREGATE_COUNT )
+	map = put_value( env, map, "count",
+	  enif_make_uint64( env, aggregates.count ) ) ;
+
+  if ( flags & AGGREGATE_NAN_COUNT )
+	map = put_value( env, map, "nan_count",
+	  enif_make_uint64( env, aggregates.nan_count ) ) ;
+
+  return enif_make_tuple2( env, atom_ok, map ) ;
+
+}
@@ -0,0 +1,1118 @@
+/* This file is part of erlhdf5 */
+
+/* erlhdf5 is free software: you can redistribute it and/or modify */
+/* it under the terms of the GNU Lesser General Public License as */
+/* published by the Free Software Foundation, either version 3 of */
+/* the License, or (at your option) any later version. */
+
+/* erlhdf5 is distributed in the hope that it will be useful, */
+/* but WITHOUT ANY WARRANTY; without even the implied warranty of */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the */
+/* GNU Lesser General Public License for more details. */
+
+/* You should have received a copy of the GNU Lesser General Public */
+/* License along with erlhdf5.  If not, see */
+/* <http://www.gnu.org/licenses/>. */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <float.h>
+#include <math.h>
+
+#include "hdf5.h"
+
+#include "erl_nif.h"
+
+#include "dbg.h"
+
+#include "erlhdf5.h"
+
+
+/*
+ * Distributions of the cells of datasets: fixed-bin histograms and quantile
+ * sketches, both computed in a single streaming pass (see erlh5d_scan.c), with
+ * a memory use that does not depend on the number of cells.
+ *
+ * Quantiles are estimated from a logarithmic sketch (as DDSketch): each
+ * non-zero value x is counted in the bucket of key ceil( log_gamma( |x| ) ),
+ * gamma being ( 1 + alpha ) / ( 1 - alpha ), so that any quantile is returned
+ * with a relative error of at most alpha (ex: 1%). Positive and negative values
+ * have their own store of buckets, and (nearly) zero ones their own counter.
+ *
+ * A store spans at most SKETCH_MAX_BUCKETS consecutive keys (i.e., for an
+ * accuracy of 1%, about 17 decades); should values span more, the lowest
+ * buckets are collapsed, so that the upper quantiles (ex: p99 and p999 of
+ * latencies) keep their accuracy.
+ *
+ * Sketches of the same accuracy can be merged exactly, hence are returned as
+ * binaries (in a portable, big-endian format), so that the sketches of several
+ * files can be stored, sent and merged later.
+ *
+ */
+
+
+// Maximum number of bins of an histogram:
+#define MAX_HISTOGRAM_BINS ( 1 << 16 )
+
+// Maximum number of buckets of each store of a sketch:
+#define SKETCH_MAX_BUCKETS 2048
+
+// Finest relative accuracy, so that all keys fit in 32 bits:
+#define SKETCH_MIN_ACCURACY 1e-4
+
+// Header of a serialized sketch (the last character being its version):
+#define SKETCH_MAGIC "ESK2"
+
+// Magic, accuracy, then total (non-NaN), zero and NaN counts, then minimum and
+// maximum:
+#define SKETCH_HEADER_SIZE ( 4 + 8 + 3 * 8 + 2 * 8 )
+
+// Offset and length of a store, before its counts:
+#define STORE_HEADER_SIZE ( 4 + 4 )
+
+
+
+// Fixed-bin histograms:
+
+
+typedef struct
+{
+
+  double low ;
+  double high ;
+
+  // Number of bins over [low, high]:
+  size_t bins ;
+
+  // Bins per unit of value:
+  double scale ;
+
+  // The counts of the bins, then of the cells below, above, and NaN:
+  uint64_t * counts ;
+
+} Histogram ;
+
+
+// Indexes, after the bins, of the extra counts of an histogram:
+#define HISTOGRAM_BELOW 0
+#define HISTOGRAM_ABOVE 1
+#define HISTOGRAM_NAN   2
+
+
+
+/*
+ * Gets from specified term (an integer or a float) the corresponding double.
+ *
+ * Returns whether the operation succeeded.
+ *
+ */
+static bool get_number( ErlNifEnv* env, ERL_NIF_TERM term, double* value )
+{
+
+  if ( enif_get_double( env, term, value ) )
+	return true ;
+
+  ErlNifSInt64 integer ;
+
+  if ( ! enif_get_int64( env, term, &integer ) )
+	return false ;
+
+  *value = (double) integer ;
+
+  return true ;
+
+}
+
+
+
+/*
+ * Counts specified cells in the bins of specified histogram; bins are
+ * half-open, except the last one, which includes the upper bound.
+ *
+ */
+static const char * histogram_cells( const double* cells, size_t count,
+  hsize_t position, void* state )
+{
+
+  Histogram * histogram = (Histogram *) state ;
+
+  uint64_t * counts = histogram->counts ;
+  size_t bins = histogram->bins ;
+  double low = histogram->low ;
+  double high = histogram->high ;
+  double scale = histogram->scale ;
+
+  size_t i ;
+
+  for ( i = 0; i < count; i++ )
+  {
+
+	double value = cells[i] ;
+	size_t index ;
+
+	if ( value >= low && value < high )
+	{
+
+	  index = (size_t) ( ( value - low ) * scale ) ;
+
+	  // Guards against rounding, for values just below the upper bound:
+	  if ( index >= bins )
+		index = bins - 1 ;
+
+	}
+	else if ( value == high )
+	  index = bins - 1 ;
+	else if ( value < low )
+	  index = bins + HISTOGRAM_BELOW ;
+	else if ( value > high )
+	  index = bins + HISTOGRAM_ABOVE ;
+	else
+	  index = bins + HISTOGRAM_NAN ;
+
+	counts[index]++ ;
+
+  }
+
+  return NULL ;
+
+}
+
+
+
+/*
+ * Counts, in a single streaming pass, the cells selected by specified file
+ * dataspace of specified dataset in the specified number of bins of equal
+ * width spanning [Low, High].
+ *
+ * -spec h5d_histogram( dataset_handle(), file_dataspace(),
+ *                      { Low::number(), High::number(), Bins::pos_integer() } )
+ *   -> { 'ok', #{ 'counts' => [ non_neg_integer() ],
+ *                 'below' | 'above' | 'nan_count' => non_neg_integer() } }
+ *      | error().
+ *
+ */
+ERL_NIF_TERM h5d_histogram( ErlNifEnv* env, int argc,
+  const ERL_NIF_TERM argv[] )
+{
+
+  if ( argc != 3 )
+	return error_tuple( env, "Incorrect number of arguments" ) ;
+
+  hid_t dataset_id ;
+
+  if ( ! get_handle_id( env, argv[0], DATASET_HANDLE, &dataset_id ) )
+	return error_tuple( env, "Cannot get dataset handle from argv" ) ;
+
+  hid_t file_dataspace_id ;
+
+  if ( ! get_file_dataspace( env, argv[1], &file_dataspace_id ) )
+	return error_tuple( env, "Cannot get dataspace handle from argv" ) ;
+
+  int arity ;
+  const ERL_NIF_TERM * spec ;
+  Histogram histogram ;
+
+  if ( ! enif_get_tuple( env, argv[2], &arity, &spec ) || arity != 3
+	|| ! get_number( env, spec[0], &histogram.low )
+	|| ! get_number( env, spec[1], &histogram.high )
+	|| ! get_size( env, spec[2], &histogram.bins ) )
+	return error_tuple( env, "Cannot get histogram bins from argv" ) ;
+
+  if ( ! ( histogram.low < histogram.high ) || isinf( histogram.low )
+	|| isinf( histogram.high ) )
+	return error_tuple( env, "Invalid histogram bounds" ) ;
+
+  if ( histogram.bins == 0 || histogram.bins > MAX_HISTOGRAM_BINS )
+	return error_tuple( env, "Invalid number of histogram bins" ) ;
+
+  histogram.scale = histogram.bins / ( histogram.high - histogram.low ) ;
+
+  size_t count_size = ( histogram.bins + 3 ) * sizeof( uint64_t ) ;
+
+  histogram.counts = (uint64_t *) enif_alloc( count_size ) ;
+
+  if ( histogram.counts == NULL )
+	return error_tuple( env, "Cannot allocate histogram" ) ;
+
+  memset( histogram.counts, 0, count_size ) ;
+
+  const char * error_message = scan_selection( dataset_id, file_dataspace_id,
+	histogram_cells, &histogram ) ;
+
+  if ( error_message )
+  {
+	enif_free( histogram.counts ) ;
+	return error_tuple( env, (char *) error_message ) ;
+  }
+
+  ERL_NIF_TERM counts = enif_make_list( env, 0 ) ;
+
+  size_t i ;
+
+  for ( i = histogram.bins; i > 0; i-- )
+	counts = enif_make_list_cell( env,
+	  enif_make_uint64( env, histogram.counts[ i - 1 ] ), counts ) ;
+
+  uint64_t * extra = histogram.counts + histogram.bins ;
+
+  ERL_NIF_TERM keys[] = {
+	enif_make_atom( env, "counts" ),
+	enif_make_atom( env, "below" ),
+	enif_make_atom( env, "above" ),
+	enif_make_atom( env, "nan_count" )
+  } ;
+
+  ERL_NIF_TERM values[] = {
+	counts,
+	enif_make_uint64( env, extra[ HISTOGRAM_BELOW ] ),
+	enif_make_uint64( env, extra[ HISTOGRAM_ABOVE ] ),
+	enif_make_uint64( env, extra[ HISTOGRAM_NAN ] )
+  } ;
+
+  enif_free( histogram.counts ) ;
+
+  ERL_NIF_TERM map = enif_make_new_map( env ) ;
+
+  for ( i = 0; i < NUM_OF( keys ); i++ )
+	enif_make_map_put( env, map, keys[i], values[i], &map ) ;
+
+  return enif_make_tuple2( env, atom_ok, map ) ;
+
+}
+
+
+
+// Quantile sketches:
+
+
+typedef struct
+{
+
+  // Key of the first bucket:
+  int32_t offset ;
+
+  // Number of buckets in use:
+  uint32_t length ;
+
+  uint64_t counts[ SKETCH_MAX_BUCKETS ] ;
+
+} SketchStore ;
+
+
+typedef struct
+{
+
+  // Relative accuracy, and the corresponding logarithm of gamma:
+  double alpha ;
+  double log_gamma ;
+
+  // Counts of the values too small to be indexed, and of the NaN ones:
+  uint64_t zero_count ;
+  uint64_t nan_count ;
+
+  // Extreme non-NaN values (quantiles being clamped to them):
+  double min ;
+  double max ;
+
+  SketchStore positive ;
+  SketchStore negative ;
+
+} Sketch ;
+
+
+
+/*
+ * Initializes specified sketch, for specified relative accuracy.
+ *
+ */
+static void init_sketch( Sketch* sketch, double alpha )
+{
+
+  sketch->alpha = alpha ;
+  sketch->log_gamma = log( ( 1 + alpha ) / ( 1 - alpha ) ) ;
+  sketch->zero_count = 0 ;
+  sketch->nan_count = 0 ;
+  sketch->min = INFINITY ;
+  sketch->max = -INFINITY ;
+  sketch->positive.offset = 0 ;
+  sketch->positive.length = 0 ;
+  sketch->negative.offset = 0 ;
+  sketch->negative.length = 0 ;
+
+}
+
+
+
+/*
+ * Makes specified store span exactly the keys from low to high (at most
+ * SKETCH_MAX_BUCKETS of them), the counts of the keys below low, if any, being
+ * collapsed into the bucket of low.
+ *
+ */
+static void rebase_store( SketchStore* store, int64_t low, int64_t high )
+{
+
+  uint64_t counts[ SKETCH_MAX_BUCKETS ] ;
+
+  memset( counts, 0, sizeof( counts ) ) ;
+
+  uint32_t i ;
+
+  for ( i = 0; i < store->length; i++ )
+  {
+
+	int64_t key = (int64_t) store->offset + i ;
+
+	if ( key < low )
+	  key = low ;
+
+	counts[ key - low ] += store->counts[i] ;
+
+  }
+
+  store->offset = (int32_t) low ;
+  store->length = (uint32_t) ( high - low + 1 ) ;
+
+  memcpy( store->counts, counts, store->length * sizeof( uint64_t ) ) ;
+
+}
+
+
+
+/*
+ * Adds specified count to the bucket of specified key of specified store.
+ *
+ */
+static void add_to_store( SketchStore* store, int32_t key, uint64_t count )
+{
+
+  if ( store->length == 0 )
+  {
+
+	store->offset = key ;
+	store->length = 1 ;
+	store->counts[0] = count ;
+	return ;
+
+  }
+
+  int64_t low = store->offset ;
+  int64_t high = low + store->length - 1 ;
+
+  if ( key > high )
+  {
+
+	if ( key - low >= SKETCH_MAX_BUCKETS )
+	  low = (int64_t) key - SKETCH_MAX_BUCKETS + 1 ;
+
+	rebase_store( store, low, key ) ;
+
+  }
+  else if ( key < low )
+  {
+
+	// The lowest buckets are the ones to collapse:
+	if ( high - key >= SKETCH_MAX_BUCKETS )
+	{
+	  key = (int32_t) ( high - SKETCH_MAX_BUCKETS + 1 ) ;
+
+	  if ( key < low )
+		rebase_store( store, key, high ) ;
+	}
+	else
+	  rebase_store( store, key, high ) ;
+
+  }
+
+  store->counts[ key - store->offset ] += count ;
+
+}
+
+
+
+/*
+ * Returns the key of the bucket of specified (strictly positive, indexable)
+ * value.
+ *
+ */
+static inline int32_t sketch_key( const Sketch* sketch, double value )
+{
+
+  // Infinite values are counted with the largest finite ones:
+  if ( value > DBL_MAX )
+	value = DBL_MAX ;
+
+  return (int32_t) ceil( log( value ) / sketch->log_gamma ) ;
+
+}
+
+
+
+/*
+ * Returns the value representing the bucket of specified key, i.e. the one
+ * whose relative distance to all the values of that bucket is at most alpha.
+ *
+ */
+static double sketch_value( const Sketch* sketch, int32_t key )
+{
+
+  return 2 * exp( key * sketch->log_gamma ) / ( 1 + exp( sketch->log_gamma ) ) ;
+
+}
+
+
+
+/*
+ * Adds specified cells to specified sketch.
+ *
+ */
+static const char * sketch_cells( const double* cells, size_t count,
+  hsize_t position, void* state )
+{
+
+  Sketch * sketch = (Sketch *) state ;
+
+  size_t i ;
+
+  for ( i = 0; i < count; i++ )
+  {
+
+	double value = cells[i] ;
+
+	if ( value != value )
+	{
+	  sketch->nan_count++ ;
+	  continue ;
+	}
+
+	if ( value < sketch->min )
+	  sketch->min = value ;
+
+	if ( value > sketch->max )
+	  sketch->max = value ;
+
+	if ( value >= DBL_MIN )
+	  add_to_store( &sketch->positive, sketch_key( sketch, value ), 1 ) ;
+	else if ( value <= -DBL_MIN )
+	  add_to_store( &sketch->negative, sketch_key( sketch, -value ), 1 ) ;
+	else
+	  sketch->zero_count++ ;
+
+  }
+
+  return NULL ;
+
+}
+
+
+
+/*
+ * Returns the number of non-NaN values counted by specified sketch.
+ *
+ */
+static uint64_t sketch_count( const Sketch* sketch )
+{
+
+  uint64_t count = sketch->zero_count ;
+
+  uint32_t i ;
+
+  for ( i = 0; i < sketch->positive.length; i++ )
+	count += sketch->positive.counts[i] ;
+
+  for ( i = 0; i < sketch->negative.length; i++ )
+	count += sketch->negative.counts[i] ;
+
+  return count ;
+
+}
+
+
+
+/*
+ * Returns the estimate of specified quantile (in [0,1]) of the values counted
+ * by specified sketch, whose count is specified.
+ *
+ */
+static double sketch_quantile( const Sketch* sketch, uint64_t count,
+  double quantile )
+{
+
+  // Rank of the value, from 0:
+  uint64_t rank = (uint64_t) ( quantile * ( count - 1 ) ) ;
+
+  uint64_t seen = 0 ;
+  double value = 0.0 ;
+
+  // Negative values first, from the most negative ones (i.e. the highest keys):
+  const SketchStore * store = &sketch->negative ;
+  uint32_t i ;
+
+  for ( i = store->length; i > 0; i-- )
+  {
+
+	seen += store->counts[ i - 1 ] ;
+
+	if ( seen > rank )
+	{
+	  value = - sketch_value( sketch, store->offset + i - 1 ) ;
+	  goto clamp ;
+	}
+
+  }
+
+  seen += sketch->zero_count ;
+
+  if ( seen > rank )
+	goto clamp ;
+
+  store = &sketch->positive ;
+
+  for ( i = 0; i < store->length; i++ )
+  {
+
+	seen += store->counts[i] ;
+
+	if ( seen > rank )
+	{
+	  value = sketch_value( sketch, store->offset + i ) ;
+	  break ;
+	}
+
+  }
+
+ clamp:
+  if ( value < sketch->min )
+	return sketch->min ;
+
+  if ( value > sketch->max )
+	return sketch->max ;
+
+  return value ;
+
+}
+
+
+
+/*
+ * Merges the second specified store into the first one, which is rebased only
+ * once, onto the span of both (its lowest buckets being collapsed if needed).
+ *
+ */
+static void merge_store( SketchStore* store, const SketchStore* other )
+{
+
+  if ( other->length == 0 )
+	return ;
+
+  if ( store->length == 0 )
+  {
+	*store = *other ;
+	return ;
+  }
+
+  int64_t low = store->offset ;
+  int64_t high = low + store->length - 1 ;
+
+  int64_t other_low = other->offset ;
+  int64_t other_high = other_low + other->length - 1 ;
+
+  if ( other_low < low )
+	low = other_low ;
+
+  if ( other_high > high )
+	high = other_high ;
+
+  if ( high - low >= SKETCH_MAX_BUCKETS )
+	low = high - SKETCH_MAX_BUCKETS + 1 ;
+
+  rebase_store( store, low, high ) ;
+
+  uint32_t i ;
+
+  for ( i = 0; i < other->length; i++ )
+  {
+
+	int64_t key = other_low + i ;
+
+	if ( key < low )
+	  key = low ;
+
+	store->counts[ key - low ] += other->counts[i] ;
+
+  }
+
+}
+
+
+
+/*
+ * Merges the second specified sketch into the first one, both having the same
+ * accuracy.
+ *
+ */
+static void merge_sketch( Sketch* sketch, const Sketch* other )
+{
+
+  sketch->zero_count += other->zero_count ;
+  sketch->nan_count += other->nan_count ;
+
+  if ( other->min < sketch->min )
+	sketch->min = other->min ;
+
+  if ( other->max > sketch->max )
+	sketch->max = other->max ;
+
+  merge_store( &sketch->positive, &other->positive ) ;
+  merge_store( &sketch->negative, &other->negative ) ;
+
+}
+
+
+
+// Big-endian serialization helpers:
+
+
+static unsigned char * put_uint64( unsigned char* cursor, uint64_t value )
+{
+
+  int i ;
+
+  for ( i = 7; i >= 0; i-- )
+  {
+	cursor[i] = (unsigned char) ( value & 0xff ) ;
+	value >>= 8 ;
+  }
+
+  return cursor + 8 ;
+
+}
+
+
+static unsigned char * put_uint32( unsigned char* cursor, uint32_t value )
+{
+
+  int i ;
+
+  for ( i = 3; i >= 0; i-- )
+  {
+	cursor[i] = (unsigned char) ( value & 0xff ) ;
+	value >>= 8 ;
+  }
+
+  return cursor + 4 ;
+
+}
+
+
+static unsigned char * put_double( unsigned char* cursor, double value )
+{
+
+  uint64_t bits ;
+
+  memcpy( &bits, &value, sizeof( bits ) ) ;
+
+  return put_uint64( cursor, bits ) ;
+
+}
+
+
+static const unsigned char * take_uint64( const unsigned char* cursor,
+  uint64_t* value )
+{
+
+  int i ;
+
+  *value = 0 ;
+
+  for ( i = 0; i < 8; i++ )
+	*value = ( *value << 8 ) | cursor[i] ;
+
+  return cursor + 8 ;
+
+}
+
+
+static const unsigned char * take_uint32( const unsigned char* cursor,
+  uint32_t* value )
+{
+
+  int i ;
+
+  *value = 0 ;
+
+  for ( i = 0; i < 4; i++ )
+	*value = ( *value << 8 ) | cursor[i] ;
+
+  return cursor + 4 ;
+
+}
+
+
+static const unsigned char * take_double( const unsigned char* cursor,
+  double* value )
+{
+
+  uint64_t bits ;
+
+  cursor = take_uint64( cursor, &bits ) ;
+
+  memcpy( value, &bits, sizeof( bits ) ) ;
+
+  return cursor ;
+
+}
+
+
+
+/*
+ * Returns a binary term serializing specified sketch.
+ *
+ */
+static ERL_NIF_TERM make_sketch_term( ErlNifEnv* env, const Sketch* sketch )
+{
+
+  const SketchStore * stores[] = { &sketch->negative, &sketch->positive } ;
+
+  size_t size = SKETCH_HEADER_SIZE + 2 * STORE_HEADER_SIZE
+	+ ( sketch->negative.length + sketch->positive.length )
+	* sizeof( uint64_t ) ;
+
+  ERL_NIF_TERM term ;
+
+  unsigned char * cursor = enif_make_new_binary( env, size, &term ) ;
+
+  memcpy( cursor, SKETCH_MAGIC, 4 ) ;
+  cursor += 4 ;
+
+  cursor = put_double( cursor, sketch->alpha ) ;
+  cursor = put_uint64( cursor, sketch_count( sketch ) ) ;
+  cursor = put_uint64( cursor, sketch->zero_count ) ;
+  cursor = put_uint64( cursor, sketch->nan_count ) ;
+  cursor = put_double( cursor, sketch->min ) ;
+  cursor = put_double( cursor, sketch->max ) ;
+
+  size_t s ;
+  uint32_t i ;
+
+  for ( s = 0; s < NUM_OF( stores ); s++ )
+  {
+
+	cursor = put_uint32( cursor, (uint32_t) stores[s]->offset ) ;
+	cursor = put_uint32( cursor, stores[s]->length ) ;
+
+	for ( i = 0; i < stores[s]->length; i++ )
+	  cursor = put_uint64( cursor, stores[s]->counts[i] ) ;
+
+  }
+
+  return term ;
+
+}
+
+
+
+/*
+ * Gets from specified term (a binary serializing a sketch) that sketch.
+ *
+ * As such binaries may come from anywhere, the sketch is checked to be
+ * consistent: stores of at most SKETCH_MAX_BUCKETS keys, all within 32 bits,
+ * counts summing to the total count, and ordered bounds if anything was
+ * counted.
+ *
+ * Returns whether the operation succeeded.
+ *
+ */
+static bool get_sketch( ErlNifEnv* env, ERL_NIF_TERM term, Sketch* sketch )
+{
+
+  ErlNifBinary data ;
+
+  if ( ! enif_inspect_binary( env, term, &data )
+	|| data.size < SKETCH_HEADER_SIZE + 2 * STORE_HEADER_SIZE
+	|| memcmp( data.data, SKETCH_MAGIC, 4 ) != 0 )
+	return false ;
+
+  const unsigned char * cursor = data.data + 4 ;
+  const unsigned char * end = data.data + data.size ;
+
+  double alpha ;
+
+  cursor = take_double( cursor, &alpha ) ;
+
+  if ( ! ( alpha >= SKETCH_MIN_ACCURACY && alpha < 1 ) )
+	return false ;
+
+  init_sketch( sketch, alpha ) ;
+
+  uint64_t total ;
+
+  cursor = take_uint64( cursor, &total ) ;
+  cursor = take_uint64( cursor, &sketch->zero_count ) ;
+  cursor = take_uint64( cursor, &sketch->nan_count ) ;
+  cursor = take_double( cursor, &sketch->min ) ;
+  cursor = take_double( cursor, &sketch->max ) ;
+
+  SketchStore * stores[] = { &sketch->negative, &sketch->positive } ;
+
+  uint64_t count = sketch->zero_count ;
+
+  size_t s ;
+  uint32_t i ;
+
+  for ( s = 0; s < NUM_OF( stores ); s++ )
+  {
+
+	uint32_t offset ;
+
+	if ( end - cursor < STORE_HEADER_SIZE )
+	  return false ;
+
+	cursor = take_uint32( cursor, &offset ) ;
+	cursor = take_uint32( cursor, &stores[s]->length ) ;
+
+	stores[s]->offset = (int32_t) offset ;
+
+	if ( stores[s]->length > SKETCH_MAX_BUCKETS
+	  || (size_t) ( end - cursor ) < stores[s]->length * sizeof( uint64_t ) )
+	  return false ;
+
+	// The last key of the store must not wrap around:
+	if ( (int64_t) stores[s]->offset + stores[s]->length - 1 > INT32_MAX )
+	  return false ;
+
+	for ( i = 0; i < stores[s]->length; i++ )
+	{
+
+	  cursor = take_uint64( cursor, stores[s]->counts + i ) ;
+
+	  if ( stores[s]->counts[i] > UINT64_MAX - count )
+		return false ;
+
+	  count += stores[s]->counts[i] ;
+
+	}
+
+  }
+
+  if ( cursor != end || count != total )
+	return false ;
+
+  // Comparisons with NaN bounds being false, these are rejected as well:
+  if ( count == 0 )
+	return sketch->min == INFINITY && sketch->max == -INFINITY ;
+
+  return sketch->min <= sketch->max ;
+
+}
+
+
+
+/*
+ * Builds, in a single streaming pass, the quantile sketch of the cells
+ * selected by specified file dataspace of specified dataset, for specified
+ * relative accuracy (ex: 0.01, at least 1.0e-4).
+ *
+ * -spec h5d_sketch( dataset_handle(), file_dataspace(),
+ *                   RelativeAccuracy::float() ) -> { 'ok', sketch() } | error().
+ *
+ */
+ERL_NIF_TERM h5d_sketch( ErlNifEnv* env, int argc, const ERL_NIF_TERM argv[] )
+{
+
+  if ( argc != 3 )
+	return error_tuple( env, "Incorrect number of arguments" ) ;
+
+  hid_t dataset_id ;
+
+  if ( ! get_handle_id( env, argv[0], DATASET_HANDLE, &dataset_id ) )
+	return error_tuple( env, "Cannot get dataset handle from argv" ) ;
+
+  hid_t file_dataspace_id ;
+
+  if ( ! get_file_dataspace( env, argv[1], &file_dataspace_id ) )
+	return error_tuple( env, "Cannot get dataspace handle from argv" ) ;
+
+  double alpha ;
+
+  if ( ! enif_get_double( env, argv[2], &alpha )
+	|| ! ( alpha >= SKETCH_MIN_ACCURACY ) || ! ( alpha < 1 ) )
+	return error_tuple( env, "Invalid relative accuracy" ) ;
+
+  Sketch * sketch = (Sketch *) enif_alloc( sizeof( Sketch ) ) ;
+
+  if ( sketch == NULL )
+	return error_tuple( env, "Cannot allocate sketch" ) ;
+
+  init_sketch( sketch, alpha ) ;
+
+  const char * error_message = scan_selection( dataset_id, file_dataspace_id,
+	sketch_cells, sketch ) ;
+
+  ERL_NIF_TERM ret ;
+
+  if ( error_message )
+	ret = error_tuple( env, (char *) error_message ) ;
+  else
+	ret = enif_make_tuple2( env, atom_ok, make_sketch_term( env, sketch ) ) ;
+
+  enif_free( sketch ) ;
+
+  return ret ;
+
+}
+
+
+
+/*
+ * Merges the specified (non-empty) list of sketches, all of the same accuracy
+ * (ex: the sketches of the same dataset in several files).
+ *
+ * -spec sketch_merge( [ sketch() ] ) -> { 'ok', sketch() } | error().
+ *
+ */
+ERL_NIF_TERM sketch_merge( ErlNifEnv* env, int argc,
+  const ERL_NIF_TERM argv[] )
+{
+
+  if ( argc != 1 )
+	return error_tuple( env, "Incorrect number of arguments" ) ;
+
+  ERL_NIF_TERM list = argv[0] ;
+  ERL_NIF_TERM head ;
+
+  if ( ! enif_get_list_cell( env, list, &head, &list ) )
+	return error_tuple( env, "Cannot get list of sketches from argv" ) ;
+
+  Sketch * sketch = (Sketch *) enif_alloc( 2 * sizeof( Sketch ) ) ;
+
+  if ( sketch == NULL )
+	return error_tuple( env, "Cannot allocate sketch" ) ;
+
+  Sketch * other = sketch + 1 ;
+
+  ERL_NIF_TERM ret ;
+
+  if ( ! get_sketch( env, head, sketch ) )
+  {
+	ret = error_tuple( env, "Invalid sketch" ) ;
+	goto end ;
+  }
+
+  while ( enif_get_list_cell( env, list, &head, &list ) )
+  {
+
+	if ( ! get_sketch( env, head, other ) )
+	{
+	  ret = error_tuple( env, "Invalid sketch" ) ;
+	  goto end ;
+	}
+
+	if ( other->alpha != sketch->alpha )
+	{
+	  ret = error_tuple( env, "Sketches of different accuracies" ) ;
+	  goto end ;
+	}
+
+	merge_sketch( sketch, other ) ;
+
+  }
+
+  if ( ! enif_is_empty_list( env, list ) )
+	ret = error_tuple( env, "Improper list of sketches" ) ;
+  else
+	ret = enif_make_tuple2( env, atom_ok, make_sketch_term( env, sketch ) ) ;
+
+ end:
+  enif_free( sketch ) ;
+
+  return ret ;
+
+}
+
+
+
+/*
+ * Returns the estimates of the specified quantiles (each in [0,1], ex: 0.99)
+ * of the values counted by specified sketch, in the same order; they are
+ * 'undefined' if the sketch counted no (non-NaN) value.
+ *
+ * -spec sketch_quantiles( sketch(), [ float() ] ) ->
+ *     { 'ok', [ float() | 'inf' | 'undefined' ] } | error().
+ *
+ */
+ERL_NIF_TERM sketch_quantiles( ErlNifEnv* env, int argc,
+  const ERL_NIF_TERM argv[] )
+{
+
+  if ( argc != 2 )
+	return error_tuple( env, "Incorrect number of arguments" ) ;
+
+  Sketch * sketch = (Sketch *) enif_alloc( sizeof( Sketch ) ) ;
+
+  if ( sketch == NULL )
+	return error_tuple( env, "Cannot allocate sketch" ) ;
+
+  ERL_NIF_TERM ret ;
+
+  if ( ! get_sketch( env, argv[0], sketch ) )
+  {
+	ret = error_tuple( env, "Invalid sketch" ) ;
+	goto end ;
+  }
+
+  unsigned int length ;
+
+  if ( ! enif_get_list_length( env, argv[1], &length ) )
+  {
+	ret = error_tuple( env, "Cannot get list of quantiles from argv" ) ;
+	goto end ;
+  }
+
+  uint64_t count = sketch_count( sketch ) ;
+
+  ERL_NIF_TERM * values = (ERL_NIF_TERM *) enif_alloc(
+	( length + 1 ) * sizeof( ERL_NIF_TERM ) ) ;
+
+  if ( values == NULL )
+  {
+	ret = error_tuple( env, "Cannot allocate quantiles" ) ;
+	goto end ;
+  }
+
+  ERL_NIF_TERM list = argv[1] ;
+  ERL_NIF_TERM head ;
+  unsigned int i = 0 ;
+
+  while ( enif_get_list_cell( env, list, &head, &list ) )
+  {
+
+	double quantile ;
+
+	if ( ! get_number( env, head, &quantile ) || ! ( quantile >= 0 )
+	  || quantile > 1 )
+	{
+	  enif_free( values ) ;
+	  ret = error_tuple( env, "Invalid quantile" ) ;
+	  goto end ;
+	}
+
+	values[ i++ ] = ( count == 0 ) ? enif_make_atom( env, "undefined" )
+	  : make_double_term( env, sketch_quantile( sketch, count, quantile ) ) ;
+
+  }
+
+  ret = enif_make_tuple2( env, atom_ok,
+	enif_make_list_from_array( env, values, length ) ) ;
+
+  enif_free( values ) ;
+
+ end:
+  enif_free( sketch ) ;
+
+  return ret ;
+
+}
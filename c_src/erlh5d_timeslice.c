@@ -0,0 +1,537 @@
+/* This file is part of erlhdf5 */
+
+/* erlhdf5 is free software: you can redistribute it and/or modify */
+/* it under the terms of the GNU Lesser General Public License as */
+/* published by the Free Software Foundation, either version 3 of */
+/* the License, or (at your option) any later version. */
+
+/* erlhdf5 is distributed in the hope that it will be useful, */
+/* but WITHOUT ANY WARRANTY; without even the implied warranty of */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the */
+/* GNU Lesser General Public License for more details. */
+
+/* You should have received a copy of the GNU Lesser General Public */
+/* License along with erlhdf5.  If not, see */
+/* <http://www.gnu.org/licenses/>. */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "hdf5.h"
+
+#include "erl_nif.h"
+
+#include "dbg.h"
+
+#include "erlhdf5.h"
+
+
+/*
+ * Time-sliced versions of the list-based reads and writes.
+ *
+ * Converting between Erlang lists and C arrays is done by bounded slices of
+ * cells, on a normal scheduler; once a slice has exhausted the timeslice of
+ * the calling process (as reported by enif_consume_timeslice/2), the
+ * conversion is rescheduled (enif_schedule_nif/6), its state (buffer and
+ * cursor) being kept in a resource, so that other processes can run meanwhile.
+ *
+ * The HDF5 call itself (a single H5Dwrite or H5Dread) is done once, before
+ * (for reads) or after (for writes) the conversion, on a dirty I/O scheduler
+ * when available.
+ *
+ */
+
+
+// Number of cells converted between two checks of the timeslice:
+#define SLICE_CELLS 4096
+
+// Duration of a full timeslice, in microseconds:
+#define TIMESLICE_USEC 1000
+
+
+// State of an ongoing conversion.
+typedef struct
+{
+
+  // Name of the NIF on whose behalf the conversion is done (for tracing):
+  const char * nif_name ;
+
+  // Type of the cells:
+  cell_type type ;
+
+  // Number of cells per tuple (0 for a list of bare cells):
+  int tuple_size ;
+
+  // The C array of cells, owned by this job:
+  void * buffer ;
+
+  // Total number of cells in the buffer (for a write being decoded: its
+  // capacity, the buffer being grown as needed):
+  hsize_t count ;
+
+  // Index of the next cell to convert:
+  hsize_t index ;
+
+} ConversionJob ;
+
+
+static ErlNifResourceType * conversion_job_type = NULL ;
+
+
+
+// Called whenever a conversion job is garbage-collected.
+static void conversion_job_destructor( ErlNifEnv* env, void* obj )
+{
+
+  ConversionJob * job = (ConversionJob *) obj ;
+
+  if ( job->buffer )
+	enif_free( job->buffer ) ;
+
+}
+
+
+
+/*
+ * Opens the resource types used by the time-sliced conversions.
+ *
+ * Returns 0 on success, -1 on failure.
+ *
+ */
+int open_timeslice_resource_types( ErlNifEnv* env )
+{
+
+  conversion_job_type = enif_open_resource_type( env, "erlhdf5",
+	"ConversionJob", conversion_job_destructor,
+	ERL_NIF_RT_CREATE | ERL_NIF_RT_TAKEOVER, NULL ) ;
+
+  return conversion_job_type ? 0 : -1 ;
+
+}
+
+
+
+// Returns a new conversion job, owning specified buffer (possibly NULL).
+static ConversionJob * create_job( const char * nif_name, cell_type type,
+  void * buffer, hsize_t count )
+{
+
+  ConversionJob * job = enif_alloc_resource( conversion_job_type,
+	sizeof( ConversionJob ) ) ;
+
+  if ( ! job )
+	return NULL ;
+
+  job->nif_name = nif_name ;
+  job->type = type ;
+  job->tuple_size = 0 ;
+  job->buffer = buffer ;
+  job->count = count ;
+  job->index = 0 ;
+
+  return job ;
+
+}
+
+
+
+// Frees as soon as possible the buffer of specified job.
+static void release_job_buffer( ConversionJob * job )
+{
+
+  if ( job->buffer )
+  {
+	enif_free( job->buffer ) ;
+	job->buffer = NULL ;
+  }
+
+}
+
+
+
+/*
+ * Accounts for the time spent since specified start, and returns whether the
+ * timeslice of the calling process is exhausted.
+ *
+ */
+static bool timeslice_exhausted( ErlNifEnv* env, ErlNifTime start )
+{
+
+  ErlNifTime elapsed = enif_monotonic_time( ERL_NIF_USEC ) - start ;
+
+  int percent = (int) ( elapsed * 100 / TIMESLICE_USEC ) ;
+
+  if ( percent < 1 )
+	percent = 1 ;
+  else if ( percent > 100 )
+	percent = 100 ;
+
+  return enif_consume_timeslice( env, percent ) ;
+
+}
+
+
+
+/*
+ * Final step of a write: performs the single H5Dwrite call, once the whole
+ * input list has been converted.
+ *
+ * argv: [ Job, Dataset, FileDataspace ]; the handles are resolved only now,
+ * as they may have been closed meanwhile.
+ *
+ */
+static ERL_NIF_TERM write_commit( ErlNifEnv* env, int argc,
+  const ERL_NIF_TERM argv[] )
+{
+
+  ConversionJob * job ;
+
+  if ( ! enif_get_resource( env, argv[0], conversion_job_type,
+	  (void**) &job ) )
+	return error_tuple( env, "Cannot get conversion job" ) ;
+
+  Handle * dataset ;
+  hid_t file_dataspace_id ;
+
+  ERL_NIF_TERM res ;
+
+  hdf5_lock() ;
+
+  // Predefined types are initialized by the library, hence with the lock held:
+  hid_t mem_type_id = get_native_cell_type( job->type ) ;
+
+  if ( ! get_handle( env, argv[1], DATASET_HANDLE, &dataset )
+	|| dataset->id < 0 )
+	res = error_tuple( env, "Cannot get dataset handle from argv" ) ;
+  else if ( ! get_file_dataspace( env, argv[2], &file_dataspace_id ) )
+	res = error_tuple( env, "Cannot get dataspace handle from argv" ) ;
+  else
+	res = write_buffer_to_dataset( dataset, env, mem_type_id, job->count,
+	  job->buffer, file_dataspace_id, HSIZE_UNDEF ) ;
+
+  hdf5_unlock() ;
+
+  release_job_buffer( job ) ;
+
+  return res ;
+
+}
+
+
+
+/*
+ * Converts the next slices of the input list of a write, rescheduling itself
+ * whenever the timeslice is exhausted.
+ *
+ * argv: [ Job, RemainingList, Dataset, FileDataspace ] (the two handles being
+ * carried along so that they remain referenced until the commit).
+ *
+ */
+static ERL_NIF_TERM write_slice( ErlNifEnv* env, int argc,
+  const ERL_NIF_TERM argv[] )
+{
+
+  ConversionJob * job ;
+
+  if ( ! enif_get_resource( env, argv[0], conversion_job_type,
+	  (void**) &job ) )
+	return error_tuple( env, "Cannot get conversion job" ) ;
+
+  ERL_NIF_TERM list = argv[1] ;
+
+  while ( true )
+  {
+
+	ErlNifTime start = enif_monotonic_time( ERL_NIF_USEC ) ;
+
+	const char * error = decode_cell_list( env, job->type, &list,
+	  job->tuple_size, &job->buffer, &job->count, &job->index,
+	  job->index + SLICE_CELLS ) ;
+
+	if ( error )
+	{
+	  release_job_buffer( job ) ;
+	  return error_tuple( env, (char *) error ) ;
+	}
+
+	if ( enif_is_empty_list( env, list ) )
+	  break ;
+
+	if ( timeslice_exhausted( env, start ) )
+	{
+
+	  ERL_NIF_TERM next_argv[ 4 ] = { argv[0], list, argv[2], argv[3] } ;
+
+	  return enif_schedule_nif( env, job->nif_name, 0, write_slice, 4,
+		next_argv ) ;
+
+	}
+
+  }
+
+  // Only the decoded cells are to be written:
+  job->count = job->index ;
+
+  ERL_NIF_TERM commit_argv[ 3 ] = { argv[0], argv[2], argv[3] } ;
+
+  return enif_schedule_nif( env, job->nif_name, ERLHDF5_DIRTY_IO,
+	write_commit, 3, commit_argv ) ;
+
+}
+
+
+
+/*
+ * Time-sliced version of h5dwrite/{2,3} (same arguments and result).
+ *
+ * Runs on a normal scheduler, and does not call HDF5 before the final step.
+ *
+ */
+ERL_NIF_TERM h5dwrite_timesliced( ErlNifEnv* env, int argc,
+  const ERL_NIF_TERM argv[] )
+{
+
+  /*
+   * The handles are only checked here, and resolved when committing (see
+   * write_commit/3), as no HDF5 call shall be made beforehand (the type of the
+   * cells of the dataset being known from its handle):
+   *
+   */
+  Handle* handle ;
+
+  ERL_NIF_TERM file_dataspace_term ;
+
+  switch ( argc )
+  {
+
+  case 2:
+	file_dataspace_term = enif_make_atom( env, "H5S_ALL" ) ;
+	break ;
+
+  case 3:
+	if ( ! get_handle( env, argv[1], DATASPACE_HANDLE, &handle ) )
+	  return error_tuple( env, "Cannot get dataspace handle from argv" ) ;
+	file_dataspace_term = argv[1] ;
+	break ;
+
+  default:
+	return error_tuple( env, "Invalid arity for h5dwrite" ) ;
+
+  }
+
+  if ( ! get_handle( env, argv[0], DATASET_HANDLE, &handle ) )
+	return error_tuple( env, "Cannot get dataset handle from argv" ) ;
+
+  cell_type type = handle->cells ;
+
+  if ( type == UNKNOWN_TYPE )
+	return error_tuple( env, "Unsupported cell type of dataset for writing" ) ;
+
+  ERL_NIF_TERM data_list = argv[argc-1] ;
+
+  struct DataDescriptor detected_desc ;
+
+  if ( ! detect_type( data_list, env, &detected_desc ) )
+	return detected_desc.error_term ;
+
+  // The buffer is allocated and grown while decoding, in a single pass:
+  ConversionJob * job = create_job( "h5dwrite", type, NULL, 0 ) ;
+
+  if ( ! job )
+	return error_tuple( env, "Cannot allocate conversion job" ) ;
+
+  job->tuple_size = detected_desc.tuple_size ;
+
+  ERL_NIF_TERM job_term = enif_make_resource( env, job ) ;
+
+  // Now owned by the term:
+  enif_release_resource( job ) ;
+
+  ERL_NIF_TERM slice_argv[ 4 ] = { job_term, data_list, argv[0],
+	file_dataspace_term } ;
+
+  return write_slice( env, 4, slice_argv ) ;
+
+}
+
+
+
+/*
+ * Builds, from its end, the list corresponding to the buffer of a read, by
+ * slices, rescheduling itself whenever the timeslice is exhausted.
+ *
+ * argv: [ Job, AccumulatedListTail ].
+ *
+ */
+static ERL_NIF_TERM convert_slice( ErlNifEnv* env, int argc,
+  const ERL_NIF_TERM argv[] )
+{
+
+  ConversionJob * job ;
+
+  if ( ! enif_get_resource( env, argv[0], conversion_job_type,
+	  (void**) &job ) )
+	return error_tuple( env, "Cannot get conversion job" ) ;
+
+  ERL_NIF_TERM acc = argv[1] ;
+
+  while ( true )
+  {
+
+	ErlNifTime start = enif_monotonic_time( ERL_NIF_USEC ) ;
+
+	hsize_t slice_start = ( job->index > SLICE_CELLS ) ?
+	  job->index - SLICE_CELLS : 0 ;
+
+	acc = make_cell_list( env, job->type, job->buffer, slice_start,
+	  job->index, acc ) ;
+
+	job->index = slice_start ;
+
+	if ( job->index == 0 )
+	  break ;
+
+	if ( timeslice_exhausted( env, start ) )
+	{
+
+	  ERL_NIF_TERM next_argv[ 2 ] = { argv[0], acc } ;
+
+	  return enif_schedule_nif( env, job->nif_name, 0, convert_slice, 2,
+		next_argv ) ;
+
+	}
+
+  }
+
+  release_job_buffer( job ) ;
+
+  return enif_make_tuple2( env, atom_ok, acc ) ;
+
+}
+
+
+
+/*
+ * Schedules, on a normal scheduler, the conversion to a list of the specified
+ * buffer of cells (whose ownership is transferred).
+ *
+ */
+static ERL_NIF_TERM schedule_list_conversion( ErlNifEnv* env,
+  const char * nif_name, cell_type type, void * buffer, hsize_t count )
+{
+
+  if ( count == 0 )
+  {
+
+	if ( buffer )
+	  enif_free( buffer ) ;
+
+	return enif_make_tuple2( env, atom_ok, enif_make_list( env, 0 ) ) ;
+
+  }
+
+  ConversionJob * job = create_job( nif_name, type, buffer, count ) ;
+
+  if ( ! job )
+  {
+	enif_free( buffer ) ;
+	return error_tuple( env, "Cannot allocate conversion job" ) ;
+  }
+
+  // Walking the buffer backward:
+  job->index = count ;
+
+  ERL_NIF_TERM job_term = enif_make_resource( env, job ) ;
+
+  enif_release_resource( job ) ;
+
+  ERL_NIF_TERM slice_argv[ 2 ] = { job_term, enif_make_list( env, 0 ) } ;
+
+  return enif_schedule_nif( env, nif_name, 0, convert_slice, 2, slice_argv ) ;
+
+}
+
+
+
+/*
+ * Time-sliced version of h5dread/3 (same arguments and result).
+ *
+ * The read itself is to be run (HDF5 lock taken) on a dirty I/O scheduler.
+ *
+ */
+ERL_NIF_TERM h5dread_timesliced( ErlNifEnv* env, int argc,
+  const ERL_NIF_TERM argv[] )
+{
+
+  if ( argc != 3 )
+	return error_tuple( env, "Incorrect number of arguments" ) ;
+
+  cell_type type ;
+  void * buffer ;
+  hsize_t count ;
+  ERL_NIF_TERM error_term ;
+
+  if ( ! read_selection( env, argv, &type, &buffer, &count, &error_term ) )
+	return error_term ;
+
+  return schedule_list_conversion( env, "h5dread", type, buffer, count ) ;
+
+}
+
+
+
+/*
+ * Time-sliced version of h5lt_read_dataset_int/2 (same arguments and result).
+ *
+ * The read itself is to be run (HDF5 lock taken) on a dirty I/O scheduler.
+ *
+ */
+ERL_NIF_TERM h5lt_read_dataset_int_timesliced( ErlNifEnv* env, int argc,
+  const ERL_NIF_TERM argv[] )
+{
+
+  if ( argc != 2 )
+	return error_tuple( env, "Incorrect number of arguments" ) ;
+
+  void * buffer ;
+  hsize_t count ;
+  ERL_NIF_TERM error_term ;
+
+  if ( ! read_lt_dataset( env, argv, H5T_NATIVE_INT, &buffer, &count,
+	  &error_term ) )
+	return error_term ;
+
+  return schedule_list_conversion( env, "h5lt_read_dataset_int", INT32_CELL,
+	buffer, count ) ;
+
+}
+
+
+
+/*
+ * Time-sliced version of h5lt_read_dataset_double/2 (same arguments and
+ * result).
+ *
+ * The read itself is to be run (HDF5 lock taken) on a dirty I/O scheduler.
+ *
+ */
+ERL_NIF_TERM h5lt_read_dataset_double_timesliced( ErlNifEnv* env, int argc,
+  const ERL_NIF_TERM argv[] )
+{
+
+  if ( argc != 2 )
+	return error_tuple( env, "Incorrect number of arguments" ) ;
+
+  void * buffer ;
+  hsize_t count ;
+  ERL_NIF_TERM error_term ;
+
+  if ( ! read_lt_dataset( env, argv, H5T_NATIVE_DOUBLE, &buffer, &count,
+	  &error_term ) )
+	return error_term ;
+
+  return schedule_list_conversion( env, "h5lt_read_dataset_double",
+	FLOAT64_CELL, buffer, count ) ;
+
+}
@@ -0,0 +1,1218 @@
+/* This file is part of erlhdf5 */
+
+/* erlhdf5 is free software: you can redistribute it and/or modify */
+/* it under the terms of the GNU Lesser General Public License as */
+/* published by the Free Software Foundation, either version 3 of */
+/* the License, or (at your option) any later version. */
+
+/* erlhdf5 is distributed in the hope that it will be useful, */
+/* but WITHOUT ANY WARRANTY; without even the implied warranty of */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the */
+/* GNU Lesser General Public License for more details. */
+
+/* You should have received a copy of the GNU Lesser General Public */
+/* License along with erlhdf5.  If not, see */
+/* <http://www.gnu.org/licenses/>. */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "hdf5.h"
+
+#include "erl_nif.h"
+
+#include "dbg.h"
+
+#include "erlhdf5.h"
+
+
+/*
+ * Zone maps of chunked datasets.
+ *
+ * A zone is a slab of rows (i.e. elements along the first dimension) of a
+ * dataset, as high as its chunks, hence spanning whole chunks; its summary is
+ * the minimum, maximum and count of its non-NaN cells.
+ *
+ * The summaries of all the zones of a dataset are stored in a companion
+ * dataset, next to it and named after it (ex: "/series.zone_map" for
+ * "/series"), of Zones x 3 doubles (a count of -1 meaning that the summary of
+ * the zone is not known), so that they are shared by all the handles and
+ * persist with the file.
+ *
+ * Whether a dataset has a zone map is determined when a handle is opened on it,
+ * and checked again only once a zone map has been created (by any handle), so
+ * that writes to datasets without a zone map do not have to look for one.
+ *
+ * Once a zone map has been created (see h5d_create_zone_map/1), any write to
+ * the dataset updates, once done, the zones it touches, with a single write to
+ * the zone map: rows appended at the end of the dataset are folded, directly
+ * from the written buffer, into the summaries of their zones, whereas zones
+ * whose cells may have been overwritten are summarized again, by scanning them
+ * (these chunks being typically still in the chunk cache). Scans can then skip
+ * the zones that cannot match their predicate, without reading (nor
+ * decompressing) their chunks.
+ *
+ * Zones that could not be summarized (ex: after a failed write, or once added
+ * by an extension of the dataset that wrote no cell) are left unknown, and thus
+ * never skipped.
+ *
+ */
+
+
+// Suffix of the name of the companion dataset holding a zone map:
+#define ZONE_MAP_SUFFIX ".zone_map"
+
+// Number of values stored per zone (minimum, maximum and count):
+#define ZONE_FIELDS 3
+
+// Number of zones per chunk of the companion dataset:
+#define ZONE_MAP_CHUNK_ZONES 1024
+
+// Maximum number of zones summarized and written at once:
+#define ZONE_BATCH 1024
+
+// Maximum number of appended cells converted at once:
+#define FOLD_BATCH 1024
+
+
+// Incremented whenever a zone map is created, so that the handles that found
+// no zone map for their dataset check again (HDF5 lock to be held):
+static unsigned int zone_map_generation = 1 ;
+
+
+
+/*
+ * Sets specified path to the one of the companion dataset holding the zone map
+ * of specified dataset.
+ *
+ * Returns whether the operation succeeded.
+ *
+ */
+static bool get_zone_map_path( hid_t dataset_id, char* path, size_t size )
+{
+
+  ssize_t length = H5Iget_name( dataset_id, path,
+	size - strlen( ZONE_MAP_SUFFIX ) ) ;
+
+  if ( length <= 0 || (size_t) length >= size - strlen( ZONE_MAP_SUFFIX ) )
+	return false ;
+
+  strcat( path, ZONE_MAP_SUFFIX ) ;
+
+  return true ;
+
+}
+
+
+
+/*
+ * Determines whether the dataset of specified handle has a zone map, and
+ * records it in this handle; called when opening it.
+ *
+ */
+void check_zone_map( Handle* dataset )
+{
+
+  char path[ MAXBUFLEN ] ;
+
+  // Anonymous datasets cannot have a zone map:
+  htri_t exists = get_zone_map_path( dataset->id, path, sizeof( path ) ) ?
+	H5Lexists( dataset->id, path, H5P_DEFAULT ) : 0 ;
+
+  dataset->zone_map = exists > 0 ;
+
+  // On failure, no zone map is assumed for now, but it will be looked for
+  // again (generations starting at 1):
+  dataset->zone_map_generation = ( exists < 0 ) ? 0 : zone_map_generation ;
+
+}
+
+
+
+/*
+ * Opens (in zone_map_id, to be closed by the caller) the companion dataset
+ * holding the zone map of the dataset of specified (open) handle, if any.
+ *
+ * Should its existence not be determined, the operation proceeds as if there
+ * were none (a write then leaving the zone map as it was), and it is looked
+ * for again by the next operation.
+ *
+ * Returns 1 if it has been opened, 0 if there is none, -1 on failure.
+ *
+ */
+static int open_zone_map( Handle* dataset, hid_t* zone_map_id )
+{
+
+  if ( dataset->zone_map_generation != zone_map_generation )
+	check_zone_map( dataset ) ;
+
+  if ( ! dataset->zone_map )
+	return 0 ;
+
+  char path[ MAXBUFLEN ] ;
+
+  if ( ! get_zone_map_path( dataset->id, path, sizeof( path ) ) )
+	return -1 ;
+
+  htri_t exists = H5Lexists( dataset->id, path, H5P_DEFAULT ) ;
+
+  if ( exists == 0 )
+	dataset->zone_map = false ;
+
+  if ( exists <= 0 )
+	return 0 ;
+
+  *zone_map_id = H5Dopen2( dataset->id, path, H5P_DEFAULT ) ;
+
+  return ( *zone_map_id < 0 ) ? -1 : 1 ;
+
+}
+
+
+
+/*
+ * Determines the zones of specified dataset: its number of rows, the number
+ * of rows per zone (the height of its chunks) and the number of cells per row.
+ *
+ * Returns NULL on success, otherwise an error message.
+ *
+ */
+static const char * get_zone_geometry( hid_t dataset_id, ZoneMap* map )
+{
+
+  hid_t space_id = H5Dget_space( dataset_id ) ;
+
+  if ( space_id < 0 )
+	return "Cannot get the dataspace of the dataset" ;
+
+  hsize_t dims[ H5S_MAX_RANK ] ;
+
+  int rank = H5Sget_simple_extent_ndims( space_id ) ;
+
+  if ( rank <= 0 || H5Sget_simple_extent_dims( space_id, dims, NULL ) < 0 )
+  {
+	H5Sclose( space_id ) ;
+	return "Cannot get dataset dimensions" ;
+  }
+
+  H5Sclose( space_id ) ;
+
+  map->rows = dims[0] ;
+  map->row_cells = 1 ;
+
+  int i ;
+
+  for ( i = 1; i < rank; i++ )
+	map->row_cells *= dims[i] ;
+
+  hid_t dcpl_id = H5Dget_create_plist( dataset_id ) ;
+
+  if ( dcpl_id < 0 )
+	return "Cannot get the creation property list of the dataset" ;
+
+  bool chunked = H5Pget_layout( dcpl_id ) == H5D_CHUNKED
+	&& H5Pget_chunk( dcpl_id, rank, dims ) == rank ;
+
+  H5Pclose( dcpl_id ) ;
+
+  if ( ! chunked )
+	return "Only chunked datasets can have a zone map" ;
+
+  map->zone_rows = dims[0] ;
+
+  return NULL ;
+
+}
+
+
+
+// Returns the number of zones of a dataset having specified geometry:
+static hsize_t get_zone_count( const ZoneMap* map )
+{
+
+  return ( map->rows + map->zone_rows - 1 ) / map->zone_rows ;
+
+}
+
+
+
+/*
+ * Selects in specified dataspace (of a zone map) specified zones.
+ *
+ * Returns whether the operation succeeded.
+ *
+ */
+static bool select_zones( hid_t space_id, hsize_t first, hsize_t count )
+{
+
+  hsize_t start[ 2 ] = { first, 0 } ;
+  hsize_t counts[ 2 ] = { count, ZONE_FIELDS } ;
+
+  return H5Sselect_hyperslab( space_id, H5S_SELECT_SET, start, NULL, counts,
+	NULL ) >= 0 ;
+
+}
+
+
+
+/*
+ * Writes specified zones, starting at specified one, in specified zone map.
+ *
+ * Returns NULL on success, otherwise an error message.
+ *
+ */
+static const char * write_zones( hid_t zone_map_id, hsize_t first,
+  hsize_t count, const Zone* zones )
+{
+
+  hsize_t dims[ 2 ] = { count, ZONE_FIELDS } ;
+
+  hid_t mem_space_id = H5Screate_simple( 2, dims, NULL ) ;
+  hid_t file_space_id = H5Dget_space( zone_map_id ) ;
+
+  const char * error_message = NULL ;
+
+  if ( mem_space_id < 0 || file_space_id < 0
+	|| ! select_zones( file_space_id, first, count )
+	|| H5Dwrite( zone_map_id, H5T_NATIVE_DOUBLE, mem_space_id, file_space_id,
+	  H5P_DEFAULT, zones ) < 0 )
+	error_message = "Failed to write the zone map" ;
+
+  if ( mem_space_id >= 0 )
+	H5Sclose( mem_space_id ) ;
+
+  if ( file_space_id >= 0 )
+	H5Sclose( file_space_id ) ;
+
+  return error_message ;
+
+}
+
+
+
+/*
+ * Reads specified zones, starting at specified one, from specified zone map.
+ *
+ * Returns NULL on success, otherwise an error message.
+ *
+ */
+static const char * read_zones( hid_t zone_map_id, hsize_t first,
+  hsize_t count, Zone* zones )
+{
+
+  hsize_t dims[ 2 ] = { count, ZONE_FIELDS } ;
+
+  hid_t mem_space_id = H5Screate_simple( 2, dims, NULL ) ;
+  hid_t file_space_id = H5Dget_space( zone_map_id ) ;
+
+  const char * error_message = NULL ;
+
+  if ( mem_space_id < 0 || file_space_id < 0
+	|| ! select_zones( file_space_id, first, count )
+	|| H5Dread( zone_map_id, H5T_NATIVE_DOUBLE, mem_space_id, file_space_id,
+	  H5P_DEFAULT, zones ) < 0 )
+	error_message = "Failed to read the zone map" ;
+
+  if ( mem_space_id >= 0 )
+	H5Sclose( mem_space_id ) ;
+
+  if ( file_space_id >= 0 )
+	H5Sclose( file_space_id ) ;
+
+  return error_message ;
+
+}
+
+
+
+// An operation on a range of zones (from first, included, to end, excluded):
+typedef const char * (*zone_action)( hid_t dataset_id, const ZoneMap* map,
+  hid_t zone_map_id, hsize_t first, hsize_t end ) ;
+
+
+
+/*
+ * Marks as unknown specified zones (from first, included, to end, excluded) in
+ * specified zone map (the dataset and its geometry being not needed).
+ *
+ * Returns NULL on success, otherwise an error message.
+ *
+ */
+static const char * forget_zones( hid_t dataset_id, const ZoneMap* map,
+  hid_t zone_map_id, hsize_t first, hsize_t end )
+{
+
+  Zone unknown[ ZONE_BATCH ] ;
+
+  hsize_t i ;
+
+  for ( i = 0; i < ZONE_BATCH; i++ )
+  {
+	unknown[i].min = NAN ;
+	unknown[i].max = NAN ;
+	unknown[i].count = UNKNOWN_ZONE_COUNT ;
+  }
+
+  for ( i = first; i < end; i += ZONE_BATCH )
+  {
+
+	hsize_t count = ( end - i < ZONE_BATCH ) ? end - i : ZONE_BATCH ;
+
+	const char * error_message = write_zones( zone_map_id, i, count,
+	  unknown ) ;
+
+	if ( error_message )
+	  return error_message ;
+
+  }
+
+  return NULL ;
+
+}
+
+
+
+/*
+ * Resizes specified zone map to specified number of zones, the added ones
+ * being unknown (as set by the fill value of the zone map).
+ *
+ * Returns NULL on success, otherwise an error message.
+ *
+ */
+static const char * resize_zone_map( hid_t zone_map_id, hsize_t zones )
+{
+
+  hid_t space_id = H5Dget_space( zone_map_id ) ;
+
+  if ( space_id < 0 )
+	return "Cannot get the dataspace of the zone map" ;
+
+  hsize_t dims[ 2 ] ;
+
+  int rank = H5Sget_simple_extent_dims( space_id, dims, NULL ) ;
+
+  H5Sclose( space_id ) ;
+
+  if ( rank != 2 || dims[1] != ZONE_FIELDS )
+	return "Invalid zone map" ;
+
+  if ( dims[0] == zones )
+	return NULL ;
+
+  dims[0] = zones ;
+
+  if ( H5Dset_extent( zone_map_id, dims ) < 0 )
+	return "Cannot resize the zone map" ;
+
+  return NULL ;
+
+}
+
+
+
+// State of the summarizing of zones:
+typedef struct
+{
+
+  Zone * zones ;
+
+  // Number of cells of each zone:
+  hsize_t zone_cells ;
+
+} Summary ;
+
+
+
+/*
+ * Folds specified cells, starting at specified position in a selection of
+ * whole zones, into the summaries of their zones.
+ *
+ */
+static const char * summarize_cells( const double* cells, size_t count,
+  hsize_t position, void* state )
+{
+
+  Summary * summary = (Summary *) state ;
+
+  while ( count > 0 )
+  {
+
+	Zone * zone = summary->zones + position / summary->zone_cells ;
+
+	size_t run = summary->zone_cells - position % summary->zone_cells ;
+
+	if ( run > count )
+	  run = count ;
+
+	// NaN cells fail all comparisons, hence are skipped without branching:
+	double min = zone->min ;
+	double max = zone->max ;
+	double non_nan = 0 ;
+
+	size_t i ;
+
+	for ( i = 0; i < run; i++ )
+	{
+	  double v = cells[i] ;
+	  min = ( v < min ) ? v : min ;
+	  max = ( v > max ) ? v : max ;
+	  non_nan += ( v == v ) ;
+	}
+
+	zone->min = min ;
+	zone->max = max ;
+	zone->count += non_nan ;
+
+	cells += run ;
+	count -= run ;
+	position += run ;
+
+  }
+
+  return NULL ;
+
+}
+
+
+
+/*
+ * Summarizes, by scanning them, specified zones of specified dataset, and
+ * writes their summaries in specified zone map.
+ *
+ * Returns NULL on success, otherwise an error message.
+ *
+ */
+static const char * refresh_zones( hid_t dataset_id, const ZoneMap* map,
+  hid_t zone_map_id, hsize_t first, hsize_t end )
+{
+
+  Zone zones[ ZONE_BATCH ] ;
+
+  hid_t space_id = H5Dget_space( dataset_id ) ;
+
+  if ( space_id < 0 )
+	return "Cannot get the dataspace of the dataset" ;
+
+  int rank = H5Sget_simple_extent_ndims( space_id ) ;
+
+  hsize_t start[ H5S_MAX_RANK ] ;
+  hsize_t count[ H5S_MAX_RANK ] ;
+
+  if ( rank <= 0 || H5Sget_simple_extent_dims( space_id, count, NULL ) < 0 )
+  {
+	H5Sclose( space_id ) ;
+	return "Cannot get dataset dimensions" ;
+  }
+
+  memset( start, 0, sizeof( start ) ) ;
+
+  Summary summary = { zones, map->zone_rows * map->row_cells } ;
+
+  const char * error_message = NULL ;
+
+  hsize_t batch ;
+
+  for ( ; first < end && ! error_message; first += batch )
+  {
+
+	batch = ( end - first < ZONE_BATCH ) ? end - first : ZONE_BATCH ;
+
+	hsize_t i ;
+
+	for ( i = 0; i < batch; i++ )
+	{
+	  zones[i].min = INFINITY ;
+	  zones[i].max = -INFINITY ;
+	  zones[i].count = 0 ;
+	}
+
+	// Whole zones, the last one of the dataset being possibly partial:
+	start[0] = first * map->zone_rows ;
+	count[0] = batch * map->zone_rows ;
+
+	if ( start[0] + count[0] > map->rows )
+	  count[0] = map->rows - start[0] ;
+
+	if ( H5Sselect_hyperslab( space_id, H5S_SELECT_SET, start, NULL, count,
+		NULL ) < 0 )
+	  error_message = "Cannot select the zones" ;
+	else
+	  error_message = scan_selection( dataset_id, space_id, summarize_cells,
+		&summary ) ;
+
+	if ( ! error_message )
+	  error_message = write_zones( zone_map_id, first, batch, zones ) ;
+
+  }
+
+  H5Sclose( space_id ) ;
+
+  return error_message ;
+
+}
+
+
+
+// Orders zone indexes:
+static int compare_zones( const void* a, const void* b )
+{
+
+  hsize_t x = *(const hsize_t *) a ;
+  hsize_t y = *(const hsize_t *) b ;
+
+  return ( x > y ) - ( x < y ) ;
+
+}
+
+
+
+/*
+ * Applies specified action to the zones of specified dataset holding the
+ * points selected by specified file dataspace.
+ *
+ * Returns NULL on success, otherwise an error message.
+ *
+ */
+static const char * apply_to_point_zones( hid_t dataset_id,
+  const ZoneMap* map, hid_t zone_map_id, hid_t file_dataspace_id,
+  zone_action action )
+{
+
+  hssize_t point_count = H5Sget_select_elem_npoints( file_dataspace_id ) ;
+  int rank = H5Sget_simple_extent_ndims( file_dataspace_id ) ;
+
+  if ( point_count < 0 || rank <= 0 )
+	return "Cannot get the selected points" ;
+
+  hsize_t * coords = enif_alloc( point_count * rank * sizeof( hsize_t ) ) ;
+
+  if ( coords == NULL )
+	return "Cannot allocate the selected points" ;
+
+  if ( H5Sget_select_elem_pointlist( file_dataspace_id, 0, point_count,
+	  coords ) < 0 )
+  {
+	enif_free( coords ) ;
+	return "Cannot get the selected points" ;
+  }
+
+  // Zone of each point, sorted then processed by runs of consecutive ones:
+  hssize_t i ;
+
+  for ( i = 0; i < point_count; i++ )
+	coords[i] = coords[ i * rank ] / map->zone_rows ;
+
+  qsort( coords, point_count, sizeof( hsize_t ), compare_zones ) ;
+
+  const char * error_message = NULL ;
+
+  hssize_t first = 0 ;
+
+  for ( i = 1; i <= point_count && ! error_message; i++ )
+  {
+
+	if ( i < point_count && coords[i] <= coords[ i - 1 ] + 1 )
+	  continue ;
+
+	error_message = action( dataset_id, map, zone_map_id, coords[ first ],
+	  coords[ i - 1 ] + 1 ) ;
+
+	first = i ;
+
+  }
+
+  enif_free( coords ) ;
+
+  return error_message ;
+
+}
+
+
+
+/*
+ * Applies specified action to the zones of specified dataset (of specified
+ * geometry) touched by the cells selected by specified file dataspace
+ * (H5S_ALL meaning its full extent).
+ *
+ * Returns NULL on success, otherwise an error message.
+ *
+ */
+static const char * apply_to_selected_zones( hid_t dataset_id,
+  const ZoneMap* map, hid_t zone_map_id, hid_t file_dataspace_id,
+  zone_action action )
+{
+
+  hsize_t zones = get_zone_count( map ) ;
+
+  if ( zones == 0 )
+	return NULL ;
+
+  H5S_sel_type selection = ( file_dataspace_id == H5S_ALL ) ? H5S_SEL_ALL :
+	H5Sget_select_type( file_dataspace_id ) ;
+
+  hsize_t first = 0 ;
+  hsize_t last = zones - 1 ;
+
+  switch ( selection )
+  {
+
+  case H5S_SEL_NONE:
+	return NULL ;
+
+  case H5S_SEL_POINTS:
+	return apply_to_point_zones( dataset_id, map, zone_map_id,
+	  file_dataspace_id, action ) ;
+
+  case H5S_SEL_HYPERSLABS:
+	{
+
+	  hsize_t start[ H5S_MAX_RANK ] ;
+	  hsize_t end[ H5S_MAX_RANK ] ;
+
+	  if ( H5Sget_select_bounds( file_dataspace_id, start, end ) < 0 )
+		return "Cannot get the bounds of the selection" ;
+
+	  first = start[0] / map->zone_rows ;
+	  last = end[0] / map->zone_rows ;
+
+	}
+	// Falls through.
+
+  default:
+	return action( dataset_id, map, zone_map_id, first, last + 1 ) ;
+
+  }
+
+}
+
+
+
+/*
+ * Tells whether the cells selected by specified file dataspace (H5S_ALL
+ * meaning its full extent) of a dataset of specified geometry are exactly the
+ * rows appended at its end, from specified row (the number of rows that the
+ * dataset had before; HSIZE_UNDEF if unknown), i.e. cells that held no data
+ * before being written, in row-major order.
+ *
+ */
+static bool is_append( const ZoneMap* map, hid_t file_dataspace_id,
+  hsize_t old_rows )
+{
+
+  if ( old_rows == HSIZE_UNDEF || old_rows >= map->rows )
+	return false ;
+
+  if ( file_dataspace_id == H5S_ALL )
+	return old_rows == 0 ;
+
+  if ( H5Sget_select_type( file_dataspace_id ) != H5S_SEL_HYPERSLABS )
+	return false ;
+
+  hsize_t start[ H5S_MAX_RANK ] ;
+  hsize_t end[ H5S_MAX_RANK ] ;
+
+  int rank = H5Sget_simple_extent_ndims( file_dataspace_id ) ;
+  hssize_t selected = H5Sget_select_npoints( file_dataspace_id ) ;
+
+  if ( rank <= 0 || selected < 0
+	|| H5Sget_select_bounds( file_dataspace_id, start, end ) < 0 )
+	return false ;
+
+  // The selection must be exactly whole rows, hence fill its bounding box:
+  hsize_t box_cells = end[0] - start[0] + 1 ;
+
+  int i ;
+
+  for ( i = 1; i < rank; i++ )
+  {
+
+	if ( start[i] != 0 )
+	  return false ;
+
+	box_cells *= end[i] + 1 ;
+
+  }
+
+  return start[0] == old_rows && end[0] + 1 == map->rows
+	&& box_cells == (hsize_t) selected
+	&& box_cells == ( map->rows - old_rows ) * map->row_cells ;
+
+}
+
+
+
+// Tells whether specified type is a scalar one that can be summarized:
+static bool is_summarizable( hid_t type_id )
+{
+
+  H5T_class_t type_class = H5Tget_class( type_id ) ;
+
+  return ( type_class == H5T_INTEGER || type_class == H5T_FLOAT )
+	&& H5Tget_size( type_id ) <= sizeof( double ) ;
+
+}
+
+
+
+/*
+ * Folds the cells of specified buffer (of specified memory type), just
+ * appended to specified dataset (of specified geometry) from specified row,
+ * into the summaries of their zones, and writes these summaries in specified
+ * zone map.
+ *
+ * The cells are converted as when they were written, then read, so that they
+ * are summarized as stored (ex: once rounded to a float).
+ *
+ * Returns NULL on success, otherwise an error message (the zones having then
+ * to be summarized otherwise).
+ *
+ */
+static const char * fold_appended_cells( hid_t dataset_id, const ZoneMap* map,
+  hid_t zone_map_id, hsize_t old_rows, hid_t mem_type_id,
+  const void* buffer )
+{
+
+  hid_t type_id = H5Dget_type( dataset_id ) ;
+
+  if ( type_id < 0 )
+	return "Cannot get the type of the dataset" ;
+
+  hid_t stored_type_id = H5Tget_native_type( type_id, H5T_DIR_ASCEND ) ;
+
+  H5Tclose( type_id ) ;
+
+  if ( stored_type_id < 0 )
+	return "Cannot get the type of the dataset" ;
+
+  const char * error_message = NULL ;
+
+  if ( ! is_summarizable( mem_type_id ) || ! is_summarizable( stored_type_id ) )
+  {
+	error_message = "Cells cannot be summarized" ;
+	goto end ;
+  }
+
+  Zone zones[ ZONE_BATCH ] ;
+  double cells[ FOLD_BATCH ] ;
+
+  Summary summary = { zones, map->zone_rows * map->row_cells } ;
+
+  size_t cell_size = H5Tget_size( mem_type_id ) ;
+
+  const unsigned char * source = (const unsigned char *) buffer ;
+
+  hsize_t first = old_rows / map->zone_rows ;
+  hsize_t end = get_zone_count( map ) ;
+
+  // Cells of the first zone held before the append, and cells appended:
+  hsize_t position = ( old_rows - first * map->zone_rows ) * map->row_cells ;
+  hsize_t remaining = ( map->rows - old_rows ) * map->row_cells ;
+
+  hsize_t batch ;
+
+  for ( ; first < end && ! error_message; first += batch )
+  {
+
+	batch = ( end - first < ZONE_BATCH ) ? end - first : ZONE_BATCH ;
+
+	hsize_t i ;
+
+	for ( i = 0; i < batch; i++ )
+	{
+	  zones[i].min = INFINITY ;
+	  zones[i].max = -INFINITY ;
+	  zones[i].count = 0 ;
+	}
+
+	// Only the first zone may hold rows from before, already summarized:
+	if ( position > 0 )
+	{
+
+	  error_message = read_zones( zone_map_id, first, 1, zones ) ;
+
+	  if ( ! error_message && zones[0].count < 0 )
+		error_message = "Zone not summarized" ;
+
+	}
+
+	hsize_t count = batch * summary.zone_cells - position ;
+
+	if ( count > remaining )
+	  count = remaining ;
+
+	remaining -= count ;
+
+	while ( count > 0 && ! error_message )
+	{
+
+	  size_t run = ( count < FOLD_BATCH ) ? count : FOLD_BATCH ;
+
+	  memcpy( cells, source, run * cell_size ) ;
+
+	  if ( H5Tconvert( mem_type_id, stored_type_id, run, cells, NULL,
+		  H5P_DEFAULT ) < 0
+		|| H5Tconvert( stored_type_id, H5T_NATIVE_DOUBLE, run, cells, NULL,
+		  H5P_DEFAULT ) < 0 )
+		error_message = "Cannot convert the appended cells" ;
+	  else
+		summarize_cells( cells, run, position, &summary ) ;
+
+	  source += run * cell_size ;
+	  position += run ;
+	  count -= run ;
+
+	}
+
+	if ( ! error_message )
+	  error_message = write_zones( zone_map_id, first, batch, zones ) ;
+
+	position = 0 ;
+
+  }
+
+ end:
+  H5Tclose( stored_type_id ) ;
+
+  return error_message ;
+
+}
+
+
+
+/*
+ * Updates the zone map (if any) of specified dataset, once specified buffer
+ * (of specified memory type) has been written (if written is true) to the
+ * cells selected by specified file dataspace (H5S_ALL meaning its full
+ * extent), the dataset having had specified number of rows before (HSIZE_UNDEF
+ * if unknown): the zone map is resized to the current extent of the dataset,
+ * and the zones touched by the write are summarized again, with a single write
+ * to the zone map.
+ *
+ * Any failure here just leaves these zones unknown (hence not skipped by
+ * scans), and is thus not reported, the write itself being done; so does a
+ * zone map whose existence cannot be determined (see open_zone_map/2), left
+ * as it was.
+ *
+ */
+void update_zone_map( Handle* dataset, hid_t file_dataspace_id,
+  hsize_t old_rows, hid_t mem_type_id, const void* buffer, bool written )
+{
+
+  hid_t zone_map_id ;
+
+  if ( open_zone_map( dataset, &zone_map_id ) <= 0 )
+	return ;
+
+  hid_t dataset_id = dataset->id ;
+
+  ZoneMap map ;
+
+  if ( get_zone_geometry( dataset_id, &map ) )
+  {
+	H5Dclose( zone_map_id ) ;
+	return ;
+  }
+
+  const char * error_message = resize_zone_map( zone_map_id,
+	get_zone_count( &map ) ) ;
+
+  // Appended rows are folded from the buffer (scanned only if this failed),
+  // whereas cells possibly overwritten are scanned again:
+  if ( ! error_message && written )
+  {
+
+	bool append = is_append( &map, file_dataspace_id, old_rows ) ;
+
+	if ( append )
+	  error_message = fold_appended_cells( dataset_id, &map, zone_map_id,
+		old_rows, mem_type_id, buffer ) ;
+
+	if ( error_message || ! append )
+	  error_message = apply_to_selected_zones( dataset_id, &map, zone_map_id,
+		file_dataspace_id, refresh_zones ) ;
+
+  }
+
+  // Cells possibly partly written, or zones not summarized, are unknown:
+  if ( error_message || ! written )
+	apply_to_selected_zones( dataset_id, &map, zone_map_id,
+	  file_dataspace_id, forget_zones ) ;
+
+  H5Dclose( zone_map_id ) ;
+
+}
+
+
+
+/*
+ * Reads the zones of specified dataset spanning specified rows, if it has a
+ * zone map (otherwise map->zones is NULL).
+ *
+ * On success, map->zones (if not NULL) is to be freed by the caller.
+ *
+ * Returns NULL on success, otherwise an error message.
+ *
+ */
+const char * read_zone_map( Handle* dataset, hsize_t first_row,
+  hsize_t end_row, ZoneMap* map )
+{
+
+  map->zones = NULL ;
+
+  hid_t zone_map_id ;
+
+  int opened = open_zone_map( dataset, &zone_map_id ) ;
+
+  if ( opened == 0 || first_row >= end_row )
+  {
+	if ( opened > 0 )
+	  H5Dclose( zone_map_id ) ;
+	return NULL ;
+  }
+
+  if ( opened < 0 )
+	return "Cannot open the zone map" ;
+
+  const char * error_message = get_zone_geometry( dataset->id, map ) ;
+
+  if ( error_message )
+	goto end ;
+
+  map->first = first_row / map->zone_rows ;
+  map->count = ( end_row - 1 ) / map->zone_rows + 1 - map->first ;
+
+  map->zones = enif_alloc( map->count * sizeof( Zone ) ) ;
+
+  if ( map->zones == NULL )
+  {
+	error_message = "Cannot allocate the zone map" ;
+	goto end ;
+  }
+
+  hsize_t i ;
+
+  for ( i = 0; i < map->count; i++ )
+	map->zones[i].count = UNKNOWN_ZONE_COUNT ;
+
+  hid_t space_id = H5Dget_space( zone_map_id ) ;
+
+  hsize_t dims[ 2 ] ;
+
+  if ( space_id < 0
+	|| H5Sget_simple_extent_dims( space_id, dims, NULL ) != 2 )
+	error_message = "Invalid zone map" ;
+
+  // Zones not stored yet are left unknown:
+  else if ( dims[0] > map->first )
+  {
+
+	hsize_t stored = ( dims[0] - map->first < map->count ) ?
+	  dims[0] - map->first : map->count ;
+
+	error_message = read_zones( zone_map_id, map->first, stored, map->zones ) ;
+
+  }
+
+  if ( space_id >= 0 )
+	H5Sclose( space_id ) ;
+
+  if ( error_message )
+  {
+	enif_free( map->zones ) ;
+	map->zones = NULL ;
+  }
+
+ end:
+  H5Dclose( zone_map_id ) ;
+
+  return error_message ;
+
+}
+
+
+
+/*
+ * Creates the zone map of specified chunked dataset (or rebuilds it, if it
+ * already exists), by summarizing all its zones; it is then kept up to date by
+ * all writes to this dataset, and used by the scans of its cells (see
+ * h5d_scan/3).
+ *
+ * This implementation corresponds to h5d_create_zone_map/1:
+ *
+ * -spec h5d_create_zone_map( dataset_handle() ) -> 'ok' | error().
+ *
+ */
+ERL_NIF_TERM h5d_create_zone_map( ErlNifEnv* env, int argc,
+  const ERL_NIF_TERM argv[] )
+{
+
+  Handle * dataset ;
+
+  if ( ! get_handle( env, argv[0], DATASET_HANDLE, &dataset )
+	|| dataset->id < 0 )
+	return error_tuple( env, "Cannot get dataset handle from argv" ) ;
+
+  hid_t dataset_id = dataset->id ;
+
+  ZoneMap map ;
+
+  const char * error_message = get_zone_geometry( dataset_id, &map ) ;
+
+  if ( error_message )
+	return error_tuple( env, (char *) error_message ) ;
+
+  hid_t zone_map_id ;
+
+  // Looked for even if this handle found none, as another one may have
+  // created it since:
+  check_zone_map( dataset ) ;
+
+  int opened = open_zone_map( dataset, &zone_map_id ) ;
+
+  if ( opened < 0 )
+	return error_tuple( env, "Cannot open the zone map" ) ;
+
+  if ( opened == 0 )
+  {
+
+	char path[ MAXBUFLEN ] ;
+
+	if ( ! get_zone_map_path( dataset_id, path, sizeof( path ) ) )
+	  return error_tuple( env, "Cannot determine the name of the zone map" ) ;
+
+	hsize_t dims[ 2 ] = { 0, ZONE_FIELDS } ;
+	hsize_t max_dims[ 2 ] = { H5S_UNLIMITED, ZONE_FIELDS } ;
+	hsize_t chunk_dims[ 2 ] = { ZONE_MAP_CHUNK_ZONES, ZONE_FIELDS } ;
+
+	hid_t space_id = H5Screate_simple( 2, dims, max_dims ) ;
+	hid_t dcpl_id = H5Pcreate( H5P_DATASET_CREATE ) ;
+
+	zone_map_id = -1 ;
+
+	// So that the zones added by resizing the zone map are unknown:
+	double unknown = UNKNOWN_ZONE_COUNT ;
+
+	if ( space_id >= 0 && dcpl_id >= 0
+	  && H5Pset_chunk( dcpl_id, 2, chunk_dims ) >= 0
+	  && H5Pset_fill_value( dcpl_id, H5T_NATIVE_DOUBLE, &unknown ) >= 0 )
+	  zone_map_id = H5Dcreate2( dataset_id, path, H5T_NATIVE_DOUBLE, space_id,
+		H5P_DEFAULT, dcpl_id, H5P_DEFAULT ) ;
+
+	if ( space_id >= 0 )
+	  H5Sclose( space_id ) ;
+
+	if ( dcpl_id >= 0 )
+	  H5Pclose( dcpl_id ) ;
+
+	if ( zone_map_id < 0 )
+	  return error_tuple( env, "Cannot create the zone map" ) ;
+
+	// So that all other handles check again for a zone map:
+	zone_map_generation++ ;
+
+	dataset->zone_map = true ;
+	dataset->zone_map_generation = zone_map_generation ;
+
+  }
+
+  hsize_t zones = get_zone_count( &map ) ;
+
+  error_message = resize_zone_map( zone_map_id, zones ) ;
+
+  if ( ! error_message )
+	error_message = refresh_zones( dataset_id, &map, zone_map_id, 0, zones ) ;
+
+  H5Dclose( zone_map_id ) ;
+
+  if ( error_message )
+	return error_tuple( env, (char *) error_message ) ;
+
+  return atom_ok ;
+
+}
+
+
+
+/*
+ * Returns the zone map of specified dataset: per zone (i.e. per slab of rows
+ * as high as its chunks), the minimum and maximum of its non-NaN cells (both
+ * 'undefined' if it has none) and their count, or 'undefined' if this zone is
+ * not summarized.
+ *
+ * This implementation corresponds to h5d_get_zone_map/1:
+ *
+ * -spec h5d_get_zone_map( dataset_handle() ) -> { 'ok', [ { aggregate_value(),
+ *                    aggregate_value(), size() } | 'undefined' ] } | error().
+ *
+ */
+ERL_NIF_TERM h5d_get_zone_map( ErlNifEnv* env, int argc,
+  const ERL_NIF_TERM argv[] )
+{
+
+  Handle * dataset ;
+
+  if ( ! get_handle( env, argv[0], DATASET_HANDLE, &dataset )
+	|| dataset->id < 0 )
+	return error_tuple( env, "Cannot get dataset handle from argv" ) ;
+
+  hid_t zone_map_id ;
+
+  int opened = open_zone_map( dataset, &zone_map_id ) ;
+
+  if ( opened == 0 )
+	return error_tuple( env, "Dataset has no zone map" ) ;
+
+  if ( opened < 0 )
+	return error_tuple( env, "Cannot open the zone map" ) ;
+
+  H5Dclose( zone_map_id ) ;
+
+  ZoneMap map ;
+
+  const char * error_message = get_zone_geometry( dataset->id, &map ) ;
+
+  if ( ! error_message )
+	error_message = read_zone_map( dataset, 0, map.rows, &map ) ;
+
+  if ( error_message )
+	return error_tuple( env, (char *) error_message ) ;
+
+  ERL_NIF_TERM list = enif_make_list( env, 0 ) ;
+
+  // No zone is held for an empty dataset:
+  if ( map.zones == NULL )
+	return enif_make_tuple2( env, atom_ok, list ) ;
+
+  ERL_NIF_TERM undefined = enif_make_atom( env, "undefined" ) ;
+
+  hsize_t i = map.count ;
+
+  while ( i-- > 0 )
+  {
+
+	const Zone * zone = map.zones + i ;
+
+	ERL_NIF_TERM element ;
+
+	if ( zone->count < 0 )
+	  element = undefined ;
+	else if ( zone->count == 0 )
+	  element = enif_make_tuple3( env, undefined, undefined,
+		enif_make_uint64( env, 0 ) ) ;
+	else
+	  element = enif_make_tuple3( env, make_double_term( env, zone->min ),
+		make_double_term( env, zone->max ),
+		enif_make_uint64( env, (ErlNifUInt64) zone->count ) ) ;
+
+	list = enif_make_list_cell( env, element, list ) ;
+
+  }
+
+  enif_free( map.zones ) ;
+
+  return enif_make_tuple2( env, atom_ok, list ) ;
+
+}
@@ -21,6 +21,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include "hdf5.h"
+#include "hdf5_hl.h"
 #include "erl_nif.h"
 #include "dbg.h"
 #include "erlhdf5.h"
@@ -30,6 +31,7 @@
 
 // prototype
 static int convert_access_flag(char* file_flags, unsigned *flags);
+static int get_access_flags(ErlNifEnv* env, ERL_NIF_TERM term, unsigned *flags);
 
 
 // convert
@@ -43,6 +45,12 @@ static int convert_access_flag(char* file_flags, unsigned *flags)
 	*flags = H5F_ACC_RDWR;
   else if(strncmp(file_flags, "H5F_ACC_RDONLY", MAXBUFLEN) == 0)
 	*flags = H5F_ACC_RDONLY;
+#ifdef H5F_ACC_SWMR_WRITE
+  else if(strncmp(file_flags, "H5F_ACC_SWMR_WRITE", MAXBUFLEN) == 0)
+	*flags = H5F_ACC_SWMR_WRITE;
+  else if(strncmp(file_flags, "H5F_ACC_SWMR_READ", MAXBUFLEN) == 0)
+	*flags = H5F_ACC_SWMR_READ;
+#endif
   else
 	sentinel("Unknown file access flag %s", file_flags);
   return 0;
@@ -52,74 +60,159 @@ static int convert_access_flag(char* file_flags, unsigned *flags)
 };
 
 
-// create file
+
+/*
+ * Gets access flags from specified term, either a single flag atom (ex:
+ * 'H5F_ACC_RDWR') or a list of them to be combined (ex: [ 'H5F_ACC_RDWR',
+ * 'H5F_ACC_SWMR_WRITE' ]).
+ *
+ * Returns 0 on success, -1 on failure (then the call is to be rejected, as a
+ * bad argument).
+ *
+ */
+static int get_access_flags(ErlNifEnv* env, ERL_NIF_TERM term, unsigned *flags)
+{
+
+  char file_access_flags[ MAXBUFLEN ] ;
+
+  unsigned flag ;
+
+  if ( enif_get_atom( env, term, file_access_flags,
+	  sizeof( file_access_flags ), ERL_NIF_LATIN1 ) )
+	return convert_access_flag( file_access_flags, flags ) ;
+
+  check( enif_is_list( env, term ), "Access flags neither an atom nor a list" ) ;
+
+  *flags = 0 ;
+
+  ERL_NIF_TERM head ;
+
+  while ( enif_get_list_cell( env, term, &head, &term ) )
+  {
+
+	check( enif_get_atom( env, head, file_access_flags,
+		sizeof( file_access_flags ), ERL_NIF_LATIN1 ),
+	  "Cannot get access flag from list" ) ;
+
+	check( ! convert_access_flag( file_access_flags, &flag ),
+	  "Failed to convert access flag" ) ;
+
+	*flags |= flag ;
+
+  }
+
+  // An improper list (ex: [ 'H5F_ACC_RDWR' | foo ]) is rejected as a whole:
+  check( enif_is_empty_list( env, term ), "Access flags not a proper list" ) ;
+
+  return 0 ;
+
+ error:
+  return -1 ;
+
+}
+
+
+/*
+ * Creates specified HDF5 file.
+ *
+ * This implementation corresponds to h5fcreate/{2,3,4}, depending on whether a
+ * file access property list and a file creation one are specified:
+ *
+ * -spec h5fcreate( FileName::string(), Flag::atom() ) ->
+ *   { 'ok', file_handle() } | error().
+ *
+ * -spec h5fcreate( FileName::string(), Flag::atom(),
+ *   file_access_proplist() ) -> { 'ok', file_handle() } | error().
+ *
+ * -spec h5fcreate( FileName::string(), Flag::atom(),
+ *   file_creation_proplist(), file_access_proplist() ) ->
+ *   { 'ok', file_handle() } | error().
+ *
+ */
 ERL_NIF_TERM h5fcreate(ErlNifEnv* env, int argc, const ERL_NIF_TERM argv[])
 {
-  hid_t file_id;
-  ERL_NIF_TERM ret;
+  hid_t file_id = -1;
+  hid_t fcpl_id = H5P_DEFAULT;
+  hid_t fapl_id = H5P_DEFAULT;
   char file_name[MAXBUFLEN];
-  char file_access_flags[MAXBUFLEN];
   unsigned flags;
 
   // parse arguments
-  check(argc == 2, "Incorrect number of arguments");
+  check(argc >= 2 && argc <= 4, "Incorrect number of arguments");
   check(enif_get_string(env, argv[0], file_name, sizeof(file_name), ERL_NIF_LATIN1), "Cannot get file name from argv");
-  check(enif_get_atom(env, argv[1], file_access_flags, sizeof(file_access_flags), ERL_NIF_LATIN1), \
-	"Cannot get file_access_flag from argv");
-
-  // convert access flag to format which hdf5 api understand
-  check(!convert_access_flag(file_access_flags, &flags), "Failed to convert access flag");
-
-  // create a new file using default properties
-  file_id = H5Fcreate(file_name, flags, H5P_DEFAULT, H5P_DEFAULT);
+  check(!get_access_flags(env, argv[1], &flags), \
+	"Cannot get file access flags from argv");
+
+  if(argc == 3)
+	check(!get_proplist(env, argv[2], H5P_FILE_ACCESS, &fapl_id), \
+	  "Cannot get file access property list from argv");
+
+  if(argc == 4) {
+	check(!get_proplist(env, argv[2], H5P_FILE_CREATE, &fcpl_id), \
+	  "Cannot get file creation property list from argv");
+	check(!get_proplist(env, argv[3], H5P_FILE_ACCESS, &fapl_id), \
+	  "Cannot get file access property list from argv");
+  }
+
+  // create a new file, the property lists remaining owned by the caller
+  file_id = H5Fcreate(file_name, flags, fcpl_id, fapl_id);
   check(file_id > 0, "Failed to create %s.", file_name);
 
-  ret = enif_make_int(env, file_id);
-  return enif_make_tuple2(env, atom_ok, ret);
+  // the handle now owns (and will close) the file
+  return make_handle(env, FILE_HANDLE, file_id);
 
  error:
-  if(file_id) H5Fclose (file_id);
+  if(file_id > 0) H5Fclose (file_id);
   return error_tuple(env, "Cannot create file");
 };
 
 
 
-// Opens specified HDF5 file.
+/*
+ * Opens specified HDF5 file.
+ *
+ * This implementation corresponds to h5fopen/{2,3}, depending on whether a
+ * file access property list is specified:
+ *
+ * -spec h5fopen( FileName::string(), Flag::atom() ) ->
+ *   { 'ok', file_handle() } | error().
+ *
+ * -spec h5fopen( FileName::string(), Flag::atom(), file_access_proplist() ) ->
+ *   { 'ok', file_handle() } | error().
+ *
+ */
 ERL_NIF_TERM h5fopen( ErlNifEnv* env, int argc, const ERL_NIF_TERM argv[] )
 {
 
-  hid_t file_id ;
+  hid_t file_id = -1 ;
 
-  ERL_NIF_TERM ret ;
+  hid_t fapl_id = H5P_DEFAULT ;
 
   char file_name[ MAXBUFLEN ] ;
 
-  char file_access_flags[ MAXBUFLEN ] ;
-
   unsigned flags ;
 
-  check( argc == 2, "Incorrect number of arguments" ) ;
+  check( argc == 2 || argc == 3, "Incorrect number of arguments" ) ;
 
   check( enif_get_string( env, argv[0], file_name, sizeof( file_name ),
 	  ERL_NIF_LATIN1 ), "Cannot get file name from argv" ) ;
 
-  check( enif_get_atom( env, argv[1], file_access_flags,
-	  sizeof( file_access_flags ), ERL_NIF_LATIN1 ),
-	"Cannot get file_access_flag from argv" ) ;
+  // Converts access flags to a format which the HDF5 library understands:
+  check( ! get_access_flags( env, argv[1], &flags ),
+	"Cannot get file access flags from argv" ) ;
 
-  // Converts access flag to a format which the HDF5 library understands:
-  check( ! convert_access_flag( file_access_flags, &flags ),
-	"Failed to convert access flag" ) ;
+  if ( argc == 3 )
+	check( ! get_proplist( env, argv[2], H5P_FILE_ACCESS, &fapl_id ),
+	  "Cannot get file access property list from argv" ) ;
 
-  // Creates a new file object, using default properties:
-  file_id = H5Fopen( file_name, flags, H5P_DEFAULT ) ;
+  // Creates a new file object (the access property list remains the caller's):
+  file_id = H5Fopen( file_name, flags, fapl_id ) ;
   check( file_id > 0, "Failed to open %s.", file_name ) ;
 
-  ret = enif_make_int( env, file_id ) ;
-  return enif_make_tuple2( env, atom_ok, ret ) ;
+  return make_handle( env, FILE_HANDLE, file_id ) ;
 
  error:
-  if ( file_id )
+  if ( file_id > 0 )
 	H5Fclose( file_id ) ;
   return error_tuple( env, "Cannot open file" ) ;
 
@@ -131,15 +224,15 @@ ERL_NIF_TERM h5fopen( ErlNifEnv* env, int argc, const ERL_NIF_TERM argv[] )
 ERL_NIF_TERM h5fclose( ErlNifEnv* env, int argc, const ERL_NIF_TERM argv[] )
 {
 
-  hid_t file_id ;
+  Handle* file_handle ;
 
   check( argc == 1, "Incorrect number of arguments" ) ;
 
-  check( enif_get_int( env, argv[0], &file_id ),
+  check( get_handle( env, argv[0], FILE_HANDLE, &file_handle ),
 	"Cannot get file handle from argv" ) ;
 
   // Closes file:
-  check( ! H5Fclose( file_id ), "Failed to close file." ) ;
+  check( close_handle( file_handle ) >= 0, "Failed to close file." ) ;
 
   return atom_ok ;
 
@@ -147,3 +240,151 @@ ERL_NIF_TERM h5fclose( ErlNifEnv* env, int argc, const ERL_NIF_TERM argv[] )
   return error_tuple( env, "Cannot close file" ) ;
 
 }
+
+
+
+/*
+ * Opens, as an in-memory HDF5 file, the file image contained in specified
+ * binary (ex: received from the network), which is copied, so that the binary
+ * may be freed afterwards; no disk I/O is performed.
+ *
+ * This implementation corresponds to h5f_open_image/{1,2}, the default access
+ * being read-only:
+ *
+ * -spec h5f_open_image( binary() ) -> { 'ok', file_handle() } | error().
+ *
+ * -spec h5f_open_image( binary(), Flag::atom() ) ->
+ *   { 'ok', file_handle() } | error().
+ *
+ */
+ERL_NIF_TERM h5f_open_image( ErlNifEnv* env, int argc,
+  const ERL_NIF_TERM argv[] )
+{
+
+  ErlNifBinary image ;
+
+  unsigned image_flags = 0 ;
+
+  check( argc == 1 || argc == 2, "Incorrect number of arguments" ) ;
+
+  check( enif_inspect_binary( env, argv[0], &image ) && image.size > 0,
+	"Cannot get (non-empty) file image from argv" ) ;
+
+  if ( argc == 2 )
+  {
+
+	unsigned flags ;
+
+	check( ! get_access_flags( env, argv[1], &flags ),
+	  "Cannot get file access flags from argv" ) ;
+
+	check( flags == H5F_ACC_RDONLY || flags == H5F_ACC_RDWR,
+	  "File images can only be opened read-only or read-write" ) ;
+
+	if ( flags == H5F_ACC_RDWR )
+	  image_flags = H5LT_FILE_IMAGE_OPEN_RW ;
+
+  }
+
+  // The image is copied by the library (no H5LT_FILE_IMAGE_DONT_COPY):
+  hid_t file_id = H5LTopen_file_image( image.data, image.size, image_flags ) ;
+
+  check( file_id > 0, "Failed to open file image." ) ;
+
+  return make_handle( env, FILE_HANDLE, file_id ) ;
+
+ error:
+  return error_tuple( env, "Cannot open file image" ) ;
+
+}
+
+
+
+/*
+ * Returns, as a binary, the image of specified (open) HDF5 file, i.e. the
+ * bytes that would be written on disk; typically used with files created with
+ * the core driver (see h5pset_fapl_core/3), so that whole files are built in
+ * RAM.
+ *
+ * -spec h5f_get_image( file_handle() ) -> { 'ok', binary() } | error().
+ *
+ */
+ERL_NIF_TERM h5f_get_image( ErlNifEnv* env, int argc,
+  const ERL_NIF_TERM argv[] )
+{
+
+  hid_t file_id ;
+
+  ErlNifBinary image ;
+
+  bool allocated = false ;
+
+  check( argc == 1, "Incorrect number of arguments" ) ;
+
+  check( get_handle_id( env, argv[0], FILE_HANDLE, &file_id ),
+	"Cannot get file handle from argv" ) ;
+
+  // So that the image includes any pending (metadata) write:
+  H5Fflush( file_id, H5F_SCOPE_LOCAL ) ;
+
+  // First call just to know the size of the image:
+  ssize_t size = H5Fget_file_image( file_id, NULL, 0 ) ;
+
+  check( size > 0, "Failed to get the size of the file image." ) ;
+
+  check( enif_alloc_binary( size, &image ), "Cannot allocate binary" ) ;
+
+  allocated = true ;
+
+  check( H5Fget_file_image( file_id, image.data, size ) == size,
+	"Failed to get the file image." ) ;
+
+  return enif_make_tuple2( env, atom_ok, enif_make_binary( env, &image ) ) ;
+
+ error:
+  if ( allocated )
+	enif_release_binary( &image ) ;
+
+  return error_tuple( env, "Cannot get file image" ) ;
+
+}
+
+
+
+/*
+ * Switches specified file, opened read-write with the latest file format (see
+ * h5pset_libver_bounds/3), to Single-Writer/Multiple-Reader writing mode, so
+ * that readers opening it with 'H5F_ACC_SWMR_READ' see consistent metadata
+ * while it is being appended to. Requires HDF5 1.10 or later.
+ *
+ * -spec h5fstart_swmr_write( file_handle() ) -> 'ok' | error().
+ *
+ */
+ERL_NIF_TERM h5fstart_swmr_write( ErlNifEnv* env, int argc,
+  const ERL_NIF_TERM argv[] )
+{
+
+#ifdef H5F_ACC_SWMR_WRITE
+
+  hid_t file_id ;
+
+  check( argc == 1, "Incorrect number of arguments" ) ;
+
+  check( get_handle_id( env, argv[0], FILE_HANDLE, &file_id ),
+	"Cannot get file handle from argv" ) ;
+
+  check( H5Fstart_swmr_write( file_id ) >= 0,
+	"Failed to start SWMR writing." ) ;
+
+  return atom_ok ;
+
+ error:
+  return error_tuple( env, "Cannot start SWMR writing" ) ;
+
+#else
+
+  return error_tuple( env, "SWMR requires HDF5 1.10 or later" ) ;
+
+#endif
+
+}
@@ -59,7 +59,7 @@ ERL_NIF_TERM h5lt_make_dataset( ErlNifEnv* env, int argc,
 
   // parse arguments
   check(argc == 5, "Incorrect number of arguments");
-  check(enif_get_int(env, argv[0], &file_id ), "cannot get file id from argv");
+  check(get_handle_id(env, argv[0], FILE_HANDLE, &file_id ), "cannot get file id from argv");
   check(enif_get_string(env, argv[1], ds_name, sizeof(ds_name), ERL_NIF_LATIN1), "cannot get dataset name from argv");
   check(enif_get_int(env, argv[2], &rank ), "cannot get rank from argv");
   check(enif_get_tuple(env, argv[3], &arity, &dims), "cannot get dimensions from argv");
@@ -112,82 +112,130 @@ static int unpack_int_list(ErlNifEnv* env, ERL_NIF_TERM* list, int* data)
 
 
 /*
- * Reads specified native integer dataset from specified file.
+ * Reads specified dataset (whose file handle and name are the first two
+ * elements of argv) into a newly-allocated buffer of cells of the specified
+ * (memory) type, which is then to be freed by the caller.
  *
- * -spec h5lt_read_dataset_int( file_handle(), DatasetName::string() ) ->
- *                 { 'ok', [ integer() ] } | error().
+ * Returns whether the operation succeeded; on failure, error_term is set.
  *
  */
-ERL_NIF_TERM h5lt_read_dataset_int( ErlNifEnv* env, int argc,
-  const ERL_NIF_TERM argv[] )
+bool read_lt_dataset( ErlNifEnv* env, const ERL_NIF_TERM argv[],
+  hid_t mem_type_id, void** buffer, hsize_t* element_count,
+  ERL_NIF_TERM* error_term )
 {
 
-  check( argc == 2, "Incorrect number of arguments" ) ;
-
   hid_t file_id ;
-  check( enif_get_int( env, argv[0], &file_id ),
-	"Cannot get file handle from argv" ) ;
 
+  if ( ! get_handle_id( env, argv[0], FILE_HANDLE, &file_id ) )
+  {
+	*error_term = error_tuple( env, "Cannot get file handle from argv" ) ;
+	return false ;
+  }
 
   char ds_name[ MAXBUFLEN ] ;
 
-  check( enif_get_string( env, argv[1], ds_name, sizeof(ds_name),
-	  ERL_NIF_LATIN1 ), "Cannot get the name of dataset from argv" ) ;
+  if ( ! enif_get_string( env, argv[1], ds_name, sizeof( ds_name ),
+	  ERL_NIF_LATIN1 ) )
+  {
+	*error_term = error_tuple( env,
+	  "Cannot get the name of dataset from argv" ) ;
+	return false ;
+  }
 
   // Get the dimensions of this dataset:
   int ndims ;
 
-  check( ! H5LTget_dataset_ndims( file_id, ds_name, &ndims ),
-	"Failed to determine dataspace dimensions." ) ;
+  if ( H5LTget_dataset_ndims( file_id, ds_name, &ndims ) )
+  {
+	*error_term = error_tuple( env, "Failed to determine dataset dimensions" ) ;
+	return false ;
+  }
 
   // Get dataset information:
   hsize_t * dims = enif_alloc( ndims * sizeof( hsize_t ) ) ;
 
-  check( ! H5LTget_dataset_info( file_id, ds_name, dims, NULL, NULL),
-	"Failed to get information about dataset." ) ;
+  if ( H5LTget_dataset_info( file_id, ds_name, dims, NULL, NULL ) )
+  {
+	enif_free( dims ) ;
+	*error_term = error_tuple( env, "Failed to get information about dataset" ) ;
+	return false ;
+  }
 
   // Finds out the total number of values in the dataset from the dimensions:
   hsize_t n_values = 1 ;
 
   int i ;
 
-  for( i = 0; i < ndims; i++ )
+  for ( i = 0; i < ndims; i++ )
   {
 	n_values = n_values * dims[i] ;
   }
 
+  enif_free( dims ) ;
+
   // Allocates the corresponding space to hold the dataset values:
-  int * data = enif_alloc( n_values * sizeof( int ) ) ;
+  void * data = enif_alloc( n_values * H5Tget_size( mem_type_id ) ) ;
+
+  if ( ! data )
+  {
+	*error_term = error_tuple( env, "Buffer allocation failed" ) ;
+	return false ;
+  }
 
   // Reads that dataset:
-  check( ! H5LTread_dataset_int( file_id, ds_name, data ),
-	"Failed to read dataset." ) ;
+  if ( H5LTread_dataset( file_id, ds_name, mem_type_id, data ) )
+  {
+	enif_free( data ) ;
+	*error_term = error_tuple( env, "Failed to read dataset" ) ;
+	return false ;
+  }
+
+  *buffer = data ;
+  *element_count = n_values ;
+
+  return true ;
+
+}
+
+
+
+/*
+ * Reads specified native integer dataset from specified file.
+ *
+ * -spec h5lt_read_dataset_int( file_handle(), DatasetName::string() ) ->
+ *                 { 'ok', [ integer() ] } | error().
+ *
+ */
+ERL_NIF_TERM h5lt_read_dataset_int( ErlNifEnv* env, int argc,
+  const ERL_NIF_TERM argv[] )
+{
+
+  if ( argc != 2 )
+	return error_tuple( env, "Incorrect number of arguments" ) ;
+
+  void * data ;
+  hsize_t n_values ;
+  ERL_NIF_TERM error_term ;
+
+  if ( ! read_lt_dataset( env, argv, H5T_NATIVE_INT, &data, &n_values,
+	  &error_term ) )
+	return error_term ;
 
   // Converts the array of ints into a nif array:
   ERL_NIF_TERM * data_arr = (ERL_NIF_TERM*) enif_alloc(
 	sizeof( ERL_NIF_TERM ) * n_values ) ;
 
-  check( ! convert_int_array_to_nif_array( env, n_values, data, data_arr ),
-	"Cannot convert array to nif" ) ;
+  convert_int_array_to_nif_array( env, n_values, (int *) data, data_arr ) ;
 
   // Makes a list of ERL_NIF_TERM, to return to the caller:
   ERL_NIF_TERM ret = enif_make_list_from_array( env, data_arr, n_values ) ;
 
   // Cleanup:
-  enif_free( dims ) ;
   enif_free( data ) ;
+  enif_free( data_arr ) ;
 
   return enif_make_tuple2( env, atom_ok, ret ) ;
 
- error:
-  if ( dims )
-	enif_free( dims ) ;
-
-  if ( data )
-	enif_free( data ) ;
-
-  return error_tuple( env, "Cannot read integer dataset" ) ;
-
 }
 
 
@@ -203,76 +251,33 @@ ERL_NIF_TERM h5lt_read_dataset_double( ErlNifEnv* env, int argc,
   const ERL_NIF_TERM argv[] )
 {
 
-  check( argc == 2, "Incorrect number of arguments" ) ;
+  if ( argc != 2 )
+	return error_tuple( env, "Incorrect number of arguments" ) ;
 
-  hid_t file_id ;
-  check( enif_get_int( env, argv[0], &file_id ),
-	"Cannot get file handle from argv" ) ;
+  void * data ;
+  hsize_t n_values ;
+  ERL_NIF_TERM error_term ;
 
+  if ( ! read_lt_dataset( env, argv, H5T_NATIVE_DOUBLE, &data, &n_values,
+	  &error_term ) )
+	return error_term ;
 
-  char ds_name[ MAXBUFLEN ] ;
-
-  check( enif_get_string( env, argv[1], ds_name, sizeof(ds_name),
-	  ERL_NIF_LATIN1 ), "Cannot get the name of dataset from argv" ) ;
-
-  // Get the dimensions of this dataset:
-  int ndims ;
-
-  check( ! H5LTget_dataset_ndims( file_id, ds_name, &ndims ),
-	"Failed to determine dataspace dimensions." ) ;
-
-  // Get dataset information:
-  hsize_t * dims = enif_alloc( ndims * sizeof( hsize_t ) ) ;
-
-  check( ! H5LTget_dataset_info( file_id, ds_name, dims, NULL, NULL ),
-	"Failed to get information about dataset." ) ;
-
-  // Finds out the total number of values in the dataset from the dimensions:
-  hsize_t n_values = 1 ;
-
-  int i ;
-
-  for ( i = 0; i < ndims; i++ )
-  {
-	n_values = n_values * dims[i] ;
-  }
-
-  //printf( "Allocating space for %llu doubles.", n_values ) ;
-
-  // Allocates the corresponding space to hold the dataset values:
-  double * data = enif_alloc( n_values * sizeof( double ) ) ;
-
-  check( data != NULL, "Buffer allocation failed" ) ;
-
-   // Reads that dataset:
-  check( ! H5LTread_dataset_double( file_id, ds_name, data ),
-	"Failed to read dataset." ) ;
-
-  // Converts the array of ints into a nif array:
+  // Converts the array of doubles into a nif array:
   ERL_NIF_TERM * data_arr = (ERL_NIF_TERM*) enif_alloc(
 	sizeof( ERL_NIF_TERM ) * n_values ) ;
 
-  check( ! convert_double_array_to_nif_array( env, n_values, data, data_arr ),
-	"Cannot convert array to nif" ) ;
+  convert_double_array_to_nif_array( env, n_values, (double *) data,
+	data_arr ) ;
 
   // Makes a list of ERL_NIF_TERM, to return to the caller:
   ERL_NIF_TERM ret = enif_make_list_from_array( env, data_arr, n_values ) ;
 
   // Cleanup:
-  enif_free( dims ) ;
   enif_free( data ) ;
+  enif_free( data_arr ) ;
 
   return enif_make_tuple2( env, atom_ok, ret ) ;
 
- error:
-  if ( dims )
-	enif_free( dims ) ;
-
-  if ( data )
-	enif_free( data ) ;
-
-  return error_tuple( env, "Cannot read double dataset" ) ;
-
 }
 
 
@@ -291,7 +296,7 @@ ERL_NIF_TERM h5lt_read_dataset_string( ErlNifEnv* env, int argc,
   check( argc == 2, "Incorrect number of arguments" ) ;
 
   hid_t file_id ;
-  check( enif_get_int( env, argv[0], &file_id ),
+  check( get_handle_id( env, argv[0], FILE_HANDLE, &file_id ),
 	"Cannot get file handle from argv" ) ;
 
   char ds_name[ MAXBUFLEN ] ;
@@ -397,7 +402,7 @@ ERL_NIF_TERM h5ltget_dataset_ndims( ErlNifEnv* env, int argc,
 
   // parse arguments
   check(argc == 2, "Incorrect number of arguments");
-  check(enif_get_int(env, argv[0], &file_id), "cannot get resource from argv");
+  check(get_handle_id(env, argv[0], FILE_HANDLE, &file_id), "cannot get resource from argv");
   check(enif_get_string(env, argv[1], ds_name, sizeof(ds_name), ERL_NIF_LATIN1), "cannot get dataset name from argv");
 
   check(!H5LTget_dataset_ndims(file_id, ds_name, &ndims), "Failed to determine dataspace dimensions.");
@@ -423,7 +428,7 @@ ERL_NIF_TERM h5ltget_dataset_info( ErlNifEnv* env, int argc,
   check( argc == 3, "Incorrect number of arguments" ) ;
 
   hid_t file_id ;
-  check( enif_get_int( env, argv[0], &file_id ),
+  check( get_handle_id( env, argv[0], FILE_HANDLE, &file_id ),
 	"Cannot get resource from argv" ) ;
 
   char ds_name[ MAXBUFLEN ] ;
@@ -78,12 +78,41 @@ static int convert_property_flag(char* file_flags, unsigned *flags)
 };
 
 
+/*
+ * Gets, from specified term, the identifier of a property list (as created by
+ * h5pcreate/1) belonging to specified class (ex: H5P_FILE_ACCESS).
+ *
+ * The property list remains owned by the Erlang side.
+ *
+ * Returns 0 on success, -1 on failure.
+ *
+ */
+int get_proplist( ErlNifEnv* env, ERL_NIF_TERM term, hid_t class_id,
+  hid_t* plist_id )
+{
+
+  hid_t id ;
+
+  check( get_handle_id( env, term, PROPLIST_HANDLE, &id ),
+	"Cannot get property list handle" ) ;
+
+  check( H5Pisa_class( id, class_id ) > 0,
+	"Property list of unexpected class" ) ;
+
+  *plist_id = id ;
+
+  return 0 ;
+
+ error:
+  return -1 ;
+
+}
+
+
 // Creates a new property list as an instance of a property list class.
 ERL_NIF_TERM h5pcreate(ErlNifEnv* env, int argc, const ERL_NIF_TERM argv[])
 {
-  hid_t dcpl_id; // dataset creation property list
-  Handle* res;
-  ERL_NIF_TERM ret;
+  hid_t dcpl_id = -1; // dataset creation property list
   unsigned cls_id;
   char cls[MAXBUFLEN];
 
@@ -99,21 +128,11 @@ ERL_NIF_TERM h5pcreate(ErlNifEnv* env, int argc, const ERL_NIF_TERM argv[])
   dcpl_id = H5Pcreate(cls_id);
   check(dcpl_id > 0, "Failed to create property list.");
 
-  // create a resource to pass reference to id back to erlang
-  res = enif_alloc_resource(resource_type, sizeof(Handle));
-  check(res, "Failed to allocate resource for type %s", "Handle");
-
-  // add ref to resource
-  res->id = dcpl_id;
-  ret = enif_make_resource(env, res);
-
-  // cleanup
-  enif_release_resource(res);
-
-  return enif_make_tuple2(env, atom_ok, ret);
+  // create a handle to pass the id back to erlang (closing it once collected)
+  return make_handle(env, PROPLIST_HANDLE, dcpl_id);
 
  error:
-  if(dcpl_id) H5Pclose(dcpl_id);
+  if(dcpl_id > 0) H5Pclose(dcpl_id);
 
   return error_tuple(env, "Can not create properties list");
 };
@@ -126,11 +145,11 @@ ERL_NIF_TERM h5pclose(ErlNifEnv* env, int argc, const ERL_NIF_TERM argv[])
 
   // parse arguments
   check(argc == 1, "Incorrent number of arguments");
-  check(enif_get_resource(env, argv[0], resource_type, (void**) &res) != 0,	\
+  check(get_handle(env, argv[0], PROPLIST_HANDLE, &res), \
 	"Can't get resource from argv");
 
   // close properties list
-  err = H5Pclose(res->id);
+  err = close_handle(res);
   check(err == 0, "Failed to close properties list.");
 
   return atom_ok;
@@ -138,3 +157,708 @@ ERL_NIF_TERM h5pclose(ErlNifEnv* env, int argc, const ERL_NIF_TERM argv[])
  error:
   return error_tuple(env, "Can not close properties list");
 };
+
+
+
+/*
+ * Sets the size of the chunks used to store a chunked layout dataset, in the
+ * specified dataset creation property list.
+ *
+ * Chunking is required for datasets having extendible (ex: 'H5S_UNLIMITED')
+ * dimensions.
+ *
+ * -spec h5pset_chunk( property_list_handle(), rank(), tuple( size() ) ) ->
+ *                     'ok' | error().
+ *
+ */
+ERL_NIF_TERM h5pset_chunk( ErlNifEnv* env, int argc, const ERL_NIF_TERM argv[] )
+{
+
+  hid_t plist_id ;
+  hsize_t * chunk_dims = NULL ;
+
+  check( argc == 3, "Incorrect number of arguments" ) ;
+
+  check( ! get_proplist( env, argv[0], H5P_DATASET_CREATE, &plist_id ),
+	"Cannot get dataset creation property list from argv" ) ;
+
+  int rank ;
+  check( enif_get_int( env, argv[1], &rank ), "Cannot get rank from argv" ) ;
+
+  int arity ;
+  const ERL_NIF_TERM* terms ;
+
+  check( enif_get_tuple( env, argv[2], &arity, &terms ),
+	"Cannot get chunk dimensions from argv" ) ;
+
+  check( rank == arity, "Rank does not match the number of dimensions" ) ;
+
+  chunk_dims = (hsize_t*) enif_alloc( arity * sizeof( hsize_t ) ) ;
+
+  if ( ! chunk_dims )
+	return error_tuple( env, "Cannot allocate chunk dimensions" ) ;
+
+  check( ! convert_nif_to_hsize_array( env, arity, terms, chunk_dims ),
+	"Cannot convert chunk dimensions array" ) ;
+
+  check( H5Pset_chunk( plist_id, rank, chunk_dims ) >= 0,
+	"Failed to set chunk dimensions." ) ;
+
+  enif_free( chunk_dims ) ;
+
+  return atom_ok ;
+
+ error:
+  if ( chunk_dims )
+	enif_free( chunk_dims ) ;
+
+  return error_tuple( env, "Cannot set chunk dimensions" ) ;
+
+}
+
+
+
+/*
+ * Adds the deflate (gzip) compression filter, with specified level (from 0,
+ * fastest, to 9, smallest), to the filter pipeline of specified dataset
+ * creation property list.
+ *
+ * -spec h5pset_deflate( property_list_handle(), Level::integer() ) ->
+ *                       'ok' | error().
+ *
+ */
+ERL_NIF_TERM h5pset_deflate( ErlNifEnv* env, int argc,
+  const ERL_NIF_TERM argv[] )
+{
+
+  hid_t plist_id ;
+  unsigned level ;
+
+  check( argc == 2, "Incorrect number of arguments" ) ;
+
+  check( ! get_proplist( env, argv[0], H5P_DATASET_CREATE, &plist_id ),
+	"Cannot get dataset creation property list from argv" ) ;
+
+  check( enif_get_uint( env, argv[1], &level ) && level <= 9,
+	"Cannot get a deflate level in [0,9] from argv" ) ;
+
+  check( H5Zfilter_avail( H5Z_FILTER_DEFLATE ) > 0,
+	"Deflate filter not available in this HDF5 library" ) ;
+
+  check( H5Pset_deflate( plist_id, level ) >= 0,
+	"Failed to set the deflate filter." ) ;
+
+  return atom_ok ;
+
+ error:
+  return error_tuple( env, "Cannot set deflate filter" ) ;
+
+}
+
+
+
+/*
+ * Adds the shuffle filter, which regroups the bytes of same significance of
+ * successive cells, thus improving the compression ratio of any subsequent
+ * filter (ex: deflate, to be set afterwards).
+ *
+ * -spec h5pset_shuffle( property_list_handle() ) -> 'ok' | error().
+ *
+ */
+ERL_NIF_TERM h5pset_shuffle( ErlNifEnv* env, int argc,
+  const ERL_NIF_TERM argv[] )
+{
+
+  hid_t plist_id ;
+
+  check( argc == 1, "Incorrect number of arguments" ) ;
+
+  check( ! get_proplist( env, argv[0], H5P_DATASET_CREATE, &plist_id ),
+	"Cannot get dataset creation property list from argv" ) ;
+
+  check( H5Pset_shuffle( plist_id ) >= 0,
+	"Failed to set the shuffle filter." ) ;
+
+  return atom_ok ;
+
+ error:
+  return error_tuple( env, "Cannot set shuffle filter" ) ;
+
+}
+
+
+
+/*
+ * Adds the Fletcher32 checksum filter, so that corrupted chunks are detected
+ * when read.
+ *
+ * -spec h5pset_fletcher32( property_list_handle() ) -> 'ok' | error().
+ *
+ */
+ERL_NIF_TERM h5pset_fletcher32( ErlNifEnv* env, int argc,
+  const ERL_NIF_TERM argv[] )
+{
+
+  hid_t plist_id ;
+
+  check( argc == 1, "Incorrect number of arguments" ) ;
+
+  check( ! get_proplist( env, argv[0], H5P_DATASET_CREATE, &plist_id ),
+	"Cannot get dataset creation property list from argv" ) ;
+
+  check( H5Pset_fletcher32( plist_id ) >= 0,
+	"Failed to set the Fletcher32 filter." ) ;
+
+  return atom_ok ;
+
+ error:
+  return error_tuple( env, "Cannot set Fletcher32 filter" ) ;
+
+}
+
+
+
+/*
+ * Adds the N-Bit filter, which stores only the significant bits of cells
+ * whose datatype has a precision lower than its size.
+ *
+ * -spec h5pset_nbit( property_list_handle() ) -> 'ok' | error().
+ *
+ */
+ERL_NIF_TERM h5pset_nbit( ErlNifEnv* env, int argc, const ERL_NIF_TERM argv[] )
+{
+
+  hid_t plist_id ;
+
+  check( argc == 1, "Incorrect number of arguments" ) ;
+
+  check( ! get_proplist( env, argv[0], H5P_DATASET_CREATE, &plist_id ),
+	"Cannot get dataset creation property list from argv" ) ;
+
+  check( H5Pset_nbit( plist_id ) >= 0, "Failed to set the N-Bit filter." ) ;
+
+  return atom_ok ;
+
+ error:
+  return error_tuple( env, "Cannot set N-Bit filter" ) ;
+
+}
+
+
+
+/*
+ * Adds the scale-offset filter, with specified scale type
+ * ('H5Z_SO_FLOAT_DSCALE', 'H5Z_SO_FLOAT_ESCALE' or 'H5Z_SO_INT') and factor.
+ *
+ * For floating-point cells, this filter is lossy: with 'H5Z_SO_FLOAT_DSCALE',
+ * the factor is the number of decimal digits that are kept.
+ *
+ * -spec h5pset_scaleoffset( property_list_handle(), ScaleType::atom(),
+ *                           Factor::integer() ) -> 'ok' | error().
+ *
+ */
+ERL_NIF_TERM h5pset_scaleoffset( ErlNifEnv* env, int argc,
+  const ERL_NIF_TERM argv[] )
+{
+
+  hid_t plist_id ;
+  char scale_name[ MAXBUFLEN ] ;
+  H5Z_SO_scale_type_t scale_type ;
+  int factor ;
+
+  check( argc == 3, "Incorrect number of arguments" ) ;
+
+  check( ! get_proplist( env, argv[0], H5P_DATASET_CREATE, &plist_id ),
+	"Cannot get dataset creation property list from argv" ) ;
+
+  check( enif_get_atom( env, argv[1], scale_name, sizeof( scale_name ),
+	  ERL_NIF_LATIN1 ), "Cannot get scale type from argv" ) ;
+
+  if ( strncmp( scale_name, "H5Z_SO_FLOAT_DSCALE", MAXBUFLEN ) == 0 )
+	scale_type = H5Z_SO_FLOAT_DSCALE ;
+  else if ( strncmp( scale_name, "H5Z_SO_FLOAT_ESCALE", MAXBUFLEN ) == 0 )
+	scale_type = H5Z_SO_FLOAT_ESCALE ;
+  else if ( strncmp( scale_name, "H5Z_SO_INT", MAXBUFLEN ) == 0 )
+	scale_type = H5Z_SO_INT ;
+  else
+	sentinel( "Unknown scale type %s", scale_name ) ;
+
+  check( enif_get_int( env, argv[2], &factor ),
+	"Cannot get scale factor from argv" ) ;
+
+  check( H5Pset_scaleoffset( plist_id, scale_type, factor ) >= 0,
+	"Failed to set the scale-offset filter." ) ;
+
+  return atom_ok ;
+
+ error:
+  return error_tuple( env, "Cannot set scale-offset filter" ) ;
+
+}
+
+
+
+/*
+ * Sets the raw data chunk cache used by the datasets opened with specified
+ * dataset access property list: number of hash table slots (preferably a
+ * prime number, about 100 times the number of chunks fitting in the cache),
+ * total size in bytes, and preemption policy W0 (in [0.0,1.0]; the closer to
+ * 1.0, the sooner fully read or written chunks are evicted).
+ *
+ * -spec h5pset_chunk_cache( dataset_access_proplist(), Slots::integer(),
+ *                           Bytes::integer(), W0::float() ) -> 'ok' | error().
+ *
+ */
+ERL_NIF_TERM h5pset_chunk_cache( ErlNifEnv* env, int argc,
+  const ERL_NIF_TERM argv[] )
+{
+
+  hid_t plist_id ;
+  size_t slots ;
+  size_t bytes ;
+  double w0 ;
+
+  check( argc == 4, "Incorrect number of arguments" ) ;
+
+  check( ! get_proplist( env, argv[0], H5P_DATASET_ACCESS, &plist_id ),
+	"Cannot get dataset access property list from argv" ) ;
+
+  check( get_size( env, argv[1], &slots ),
+	"Cannot get slot count from argv" ) ;
+
+  check( get_size( env, argv[2], &bytes ),
+	"Cannot get cache size from argv" ) ;
+
+  if ( ! enif_get_double( env, argv[3], &w0 ) )
+  {
+
+	// Integers 0 and 1 are accepted as well:
+	int int_w0 ;
+
+	check( enif_get_int( env, argv[3], &int_w0 ),
+	  "Cannot get preemption policy from argv" ) ;
+
+	w0 = (double) int_w0 ;
+
+  }
+
+  check( w0 >= 0.0 && w0 <= 1.0, "Preemption policy not in [0.0,1.0]" ) ;
+
+  check( H5Pset_chunk_cache( plist_id, slots, bytes, w0 ) >= 0,
+	"Failed to set the chunk cache." ) ;
+
+  return atom_ok ;
+
+ error:
+  return error_tuple( env, "Cannot set chunk cache" ) ;
+
+}
+
+
+
+/*
+ * Sets the sizes (in bytes) of the metadata cache of the files opened with
+ * specified file access property list: initial size, and bounds between which
+ * the cache is then automatically resized.
+ *
+ * -spec h5pset_mdc_size( file_access_proplist(), Initial::integer(),
+ *                        Min::integer(), Max::integer() ) -> 'ok' | error().
+ *
+ */
+ERL_NIF_TERM h5pset_mdc_size( ErlNifEnv* env, int argc,
+  const ERL_NIF_TERM argv[] )
+{
+
+  hid_t fapl_id ;
+  size_t initial_size ;
+  size_t min_size ;
+  size_t max_size ;
+
+  check( argc == 4, "Incorrect number of arguments" ) ;
+
+  check( ! get_proplist( env, argv[0], H5P_FILE_ACCESS, &fapl_id ),
+	"Cannot get file access property list from argv" ) ;
+
+  check( get_size( env, argv[1], &initial_size )
+	&& get_size( env, argv[2], &min_size )
+	&& get_size( env, argv[3], &max_size ),
+	"Cannot get cache sizes from argv" ) ;
+
+  check( min_size <= initial_size && initial_size <= max_size,
+	"Initial cache size not within bounds" ) ;
+
+  H5AC_cache_config_t config ;
+
+  // Only the sizes are changed, the other settings are kept:
+  config.version = H5AC__CURR_CACHE_CONFIG_VERSION ;
+
+  check( H5Pget_mdc_config( fapl_id, &config ) >= 0,
+	"Failed to get the metadata cache configuration." ) ;
+
+  config.set_initial_size = 1 ;
+  config.initial_size = initial_size ;
+  config.min_size = min_size ;
+  config.max_size = max_size ;
+
+  check( H5Pset_mdc_config( fapl_id, &config ) >= 0,
+	"Failed to set the metadata cache configuration." ) ;
+
+  return atom_ok ;
+
+ error:
+  return error_tuple( env, "Cannot set metadata cache size" ) ;
+
+}
+
+
+
+/*
+ * Makes the files opened or created with specified file access property list
+ * use the core (in-memory) driver: the file is held in memory, grown by
+ * Increment bytes whenever needed, and written to disk on closing only if a
+ * backing store is requested.
+ *
+ * -spec h5pset_fapl_core( file_access_proplist(), Increment::integer(),
+ *                         BackingStore::boolean() ) -> 'ok' | error().
+ *
+ */
+ERL_NIF_TERM h5pset_fapl_core( ErlNifEnv* env, int argc,
+  const ERL_NIF_TERM argv[] )
+{
+
+  hid_t fapl_id ;
+  size_t increment ;
+  char backing_store[ MAXBUFLEN ] ;
+
+  check( argc == 3, "Incorrect number of arguments" ) ;
+
+  check( ! get_proplist( env, argv[0], H5P_FILE_ACCESS, &fapl_id ),
+	"Cannot get file access property list from argv" ) ;
+
+  check( get_size( env, argv[1], &increment ) && increment > 0,
+	"Cannot get (non-null) increment from argv" ) ;
+
+  check( enif_get_atom( env, argv[2], backing_store, sizeof( backing_store ),
+	  ERL_NIF_LATIN1 ), "Cannot get backing store flag from argv" ) ;
+
+  check( H5Pset_fapl_core( fapl_id, increment,
+	  strncmp( backing_store, "true", MAXBUFLEN ) == 0 ) >= 0,
+	"Failed to set the core driver." ) ;
+
+  return atom_ok ;
+
+ error:
+  return error_tuple( env, "Cannot set core driver" ) ;
+
+}
+
+
+
+/*
+ * Sets the maximum size (in bytes) of the data sieve buffer, used to aggregate
+ * small accesses to contiguous datasets.
+ *
+ * -spec h5pset_sieve_buf_size( file_access_proplist(), Size::integer() ) ->
+ *                              'ok' | error().
+ *
+ */
+ERL_NIF_TERM h5pset_sieve_buf_size( ErlNifEnv* env, int argc,
+  const ERL_NIF_TERM argv[] )
+{
+
+  hid_t fapl_id ;
+  size_t size ;
+
+  check( argc == 2, "Incorrect number of arguments" ) ;
+
+  check( ! get_proplist( env, argv[0], H5P_FILE_ACCESS, &fapl_id ),
+	"Cannot get file access property list from argv" ) ;
+
+  check( get_size( env, argv[1], &size ),
+	"Cannot get sieve buffer size from argv" ) ;
+
+  check( H5Pset_sieve_buf_size( fapl_id, size ) >= 0,
+	"Failed to set the sieve buffer size." ) ;
+
+  return atom_ok ;
+
+ error:
+  return error_tuple( env, "Cannot set sieve buffer size" ) ;
+
+}
+
+
+
+/*
+ * Sets the alignment of the file objects: any allocation of at least
+ * Threshold bytes starts at a multiple of Alignment bytes (ex: a RAID stripe).
+ *
+ * -spec h5pset_alignment( file_access_proplist(), Threshold::integer(),
+ *                         Alignment::integer() ) -> 'ok' | error().
+ *
+ */
+ERL_NIF_TERM h5pset_alignment( ErlNifEnv* env, int argc,
+  const ERL_NIF_TERM argv[] )
+{
+
+  hid_t fapl_id ;
+  hsize_t threshold ;
+  hsize_t alignment ;
+
+  check( argc == 3, "Incorrect number of arguments" ) ;
+
+  check( ! get_proplist( env, argv[0], H5P_FILE_ACCESS, &fapl_id ),
+	"Cannot get file access property list from argv" ) ;
+
+  check( get_hsize( env, argv[1], &threshold )
+	&& get_hsize( env, argv[2], &alignment ) && alignment > 0,
+	"Cannot get threshold and (non-null) alignment from argv" ) ;
+
+  check( H5Pset_alignment( fapl_id, threshold, alignment ) >= 0,
+	"Failed to set the alignment." ) ;
+
+  return atom_ok ;
+
+ error:
+  return error_tuple( env, "Cannot set alignment" ) ;
+
+}
+
+
+
+// Converts specified atom into a library version bound.
+static int convert_libver( ErlNifEnv* env, ERL_NIF_TERM term,
+  H5F_libver_t* libver )
+{
+
+  char name[ MAXBUFLEN ] ;
+
+  check( enif_get_atom( env, term, name, sizeof( name ), ERL_NIF_LATIN1 ),
+	"Cannot get library version from term" ) ;
+
+  if ( strncmp( name, "H5F_LIBVER_EARLIEST", MAXBUFLEN ) == 0 )
+	*libver = H5F_LIBVER_EARLIEST ;
+#if H5_VERSION_GE(1,10,2)
+  else if ( strncmp( name, "H5F_LIBVER_V18", MAXBUFLEN ) == 0 )
+	*libver = H5F_LIBVER_V18 ;
+  else if ( strncmp( name, "H5F_LIBVER_V110", MAXBUFLEN ) == 0 )
+	*libver = H5F_LIBVER_V110 ;
+#endif
+  else if ( strncmp( name, "H5F_LIBVER_LATEST", MAXBUFLEN ) == 0 )
+	*libver = H5F_LIBVER_LATEST ;
+  else
+	sentinel( "Unknown library version %s", name ) ;
+
+  return 0 ;
+
+ error:
+  return -1 ;
+
+}
+
+
+
+/*
+ * Sets the range of library versions whose file format may be used when
+ * writing objects; with 'H5F_LIBVER_LATEST' as low bound, the newest (and
+ * generally faster) metadata structures are used.
+ *
+ * -spec h5pset_libver_bounds( file_access_proplist(), Low::libver(),
+ *                             High::libver() ) -> 'ok' | error().
+ *
+ */
+ERL_NIF_TERM h5pset_libver_bounds( ErlNifEnv* env, int argc,
+  const ERL_NIF_TERM argv[] )
+{
+
+  hid_t fapl_id ;
+  H5F_libver_t low ;
+  H5F_libver_t high ;
+
+  check( argc == 3, "Incorrect number of arguments" ) ;
+
+  check( ! get_proplist( env, argv[0], H5P_FILE_ACCESS, &fapl_id ),
+	"Cannot get file access property list from argv" ) ;
+
+  check( ! convert_libver( env, argv[1], &low ),
+	"Cannot get low library version bound from argv" ) ;
+
+  check( ! convert_libver( env, argv[2], &high ),
+	"Cannot get high library version bound from argv" ) ;
+
+  check( H5Pset_libver_bounds( fapl_id, low, high ) >= 0,
+	"Failed to set the library version bounds." ) ;
+
+  return atom_ok ;
+
+ error:
+  return error_tuple( env, "Cannot set library version bounds" ) ;
+
+}
+
+
+
+/*
+ * Sets the size (in bytes) of the page buffer, and the minimum percentages of
+ * it kept for metadata and for raw data pages.
+ *
+ * Only applies to files created with the paged file space strategy (see
+ * h5pset_file_space_strategy/4), and requires HDF5 1.10.1 or later.
+ *
+ * -spec h5pset_page_buffer_size( file_access_proplist(), Size::integer(),
+ *   MinMetaPercent::integer(), MinRawPercent::integer() ) -> 'ok' | error().
+ *
+ */
+ERL_NIF_TERM h5pset_page_buffer_size( ErlNifEnv* env, int argc,
+  const ERL_NIF_TERM argv[] )
+{
+
+#if H5_VERSION_GE(1,10,1)
+
+  hid_t fapl_id ;
+  size_t size ;
+  unsigned min_meta_percent ;
+  unsigned min_raw_percent ;
+
+  check( argc == 4, "Incorrect number of arguments" ) ;
+
+  check( ! get_proplist( env, argv[0], H5P_FILE_ACCESS, &fapl_id ),
+	"Cannot get file access property list from argv" ) ;
+
+  check( get_size( env, argv[1], &size ),
+	"Cannot get page buffer size from argv" ) ;
+
+  check( enif_get_uint( env, argv[2], &min_meta_percent )
+	&& enif_get_uint( env, argv[3], &min_raw_percent )
+	&& min_meta_percent + min_raw_percent <= 100,
+	"Cannot get consistent minimum percentages from argv" ) ;
+
+  check( H5Pset_page_buffer_size( fapl_id, size, min_meta_percent,
+	  min_raw_percent ) >= 0, "Failed to set the page buffer size." ) ;
+
+  return atom_ok ;
+
+ error:
+  return error_tuple( env, "Cannot set page buffer size" ) ;
+
+#else
+
+  return error_tuple( env, "Page buffering requires HDF5 1.10.1 or later" ) ;
+
+#endif
+
+}
+
+
+
+/*
+ * Sets the file space handling strategy of the files created with specified
+ * file creation property list ('H5F_FSPACE_STRATEGY_FSM_AGGR',
+ * 'H5F_FSPACE_STRATEGY_PAGE', 'H5F_FSPACE_STRATEGY_AGGR' or
+ * 'H5F_FSPACE_STRATEGY_NONE'), whether free space is persisted, and the
+ * smallest free-space section size tracked.
+ *
+ * 'H5F_FSPACE_STRATEGY_PAGE' (paged aggregation) is needed for page buffering.
+ * Requires HDF5 1.10.1 or later.
+ *
+ * -spec h5pset_file_space_strategy( file_creation_proplist(), Strategy::atom(),
+ *   Persist::boolean(), Threshold::integer() ) -> 'ok' | error().
+ *
+ */
+ERL_NIF_TERM h5pset_file_space_strategy( ErlNifEnv* env, int argc,
+  const ERL_NIF_TERM argv[] )
+{
+
+#if H5_VERSION_GE(1,10,1)
+
+  hid_t fcpl_id ;
+  char name[ MAXBUFLEN ] ;
+  H5F_fspace_strategy_t strategy ;
+  char persist_name[ MAXBUFLEN ] ;
+  ErlNifUInt64 threshold ;
+
+  check( argc == 4, "Incorrect number of arguments" ) ;
+
+  check( ! get_proplist( env, argv[0], H5P_FILE_CREATE, &fcpl_id ),
+	"Cannot get file creation property list from argv" ) ;
+
+  check( enif_get_atom( env, argv[1], name, sizeof( name ), ERL_NIF_LATIN1 ),
+	"Cannot get strategy from argv" ) ;
+
+  if ( strncmp( name, "H5F_FSPACE_STRATEGY_FSM_AGGR", MAXBUFLEN ) == 0 )
+	strategy = H5F_FSPACE_STRATEGY_FSM_AGGR ;
+  else if ( strncmp( name, "H5F_FSPACE_STRATEGY_PAGE", MAXBUFLEN ) == 0 )
+	strategy = H5F_FSPACE_STRATEGY_PAGE ;
+  else if ( strncmp( name, "H5F_FSPACE_STRATEGY_AGGR", MAXBUFLEN ) == 0 )
+	strategy = H5F_FSPACE_STRATEGY_AGGR ;
+  else if ( strncmp( name, "H5F_FSPACE_STRATEGY_NONE", MAXBUFLEN ) == 0 )
+	strategy = H5F_FSPACE_STRATEGY_NONE ;
+  else
+	sentinel( "Unknown file space strategy %s", name ) ;
+
+  check( enif_get_atom( env, argv[2], persist_name, sizeof( persist_name ),
+	  ERL_NIF_LATIN1 ), "Cannot get persist flag from argv" ) ;
+
+  check( enif_get_uint64( env, argv[3], &threshold ),
+	"Cannot get threshold from argv" ) ;
+
+  check( H5Pset_file_space_strategy( fcpl_id, strategy,
+	  strncmp( persist_name, "true", MAXBUFLEN ) == 0,
+	  (hsize_t) threshold ) >= 0, "Failed to set the file space strategy." ) ;
+
+  return atom_ok ;
+
+ error:
+  return error_tuple( env, "Cannot set file space strategy" ) ;
+
+#else
+
+  return error_tuple( env,
+	"File space strategies require HDF5 1.10.1 or later" ) ;
+
+#endif
+
+}
+
+
+
+/*
+ * Sets the size (in bytes) of the file space pages, when the paged file space
+ * strategy is used. Requires HDF5 1.10.1 or later.
+ *
+ * -spec h5pset_file_space_page_size( file_creation_proplist(),
+ *                                    Size::integer() ) -> 'ok' | error().
+ *
+ */
+ERL_NIF_TERM h5pset_file_space_page_size( ErlNifEnv* env, int argc,
+  const ERL_NIF_TERM argv[] )
+{
+
+#if H5_VERSION_GE(1,10,1)
+
+  hid_t fcpl_id ;
+  ErlNifUInt64 size ;
+
+  check( argc == 2, "Incorrect number of arguments" ) ;
+
+  check( ! get_proplist( env, argv[0], H5P_FILE_CREATE, &fcpl_id ),
+	"Cannot get file creation property list from argv" ) ;
+
+  check( enif_get_uint64( env, argv[1], &size ),
+	"Cannot get page size from argv" ) ;
+
+  check( H5Pset_file_space_page_size( fcpl_id, (hsize_t) size ) >= 0,
+	"Failed to set the file space page size." ) ;
+
+  return atom_ok ;
+
+ error:
+  return error_tuple( env, "Cannot set file space page size" ) ;
+
+#else
+
+  return error_tuple( env, "Paged file space requires HDF5 1.10.1 or later" ) ;
+
+#endif
+
+}
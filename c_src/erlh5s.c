@@ -20,6 +20,8 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
 
 #include "hdf5.h"
 
@@ -32,20 +34,77 @@
 // H5S: Dataspace Interface, dataspace definition and access routines.
 
 
+/*
+ * Converts specified tuple of maximum dimension sizes, whose elements are
+ * either integers or the 'H5S_UNLIMITED' atom, into specified array.
+ *
+ * Returns 0 on success, -1 on failure.
+ *
+ */
+static int convert_nif_to_maxdims_array( ErlNifEnv* env, hsize_t size,
+  const ERL_NIF_TERM* arr_from, hsize_t *arr_to )
+{
+
+  int i ;
+
+  for ( i = 0; i < size; i++ )
+  {
+
+	char atom_string[ 16 ] ;
+
+	if ( enif_get_atom( env, arr_from[i], atom_string, sizeof( atom_string ),
+		ERL_NIF_LATIN1 ) )
+	{
+
+	  if ( strcmp( atom_string, "H5S_UNLIMITED" ) != 0 )
+		return -1 ;
+
+	  arr_to[i] = H5S_UNLIMITED ;
+
+	}
+	else if ( convert_nif_to_hsize_array( env, 1, arr_from + i, arr_to + i ) )
+	{
+
+	  return -1 ;
+
+	}
+
+  }
+
+  return 0 ;
+
+}
+
+
+
 /*
  * Creates a new simple dataspace, and opens it for access, returning a
  * dataspace identifier.
  *
+ * This implementation corresponds to h5screate_simple/{2,3}, depending on
+ * whether maximum dimension sizes are specified (by default, they are the
+ * current ones, hence the dataspace is not extendible):
+ *
  * -spec h5screate_simple( rank(), tuple( dimension_size() ) ) ->
  *   { 'ok', dataspace_handle() } | error().
  *
+ * and
+ *
+ * -spec h5screate_simple( rank(), tuple( dimension_size() ),
+ *   tuple( dimension_size() | 'H5S_UNLIMITED' ) ) ->
+ *   { 'ok', dataspace_handle() } | error().
+ *
  */
 ERL_NIF_TERM h5screate_simple( ErlNifEnv* env, int argc,
   const ERL_NIF_TERM argv[] )
 {
 
+  hsize_t * dimsf = NULL ;
+  hsize_t * maxdimsf = NULL ;
+  hid_t dataspace_id = -1 ;
+
   // Parses arguments:
-  check( argc == 2, "Incorrect number of arguments" ) ;
+  check( argc == 2 || argc == 3, "Incorrect number of arguments" ) ;
 
   // Number of dimensions of dataspace:
   int rank ;
@@ -58,31 +117,57 @@ ERL_NIF_TERM h5screate_simple( ErlNifEnv* env, int argc,
 	"Cannot get dimension sizes from argv" ) ;
 
   // Makes sure that rank is matching arity:
-  check( rank <= 2, "Up to two dimensions supported only" ) ;
+  check( rank >= 1 && rank <= H5S_MAX_RANK, "Unsupported rank" ) ;
+  check( rank == arity, "Rank does not match the number of dimensions" ) ;
 
   // Allocates array of size rank, specifying the size of each dimension:
-  hsize_t * dimsf = (hsize_t*) enif_alloc( arity * sizeof( hsize_t ) ) ;
+  dimsf = (hsize_t*) enif_alloc( arity * sizeof( hsize_t ) ) ;
 
   // Copies the specified dimensions into dimsf:
   check( ! convert_nif_to_hsize_array( env, arity, terms, dimsf ),
 	"Cannot convert dimensions array" ) ;
 
+  if ( argc == 3 )
+  {
+
+	int max_arity ;
+	const ERL_NIF_TERM* max_terms ;
+
+	check( enif_get_tuple( env, argv[2], &max_arity, &max_terms ),
+	  "Cannot get maximum dimension sizes from argv" ) ;
+
+	check( max_arity == arity,
+	  "Maximum dimensions do not match the current ones" ) ;
+
+	maxdimsf = (hsize_t*) enif_alloc( arity * sizeof( hsize_t ) ) ;
+
+	check( ! convert_nif_to_maxdims_array( env, arity, max_terms, maxdimsf ),
+	  "Cannot convert maximum dimensions array" ) ;
+
+  }
+
   // Creates a new dataspace, using default properties:
-  hid_t dataspace_id = H5Screate_simple( rank, dimsf, NULL ) ;
+  dataspace_id = H5Screate_simple( rank, dimsf, maxdimsf ) ;
   check( dataspace_id > 0, "Failed to create dataspace." ) ;
 
   // Clean-up:
   enif_free( dimsf ) ;
-  ERL_NIF_TERM ret = enif_make_int( env, dataspace_id ) ;
-  return enif_make_tuple2( env, atom_ok, ret ) ;
+
+  if ( maxdimsf )
+	enif_free( maxdimsf ) ;
+
+  return make_handle( env, DATASPACE_HANDLE, dataspace_id ) ;
 
  error:
-  if ( dataspace_id )
+  if ( dataspace_id > 0 )
 	H5Sclose( dataspace_id ) ;
 
   if ( dimsf )
 	enif_free( dimsf ) ;
 
+  if ( maxdimsf )
+	enif_free( maxdimsf ) ;
+
   return error_tuple( env, "Cannot create dataspace" ) ;
 
 }
@@ -94,12 +179,12 @@ ERL_NIF_TERM h5sclose( ErlNifEnv* env, int argc, const ERL_NIF_TERM argv[] )
 
   check( argc == 1, "Incorrect number of arguments" ) ;
 
-  hid_t dataspace_id ;
+  Handle* dataspace_handle ;
 
-  check( enif_get_int( env, argv[0], &dataspace_id ),
+  check( get_handle( env, argv[0], DATASPACE_HANDLE, &dataspace_handle ),
 	"Cannot get dataspace handle from argv" ) ;
 
-  check( ! H5Sclose( dataspace_id ), "Failed to close dataspace" ) ;
+  check( close_handle( dataspace_handle ) >= 0, "Failed to close dataspace" ) ;
 
   return atom_ok ;
 
@@ -118,7 +203,7 @@ ERL_NIF_TERM h5sget_simple_extent_ndims( ErlNifEnv* env, int argc,
   check( argc == 1, "Incorrect number of arguments" ) ;
 
   hid_t dataspace_id ;
-  check( enif_get_int( env, argv[0], &dataspace_id ),
+  check( get_handle_id( env, argv[0], DATASPACE_HANDLE, &dataspace_id ),
 	"Cannot get dataspace handle from argv" ) ;
 
   int ndims = H5Sget_simple_extent_ndims( dataspace_id ) ;
@@ -160,7 +245,7 @@ ERL_NIF_TERM h5sselect_hyperslab( ErlNifEnv* env, int argc,
 
   hid_t dataspace_id ;
 
-  if ( ! enif_get_int( env, argv[0], &dataspace_id ) )
+  if ( ! get_handle_id( env, argv[0], DATASPACE_HANDLE, &dataspace_id ) )
 	return error_tuple( env, "Cannot get dataspace handle from argv" ) ;
 
   char selection_operator[ MAXBUFLEN ] ;
@@ -221,25 +306,21 @@ ERL_NIF_TERM h5sselect_hyperslab( ErlNifEnv* env, int argc,
 
 	//tuple_size = 1 ;
 
-	int int_offset ;
-	if ( ! enif_get_int( env, argv[2], &int_offset ) )
+	hsize_t offset ;
+	if ( ! get_hsize( env, argv[2], &offset ) )
 	  return error_tuple( env, "Offset does not contain an integer" ) ;
-	hsize_t offset = int_offset ;
 
-	int int_stride ;
-	if ( ! enif_get_int( env, argv[3], &int_stride ) )
+	hsize_t stride ;
+	if ( ! get_hsize( env, argv[3], &stride ) )
 	  return error_tuple( env, "Stride does not contain an integer" ) ;
-	hsize_t stride = int_stride ;
 
-	int int_count ;
-	if ( ! enif_get_int( env, argv[4], &int_count ) )
+	hsize_t count ;
+	if ( ! get_hsize( env, argv[4], &count ) )
 	  return error_tuple( env, "Count does not contain an integer" ) ;
-	hsize_t count = int_count ;
 
-	int int_block ;
-	if ( ! enif_get_int( env, argv[5], &int_block ) )
+	hsize_t block ;
+	if ( ! get_hsize( env, argv[5], &block ) )
 	  return error_tuple( env, "Block does not contain an integer" ) ;
-	hsize_t block = int_block ;
 
 	//printf( "offset = %llu, stride = %llu, count = %llu, block = %llu.\n",
 	//  offset, stride, count, block ) ;
@@ -274,20 +355,16 @@ ERL_NIF_TERM h5sselect_hyperslab( ErlNifEnv* env, int argc,
 
   unsigned int i ;
 
-  int cell ;
-
   for ( i = 0 ; i < tuple_size ; i++ )
   {
 
-	  if ( ! enif_get_int( env, tuple_elements[i], &cell ) )
+	  if ( ! get_hsize( env, tuple_elements[i], offset_buffer + i ) )
 	  {
 		enif_free( offset_buffer ) ;
 		return error_tuple( env, "Offset cell does not contain an integer" ) ;
 
 	  }
 
-	  offset_buffer[i] = (hsize_t) cell ;
-
   }
 
 
@@ -305,7 +382,7 @@ ERL_NIF_TERM h5sselect_hyperslab( ErlNifEnv* env, int argc,
   for ( i = 0 ; i < tuple_size ; i++ )
   {
 
-	  if ( ! enif_get_int( env, tuple_elements[i], &cell ) )
+	  if ( ! get_hsize( env, tuple_elements[i], stride_buffer + i ) )
 	  {
 
 		enif_free( offset_buffer ) ;
@@ -314,8 +391,6 @@ ERL_NIF_TERM h5sselect_hyperslab( ErlNifEnv* env, int argc,
 
 	  }
 
-	  stride_buffer[i] = (hsize_t) cell ;
-
   }
 
   // Count is argc=4:
@@ -332,7 +407,7 @@ ERL_NIF_TERM h5sselect_hyperslab( ErlNifEnv* env, int argc,
   for ( i = 0 ; i < tuple_size ; i++ )
   {
 
-	  if ( ! enif_get_int( env, tuple_elements[i], &cell ) )
+	  if ( ! get_hsize( env, tuple_elements[i], count_buffer + i ) )
 	  {
 
 		enif_free( offset_buffer ) ;
@@ -342,8 +417,6 @@ ERL_NIF_TERM h5sselect_hyperslab( ErlNifEnv* env, int argc,
 
 	  }
 
-	  count_buffer[i] = (hsize_t) cell ;
-
   }
 
 
@@ -361,7 +434,7 @@ ERL_NIF_TERM h5sselect_hyperslab( ErlNifEnv* env, int argc,
   for ( i = 0 ; i < tuple_size ; i++ )
   {
 
-	  if ( ! enif_get_int( env, tuple_elements[i], &cell ) )
+	  if ( ! get_hsize( env, tuple_elements[i], block_buffer + i ) )
 	  {
 
 		enif_free( offset_buffer ) ;
@@ -372,8 +445,6 @@ ERL_NIF_TERM h5sselect_hyperslab( ErlNifEnv* env, int argc,
 
 	  }
 
-	  block_buffer[i] = (hsize_t) cell ;
-
   }
 
   // Now that we have our four buffers right:
@@ -400,6 +471,154 @@ ERL_NIF_TERM h5sselect_hyperslab( ErlNifEnv* env, int argc,
 
 
 
+/*
+ * Selects in specified dataspace, according to specified operator, the points
+ * whose coordinates are packed in specified binary, as native unsigned 64-bit
+ * integers: rank of them per point, the last dimension varying fastest (ex:
+ * <<R1:64/native, C1:64/native, R2:64/native, C2:64/native>> for two points of
+ * a bidimensional dataspace).
+ *
+ * All coordinates are checked against the current extent of the dataspace, and
+ * the whole set of points is selected in a single H5Sselect_elements/4 call.
+ *
+ * Returns the number of points selected, or 0 on failure (then error_message
+ * is set).
+ *
+ */
+hsize_t select_points( ErlNifEnv* env, hid_t dataspace_id, H5S_seloper_t op,
+  ERL_NIF_TERM coords_term, const char** error_message )
+{
+
+  ErlNifBinary coords ;
+
+  if ( ! enif_inspect_binary( env, coords_term, &coords ) )
+  {
+	*error_message = "Coordinates are not a binary" ;
+	return 0 ;
+  }
+
+  hsize_t extent[ H5S_MAX_RANK ] ;
+
+  int rank = H5Sget_simple_extent_dims( dataspace_id, extent, NULL ) ;
+
+  if ( rank < 1 )
+  {
+	*error_message = "Cannot get the dimensions of the dataspace" ;
+	return 0 ;
+  }
+
+  size_t point_size = rank * sizeof( hsize_t ) ;
+
+  if ( coords.size == 0 || coords.size % point_size != 0 )
+  {
+	*error_message =
+	  "Coordinate binary size is not a multiple of the point size" ;
+	return 0 ;
+  }
+
+  size_t point_count = coords.size / point_size ;
+
+  // HDF5 reads the coordinates in place, hence they must be properly aligned:
+  const hsize_t * coord = (const hsize_t *) coords.data ;
+  hsize_t * aligned = NULL ;
+
+  if ( (uintptr_t) coords.data % sizeof( hsize_t ) != 0 )
+  {
+	aligned = (hsize_t *) enif_alloc( coords.size ) ;
+
+	if ( aligned == NULL )
+	{
+	  *error_message = "Cannot allocate coordinates" ;
+	  return 0 ;
+	}
+
+	memcpy( aligned, coords.data, coords.size ) ;
+	coord = aligned ;
+  }
+
+  size_t value_count = point_count * rank ;
+  size_t i ;
+  int dim = 0 ;
+
+  for ( i = 0; i < value_count; i++ )
+  {
+
+	if ( coord[i] >= extent[dim] )
+	{
+	  *error_message = "Point out of the extent of the dataspace" ;
+	  point_count = 0 ;
+	  goto end ;
+	}
+
+	if ( ++dim == rank )
+	  dim = 0 ;
+
+  }
+
+  if ( H5Sselect_elements( dataspace_id, op, point_count, coord ) < 0 )
+  {
+	*error_message = "Point selection failed" ;
+	point_count = 0 ;
+  }
+
+ end:
+  if ( aligned )
+	enif_free( aligned ) ;
+
+  return point_count ;
+
+}
+
+
+
+/*
+ * Selects points in specified dataspace.
+ *
+ * -spec h5sselect_elements( dataspace_handle(), point_selection_operator(),
+ *                           Coords::binary() ) -> 'ok' | error().
+ *
+ */
+ERL_NIF_TERM h5sselect_elements( ErlNifEnv* env, int argc,
+  const ERL_NIF_TERM argv[] )
+{
+
+  if ( argc != 3 )
+	return error_tuple( env, "Expected 3 arguments" ) ;
+
+  hid_t dataspace_id ;
+
+  if ( ! get_handle_id( env, argv[0], DATASPACE_HANDLE, &dataspace_id ) )
+	return error_tuple( env, "Cannot get dataspace handle from argv" ) ;
+
+  char selection_operator[ MAXBUFLEN ] ;
+
+  if ( ! enif_get_atom( env, argv[1], selection_operator, MAXBUFLEN,
+	  ERL_NIF_LATIN1 ) )
+	return error_tuple( env, "Cannot get selection operator from argv" ) ;
+
+  H5S_seloper_t selection_op ;
+
+  if ( strcmp( selection_operator, "H5S_SELECT_SET" ) == 0 )
+	selection_op = H5S_SELECT_SET ;
+  else if ( strcmp( selection_operator, "H5S_SELECT_APPEND" ) == 0 )
+	selection_op = H5S_SELECT_APPEND ;
+  else if ( strcmp( selection_operator, "H5S_SELECT_PREPEND" ) == 0 )
+	selection_op = H5S_SELECT_PREPEND ;
+  else
+	return error_tuple( env, "Unsupported point selection operator" ) ;
+
+  const char * error_message ;
+
+  if ( select_points( env, dataspace_id, selection_op, argv[2],
+	  &error_message ) == 0 )
+	return error_tuple( env, (char *) error_message ) ;
+
+  return atom_ok ;
+
+}
+
+
+
 // Retrieves dataspace dimension sizes: current and maximum sizes.
 ERL_NIF_TERM h5sget_simple_extent_dims( ErlNifEnv* env, int argc,
   const ERL_NIF_TERM argv[] )
@@ -408,7 +627,7 @@ ERL_NIF_TERM h5sget_simple_extent_dims( ErlNifEnv* env, int argc,
   check( argc == 2, "Incorrect number of arguments" ) ;
 
   hid_t dataspace_id ;
-  check( enif_get_int( env, argv[0], &dataspace_id ),
+  check( get_handle_id( env, argv[0], DATASPACE_HANDLE, &dataspace_id ),
 	"Cannot get dataspace handle from argv" ) ;
 
   int rank ;
@@ -446,6 +665,17 @@ ERL_NIF_TERM h5sget_simple_extent_dims( ErlNifEnv* env, int argc,
   check( ! convert_array_to_nif_array( env, rank, maxdims, maxdims_arr ),
 	"Cannot convert max array" ) ;
 
+  // Extendible dimensions are reported as such:
+  int i ;
+
+  for ( i = 0; i < rank; i++ )
+  {
+
+	if ( maxdims[i] == H5S_UNLIMITED )
+	  maxdims_arr[i] = enif_make_atom( env, "H5S_UNLIMITED" ) ;
+
+  }
+
    // Convert arrays to lists:
 
   ERL_NIF_TERM dims_list = enif_make_list_from_array( env, dims_arr, rank ) ;
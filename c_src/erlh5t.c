@@ -41,16 +41,50 @@
 // H5T: Datatype Interface, datatype creation and manipulation routines.
 
 
+// Names of the fixed-size numeric types, and their cell type:
+static const struct
+{
+
+  const char * name ;
+
+  cell_type type ;
+
+} cell_type_names[] = {
+
+  { "H5T_NATIVE_INT8",   INT8_CELL },
+  { "H5T_NATIVE_INT16",  INT16_CELL },
+  { "H5T_NATIVE_INT32",  INT32_CELL },
+  { "H5T_NATIVE_INT64",  INT64_CELL },
+  { "H5T_NATIVE_UINT8",  UINT8_CELL },
+  { "H5T_NATIVE_UINT16", UINT16_CELL },
+  { "H5T_NATIVE_UINT32", UINT32_CELL },
+  { "H5T_NATIVE_UINT64", UINT64_CELL }
+
+} ;
+
+
+
 /*
  * Converts an HDF5 type, expressed as a string, into the actual corresponding
  * HDF5 type (as an integer).
  *
+ * Returns 0 on success, -1 on failure.
+ *
  */
-static int convert_type( const char* string_type, hid_t* target_hdf_type )
+int convert_type( const char* string_type, hid_t* target_hdf_type )
 {
 
   // The full, longer list of HDF5 types is defined in ./include/H5Tpublic.h.
 
+  int i ;
+
+  for ( i = 0; i < NUM_OF( cell_type_names ); i++ )
+	if ( strncmp( string_type, cell_type_names[i].name, MAXBUFLEN ) == 0 )
+	{
+	  *target_hdf_type = get_native_cell_type( cell_type_names[i].type ) ;
+	  return 0 ;
+	}
+
   if( strncmp( string_type, "H5T_NATIVE_INT", MAXBUFLEN ) == 0 )
 	*target_hdf_type = H5T_NATIVE_INT;
 
@@ -99,9 +133,8 @@ ERL_NIF_TERM datatype_name_to_handle( ErlNifEnv* env, int argc,
   check( ! convert_type( type, &dtype_id ), "Failed to convert datatype" ) ;
 
 
-  ERL_NIF_TERM ret = enif_make_int( env, dtype_id ) ;
-
-  return enif_make_tuple2( env, atom_ok, ret ) ;
+  // Predefined types belong to the library, hence are not to be closed:
+  return make_unowned_handle( env, DATATYPE_HANDLE, dtype_id ) ;
 
  error:
 
@@ -135,9 +168,7 @@ ERL_NIF_TERM h5tcopy( ErlNifEnv* env, int argc, const ERL_NIF_TERM argv[] )
   hid_t type_id = H5Tcopy( dtype_id ) ;
   check( type_id > 0, "Failed to create datatype." ) ;
 
-  ERL_NIF_TERM ret = enif_make_int( env, type_id ) ;
-
-  return enif_make_tuple2( env, atom_ok, ret ) ;
+  return make_handle( env, DATATYPE_HANDLE, type_id ) ;
 
  error:
   if ( type_id )
@@ -151,14 +182,15 @@ ERL_NIF_TERM h5tcopy( ErlNifEnv* env, int argc, const ERL_NIF_TERM argv[] )
 // close
 ERL_NIF_TERM h5tclose(ErlNifEnv* env, int argc, const ERL_NIF_TERM argv[])
 {
-  hid_t type_id;
+  Handle* type_handle;
 
   // parse arguments
   check(argc == 1, "Incorrect number of arguments");
-  check(enif_get_int(env, argv[0], &type_id), "cannot get resource from argv");
+  check(get_handle(env, argv[0], DATATYPE_HANDLE, &type_handle), \
+	"cannot get resource from argv");
 
-  // close properties list
-  check(!H5Tclose(type_id), "Failed to close type.");
+  // close datatype
+  check(close_handle(type_handle) >= 0, "Failed to close type.");
   return atom_ok;
 
  error:
@@ -175,7 +207,8 @@ ERL_NIF_TERM h5tget_class(ErlNifEnv* env, int argc, const ERL_NIF_TERM argv[])
 
   // parse arguments
   check(argc == 1, "Incorrect number of arguments");
-  check(enif_get_int(env, argv[0], &type_id), "cannot get resource from argv");
+  check(get_handle_id(env, argv[0], DATATYPE_HANDLE, &type_id), \
+	"cannot get resource from argv");
 
   class_id = H5Tget_class(type_id);
   //fprintf(stderr, "class type: %d\r\n", class_id);
@@ -198,7 +231,8 @@ ERL_NIF_TERM h5tget_order(ErlNifEnv* env, int argc, const ERL_NIF_TERM argv[])
 
   // parse arguments
   check(argc == 1, "Incorrect number of arguments");
-  check(enif_get_int(env, argv[0], &type_id), "cannot get resource from argv");
+  check(get_handle_id(env, argv[0], DATATYPE_HANDLE, &type_id), \
+	"cannot get resource from argv");
 
   order = H5Tget_order(type_id);
   check(order != H5T_ORDER_ERROR, "Failed to get order.");
@@ -220,13 +254,13 @@ ERL_NIF_TERM h5tget_size( ErlNifEnv* env, int argc, const ERL_NIF_TERM argv[] )
 
   hid_t type_id ;
 
-  check( enif_get_int( env, argv[0], &type_id ),
+  check( get_handle_id( env, argv[0], DATATYPE_HANDLE, &type_id ),
 	"Cannot get resource from argv" ) ;
 
   size_t size = H5Tget_size( type_id ) ;
   check( size > 0, "Failed to get datatype size." ) ;
 
-  ERL_NIF_TERM ret = enif_make_int( env, size ) ;
+  ERL_NIF_TERM ret = enif_make_uint64( env, (ErlNifUInt64) size ) ;
 
   return enif_make_tuple2( env, atom_ok, ret ) ;
 
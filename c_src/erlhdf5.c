@@ -36,28 +36,57 @@
 // Main HDF5 binding file.
 
 
-// Called because of enif_open_resource_type/5:
-void resource_destructor( ErlNifEnv* env, void* obj )
+void info( char * message )
 {
 
+  fprintf( stderr, "[INFO] %s", message ) ;
+
 }
 
 
+void display_error( char * message )
+{
 
-void info( char * message )
+  char * error =  ( errno == 0 ? "None" : strerror( errno ) ) ;
+
+  fprintf( stderr, "[ERROR] %s (errno: %s) ", message, error ) ;
+
+}
+
+
+
+/*
+ * The HDF5 library is not thread-safe by default, whereas NIFs may be called
+ * concurrently from any (normal or dirty) scheduler: all calls to HDF5 are
+ * thus serialized through this lock.
+ *
+ */
+static ErlNifMutex * hdf5_mutex = NULL ;
+
+
+// Acquires the HDF5 lock (possibly blocking the caller).
+void hdf5_lock()
 {
 
-  fprintf( stderr, "[INFO] %s", message ) ;
+  enif_mutex_lock( hdf5_mutex ) ;
 
 }
 
 
-void display_error( char * message )
+// Tries to acquire the HDF5 lock; returns whether it succeeded.
+bool hdf5_try_lock()
 {
 
-  char * error =  ( errno == 0 ? "None" : strerror( errno ) ) ;
+  return enif_mutex_trylock( hdf5_mutex ) == 0 ;
 
-  fprintf( stderr, "[ERROR] %s (errno: %s) ", message, error ) ;
+}
+
+
+// Releases the HDF5 lock.
+void hdf5_unlock()
+{
+
+  enif_mutex_unlock( hdf5_mutex ) ;
 
 }
 
@@ -69,20 +98,39 @@ static int load( ErlNifEnv* env, void** priv_data, ERL_NIF_TERM load_info )
 
   info( "Loading erlhdf5 NIF." ) ;
 
-  const char* module_name = "erlhdf5" ;
-  const char* resource_name = "FileHandle" ;
+  if ( open_handle_resource_types( env ) )
+  {
+
+	display_error( "Unable to open handle resource types." ) ;
+
+	return -1 ;
+
+  }
+
+  if ( open_timeslice_resource_types( env ) )
+  {
 
-  int resource_flags = ERL_NIF_RT_CREATE | ERL_NIF_RT_TAKEOVER ;
+	display_error( "Unable to open conversion resource types." ) ;
 
-  ErlNifResourceFlags* tried = NULL ;
+	return -1 ;
 
-  resource_type = enif_open_resource_type( env, module_name,
-	resource_name, /* resource_destructor */ NULL, resource_flags, tried ) ;
+  }
 
-  if ( ! resource_type )
+  if ( open_plan_resource_types( env ) )
   {
 
-	display_error( "Unable to open resource type." ) ;
+	display_error( "Unable to open write plan resource types." ) ;
+
+	return -1 ;
+
+  }
+
+  hdf5_mutex = enif_mutex_create( "erlhdf5_hdf5_lock" ) ;
+
+  if ( ! hdf5_mutex )
+  {
+
+	display_error( "Unable to create the HDF5 lock." ) ;
 
 	return -1 ;
 
@@ -92,12 +140,55 @@ static int load( ErlNifEnv* env, void** priv_data, ERL_NIF_TERM load_info )
   atom_ok    = enif_make_atom( env, "ok" ) ;
   atom_error = enif_make_atom( env, "error" ) ;
 
+  if ( executor_start( env ) )
+  {
+
+	display_error( "Unable to start the HDF5 executor." ) ;
+
+	enif_mutex_destroy( hdf5_mutex ) ;
+	hdf5_mutex = NULL ;
+
+	return -1 ;
+
+  }
+
+  // Starts also the flusher of the append buffers:
+  if ( open_buffer_resource_types( env ) )
+  {
+
+	display_error( "Unable to open append buffer resource types." ) ;
+
+	executor_stop() ;
+
+	return -1 ;
+
+  }
+
   return 0 ;
 
 }
 
 
 
+// Unloads this NIF.
+static void unload( ErlNifEnv* env, void* priv_data )
+{
+
+  buffer_flusher_stop() ;
+
+  // Performs any pending asynchronous call first:
+  executor_stop() ;
+
+  /*
+   * The HDF5 lock is not destroyed, as handles may still be garbage-collected
+   * (hence closed) afterwards.
+   *
+   */
+
+}
+
+
+
 /*
  * Converts specified error message from C to:
  *   { error::atom(), Reason::string() }
@@ -131,57 +222,314 @@ ERL_NIF_TERM error_tuple( ErlNifEnv* env, char* reason )
 
 
 /*
- * API name, arity and C name of all functions offered by the NIF:
+ * Wrappers serializing the calls to HDF5 (see hdf5_mutex).
+ *
+ * SERIALIZED_NIF( f ) defines serialized_f, which waits for the lock: it is
+ * meant to be run on a dirty scheduler (or, lacking dirty scheduler support,
+ * on a normal one).
+ *
+ * SERIALIZED_FAST_NIF( f ) defines additionally fast_f, for short calls run on
+ * a normal scheduler: if the lock is already held (typically by a long dirty
+ * I/O call), rather than blocking that scheduler, the call is rescheduled onto
+ * a dirty I/O one, where it will wait for the lock.
+ *
+ */
+
+#define SERIALIZED_NIF( f )                                             \
+  static ERL_NIF_TERM serialized_##f( ErlNifEnv* env, int argc,         \
+	const ERL_NIF_TERM argv[] )                                         \
+  {                                                                     \
+	hdf5_lock() ;                                                       \
+	ERL_NIF_TERM res = f( env, argc, argv ) ;                           \
+	hdf5_unlock() ;                                                     \
+	return res ;                                                        \
+  }
+
+#if ERLHDF5_DIRTY_SCHEDULERS
+
+#define SERIALIZED_FAST_NIF( f )                                        \
+  SERIALIZED_NIF( f )                                                   \
+  static ERL_NIF_TERM fast_##f( ErlNifEnv* env, int argc,               \
+	const ERL_NIF_TERM argv[] )                                         \
+  {                                                                     \
+	if ( ! hdf5_try_lock() )                                            \
+	  return enif_schedule_nif( env, #f, ERL_NIF_DIRTY_JOB_IO_BOUND,    \
+		serialized_##f, argc, argv ) ;                                  \
+	ERL_NIF_TERM res = f( env, argc, argv ) ;                           \
+	hdf5_unlock() ;                                                     \
+	return res ;                                                        \
+  }
+
+#else
+
+#define SERIALIZED_FAST_NIF( f )                                        \
+  SERIALIZED_NIF( f )                                                   \
+  static ERL_NIF_TERM fast_##f( ErlNifEnv* env, int argc,               \
+	const ERL_NIF_TERM argv[] )                                         \
+  {                                                                     \
+	return serialized_##f( env, argc, argv ) ;                          \
+  }
+
+#endif
+
+
+// Short, in-memory operations on HDF5 objects (normal schedulers):
+
+SERIALIZED_FAST_NIF( h5screate_simple )
+SERIALIZED_FAST_NIF( h5sclose )
+SERIALIZED_FAST_NIF( h5sget_simple_extent_dims )
+SERIALIZED_FAST_NIF( h5sget_simple_extent_ndims )
+SERIALIZED_FAST_NIF( h5sselect_hyperslab )
+SERIALIZED_NIF( h5sselect_elements )
+
+SERIALIZED_FAST_NIF( h5pcreate )
+SERIALIZED_FAST_NIF( h5pclose )
+SERIALIZED_FAST_NIF( h5pset_chunk )
+SERIALIZED_FAST_NIF( h5pset_deflate )
+SERIALIZED_FAST_NIF( h5pset_shuffle )
+SERIALIZED_FAST_NIF( h5pset_fletcher32 )
+SERIALIZED_FAST_NIF( h5pset_nbit )
+SERIALIZED_FAST_NIF( h5pset_scaleoffset )
+SERIALIZED_FAST_NIF( h5pset_chunk_cache )
+SERIALIZED_FAST_NIF( h5pset_fapl_core )
+SERIALIZED_FAST_NIF( h5pset_mdc_size )
+SERIALIZED_FAST_NIF( h5pset_sieve_buf_size )
+SERIALIZED_FAST_NIF( h5pset_alignment )
+SERIALIZED_FAST_NIF( h5pset_libver_bounds )
+SERIALIZED_FAST_NIF( h5pset_page_buffer_size )
+SERIALIZED_FAST_NIF( h5pset_file_space_strategy )
+SERIALIZED_FAST_NIF( h5pset_file_space_page_size )
+
+SERIALIZED_FAST_NIF( datatype_name_to_handle )
+SERIALIZED_FAST_NIF( h5tcopy )
+SERIALIZED_FAST_NIF( h5tclose )
+SERIALIZED_FAST_NIF( h5tget_class )
+SERIALIZED_FAST_NIF( h5tget_order )
+SERIALIZED_FAST_NIF( h5tget_size )
+
+SERIALIZED_FAST_NIF( h5dget_type )
+SERIALIZED_FAST_NIF( h5d_get_space_status )
+SERIALIZED_FAST_NIF( h5d_get_storage_size )
+SERIALIZED_FAST_NIF( h5dget_space )
+SERIALIZED_FAST_NIF( h5d_prepare_write )
+SERIALIZED_FAST_NIF( h5d_create_buffer )
+
+
+// Operations that may block on the disk (dirty I/O schedulers):
+
+SERIALIZED_NIF( h5fcreate )
+SERIALIZED_NIF( h5fopen )
+SERIALIZED_NIF( h5fclose )
+SERIALIZED_NIF( h5fstart_swmr_write )
+
+SERIALIZED_NIF( h5dcreate )
+SERIALIZED_NIF( h5dopen )
+SERIALIZED_NIF( h5dclose )
+SERIALIZED_NIF( h5dflush )
+SERIALIZED_NIF( h5drefresh )
+SERIALIZED_NIF( h5dwrite_binary )
+SERIALIZED_NIF( h5dread_binary )
+SERIALIZED_NIF( h5dwrite_block )
+SERIALIZED_NIF( h5dread_block )
+SERIALIZED_NIF( h5dwrite_points )
+SERIALIZED_NIF( h5dread_points )
+SERIALIZED_NIF( h5d_aggregate )
+SERIALIZED_NIF( h5d_histogram )
+SERIALIZED_NIF( h5d_sketch )
+SERIALIZED_NIF( h5d_read_downsampled )
+SERIALIZED_NIF( h5d_scan )
+SERIALIZED_NIF( h5d_create_zone_map )
+SERIALIZED_NIF( h5d_get_zone_map )
+SERIALIZED_NIF( h5dappend )
+SERIALIZED_NIF( h5dappend_binary )
+SERIALIZED_NIF( h5d_exec_write )
+SERIALIZED_NIF( h5d_flush_buffer )
+
+SERIALIZED_NIF( h5ltget_dataset_ndims )
+SERIALIZED_NIF( h5ltget_dataset_info )
+
+
+/*
+ * List-based reads, whose conversion to terms is then time-sliced on normal
+ * schedulers (see erlh5d_timeslice.c; the list-based writes, converting before
+ * taking the lock, need no wrapper):
+ *
+ */
+
+SERIALIZED_NIF( h5dread_timesliced )
+
+SERIALIZED_NIF( h5lt_read_dataset_int_timesliced )
+SERIALIZED_NIF( h5lt_read_dataset_double_timesliced )
+
+
+// Other operations dominated by term conversions or by in-memory copies (dirty
+// CPU schedulers):
+
+SERIALIZED_NIF( h5lt_make_dataset )
+SERIALIZED_NIF( h5f_open_image )
+SERIALIZED_NIF( h5f_get_image )
+SERIALIZED_NIF( h5lt_read_dataset_string )
+
+
+
+/*
+ * Asynchronous variants: ASYNC_NIF( f ) defines async_f, which submits the
+ * call to the HDF5 executor and returns at once { ok, Ref }, the result being
+ * later sent to the caller as { erlhdf5_reply, Ref, Result }.
+ *
+ */
+
+#define ASYNC_NIF( f )                                                  \
+  static ERL_NIF_TERM async_##f( ErlNifEnv* env, int argc,              \
+	const ERL_NIF_TERM argv[] )                                         \
+  {                                                                     \
+	return submit_async_job( env, f, argc, argv ) ;                     \
+  }
+
+ASYNC_NIF( h5fclose )
+
+ASYNC_NIF( h5dwrite )
+ASYNC_NIF( h5dwrite_binary )
+ASYNC_NIF( h5dread )
+ASYNC_NIF( h5dread_binary )
+
+ASYNC_NIF( h5lt_read_dataset_int )
+ASYNC_NIF( h5lt_read_dataset_double )
+
+
+
+/*
+ * API name, arity, C name and flags of all functions offered by the NIF:
  *
  * (note that apparently if a function is declared and listed yet not defined in
  * C, then the module will be loadable, yet even calls to functions that were
  * defined will fail as if they were not, ex: {undef,[{erlhdf5,h5fcreate,...)
  *
+ * Calls that may block on the disk (opening, flushing, reading or writing data)
+ * are run on dirty I/O schedulers, and the ones dominated by the conversion of
+ * (potentially large) lists of terms are either time-sliced or run on dirty CPU
+ * schedulers, so that the normal schedulers are never stalled.
+ *
  */
 
 static ErlNifFunc nif_funcs[] =
 {
 
-  { "h5fcreate",                  2, h5fcreate },
-  { "h5fopen",                    2, h5fopen },
-  { "h5fclose",                   1, h5fclose },
-
-  { "h5screate_simple",           2, h5screate_simple },
-  { "h5sclose",                   1, h5sclose },
-  { "h5sget_simple_extent_dims",  2, h5sget_simple_extent_dims },
-  { "h5sget_simple_extent_ndims", 1, h5sget_simple_extent_ndims },
-  { "h5sselect_hyperslab",        6, h5sselect_hyperslab },
-
-  { "h5pcreate",                  1, h5pcreate },
-  { "h5pclose",                   1, h5pclose },
-
-  { "datatype_name_to_handle",    1, datatype_name_to_handle },
-  { "h5tcopy",                    1, h5tcopy },
-  { "h5tclose",                   1, h5tclose },
-  { "h5tget_class",               1, h5tget_class },
-  { "h5tget_order",               1, h5tget_order },
-  { "h5tget_size",                1, h5tget_size },
-
-  { "h5dcreate",                  5, h5dcreate },
-  { "h5dopen",                    2, h5dopen },
-  { "h5dopen",                    3, h5dopen },
-  { "h5dclose",                   1, h5dclose },
-  { "h5dget_type",                1, h5dget_type },
-  { "h5d_get_space_status",       1, h5d_get_space_status },
-  { "h5dwrite",                   2, h5dwrite },
-  { "h5dwrite",                   3, h5dwrite },
-  { "h5d_get_storage_size",       1, h5d_get_storage_size },
-  { "h5dget_space",               1, h5dget_space },
-
-  { "h5lt_make_dataset",          5, h5lt_make_dataset },
-  { "h5lt_read_dataset_int",      2, h5lt_read_dataset_int },
-  { "h5lt_read_dataset_double",   2, h5lt_read_dataset_double },
-  { "h5lt_read_dataset_string",   2, h5lt_read_dataset_string },
-  { "h5ltget_dataset_ndims",      2, h5ltget_dataset_ndims },
-  { "h5ltget_dataset_info",       3, h5ltget_dataset_info }
+  { "h5fcreate",                  2, serialized_h5fcreate,  ERLHDF5_DIRTY_IO },
+  { "h5fcreate",                  3, serialized_h5fcreate,  ERLHDF5_DIRTY_IO },
+  { "h5fcreate",                  4, serialized_h5fcreate,  ERLHDF5_DIRTY_IO },
+  { "h5fopen",                    2, serialized_h5fopen,    ERLHDF5_DIRTY_IO },
+  { "h5fopen",                    3, serialized_h5fopen,    ERLHDF5_DIRTY_IO },
+  { "h5fclose",                   1, serialized_h5fclose,   ERLHDF5_DIRTY_IO },
+  { "h5fstart_swmr_write",        1, serialized_h5fstart_swmr_write,
+	ERLHDF5_DIRTY_IO },
+  { "h5fclose_async",             1, async_h5fclose,        0 },
+  { "h5f_open_image",             1, serialized_h5f_open_image,
+	ERLHDF5_DIRTY_CPU },
+  { "h5f_open_image",             2, serialized_h5f_open_image,
+	ERLHDF5_DIRTY_CPU },
+  { "h5f_get_image",              1, serialized_h5f_get_image,
+	ERLHDF5_DIRTY_CPU },
+
+  { "h5screate_simple",           2, fast_h5screate_simple,           0 },
+  { "h5screate_simple",           3, fast_h5screate_simple,           0 },
+  { "h5sclose",                   1, fast_h5sclose,                   0 },
+  { "h5sget_simple_extent_dims",  2, fast_h5sget_simple_extent_dims,  0 },
+  { "h5sget_simple_extent_ndims", 1, fast_h5sget_simple_extent_ndims, 0 },
+  { "h5sselect_hyperslab",        6, fast_h5sselect_hyperslab,        0 },
+  { "h5sselect_elements",         3, serialized_h5sselect_elements,
+	ERLHDF5_DIRTY_CPU },
+
+  { "h5pcreate",                  1, fast_h5pcreate,                  0 },
+  { "h5pclose",                   1, fast_h5pclose,                   0 },
+  { "h5pset_chunk",               3, fast_h5pset_chunk,               0 },
+  { "h5pset_deflate",             2, fast_h5pset_deflate,             0 },
+  { "h5pset_shuffle",             1, fast_h5pset_shuffle,             0 },
+  { "h5pset_fletcher32",          1, fast_h5pset_fletcher32,          0 },
+  { "h5pset_nbit",                1, fast_h5pset_nbit,                0 },
+  { "h5pset_scaleoffset",         3, fast_h5pset_scaleoffset,         0 },
+  { "h5pset_chunk_cache",         4, fast_h5pset_chunk_cache,         0 },
+  { "h5pset_fapl_core",           3, fast_h5pset_fapl_core,           0 },
+  { "h5pset_mdc_size",            4, fast_h5pset_mdc_size,            0 },
+  { "h5pset_sieve_buf_size",      2, fast_h5pset_sieve_buf_size,      0 },
+  { "h5pset_alignment",           3, fast_h5pset_alignment,           0 },
+  { "h5pset_libver_bounds",       3, fast_h5pset_libver_bounds,       0 },
+  { "h5pset_page_buffer_size",    4, fast_h5pset_page_buffer_size,    0 },
+  { "h5pset_file_space_strategy", 4, fast_h5pset_file_space_strategy, 0 },
+  { "h5pset_file_space_page_size", 2, fast_h5pset_file_space_page_size, 0 },
+
+  { "datatype_name_to_handle",    1, fast_datatype_name_to_handle,    0 },
+  { "h5tcopy",                    1, fast_h5tcopy,                    0 },
+  { "h5tclose",                   1, fast_h5tclose,                   0 },
+  { "h5tget_class",               1, fast_h5tget_class,               0 },
+  { "h5tget_order",               1, fast_h5tget_order,               0 },
+  { "h5tget_size",                1, fast_h5tget_size,                0 },
+
+  { "h5dcreate",            5, serialized_h5dcreate,       ERLHDF5_DIRTY_IO },
+  { "h5dopen",              2, serialized_h5dopen,         ERLHDF5_DIRTY_IO },
+  { "h5dopen",              3, serialized_h5dopen,         ERLHDF5_DIRTY_IO },
+  { "h5dclose",             1, serialized_h5dclose,        ERLHDF5_DIRTY_IO },
+  { "h5dflush",             1, serialized_h5dflush,        ERLHDF5_DIRTY_IO },
+  { "h5drefresh",           1, serialized_h5drefresh,      ERLHDF5_DIRTY_IO },
+  { "h5dget_type",          1, fast_h5dget_type,           0 },
+  { "h5d_get_space_status", 1, fast_h5d_get_space_status,  0 },
+  { "h5dwrite",             2, h5dwrite_timesliced,        0 },
+  { "h5dwrite",             3, h5dwrite_timesliced,        0 },
+  { "h5dwrite_binary",      3, serialized_h5dwrite_binary, ERLHDF5_DIRTY_IO },
+  { "h5dwrite_binary",      4, serialized_h5dwrite_binary, ERLHDF5_DIRTY_IO },
+  { "h5dread",       3, serialized_h5dread_timesliced,   ERLHDF5_DIRTY_IO },
+  { "h5dread_binary",       3, serialized_h5dread_binary,  ERLHDF5_DIRTY_IO },
+  { "h5dwrite_block",       4, serialized_h5dwrite_block,  ERLHDF5_DIRTY_IO },
+  { "h5dread_block",        4, serialized_h5dread_block,   ERLHDF5_DIRTY_IO },
+  { "h5dwrite_points",      4, serialized_h5dwrite_points, ERLHDF5_DIRTY_IO },
+  { "h5dread_points",       3, serialized_h5dread_points,  ERLHDF5_DIRTY_IO },
+  { "h5dappend",            2, serialized_h5dappend,       ERLHDF5_DIRTY_IO },
+  { "h5dappend_binary",     3, serialized_h5dappend_binary, ERLHDF5_DIRTY_IO },
+  { "h5d_prepare_write",    3, fast_h5d_prepare_write,     0 },
+  { "h5d_exec_write",       3, serialized_h5d_exec_write,  ERLHDF5_DIRTY_IO },
+  { "h5d_create_buffer",    4, fast_h5d_create_buffer,     0 },
+  { "h5d_buffer_append",    2, h5d_buffer_append,          0 },
+  { "h5d_flush_buffer",     1, serialized_h5d_flush_buffer, ERLHDF5_DIRTY_IO },
+  { "h5d_buffer_info",      1, h5d_buffer_info,            0 },
+  { "h5d_aggregate",        3, serialized_h5d_aggregate,   ERLHDF5_DIRTY_IO },
+  { "h5d_histogram",        3, serialized_h5d_histogram,   ERLHDF5_DIRTY_IO },
+  { "h5d_sketch",           3, serialized_h5d_sketch,      ERLHDF5_DIRTY_IO },
+  { "h5d_read_downsampled", 4, serialized_h5d_read_downsampled,
+	ERLHDF5_DIRTY_IO },
+  { "h5d_scan",             3, serialized_h5d_scan,        ERLHDF5_DIRTY_IO },
+  { "h5d_scan",             4, serialized_h5d_scan,        ERLHDF5_DIRTY_IO },
+  { "h5d_create_zone_map",  1, serialized_h5d_create_zone_map,
+	ERLHDF5_DIRTY_IO },
+  { "h5d_get_zone_map",     1, serialized_h5d_get_zone_map, ERLHDF5_DIRTY_IO },
+  { "sketch_merge",         1, sketch_merge,               ERLHDF5_DIRTY_CPU },
+  { "sketch_quantiles",     2, sketch_quantiles,
+	ERLHDF5_DIRTY_CPU },
+  { "h5dwrite_async",       2, async_h5dwrite,             0 },
+  { "h5dwrite_async",       3, async_h5dwrite,             0 },
+  { "h5dwrite_binary_async", 3, async_h5dwrite_binary,     0 },
+  { "h5dwrite_binary_async", 4, async_h5dwrite_binary,     0 },
+  { "h5dread_async",        3, async_h5dread,              0 },
+  { "h5dread_binary_async", 3, async_h5dread_binary,       0 },
+  { "h5d_get_storage_size", 1, fast_h5d_get_storage_size,  0 },
+  { "h5dget_space",         1, fast_h5dget_space,          0 },
+
+  { "h5lt_make_dataset",        5, serialized_h5lt_make_dataset,
+	ERLHDF5_DIRTY_CPU },
+  { "h5lt_read_dataset_int",    2,
+	serialized_h5lt_read_dataset_int_timesliced, ERLHDF5_DIRTY_IO },
+  { "h5lt_read_dataset_double", 2,
+	serialized_h5lt_read_dataset_double_timesliced, ERLHDF5_DIRTY_IO },
+  { "h5lt_read_dataset_int_async",    2, async_h5lt_read_dataset_int,    0 },
+  { "h5lt_read_dataset_double_async", 2, async_h5lt_read_dataset_double, 0 },
+  { "h5lt_read_dataset_string", 2, serialized_h5lt_read_dataset_string,
+	ERLHDF5_DIRTY_CPU },
+  { "h5ltget_dataset_ndims",    2, serialized_h5ltget_dataset_ndims,
+	ERLHDF5_DIRTY_IO },
+  { "h5ltget_dataset_info",     3, serialized_h5ltget_dataset_info,
+	ERLHDF5_DIRTY_IO }
 
 } ;
 
 
 // Module name, NIF array, four callbacks (load, reload, upgrade, unload):
-ERL_NIF_INIT( erlhdf5, nif_funcs, &load, NULL, NULL, NULL ) ;
+ERL_NIF_INIT( erlhdf5, nif_funcs, &load, NULL, NULL, &unload ) ;
@@ -32,38 +32,174 @@
 
 #define MAXBUFLEN 1024
 
-// 0, 1:
-typedef enum { false, true } bool ;
+// Target size of the chunks chosen by default for extendible datasets:
+#define DEFAULT_CHUNK_BYTES 65536
+
+// bool, false, true (as also used by the headers of recent HDF5 versions):
+#include <stdbool.h>
 
 // Determines the number of elements of specified array:
 #define NUM_OF(x) (sizeof(x) / sizeof *(x))
 
 
+/*
+ * Dirty schedulers are available by default from NIF 2.12 (OTP 20) on, and
+ * before only if the VM was built with them.
+ *
+ * Lacking them, the corresponding NIFs are run on normal schedulers.
+ *
+ */
+#if defined( ERL_NIF_DIRTY_SCHEDULER_SUPPORT ) || ERL_NIF_MAJOR_VERSION > 2 \
+  || ( ERL_NIF_MAJOR_VERSION == 2 && ERL_NIF_MINOR_VERSION >= 12 )
+
+#define ERLHDF5_DIRTY_SCHEDULERS 1
+#define ERLHDF5_DIRTY_IO  ERL_NIF_DIRTY_JOB_IO_BOUND
+#define ERLHDF5_DIRTY_CPU ERL_NIF_DIRTY_JOB_CPU_BOUND
+
+#else
+
+#define ERLHDF5_DIRTY_SCHEDULERS 0
+#define ERLHDF5_DIRTY_IO  0
+#define ERLHDF5_DIRTY_CPU 0
+
+#endif
+
+
 // Shared variables.
 
 // Atoms (initialized in on_load):
 ERL_NIF_TERM atom_ok ;
 ERL_NIF_TERM atom_error ;
 
-ErlNifResourceType* resource_type ;
 
 
-// Resource type to pass pointers from C to Erlang:
+/*
+ * Numeric types of cell elements, converted between terms and C arrays by the
+ * kernels of erlhdf5_cell.c:
+ *
+ */
+typedef enum { UNKNOWN_TYPE, INT8_CELL, INT16_CELL, INT32_CELL, INT64_CELL,
+			   UINT8_CELL, UINT16_CELL, UINT32_CELL, UINT64_CELL,
+			   FLOAT32_CELL, FLOAT64_CELL, CELL_TYPE_COUNT } cell_type ;
+
+
+// Kinds of HDF5 objects referenced from Erlang, each with its resource type:
+typedef enum { FILE_HANDLE, DATASET_HANDLE, DATASPACE_HANDLE, DATATYPE_HANDLE,
+			   PROPLIST_HANDLE, HANDLE_KIND_COUNT } handle_kind ;
+
+
+/*
+ * Resource type to pass HDF5 identifiers from C to Erlang: the identifier is
+ * closed (with the H5*close function matching its kind) either explicitly
+ * (ex: h5dclose/1) or, at the latest, when the handle is garbage-collected.
+ *
+ */
 typedef struct
 {
 
+  // Negative once closed:
   hid_t id ;
 
+  handle_kind kind ;
+
+  // Whether this handle has to close its identifier (not the case for the
+  // predefined datatypes, owned by the library):
+  bool owned ;
+
+  // For a dataset, the (immutable) type of its cells, UNKNOWN_TYPE if not
+  // numeric; determined once at opening, so that it can be known without
+  // calling HDF5:
+  cell_type cells ;
+
+  // For a dataset, whether it has a zone map, as determined at opening and
+  // checked again only once a zone map has been created since (see
+  // erlh5d_zonemap.c), so that writes do not have to look for it:
+  bool zone_map ;
+  unsigned int zone_map_generation ;
+
 } Handle ;
 
 
-// To identify the type of cell elements:
-typedef enum { UNKNOWN_TYPE, INTEGER, FLOAT } cell_type ;
+// Signature of the C implementation of a NIF:
+typedef ERL_NIF_TERM (*nif_function)( ErlNifEnv* env, int argc,
+  const ERL_NIF_TERM argv[] ) ;
+
+
+/*
+ * Describes the shape of data, typically to be written in a dataset (its
+ * length is only known once it has been decoded, in a single pass).
+ *
+ */
+struct DataDescriptor
+{
+
+  // Number of cells of each tuple (0 for a list of bare cells):
+  int tuple_size ;
+
+  // Not allowed in C: ERL_NIF_TERM * error_term = NULL ;
+  ERL_NIF_TERM error_term ;
+
+} ;
+
 
 
 // C prototypes for helpers:
 
 
+/*
+ * Serialization of the calls to the HDF5 library (which is not thread-safe by
+ * default); NIFs are wrapped accordingly (see erlhdf5.c), other code paths
+ * calling HDF5 (ex: from another thread) shall use these functions.
+ *
+ */
+void hdf5_lock() ;
+bool hdf5_try_lock() ;
+void hdf5_unlock() ;
+
+
+/*
+ * HDF5 executor: a thread performing the asynchronous calls (see
+ * erlhdf5_executor.c).
+ *
+ */
+int executor_start( ErlNifEnv* env ) ;
+void executor_stop() ;
+
+ERL_NIF_TERM submit_async_job( ErlNifEnv* env, nif_function fun, int argc,
+  const ERL_NIF_TERM argv[] ) ;
+
+bool submit_close_job( handle_kind kind, hid_t id ) ;
+
+// A task deferred to the executor, run with the HDF5 lock held:
+typedef void (*executor_task)( void* arg ) ;
+
+bool submit_task_job( executor_task task, void* arg ) ;
+
+
+/*
+ * Handles (see erlhdf5_handle.c).
+ *
+ */
+int open_handle_resource_types( ErlNifEnv* env ) ;
+
+ERL_NIF_TERM make_handle( ErlNifEnv* env, handle_kind kind, hid_t id ) ;
+
+ERL_NIF_TERM make_unowned_handle( ErlNifEnv* env, handle_kind kind,
+  hid_t id ) ;
+
+bool get_handle( ErlNifEnv* env, ERL_NIF_TERM term, handle_kind kind,
+  Handle** handle ) ;
+
+bool get_handle_id( ErlNifEnv* env, ERL_NIF_TERM term, handle_kind kind,
+  hid_t* id ) ;
+
+herr_t close_handle( Handle* handle ) ;
+
+herr_t close_hdf5_object( handle_kind kind, hid_t id ) ;
+
+void release_hdf5_object( handle_kind kind, hid_t id ) ;
+
+
 ERL_NIF_TERM error_tuple( ErlNifEnv* env, char* reason ) ;
 
 
@@ -83,6 +219,13 @@ int convert_array_to_nif_array( ErlNifEnv* env, hsize_t size, hsize_t *arr_from,
 int convert_nif_to_hsize_array( ErlNifEnv* env, hsize_t size,
   const ERL_NIF_TERM* arr_from, hsize_t *arr_to ) ;
 
+bool get_hsize( ErlNifEnv* env, ERL_NIF_TERM term, hsize_t * value ) ;
+
+bool get_size( ErlNifEnv* env, ERL_NIF_TERM term, size_t * value ) ;
+
+bool get_dimension_tuple( ErlNifEnv* env, ERL_NIF_TERM term, int rank,
+  hsize_t* dims ) ;
+
 
 int convert_int_array_to_nif_array( ErlNifEnv* env, hsize_t size, int *arr_from,
   ERL_NIF_TERM* arr_to ) ;
@@ -91,25 +234,298 @@ int convert_double_array_to_nif_array( ErlNifEnv* env, hsize_t size,
   double* arr_from, ERL_NIF_TERM* arr_to ) ;
 
 
-// Read/write helpers, for [ T ] and [ tuple(T) ] where T :: int() | float():
+/*
+ * Converts specified C double into an Erlang-level float, managing the mapping
+ * of infinite and nan values (to the 'inf' and 'nan' atoms).
+ *
+ */
+ERL_NIF_TERM make_double_term( ErlNifEnv* env, double value ) ;
+
+
+/*
+ * Detects the shape of the elements of specified data list, and fills
+ * accordingly specified descriptor.
+ *
+ */
+bool detect_type( ERL_NIF_TERM data_list, ErlNifEnv* env,
+  struct DataDescriptor * detected_desc ) ;
 
 
-ERL_NIF_TERM write_ints_to_array( hid_t dataset_id, ErlNifEnv* env,
-  unsigned int list_length, ERL_NIF_TERM int_list, hid_t file_dataspace_id ) ;
+/*
+ * Cell conversion kernels, for [ T ] and [ tuple(T) ] where T is a numeric
+ * type (see erlhdf5_cell.c).
+ *
+ */
+hid_t get_native_cell_type( cell_type type ) ;
 
-ERL_NIF_TERM write_int_tuples_to_array( hid_t dataset_id, ErlNifEnv* env,
-  unsigned int list_length, int tuple_size, ERL_NIF_TERM int_tuple_list,
-  hid_t file_dataspace_id ) ;
+cell_type get_cell_type( hid_t type_id ) ;
+
+cell_type get_dataset_cell_type( hid_t dataset_id ) ;
+
+size_t get_cell_size( cell_type type ) ;
 
+const char * encode_cell_list( ErlNifEnv* env, cell_type type,
+  ERL_NIF_TERM* list, int tuple_size, void* buffer, hsize_t* index,
+  hsize_t slice_end, hsize_t capacity ) ;
 
-ERL_NIF_TERM write_floats_to_array( hid_t dataset_id, ErlNifEnv* env,
-  unsigned int list_length, ERL_NIF_TERM float_list, hid_t file_dataspace_id ) ;
+const char * decode_cell_list( ErlNifEnv* env, cell_type type,
+  ERL_NIF_TERM* list, int tuple_size, void** buffer, hsize_t* capacity,
+  hsize_t* index, hsize_t slice_end ) ;
 
-ERL_NIF_TERM write_float_tuples_to_array( hid_t dataset_id, ErlNifEnv* env,
-  unsigned int list_length, int tuple_size, ERL_NIF_TERM float_tuple_list,
+ERL_NIF_TERM make_cell_list( ErlNifEnv* env, cell_type type,
+  const void* buffer, hsize_t from, hsize_t to, ERL_NIF_TERM tail ) ;
+
+
+/*
+ * Writes specified data list, as described by specified descriptor, into
+ * specified (open) dataset, using specified selection within the file
+ * dataspace.
+ *
+ */
+ERL_NIF_TERM write_data_list( Handle* dataset, ErlNifEnv* env,
+  const struct DataDescriptor* desc, ERL_NIF_TERM data_list,
   hid_t file_dataspace_id ) ;
 
 
+/*
+ * Writes specified in-memory buffer, made of element_count contiguous cells of
+ * the specified (memory) type, into specified (in-file) dataspace of specified
+ * (open) dataset, which had specified number of rows before (HSIZE_UNDEF
+ * unless the write appends rows to it).
+ *
+ */
+ERL_NIF_TERM write_buffer_to_dataset( Handle* dataset, ErlNifEnv* env,
+  hid_t mem_type_id, hsize_t element_count, const void* buffer,
+  hid_t file_dataspace_id, hsize_t old_rows ) ;
+
+
+
+/*
+ * Returns the number of elements selected by specified file dataspace in
+ * specified dataset (H5S_ALL meaning the full extent of the dataset), or a
+ * negative value on failure.
+ *
+ */
+hssize_t get_selected_count( hid_t dataset_id, hid_t file_dataspace_id ) ;
+
+
+/*
+ * Extends specified dataset along its first dimension by specified number of
+ * rows, selecting them in the returned tail dataspace; shrink_dataset/2
+ * restores a previous number of rows, after a failed write (see erlh5d.c).
+ *
+ */
+const char * extend_dataset( hid_t dataset_id, hsize_t new_rows,
+  hid_t* tail_dataspace_id, hsize_t* row_cells, hsize_t* old_rows ) ;
+
+void shrink_dataset( hid_t dataset_id, hsize_t rows ) ;
+
+
+/*
+ * Gets from specified term a file dataspace: either the 'H5S_ALL' atom or a
+ * dataspace handle.
+ *
+ * Returns whether the operation succeeded.
+ *
+ */
+bool get_file_dataspace( ErlNifEnv* env, ERL_NIF_TERM term,
+  hid_t* file_dataspace_id ) ;
+
+
+/*
+ * Reads from specified (in-file) dataspace element_count contiguous cells of
+ * the specified (memory) type into specified, caller-allocated buffer.
+ *
+ * Returns whether the operation succeeded.
+ *
+ */
+bool read_buffer_from_dataset( hid_t dataset_id, hid_t mem_type_id,
+  hsize_t element_count, void* buffer, hid_t file_dataspace_id ) ;
+
+
+
+/*
+ * Converts an HDF5 type name (ex: "H5T_NATIVE_INT") into the corresponding
+ * predefined HDF5 type.
+ *
+ * Returns 0 on success, -1 on failure.
+ *
+ */
+int convert_type( const char* string_type, hid_t* target_hdf_type ) ;
+
+
+/*
+ * Synchronous read helpers, filling a newly-allocated buffer (to be freed by
+ * the caller), for h5dread/3 and h5lt_read_dataset_{int,double}/2.
+ *
+ */
+bool read_selection( ErlNifEnv* env, const ERL_NIF_TERM argv[],
+  cell_type* type, void** buffer, hsize_t* element_count,
+  ERL_NIF_TERM* error_term ) ;
+
+bool read_lt_dataset( ErlNifEnv* env, const ERL_NIF_TERM argv[],
+  hid_t mem_type_id, void** buffer, hsize_t* element_count,
+  ERL_NIF_TERM* error_term ) ;
+
+
+/*
+ * Time-sliced versions of the list-based reads and writes (see
+ * erlh5d_timeslice.c).
+ *
+ */
+int open_timeslice_resource_types( ErlNifEnv* env ) ;
+
+ERL_NIF_TERM h5dwrite_timesliced( ErlNifEnv* env, int argc,
+  const ERL_NIF_TERM argv[] ) ;
+
+ERL_NIF_TERM h5dread_timesliced( ErlNifEnv* env, int argc,
+  const ERL_NIF_TERM argv[] ) ;
+
+ERL_NIF_TERM h5lt_read_dataset_int_timesliced( ErlNifEnv* env, int argc,
+  const ERL_NIF_TERM argv[] ) ;
+
+ERL_NIF_TERM h5lt_read_dataset_double_timesliced( ErlNifEnv* env, int argc,
+  const ERL_NIF_TERM argv[] ) ;
+
+
+/*
+ * Prepared write plans, for repeated writes of same-shape blocks (see
+ * erlh5d_plan.c).
+ *
+ */
+int open_plan_resource_types( ErlNifEnv* env ) ;
+
+ERL_NIF_TERM h5d_prepare_write( ErlNifEnv* env, int argc,
+  const ERL_NIF_TERM argv[] ) ;
+
+ERL_NIF_TERM h5d_exec_write( ErlNifEnv* env, int argc,
+  const ERL_NIF_TERM argv[] ) ;
+
+
+/*
+ * Write-behind append buffers, coalescing small appends into large writes (see
+ * erlh5d_buffer.c).
+ *
+ */
+int open_buffer_resource_types( ErlNifEnv* env ) ;
+
+void buffer_flusher_stop() ;
+
+ERL_NIF_TERM h5d_create_buffer( ErlNifEnv* env, int argc,
+  const ERL_NIF_TERM argv[] ) ;
+
+ERL_NIF_TERM h5d_buffer_append( ErlNifEnv* env, int argc,
+  const ERL_NIF_TERM argv[] ) ;
+
+ERL_NIF_TERM h5d_flush_buffer( ErlNifEnv* env, int argc,
+  const ERL_NIF_TERM argv[] ) ;
+
+ERL_NIF_TERM h5d_buffer_info( ErlNifEnv* env, int argc,
+  const ERL_NIF_TERM argv[] ) ;
+
+
+
+/*
+ * Streaming scans of dataset selections, through a bounded buffer (see
+ * erlh5d_scan.c).
+ *
+ * A scan function is handed over, in the order of the selection, the count
+ * cells (read as doubles) starting at specified position of that selection; it
+ * returns NULL to continue the scan, otherwise an error message.
+ *
+ */
+typedef const char * (*scan_function)( const double* cells, size_t count,
+  hsize_t position, void* state ) ;
+
+const char * scan_selection( hid_t dataset_id, hid_t file_dataspace_id,
+  scan_function scan, void* state ) ;
+
+hid_t select_series_range( ErlNifEnv* env, hid_t dataset_id,
+  ERL_NIF_TERM range_term, hsize_t* start, hsize_t* count,
+  const char** error_message ) ;
+
+ERL_NIF_TERM h5d_aggregate( ErlNifEnv* env, int argc,
+  const ERL_NIF_TERM argv[] ) ;
+
+ERL_NIF_TERM h5d_scan( ErlNifEnv* env, int argc, const ERL_NIF_TERM argv[] ) ;
+
+
+/*
+ * Fixed-bin histograms and mergeable quantile sketches (see erlh5d_sketch.c).
+ *
+ */
+ERL_NIF_TERM h5d_histogram( ErlNifEnv* env, int argc,
+  const ERL_NIF_TERM argv[] ) ;
+
+ERL_NIF_TERM h5d_sketch( ErlNifEnv* env, int argc, const ERL_NIF_TERM argv[] ) ;
+
+ERL_NIF_TERM sketch_merge( ErlNifEnv* env, int argc,
+  const ERL_NIF_TERM argv[] ) ;
+
+ERL_NIF_TERM sketch_quantiles( ErlNifEnv* env, int argc,
+  const ERL_NIF_TERM argv[] ) ;
+
+
+// Downsampled reads of series, for plotting (see erlh5d_downsample.c):
+ERL_NIF_TERM h5d_read_downsampled( ErlNifEnv* env, int argc,
+  const ERL_NIF_TERM argv[] ) ;
+
+
+
+/*
+ * Zone maps: per slab of rows as high as the chunks of a dataset (a zone), the
+ * minimum, maximum and count of its non-NaN cells, kept up to date by writes
+ * and used by scans to skip zones (see erlh5d_zonemap.c).
+ *
+ */
+
+// Count of a zone whose summary is not known:
+#define UNKNOWN_ZONE_COUNT -1.0
+
+typedef struct
+{
+
+  double min ;
+  double max ;
+
+  // Number of non-NaN cells (as stored, in a double), or UNKNOWN_ZONE_COUNT:
+  double count ;
+
+} Zone ;
+
+
+typedef struct
+{
+
+  // Number of rows of the dataset, of rows per zone, and of cells per row:
+  hsize_t rows ;
+  hsize_t zone_rows ;
+  hsize_t row_cells ;
+
+  // Index of the first zone held, and number of zones held:
+  hsize_t first ;
+  hsize_t count ;
+
+  Zone * zones ;
+
+} ZoneMap ;
+
+
+void check_zone_map( Handle* dataset ) ;
+
+void update_zone_map( Handle* dataset, hid_t file_dataspace_id,
+  hsize_t old_rows, hid_t mem_type_id, const void* buffer, bool written ) ;
+
+const char * read_zone_map( Handle* dataset, hsize_t first_row,
+  hsize_t end_row, ZoneMap* map ) ;
+
+ERL_NIF_TERM h5d_create_zone_map( ErlNifEnv* env, int argc,
+  const ERL_NIF_TERM argv[] ) ;
+
+ERL_NIF_TERM h5d_get_zone_map( ErlNifEnv* env, int argc,
+  const ERL_NIF_TERM argv[] ) ;
+
+
 
 /*
  * Converts a data type, specified as an atom, to its handle (integer) HDF5
@@ -133,6 +549,15 @@ ERL_NIF_TERM h5fcreate( ErlNifEnv* env, int argc, const ERL_NIF_TERM argv[] ) ;
 ERL_NIF_TERM h5fopen(   ErlNifEnv* env, int argc, const ERL_NIF_TERM argv[] ) ;
 ERL_NIF_TERM h5fclose(  ErlNifEnv* env, int argc, const ERL_NIF_TERM argv[] ) ;
 
+ERL_NIF_TERM h5f_open_image( ErlNifEnv* env, int argc,
+  const ERL_NIF_TERM argv[] ) ;
+
+ERL_NIF_TERM h5f_get_image( ErlNifEnv* env, int argc,
+  const ERL_NIF_TERM argv[] ) ;
+
+ERL_NIF_TERM h5fstart_swmr_write( ErlNifEnv* env, int argc,
+  const ERL_NIF_TERM argv[] ) ;
+
 
 // h5s sub-API;
 ERL_NIF_TERM h5screate_simple( ErlNifEnv* env, int argc,
@@ -149,12 +574,79 @@ ERL_NIF_TERM h5sget_simple_extent_dims( ErlNifEnv* env, int argc,
 ERL_NIF_TERM h5sselect_hyperslab( ErlNifEnv* env, int argc,
   const ERL_NIF_TERM argv[] ) ;
 
+ERL_NIF_TERM h5sselect_elements( ErlNifEnv* env, int argc,
+  const ERL_NIF_TERM argv[] ) ;
+
+
+/*
+ * Selects in specified dataspace, according to specified operator, the points
+ * whose coordinates are packed in specified binary (see erlh5s.c).
+ *
+ * Returns the number of points selected, or 0 on failure (then error_message
+ * is set).
+ *
+ */
+hsize_t select_points( ErlNifEnv* env, hid_t dataspace_id, H5S_seloper_t op,
+  ERL_NIF_TERM coords_term, const char** error_message ) ;
+
 
 
 // h5p sub-API;
 ERL_NIF_TERM h5pcreate( ErlNifEnv* env, int argc, const ERL_NIF_TERM argv[] ) ;
 ERL_NIF_TERM h5pclose(  ErlNifEnv* env, int argc, const ERL_NIF_TERM argv[] ) ;
 
+ERL_NIF_TERM h5pset_chunk( ErlNifEnv* env, int argc,
+  const ERL_NIF_TERM argv[] ) ;
+
+ERL_NIF_TERM h5pset_deflate( ErlNifEnv* env, int argc,
+  const ERL_NIF_TERM argv[] ) ;
+
+ERL_NIF_TERM h5pset_shuffle( ErlNifEnv* env, int argc,
+  const ERL_NIF_TERM argv[] ) ;
+
+ERL_NIF_TERM h5pset_fletcher32( ErlNifEnv* env, int argc,
+  const ERL_NIF_TERM argv[] ) ;
+
+ERL_NIF_TERM h5pset_nbit( ErlNifEnv* env, int argc, const ERL_NIF_TERM argv[] ) ;
+
+ERL_NIF_TERM h5pset_scaleoffset( ErlNifEnv* env, int argc,
+  const ERL_NIF_TERM argv[] ) ;
+
+ERL_NIF_TERM h5pset_chunk_cache( ErlNifEnv* env, int argc,
+  const ERL_NIF_TERM argv[] ) ;
+
+ERL_NIF_TERM h5pset_fapl_core( ErlNifEnv* env, int argc,
+  const ERL_NIF_TERM argv[] ) ;
+
+ERL_NIF_TERM h5pset_mdc_size( ErlNifEnv* env, int argc,
+  const ERL_NIF_TERM argv[] ) ;
+
+ERL_NIF_TERM h5pset_sieve_buf_size( ErlNifEnv* env, int argc,
+  const ERL_NIF_TERM argv[] ) ;
+
+ERL_NIF_TERM h5pset_alignment( ErlNifEnv* env, int argc,
+  const ERL_NIF_TERM argv[] ) ;
+
+ERL_NIF_TERM h5pset_libver_bounds( ErlNifEnv* env, int argc,
+  const ERL_NIF_TERM argv[] ) ;
+
+ERL_NIF_TERM h5pset_page_buffer_size( ErlNifEnv* env, int argc,
+  const ERL_NIF_TERM argv[] ) ;
+
+ERL_NIF_TERM h5pset_file_space_strategy( ErlNifEnv* env, int argc,
+  const ERL_NIF_TERM argv[] ) ;
+
+ERL_NIF_TERM h5pset_file_space_page_size( ErlNifEnv* env, int argc,
+  const ERL_NIF_TERM argv[] ) ;
+
+/*
+ * Gets, from specified term, the identifier of a property list of specified
+ * class. Returns 0 on success, -1 on failure.
+ *
+ */
+int get_proplist( ErlNifEnv* env, ERL_NIF_TERM term, hid_t class_id,
+  hid_t* plist_id ) ;
+
 
 // h5t sub-API;
 ERL_NIF_TERM h5tcopy(  ErlNifEnv* env, int argc, const ERL_NIF_TERM argv[] ) ;
@@ -174,12 +666,39 @@ ERL_NIF_TERM h5tget_size( ErlNifEnv* env, int argc,
 ERL_NIF_TERM h5dcreate( ErlNifEnv* env, int argc, const ERL_NIF_TERM argv[] ) ;
 ERL_NIF_TERM h5dopen(   ErlNifEnv* env, int argc, const ERL_NIF_TERM argv[] ) ;
 ERL_NIF_TERM h5dclose(  ErlNifEnv* env, int argc, const ERL_NIF_TERM argv[] ) ;
+ERL_NIF_TERM h5dflush(  ErlNifEnv* env, int argc, const ERL_NIF_TERM argv[] ) ;
+ERL_NIF_TERM h5drefresh( ErlNifEnv* env, int argc, const ERL_NIF_TERM argv[] ) ;
 
 ERL_NIF_TERM h5d_get_space_status( ErlNifEnv* env, int argc,
   const ERL_NIF_TERM argv[] ) ;
 
 ERL_NIF_TERM h5dwrite( ErlNifEnv* env, int argc, const ERL_NIF_TERM argv[] ) ;
 
+ERL_NIF_TERM h5dwrite_binary( ErlNifEnv* env, int argc,
+  const ERL_NIF_TERM argv[] ) ;
+
+ERL_NIF_TERM h5dread_binary( ErlNifEnv* env, int argc,
+  const ERL_NIF_TERM argv[] ) ;
+
+ERL_NIF_TERM h5dwrite_block( ErlNifEnv* env, int argc,
+  const ERL_NIF_TERM argv[] ) ;
+
+ERL_NIF_TERM h5dread_block( ErlNifEnv* env, int argc,
+  const ERL_NIF_TERM argv[] ) ;
+
+ERL_NIF_TERM h5dwrite_points( ErlNifEnv* env, int argc,
+  const ERL_NIF_TERM argv[] ) ;
+
+ERL_NIF_TERM h5dread_points( ErlNifEnv* env, int argc,
+  const ERL_NIF_TERM argv[] ) ;
+
+ERL_NIF_TERM h5dread( ErlNifEnv* env, int argc, const ERL_NIF_TERM argv[] ) ;
+
+ERL_NIF_TERM h5dappend( ErlNifEnv* env, int argc, const ERL_NIF_TERM argv[] ) ;
+
+ERL_NIF_TERM h5dappend_binary( ErlNifEnv* env, int argc,
+  const ERL_NIF_TERM argv[] ) ;
+
 ERL_NIF_TERM h5d_get_storage_size( ErlNifEnv* env, int argc,
   const ERL_NIF_TERM argv[] ) ;
 
@@ -0,0 +1,492 @@
+/* This file is part of erlhdf5 */
+
+/* erlhdf5 is free software: you can redistribute it and/or modify */
+/* it under the terms of the GNU Lesser General Public License as */
+/* published by the Free Software Foundation, either version 3 of */
+/* the License, or (at your option) any later version. */
+
+/* erlhdf5 is distributed in the hope that it will be useful, */
+/* but WITHOUT ANY WARRANTY; without even the implied warranty of */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the */
+/* GNU Lesser General Public License for more details. */
+
+/* You should have received a copy of the GNU Lesser General Public */
+/* License along with erlhdf5.  If not, see */
+/* <http://www.gnu.org/licenses/>. */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <float.h>
+#include <math.h>
+
+#include "hdf5.h"
+
+#include "erl_nif.h"
+
+#include "dbg.h"
+
+#include "erlhdf5.h"
+
+
+/*
+ * Cell conversion kernels: for each supported numeric type (signed and
+ * unsigned integers of 8, 16, 32 and 64 bits, single and double precision
+ * floating-point values), a loop converting a list of terms into a C array,
+ * and one converting a C array into a list of terms.
+ *
+ * These loops are generated by macros, so that each is specialized for its C
+ * type (no per-cell dispatch), and writes are range-checked against their
+ * type: a cell that does not fit is reported as an error, instead of being
+ * silently clamped or wrapped.
+ *
+ */
+
+
+// Initial capacity, in cells, of the buffers of the list decoders:
+#define INITIAL_DECODE_CELLS 1024
+
+
+/*
+ * Defines get_<name>_cell(), converting a term into a signed integer cell,
+ * checked against the bounds of its type.
+ *
+ */
+#define SIGNED_CELL_GETTER( name, ctype, min, max )                     \
+  static inline const char * get_##name##_cell( ErlNifEnv* env,        \
+	ERL_NIF_TERM term, ctype* target )                                  \
+  {                                                                     \
+	ErlNifSInt64 value ;                                                \
+	if ( ! enif_get_int64( env, term, &value ) )                        \
+	  return "Cell does not contain an integer" ;                       \
+	if ( value < (min) || value > (max) )                               \
+	  return "Integer cell out of the range of its type" ;              \
+	*target = (ctype) value ;                                           \
+	return NULL ;                                                       \
+  }
+
+
+// Same for unsigned integers (negative values being out of range):
+#define UNSIGNED_CELL_GETTER( name, ctype, max )                        \
+  static inline const char * get_##name##_cell( ErlNifEnv* env,        \
+	ERL_NIF_TERM term, ctype* target )                                  \
+  {                                                                     \
+	ErlNifUInt64 value ;                                                \
+	if ( ! enif_get_uint64( env, term, &value ) )                       \
+	{                                                                   \
+	  ErlNifSInt64 signed_value ;                                       \
+	  if ( enif_get_int64( env, term, &signed_value ) )                 \
+		return "Integer cell out of the range of its type" ;            \
+	  return "Cell does not contain an integer" ;                       \
+	}                                                                   \
+	if ( value > (max) )                                                \
+	  return "Integer cell out of the range of its type" ;              \
+	*target = (ctype) value ;                                           \
+	return NULL ;                                                       \
+  }
+
+
+/*
+ * Same for floating-point values, which may also be specified as integers, or
+ * as the 'nan' and 'inf' atoms; finite values must fit in the type.
+ *
+ * The checks are tried in order of likely hit: float first, then integer, and
+ * the (costlier) atom one last.
+ *
+ */
+#define FLOAT_CELL_GETTER( name, ctype, max )                           \
+  static inline const char * get_##name##_cell( ErlNifEnv* env,        \
+	ERL_NIF_TERM term, ctype* target )                                  \
+  {                                                                     \
+	double value ;                                                      \
+	ErlNifSInt64 int_value ;                                            \
+	if ( enif_get_double( env, term, &value ) )                         \
+	{                                                                   \
+	  if ( fabs( value ) > (max) )                                      \
+		return "Floating-point cell out of the range of its type" ;     \
+	}                                                                   \
+	else if ( enif_get_int64( env, term, &int_value ) )                 \
+	{                                                                   \
+	  value = (double) int_value ;                                      \
+	  if ( fabs( value ) > (max) )                                      \
+		return "Floating-point cell out of the range of its type" ;     \
+	}                                                                   \
+	else if ( ! convert_float_value_to_c( term, &value, env ) )         \
+	  return "Unable to convert float to C double" ;                    \
+	*target = (ctype) value ;                                           \
+	return NULL ;                                                       \
+  }
+
+
+SIGNED_CELL_GETTER( int8,  int8_t,  INT8_MIN,  INT8_MAX )
+SIGNED_CELL_GETTER( int16, int16_t, INT16_MIN, INT16_MAX )
+SIGNED_CELL_GETTER( int32, int32_t, INT32_MIN, INT32_MAX )
+SIGNED_CELL_GETTER( int64, int64_t, INT64_MIN, INT64_MAX )
+
+UNSIGNED_CELL_GETTER( uint8,  uint8_t,  UINT8_MAX )
+UNSIGNED_CELL_GETTER( uint16, uint16_t, UINT16_MAX )
+UNSIGNED_CELL_GETTER( uint32, uint32_t, UINT32_MAX )
+UNSIGNED_CELL_GETTER( uint64, uint64_t, UINT64_MAX )
+
+FLOAT_CELL_GETTER( float32, float,  FLT_MAX )
+FLOAT_CELL_GETTER( float64, double, DBL_MAX )
+
+
+
+// Term makers, from a cell of each family:
+#define MAKE_SIGNED_TERM( env, value )   enif_make_int64( env, value )
+#define MAKE_UNSIGNED_TERM( env, value ) enif_make_uint64( env, value )
+#define MAKE_FLOAT_TERM( env, value )    make_double_term( env, value )
+
+
+
+/*
+ * Defines, for the specified cell type, the two kernels:
+ *
+ * - encode_list_<name>(), converting the cells of a list (either of bare cells
+ * if tuple_size is 0, or of tuples of tuple_size cells) into the buffer,
+ * starting at *index, until either the list is exhausted, or slice_end is
+ * reached (no slicing if it is (hsize_t) -1), or the next element would not
+ * fit in the capacity of the buffer, or an element is not a list cell; *list
+ * and *index are updated accordingly, and each element is checked (tuple
+ * arity, and type and range of each cell)
+ *
+ * - make_list_<name>(), prepending to tail the cells of the buffer in [from,to[
+ *
+ */
+#define DEFINE_CELL_KERNELS( name, ctype, MAKE_TERM )                   \
+  static const char * encode_list_##name( ErlNifEnv* env,              \
+	ERL_NIF_TERM* list, int tuple_size, void* buffer, hsize_t* index,   \
+	hsize_t slice_end, hsize_t capacity )                               \
+  {                                                                     \
+	ctype * target = (ctype *) buffer ;                                 \
+	hsize_t i = *index ;                                                \
+	ERL_NIF_TERM head, tail ;                                           \
+	const char * error = NULL ;                                         \
+	while ( i < slice_end                                               \
+	  && enif_get_list_cell( env, *list, &head, &tail ) )               \
+	{                                                                   \
+	  if ( tuple_size == 0 )                                            \
+	  {                                                                 \
+		if ( i >= capacity )                                            \
+		  break ;                                                       \
+		if ( ( error = get_##name##_cell( env, head, target + i ) ) )   \
+		  break ;                                                       \
+		i++ ;                                                           \
+	  }                                                                 \
+	  else                                                              \
+	  {                                                                 \
+		int arity ;                                                     \
+		const ERL_NIF_TERM * cells ;                                    \
+		if ( ! enif_get_tuple( env, head, &arity, &cells ) )            \
+		{                                                               \
+		  error = "Cannot get tuples from the input list" ;             \
+		  break ;                                                       \
+		}                                                               \
+		if ( arity != tuple_size )                                      \
+		{                                                               \
+		  error = "Non-uniform tuple size detected" ;                   \
+		  break ;                                                       \
+		}                                                               \
+		if ( i + arity > capacity )                                     \
+		  break ;                                                       \
+		int c ;                                                         \
+		for ( c = 0; c < arity && ! error; c++ )                        \
+		  error = get_##name##_cell( env, cells[c], target + i + c ) ;  \
+		if ( error )                                                    \
+		  break ;                                                       \
+		i += arity ;                                                    \
+	  }                                                                 \
+	  *list = tail ;                                                    \
+	}                                                                   \
+	*index = i ;                                                        \
+	return error ;                                                      \
+  }                                                                     \
+                                                                        \
+  static ERL_NIF_TERM make_list_##name( ErlNifEnv* env,                \
+	const void* buffer, hsize_t from, hsize_t to, ERL_NIF_TERM tail )   \
+  {                                                                     \
+	const ctype * source = (const ctype *) buffer ;                     \
+	hsize_t i = to ;                                                    \
+	while ( i > from )                                                  \
+	{                                                                   \
+	  i-- ;                                                             \
+	  tail = enif_make_list_cell( env, MAKE_TERM( env, source[i] ),     \
+		tail ) ;                                                        \
+	}                                                                   \
+	return tail ;                                                       \
+  }
+
+
+DEFINE_CELL_KERNELS( int8,  int8_t,  MAKE_SIGNED_TERM )
+DEFINE_CELL_KERNELS( int16, int16_t, MAKE_SIGNED_TERM )
+DEFINE_CELL_KERNELS( int32, int32_t, MAKE_SIGNED_TERM )
+DEFINE_CELL_KERNELS( int64, int64_t, MAKE_SIGNED_TERM )
+
+DEFINE_CELL_KERNELS( uint8,  uint8_t,  MAKE_UNSIGNED_TERM )
+DEFINE_CELL_KERNELS( uint16, uint16_t, MAKE_UNSIGNED_TERM )
+DEFINE_CELL_KERNELS( uint32, uint32_t, MAKE_UNSIGNED_TERM )
+DEFINE_CELL_KERNELS( uint64, uint64_t, MAKE_UNSIGNED_TERM )
+
+DEFINE_CELL_KERNELS( float32, float,  MAKE_FLOAT_TERM )
+DEFINE_CELL_KERNELS( float64, double, MAKE_FLOAT_TERM )
+
+
+
+typedef const char * (*list_encoder)( ErlNifEnv* env, ERL_NIF_TERM* list,
+  int tuple_size, void* buffer, hsize_t* index, hsize_t slice_end,
+  hsize_t capacity ) ;
+
+typedef ERL_NIF_TERM (*list_maker)( ErlNifEnv* env, const void* buffer,
+  hsize_t from, hsize_t to, ERL_NIF_TERM tail ) ;
+
+
+// The kernels and size of each cell type:
+typedef struct
+{
+
+  list_encoder encode ;
+
+  list_maker make ;
+
+  size_t size ;
+
+} CellKernels ;
+
+
+#define CELL_KERNELS( name, ctype ) \
+  { encode_list_##name, make_list_##name, sizeof( ctype ) }
+
+static const CellKernels cell_kernels[ CELL_TYPE_COUNT ] =
+{
+
+  [ INT8_CELL ]    = CELL_KERNELS( int8,    int8_t ),
+  [ INT16_CELL ]   = CELL_KERNELS( int16,   int16_t ),
+  [ INT32_CELL ]   = CELL_KERNELS( int32,   int32_t ),
+  [ INT64_CELL ]   = CELL_KERNELS( int64,   int64_t ),
+  [ UINT8_CELL ]   = CELL_KERNELS( uint8,   uint8_t ),
+  [ UINT16_CELL ]  = CELL_KERNELS( uint16,  uint16_t ),
+  [ UINT32_CELL ]  = CELL_KERNELS( uint32,  uint32_t ),
+  [ UINT64_CELL ]  = CELL_KERNELS( uint64,  uint64_t ),
+  [ FLOAT32_CELL ] = CELL_KERNELS( float32, float ),
+  [ FLOAT64_CELL ] = CELL_KERNELS( float64, double )
+
+} ;
+
+
+
+/*
+ * Returns the predefined HDF5 memory type corresponding to specified cell type
+ * (a negative value for UNKNOWN_TYPE).
+ *
+ */
+hid_t get_native_cell_type( cell_type type )
+{
+
+  // Not constants (library-initialized variables), hence not in the table:
+  switch( type )
+  {
+
+  case INT8_CELL:
+	return H5T_NATIVE_INT8 ;
+
+  case INT16_CELL:
+	return H5T_NATIVE_INT16 ;
+
+  case INT32_CELL:
+	return H5T_NATIVE_INT32 ;
+
+  case INT64_CELL:
+	return H5T_NATIVE_INT64 ;
+
+  case UINT8_CELL:
+	return H5T_NATIVE_UINT8 ;
+
+  case UINT16_CELL:
+	return H5T_NATIVE_UINT16 ;
+
+  case UINT32_CELL:
+	return H5T_NATIVE_UINT32 ;
+
+  case UINT64_CELL:
+	return H5T_NATIVE_UINT64 ;
+
+  case FLOAT32_CELL:
+	return H5T_NATIVE_FLOAT ;
+
+  case FLOAT64_CELL:
+	return H5T_NATIVE_DOUBLE ;
+
+  default:
+	return -1 ;
+
+  }
+
+}
+
+
+
+/*
+ * Returns the cell type matching specified HDF5 datatype (either a memory one,
+ * or the one of a dataset, whatever its byte order), or UNKNOWN_TYPE if it is
+ * not a supported numeric type.
+ *
+ */
+cell_type get_cell_type( hid_t type_id )
+{
+
+  hid_t native_type_id = H5Tget_native_type( type_id, H5T_DIR_ASCEND ) ;
+
+  if ( native_type_id < 0 )
+	return UNKNOWN_TYPE ;
+
+  cell_type res = UNKNOWN_TYPE ;
+
+  int type ;
+
+  for ( type = INT8_CELL; type < CELL_TYPE_COUNT; type++ )
+	if ( H5Tequal( native_type_id, get_native_cell_type( type ) ) > 0 )
+	{
+	  res = type ;
+	  break ;
+	}
+
+  H5Tclose( native_type_id ) ;
+
+  return res ;
+
+}
+
+
+
+// Returns the cell type of specified dataset (UNKNOWN_TYPE if not numeric).
+cell_type get_dataset_cell_type( hid_t dataset_id )
+{
+
+  hid_t type_id = H5Dget_type( dataset_id ) ;
+
+  if ( type_id < 0 )
+	return UNKNOWN_TYPE ;
+
+  cell_type res = get_cell_type( type_id ) ;
+
+  H5Tclose( type_id ) ;
+
+  return res ;
+
+}
+
+
+
+// Returns the size in bytes of a cell of specified type (0 if unknown).
+size_t get_cell_size( cell_type type )
+{
+
+  if ( type <= UNKNOWN_TYPE || type >= CELL_TYPE_COUNT )
+	return 0 ;
+
+  return cell_kernels[ type ].size ;
+
+}
+
+
+
+/*
+ * Converts, with the kernel of specified type, the cells of the list pointed
+ * to by list into specified buffer (see DEFINE_CELL_KERNELS above).
+ *
+ * Returns NULL on success, otherwise an error message.
+ *
+ */
+const char * encode_cell_list( ErlNifEnv* env, cell_type type,
+  ERL_NIF_TERM* list, int tuple_size, void* buffer, hsize_t* index,
+  hsize_t slice_end, hsize_t capacity )
+{
+
+  if ( type <= UNKNOWN_TYPE || type >= CELL_TYPE_COUNT )
+	return "Unsupported cell type" ;
+
+  return cell_kernels[ type ].encode( env, list, tuple_size, buffer, index,
+	slice_end, capacity ) ;
+
+}
+
+
+
+/*
+ * Decodes, in a single pass, the cells of the list pointed to by list into
+ * *buffer, which is allocated if NULL, and grown geometrically whenever full
+ * (*capacity being its size, in cells), so that the list does not have to be
+ * walked beforehand to determine its length.
+ *
+ * Decoding stops once the list is exhausted, or once slice_end is reached (no
+ * slicing if it is (hsize_t) -1); *list and *index are updated accordingly.
+ *
+ * Returns NULL on success, otherwise an error message; in all cases, *buffer
+ * is then owned by the caller.
+ *
+ */
+const char * decode_cell_list( ErlNifEnv* env, cell_type type,
+  ERL_NIF_TERM* list, int tuple_size, void** buffer, hsize_t* capacity,
+  hsize_t* index, hsize_t slice_end )
+{
+
+  size_t cell_size = get_cell_size( type ) ;
+
+  if ( cell_size == 0 )
+	return "Unsupported cell type" ;
+
+  while ( true )
+  {
+
+	if ( *buffer )
+	{
+
+	  const char * error = cell_kernels[ type ].encode( env, list, tuple_size,
+		*buffer, index, slice_end, *capacity ) ;
+
+	  if ( error )
+		return error ;
+
+	  if ( enif_is_empty_list( env, *list ) || *index >= slice_end )
+		return NULL ;
+
+	  if ( ! enif_is_list( env, *list ) )
+		return "Improper input list" ;
+
+	}
+
+	// Here the buffer is either not allocated yet, or full:
+	hsize_t new_capacity = ( *capacity < INITIAL_DECODE_CELLS ) ?
+	  INITIAL_DECODE_CELLS : 2 * *capacity ;
+
+	void * new_buffer = enif_realloc( *buffer, new_capacity * cell_size ) ;
+
+	if ( ! new_buffer )
+	  return "Cannot allocate intermediate array memory" ;
+
+	*buffer = new_buffer ;
+	*capacity = new_capacity ;
+
+  }
+
+}
+
+
+
+/*
+ * Prepends to specified tail, with the kernel of specified type, the cells of
+ * specified buffer whose indexes are in [from,to[.
+ *
+ */
+ERL_NIF_TERM make_cell_list( ErlNifEnv* env, cell_type type,
+  const void* buffer, hsize_t from, hsize_t to, ERL_NIF_TERM tail )
+{
+
+  if ( type <= UNKNOWN_TYPE || type >= CELL_TYPE_COUNT )
+	return tail ;
+
+  return cell_kernels[ type ].make( env, buffer, from, to, tail ) ;
+
+}
@@ -0,0 +1,447 @@
+/* This file is part of erlhdf5 */
+
+/* erlhdf5 is free software: you can redistribute it and/or modify */
+/* it under the terms of the GNU Lesser General Public License as */
+/* published by the Free Software Foundation, either version 3 of */
+/* the License, or (at your option) any later version. */
+
+/* erlhdf5 is distributed in the hope that it will be useful, */
+/* but WITHOUT ANY WARRANTY; without even the implied warranty of */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the */
+/* GNU Lesser General Public License for more details. */
+
+/* You should have received a copy of the GNU Lesser General Public */
+/* License along with erlhdf5.  If not, see */
+/* <http://www.gnu.org/licenses/>. */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "hdf5.h"
+
+#include "erl_nif.h"
+
+#include "dbg.h"
+
+#include "erlhdf5.h"
+
+
+/*
+ * HDF5 executor: a single, NIF-owned OS thread performing, in turn, the HDF5
+ * calls submitted by the asynchronous NIFs (ex: h5dwrite_async/3).
+ *
+ * The submitting NIF only copies its arguments and enqueues a job, returning
+ * immediately a reference; once the job has been executed, the caller is sent
+ * a {erlhdf5_reply, Ref, Result} message, Result being what the synchronous
+ * version of that call would have returned.
+ *
+ * The executor still takes the HDF5 lock for each job, so that asynchronous
+ * and synchronous calls can be freely mixed.
+ *
+ * It also performs the closes deferred by the destructors of handles (see
+ * erlhdf5_handle.c), and the tasks deferred by other destructors (ex: the
+ * final flush of an append buffer), which send no reply.
+ *
+ */
+
+
+// Maximum number of arguments of a submitted call:
+#define MAX_JOB_ARGS 8
+
+
+// A pending call to perform on behalf of an Erlang process, a close or a task.
+typedef struct Job
+{
+
+  // Process-independent environment owning all the terms of this job (NULL
+  // for a close or a task):
+  ErlNifEnv * env ;
+
+  // The (synchronous) implementation of the call (NULL for a close or a task):
+  nif_function fun ;
+
+  // For a close, the kind and identifier of the object to close:
+  handle_kind close_kind ;
+  hid_t close_id ;
+
+  // For a task, the function to run and its argument:
+  executor_task task ;
+  void * task_arg ;
+
+  int argc ;
+
+  ERL_NIF_TERM argv[ MAX_JOB_ARGS ] ;
+
+  // The reference returned to the caller, to match the reply:
+  ERL_NIF_TERM ref ;
+
+  // The process to notify:
+  ErlNifPid caller ;
+
+  struct Job * next ;
+
+} Job ;
+
+
+// FIFO of pending jobs, protected by queue_mutex:
+static Job * queue_head = NULL ;
+static Job * queue_tail = NULL ;
+
+static ErlNifMutex * queue_mutex = NULL ;
+
+// Signaled whenever a job is enqueued or a stop is requested:
+static ErlNifCond * queue_cond = NULL ;
+
+static bool stop_requested = false ;
+
+static bool executor_running = false ;
+
+static ErlNifTid executor_tid ;
+
+static ERL_NIF_TERM atom_erlhdf5_reply ;
+
+
+
+// Frees specified job, and the terms it owns.
+static void free_job( Job * job )
+{
+
+  if ( job->env )
+	enif_free_env( job->env ) ;
+
+  enif_free( job ) ;
+
+}
+
+
+
+// Main loop of the executor thread.
+static void * executor_loop( void * arg )
+{
+
+  while ( true )
+  {
+
+	enif_mutex_lock( queue_mutex ) ;
+
+	while ( queue_head == NULL && ! stop_requested )
+	  enif_cond_wait( queue_cond, queue_mutex ) ;
+
+	if ( queue_head == NULL )
+	{
+
+	  // Stop requested, and no job left:
+	  enif_mutex_unlock( queue_mutex ) ;
+	  break ;
+
+	}
+
+	Job * job = queue_head ;
+
+	queue_head = job->next ;
+
+	if ( queue_head == NULL )
+	  queue_tail = NULL ;
+
+	enif_mutex_unlock( queue_mutex ) ;
+
+	if ( job->task )
+	{
+
+	  hdf5_lock() ;
+	  job->task( job->task_arg ) ;
+	  hdf5_unlock() ;
+
+	  free_job( job ) ;
+
+	  continue ;
+
+	}
+
+	if ( ! job->fun )
+	{
+
+	  hdf5_lock() ;
+	  close_hdf5_object( job->close_kind, job->close_id ) ;
+	  hdf5_unlock() ;
+
+	  free_job( job ) ;
+
+	  continue ;
+
+	}
+
+	hdf5_lock() ;
+
+	ERL_NIF_TERM result = job->fun( job->env, job->argc, job->argv ) ;
+
+	hdf5_unlock() ;
+
+	ERL_NIF_TERM reply = enif_make_tuple3( job->env, atom_erlhdf5_reply,
+	  job->ref, result ) ;
+
+	// Not from a scheduler thread, hence no caller environment:
+	enif_send( NULL, &job->caller, job->env, reply ) ;
+
+	free_job( job ) ;
+
+  }
+
+  return NULL ;
+
+}
+
+
+
+/*
+ * Starts the executor thread.
+ *
+ * Returns 0 on success, -1 on failure.
+ *
+ */
+int executor_start( ErlNifEnv* env )
+{
+
+  atom_erlhdf5_reply = enif_make_atom( env, "erlhdf5_reply" ) ;
+
+  queue_mutex = enif_mutex_create( "erlhdf5_executor_queue" ) ;
+  check( queue_mutex, "Unable to create the executor queue lock" ) ;
+
+  queue_cond = enif_cond_create( "erlhdf5_executor_cond" ) ;
+  check( queue_cond, "Unable to create the executor condition" ) ;
+
+  stop_requested = false ;
+
+  check( enif_thread_create( "erlhdf5_executor", &executor_tid,
+	  executor_loop, NULL, NULL ) == 0,
+	"Unable to create the executor thread" ) ;
+
+  executor_running = true ;
+
+  return 0 ;
+
+ error:
+  if ( queue_cond )
+  {
+	enif_cond_destroy( queue_cond ) ;
+	queue_cond = NULL ;
+  }
+
+  if ( queue_mutex )
+  {
+	enif_mutex_destroy( queue_mutex ) ;
+	queue_mutex = NULL ;
+  }
+
+  return -1 ;
+
+}
+
+
+
+/*
+ * Stops the executor thread, once all already-submitted jobs have been
+ * performed.
+ *
+ */
+void executor_stop()
+{
+
+  if ( ! executor_running )
+	return ;
+
+  enif_mutex_lock( queue_mutex ) ;
+  stop_requested = true ;
+  enif_cond_signal( queue_cond ) ;
+  enif_mutex_unlock( queue_mutex ) ;
+
+  enif_thread_join( executor_tid, NULL ) ;
+
+  executor_running = false ;
+
+  /*
+   * The queue lock and condition are not destroyed, as the destructors of
+   * handles may still try to submit closes afterwards.
+   *
+   */
+
+}
+
+
+
+/*
+ * Appends specified job to the queue, and wakes up the executor.
+ *
+ * Returns false if the executor is stopping (then the job is not enqueued).
+ *
+ */
+static bool enqueue_job( Job * job )
+{
+
+  enif_mutex_lock( queue_mutex ) ;
+
+  // Once a stop is requested, the queue may not be processed anymore:
+  if ( stop_requested )
+  {
+
+	enif_mutex_unlock( queue_mutex ) ;
+
+	return false ;
+
+  }
+
+  if ( queue_tail )
+	queue_tail->next = job ;
+  else
+	queue_head = job ;
+
+  queue_tail = job ;
+
+  enif_cond_signal( queue_cond ) ;
+
+  enif_mutex_unlock( queue_mutex ) ;
+
+  return true ;
+
+}
+
+
+
+/*
+ * Submits to the executor a call to specified (synchronous) NIF
+ * implementation, with specified arguments, on behalf of the calling process.
+ *
+ * Returns { 'ok', reference() } | error().
+ *
+ */
+ERL_NIF_TERM submit_async_job( ErlNifEnv* env, nif_function fun, int argc,
+  const ERL_NIF_TERM argv[] )
+{
+
+  if ( argc > MAX_JOB_ARGS )
+	return error_tuple( env, "Too many arguments for an asynchronous call" ) ;
+
+  if ( ! executor_running )
+	return error_tuple( env, "Executor not running" ) ;
+
+  Job * job = enif_alloc( sizeof( Job ) ) ;
+
+  if ( ! job )
+	return error_tuple( env, "Cannot allocate job" ) ;
+
+  job->env = enif_alloc_env() ;
+
+  if ( ! job->env )
+  {
+	enif_free( job ) ;
+	return error_tuple( env, "Cannot allocate job environment" ) ;
+  }
+
+  if ( ! enif_self( env, &job->caller ) )
+  {
+	free_job( job ) ;
+	return error_tuple( env, "Cannot determine calling process" ) ;
+  }
+
+  job->fun = fun ;
+  job->task = NULL ;
+  job->argc = argc ;
+
+  int i ;
+
+  // The arguments must outlive the calling NIF, hence are copied:
+  for ( i = 0; i < argc; i++ )
+	job->argv[i] = enif_make_copy( job->env, argv[i] ) ;
+
+  ERL_NIF_TERM ref = enif_make_ref( env ) ;
+
+  job->ref = enif_make_copy( job->env, ref ) ;
+
+  job->next = NULL ;
+
+  if ( ! enqueue_job( job ) )
+  {
+	free_job( job ) ;
+	return error_tuple( env, "Executor not running" ) ;
+  }
+
+  return enif_make_tuple2( env, atom_ok, ref ) ;
+
+}
+
+
+
+/*
+ * Submits to the executor the close of specified HDF5 object (typically from
+ * the destructor of a handle, which could not take the HDF5 lock).
+ *
+ * Returns whether the close could be submitted.
+ *
+ */
+bool submit_close_job( handle_kind kind, hid_t id )
+{
+
+  if ( ! queue_mutex )
+	return false ;
+
+  Job * job = enif_alloc( sizeof( Job ) ) ;
+
+  if ( ! job )
+	return false ;
+
+  job->env = NULL ;
+  job->fun = NULL ;
+  job->task = NULL ;
+  job->argc = 0 ;
+  job->close_kind = kind ;
+  job->close_id = id ;
+  job->next = NULL ;
+
+  if ( ! enqueue_job( job ) )
+  {
+	free_job( job ) ;
+	return false ;
+  }
+
+  return true ;
+
+}
+
+
+
+/*
+ * Submits to the executor specified task, run with the HDF5 lock held
+ * (typically from a destructor, which must not perform HDF5 I/O itself); the
+ * task owns its argument.
+ *
+ * Returns whether the task could be submitted.
+ *
+ */
+bool submit_task_job( executor_task task, void* arg )
+{
+
+  if ( ! queue_mutex )
+	return false ;
+
+  Job * job = enif_alloc( sizeof( Job ) ) ;
+
+  if ( ! job )
+	return false ;
+
+  job->env = NULL ;
+  job->fun = NULL ;
+  job->task = task ;
+  job->task_arg = arg ;
+  job->argc = 0 ;
+  job->next = NULL ;
+
+  if ( ! enqueue_job( job ) )
+  {
+	free_job( job ) ;
+	return false ;
+  }
+
+  return true ;
+
+}
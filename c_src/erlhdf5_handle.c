@@ -0,0 +1,296 @@
+/* This file is part of erlhdf5 */
+
+/* erlhdf5 is free software: you can redistribute it and/or modify */
+/* it under the terms of the GNU Lesser General Public License as */
+/* published by the Free Software Foundation, either version 3 of */
+/* the License, or (at your option) any later version. */
+
+/* erlhdf5 is distributed in the hope that it will be useful, */
+/* but WITHOUT ANY WARRANTY; without even the implied warranty of */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the */
+/* GNU Lesser General Public License for more details. */
+
+/* You should have received a copy of the GNU Lesser General Public */
+/* License along with erlhdf5.  If not, see */
+/* <http://www.gnu.org/licenses/>. */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "hdf5.h"
+
+#include "erl_nif.h"
+
+#include "dbg.h"
+
+#include "erlhdf5.h"
+
+
+/*
+ * Handles: all the HDF5 identifiers returned to Erlang are wrapped in NIF
+ * resources, one resource type per kind of object, so that:
+ *
+ * - a handle of a kind cannot be mistaken for one of another kind
+ *
+ * - a handle that was not explicitly closed (ex: because its owning process
+ * crashed) is closed when garbage-collected, so that the open-object tables
+ * of the library do not grow unbounded
+ *
+ */
+
+
+static ErlNifResourceType* handle_types[ HANDLE_KIND_COUNT ] ;
+
+
+static const char * handle_type_names[ HANDLE_KIND_COUNT ] = {
+  "FileHandle", "DatasetHandle", "DataspaceHandle", "DatatypeHandle",
+  "PropertyListHandle" } ;
+
+
+
+// Closes specified identifier, according to its kind (HDF5 lock to be held).
+herr_t close_hdf5_object( handle_kind kind, hid_t id )
+{
+
+  switch( kind )
+  {
+
+  case FILE_HANDLE:
+	return H5Fclose( id ) ;
+
+  case DATASET_HANDLE:
+	return H5Dclose( id ) ;
+
+  case DATASPACE_HANDLE:
+	return H5Sclose( id ) ;
+
+  case DATATYPE_HANDLE:
+	return H5Tclose( id ) ;
+
+  case PROPLIST_HANDLE:
+	return H5Pclose( id ) ;
+
+  default:
+	return -1 ;
+
+  }
+
+}
+
+
+
+/*
+ * Closes specified identifier from a resource destructor, possibly called from
+ * any thread.
+ *
+ * As the HDF5 lock may be held at this point (possibly by the current thread),
+ * if it cannot be taken immediately the close is deferred to the executor.
+ *
+ */
+void release_hdf5_object( handle_kind kind, hid_t id )
+{
+
+  if ( hdf5_try_lock() )
+  {
+
+	close_hdf5_object( kind, id ) ;
+	hdf5_unlock() ;
+
+  }
+  else if ( ! submit_close_job( kind, id ) )
+  {
+
+	// Executor already stopped (unloading), hence no concurrent HDF5 call:
+	hdf5_lock() ;
+	close_hdf5_object( kind, id ) ;
+	hdf5_unlock() ;
+
+  }
+
+}
+
+
+
+// Called when a handle is garbage-collected.
+static void handle_destructor( ErlNifEnv* env, void* obj )
+{
+
+  Handle* handle = (Handle*) obj ;
+
+  if ( handle->id < 0 || ! handle->owned )
+	return ;
+
+  release_hdf5_object( handle->kind, handle->id ) ;
+
+  handle->id = -1 ;
+
+}
+
+
+
+/*
+ * Opens the resource types of the handles.
+ *
+ * Returns 0 on success, -1 on failure.
+ *
+ */
+int open_handle_resource_types( ErlNifEnv* env )
+{
+
+  int kind ;
+
+  for ( kind = 0; kind < HANDLE_KIND_COUNT; kind++ )
+  {
+
+	handle_types[ kind ] = enif_open_resource_type( env, "erlhdf5",
+	  handle_type_names[ kind ], handle_destructor,
+	  ERL_NIF_RT_CREATE | ERL_NIF_RT_TAKEOVER, NULL ) ;
+
+	if ( ! handle_types[ kind ] )
+	  return -1 ;
+
+  }
+
+  return 0 ;
+
+}
+
+
+
+// Returns a handle term of specified kind, wrapping specified identifier.
+static ERL_NIF_TERM make_handle_term( ErlNifEnv* env, handle_kind kind,
+  hid_t id, bool owned )
+{
+
+  Handle* handle = enif_alloc_resource( handle_types[ kind ],
+	sizeof( Handle ) ) ;
+
+  if ( ! handle )
+  {
+
+	if ( owned )
+	  close_hdf5_object( kind, id ) ;
+
+	return error_tuple( env, "Cannot allocate handle" ) ;
+
+  }
+
+  handle->id = id ;
+  handle->kind = kind ;
+  handle->owned = owned ;
+  handle->cells = ( kind == DATASET_HANDLE ) ?
+	get_dataset_cell_type( id ) : UNKNOWN_TYPE ;
+
+  handle->zone_map = false ;
+  handle->zone_map_generation = 0 ;
+
+  if ( kind == DATASET_HANDLE )
+	check_zone_map( handle ) ;
+
+  ERL_NIF_TERM term = enif_make_resource( env, handle ) ;
+
+  // The term is now the only owner of the handle:
+  enif_release_resource( handle ) ;
+
+  return enif_make_tuple2( env, atom_ok, term ) ;
+
+}
+
+
+
+/*
+ * Returns { 'ok', Handle }, Handle being a new handle of specified kind, owning
+ * (hence closing, at the latest on garbage collection) specified identifier;
+ * returns an error tuple (and closes the identifier) on failure.
+ *
+ */
+ERL_NIF_TERM make_handle( ErlNifEnv* env, handle_kind kind, hid_t id )
+{
+
+  return make_handle_term( env, kind, id, /* owned */ true ) ;
+
+}
+
+
+
+/*
+ * Returns { 'ok', Handle }, like make_handle/3, except that the identifier is
+ * not owned by the handle, and thus will never be closed by it.
+ *
+ */
+ERL_NIF_TERM make_unowned_handle( ErlNifEnv* env, handle_kind kind, hid_t id )
+{
+
+  return make_handle_term( env, kind, id, /* owned */ false ) ;
+
+}
+
+
+
+/*
+ * Gets the handle of specified kind from specified term, even if already
+ * closed.
+ *
+ * Returns whether it succeeded.
+ *
+ */
+bool get_handle( ErlNifEnv* env, ERL_NIF_TERM term, handle_kind kind,
+  Handle** handle )
+{
+
+  return enif_get_resource( env, term, handle_types[ kind ],
+	(void**) handle ) ;
+
+}
+
+
+
+/*
+ * Gets the identifier of the (still open) handle of specified kind from
+ * specified term.
+ *
+ * Returns whether it succeeded.
+ *
+ */
+bool get_handle_id( ErlNifEnv* env, ERL_NIF_TERM term, handle_kind kind,
+  hid_t* id )
+{
+
+  Handle* handle ;
+
+  if ( ! get_handle( env, term, kind, &handle ) || handle->id < 0 )
+	return false ;
+
+  *id = handle->id ;
+
+  return true ;
+
+}
+
+
+
+/*
+ * Closes explicitly specified handle, which cannot be used afterwards (HDF5
+ * lock to be held).
+ *
+ * Returns a negative value on failure (ex: if already closed).
+ *
+ */
+herr_t close_handle( Handle* handle )
+{
+
+  if ( handle->id < 0 )
+	return -1 ;
+
+  herr_t res = 0 ;
+
+  if ( handle->owned )
+	res = close_hdf5_object( handle->kind, handle->id ) ;
+
+  if ( res >= 0 )
+	handle->id = -1 ;
+
+  return res ;
+
+}
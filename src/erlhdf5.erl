@@ -26,16 +26,25 @@
 
 
 % H5F, about HDF5 files:
--export( [ h5fcreate/2, h5fopen/2, h5fclose/1 ] ).
+-export( [ h5fcreate/2, h5fcreate/3, h5fcreate/4, h5fopen/2, h5fopen/3,
+		   h5fclose/1, h5f_open_image/1, h5f_open_image/2, h5f_get_image/1,
+		   h5fstart_swmr_write/1 ] ).
 
 
 % H5S, about dataspaces:
--export( [ h5screate_simple/2, h5sclose/1, h5sget_simple_extent_dims/2,
-		   h5sget_simple_extent_ndims/1, h5sselect_hyperslab/6 ] ).
+-export( [ h5screate_simple/2, h5screate_simple/3, h5sclose/1,
+		   h5sget_simple_extent_dims/2, h5sget_simple_extent_ndims/1,
+		   h5sselect_hyperslab/6, h5sselect_elements/3 ] ).
 
 
 % H5P, about property lists:
--export( [ h5pcreate/1, h5pclose/1 ] ).
+-export( [ h5pcreate/1, h5pclose/1, h5pset_chunk/3,
+		   h5pset_deflate/2, h5pset_shuffle/1, h5pset_fletcher32/1,
+		   h5pset_nbit/1, h5pset_scaleoffset/3, h5pset_chunk_cache/4,
+		   h5pset_fapl_core/3,
+		   h5pset_mdc_size/4, h5pset_sieve_buf_size/2, h5pset_alignment/3,
+		   h5pset_libver_bounds/3, h5pset_page_buffer_size/4,
+		   h5pset_file_space_strategy/4, h5pset_file_space_page_size/2 ] ).
 
 
 % H5T, about datatypes:
@@ -45,11 +54,32 @@
 
 
 % H5D, about datasets:
--export( [ h5dcreate/5, h5dopen/2, h5dopen/3, h5dclose/1, h5dget_type/1,
+-export( [ h5dcreate/5, h5dopen/2, h5dopen/3, h5dclose/1,
+		   h5dflush/1, h5drefresh/1, h5dget_type/1,
 		   h5d_get_space_status/1, h5dwrite/2, h5dwrite/3,
+		   h5dwrite_binary/3, h5dwrite_binary/4,
+		   h5dread/3, h5dread_binary/3,
+		   h5dwrite_block/4, h5dread_block/4,
+		   h5dwrite_points/4, h5dread_points/3,
+		   h5dappend/2, h5dappend_binary/3,
+		   h5d_prepare_write/3, h5d_exec_write/3,
+		   h5d_create_buffer/4, h5d_buffer_append/2, h5d_flush_buffer/1,
+		   h5d_buffer_info/1, h5d_aggregate/3,
+		   h5d_histogram/3, h5d_sketch/3, sketch_merge/1, sketch_quantiles/2,
+		   h5d_read_downsampled/4, h5d_scan/3, h5d_scan/4,
+		   h5d_create_zone_map/1, h5d_get_zone_map/1,
 		   h5d_get_storage_size/1, h5dget_space/1 ] ).
 
 
+% Asynchronous variants, performed by the HDF5 executor:
+-export( [ h5fclose_async/1,
+		   h5dwrite_async/2, h5dwrite_async/3,
+		   h5dwrite_binary_async/3, h5dwrite_binary_async/4,
+		   h5dread_async/3, h5dread_binary_async/3,
+		   h5lt_read_dataset_int_async/2, h5lt_read_dataset_double_async/2,
+		   wait_reply/1, wait_reply/2 ] ).
+
+
 % H5LT, about HDF5 Lite:
 -export( [ h5lt_make_dataset/5,
 
@@ -64,8 +94,8 @@
 -include( "../include/erlhdf5.hrl" ).
 
 
-% Number of elements (ex: in a dimension):
--type size() :: integer().
+% Number of elements (ex: in a dimension), or offset; up to 64 bits:
+-type size() :: non_neg_integer().
 
 
 % A tuple whose elements are of type size(), corresponding to as many
@@ -82,12 +112,39 @@
 -type selection_operator() :: 'H5S_SELECT_SET' | 'H5S_SELECT_OR'.
 
 
--type handle() :: integer().
+% Either replaces the existing point selection, or adds points after or before
+% the already selected ones.
+%
+-type point_selection_operator() :: 'H5S_SELECT_SET' | 'H5S_SELECT_APPEND'
+								  | 'H5S_SELECT_PREPEND'.
+
+
+% Coordinates of a set of points, packed as native unsigned 64-bit integers,
+% rank of them per point (ex: <<Row:64/native, Col:64/native, ...>>):
+%
+-type coordinates() :: binary().
+
+
+% Handles are opaque NIF resources: each is bound to a kind of HDF5 object
+% (file, dataset, dataspace, datatype or property list), and the object is
+% closed as soon as its handle is garbage-collected, should it not have been
+% explicitly closed before.
+%
+-opaque handle() :: reference().
 
 -type file_handle()          :: handle().
 -type dataset_handle()       :: handle().
 -type dataspace_handle()     :: handle().
 
+% A selection in a file: either a dataspace or the full extent of a dataset:
+-type file_dataspace()       :: dataspace_handle() | 'H5S_ALL'.
+
+% Name of a predefined datatype; the numeric ones, which can be used as cell
+% types, are 'H5T_NATIVE_INT8', 'H5T_NATIVE_INT16', 'H5T_NATIVE_INT32',
+% 'H5T_NATIVE_INT64', their 'H5T_NATIVE_UINT*' unsigned counterparts,
+% 'H5T_NATIVE_FLOAT' (32-bit), 'H5T_NATIVE_DOUBLE' (64-bit), and the
+% platform-dependent 'H5T_NATIVE_INT' and 'H5T_NATIVE_LONG'.
+%
 -type datatype_name()        :: atom().
 -type datatype_handle()      :: handle().
 
@@ -95,15 +152,113 @@
 
 -type dataset_creation_proplist() :: property_list_handle().
 -type dataset_access_proplist()   :: property_list_handle().
+-type file_creation_proplist()    :: property_list_handle().
+-type file_access_proplist()      :: property_list_handle().
+
+% Library version bound, determining which file format versions may be used:
+-type libver() :: 'H5F_LIBVER_EARLIEST' | 'H5F_LIBVER_V18' | 'H5F_LIBVER_V110'
+				| 'H5F_LIBVER_LATEST'.
+
+-type file_space_strategy() :: 'H5F_FSPACE_STRATEGY_FSM_AGGR'
+							 | 'H5F_FSPACE_STRATEGY_PAGE'
+							 | 'H5F_FSPACE_STRATEGY_AGGR'
+							 | 'H5F_FSPACE_STRATEGY_NONE'.
 
 -type dataset_name() :: string().
 
 
+% Prepared writing of same-shape blocks into a dataset (see
+% h5d_prepare_write/3); an opaque NIF resource as well:
+%
+-opaque write_plan() :: reference().
+
+
+% Write-behind buffer coalescing the appends to a dataset (see
+% h5d_create_buffer/4); an opaque NIF resource as well:
+%
+-opaque append_buffer() :: reference().
+
+% Amount of buffered data triggering a write:
+-type buffer_threshold() :: { 'rows', pos_integer() }
+						  | { 'bytes', pos_integer() }.
+
+
+% Aggregate computed over a selection of a dataset (see h5d_aggregate/3):
+-type aggregate() :: 'sum' | 'min' | 'max' | 'mean' | 'count' | 'nan_count'.
+
+% A float, or one of the atoms standing for non-finite or missing values:
+-type aggregate_value() :: number() | 'inf' | 'nan' | 'undefined'.
+
+% Bins of equal width spanning [Low, High] (see h5d_histogram/3):
+-type histogram_bins() :: { Low::number(), High::number(), pos_integer() }.
+
+% Mergeable quantile sketch, serialized in a portable binary (see
+% h5d_sketch/3):
+%
+-type sketch() :: binary().
+
+% Range of consecutive cells of a series, or all of them:
+-type series_range() :: { Start::size(), Count::size() } | 'all'.
+
+% How the buckets of a downsampled read are reduced (see
+% h5d_read_downsampled/4):
+%
+-type downsampling_mode() :: 'minmax' | 'mean' | 'lttb'.
+
+% Condition on the cells of a series (see h5d_scan/3); apart from 'ne', no
+% comparison holds for NaN cells, and ranges include their bounds:
+%
+-type predicate() :: { 'gt' | 'ge' | 'lt' | 'le' | 'eq' | 'ne', number() }
+				   | { 'between' | 'outside', Low::number(), High::number() }
+				   | 'is_nan' | 'is_inf' | 'not_finite'.
+
+% How the matches of a scan are reported (see h5d_scan/4):
+-type scan_format() :: 'indexes' | 'ranges'.
+
+% Summary of a zone of a dataset (see h5d_get_zone_map/1): the minimum and
+% maximum of its non-NaN cells, and their count, or 'undefined' if not known:
+%
+-type zone() :: { Min::aggregate_value(), Max::aggregate_value(),
+				  Count::size() } | 'undefined'.
+
+
+-type access_flag() :: 'H5F_ACC_TRUNC' | 'H5F_ACC_EXCL' | 'H5F_ACC_RDWR'
+					 | 'H5F_ACC_RDONLY' | 'H5F_ACC_SWMR_WRITE'
+					 | 'H5F_ACC_SWMR_READ'.
+
+% A single flag, or a list of flags to combine (ex: [ 'H5F_ACC_RDWR',
+% 'H5F_ACC_SWMR_WRITE' ]):
+%
+-type access_flags() :: access_flag() | [ access_flag() ].
+
+
+% How the scale-offset filter processes cells (see h5pset_scaleoffset/3):
+-type scale_type() :: 'H5Z_SO_FLOAT_DSCALE' | 'H5Z_SO_FLOAT_ESCALE'
+					| 'H5Z_SO_INT'.
+
+
 -type error() :: { 'error', Reason::string() }.
 
+
+% Reference identifying a pending asynchronous call:
+-type async_ref() :: reference().
+
+% Returned by asynchronous calls, whose result will be later sent to the caller
+% as a { 'erlhdf5_reply', async_ref(), Result } message:
+%
+-type async_result() :: { 'ok', async_ref() } | error().
+
 -type rank() :: integer().
 -type dimensions() :: tuple().
 
+% Maximum size of a dimension, possibly unbounded (then the dataset can be
+% extended at will along it, provided it is chunked):
+%
+-type max_dimension() :: size() | 'H5S_UNLIMITED'.
+
+% A tuple whose elements are of type max_dimension():
+-type max_dimensions() :: tuple().
+
 
 % Element of an array (a dataset):
 -type cell_element() :: 'native_int' | 'native_float'.
@@ -112,14 +267,28 @@
 % Data typically read or written.
 -type data() :: list(). % More precisely: list( tuple( cell_element() ) ).
 
+% A block of cells of any rank: its dimensions, and the packed cells, in
+% row-major order (the last dimension varying fastest):
+%
+-type shaped_binary() :: { size_tuple(), binary() }.
+
 
 -export_type([
 			   size/0, size_tuple/0, selection_operator/0,
+			   point_selection_operator/0, coordinates/0, handle/0,
 			   file_handle/0, dataset_handle/0, dataspace_handle/0,
+			   file_dataspace/0, write_plan/0, append_buffer/0,
+			   buffer_threshold/0, aggregate/0, aggregate_value/0,
+			   histogram_bins/0, sketch/0, series_range/0, downsampling_mode/0,
+			   predicate/0, scan_format/0, zone/0,
 			   datatype_handle/0, property_list_handle/0,
 			   dataset_creation_proplist/0, dataset_access_proplist/0,
-			   error/0, rank/0, dimensions/0,
-			   cell_element/0, data/0
+			   access_flag/0, access_flags/0,
+			   file_creation_proplist/0, file_access_proplist/0,
+			   libver/0, file_space_strategy/0, scale_type/0,
+			   error/0, async_ref/0, async_result/0, rank/0, dimensions/0,
+			   max_dimension/0, max_dimensions/0,
+			   cell_element/0, data/0, shaped_binary/0
 			 ]).
 
 
@@ -135,6 +304,7 @@
 % - H5P: about property lists
 % - H5T: about datatypes
 % - H5D: about dataset
+% - asynchronous variants
 % - H5LT: about HDF5 Lite
 % - helpers
 
@@ -174,22 +344,53 @@ get_priv_dir( Module ) ->
 
 % Creates a (new) HDF5 file.
 %
--spec h5fcreate( File::string(), Flag::atom() ) ->
+-spec h5fcreate( File::string(), access_flags() ) ->
 					   { 'ok', file_handle() } | error().
 h5fcreate( _FileName, _Flag ) ->
 	nif_error( ?LINE ).
 
 
 
+% Creates a (new) HDF5 file, with specified file access property list, as
+% created by h5pcreate( 'H5P_FILE_ACCESS' ) and remaining owned by the caller.
+%
+-spec h5fcreate( File::string(), access_flags(), file_access_proplist() ) ->
+					   { 'ok', file_handle() } | error().
+h5fcreate( _FileName, _Flag, _FileAccessPropList ) ->
+	nif_error( ?LINE ).
+
+
+
+% Creates a (new) HDF5 file, with specified file creation property list (ex:
+% to select paged aggregation) and file access property list.
+%
+-spec h5fcreate( File::string(), access_flags(), file_creation_proplist(),
+				 file_access_proplist() ) ->
+					   { 'ok', file_handle() } | error().
+h5fcreate( _FileName, _Flag, _FileCreationPropList, _FileAccessPropList ) ->
+	nif_error( ?LINE ).
+
+
+
 % Opens an (already-existing) HDF5 file.
 %
--spec h5fopen( File::string(), Flag::atom() ) ->
+-spec h5fopen( File::string(), access_flags() ) ->
 				 { 'ok', file_handle() } | error().
 h5fopen( _FileName, _Flag ) ->
 	nif_error( ?LINE ).
 
 
 
+% Opens an (already-existing) HDF5 file, with specified file access property
+% list (remaining owned by the caller).
+%
+-spec h5fopen( File::string(), access_flags(), file_access_proplist() ) ->
+				 { 'ok', file_handle() } | error().
+h5fopen( _FileName, _Flag, _FileAccessPropList ) ->
+	nif_error( ?LINE ).
+
+
+
 % Closes specified HDF5 file.
 %
 -spec h5fclose( file_handle() ) -> 'ok' | error().
@@ -198,6 +399,49 @@ h5fclose( _Handle ) ->
 
 
 
+% Switches specified file (opened read-write, with 'H5F_LIBVER_LATEST' as low
+% library version bound, see h5pset_libver_bounds/3) to Single-Writer/Multiple-
+% Reader mode: processes may then open it with [ 'H5F_ACC_RDONLY',
+% 'H5F_ACC_SWMR_READ' ] and follow the rows appended to it (see h5drefresh/1).
+%
+% Alternatively a file can be directly opened with [ 'H5F_ACC_RDWR',
+% 'H5F_ACC_SWMR_WRITE' ]. Requires HDF5 1.10 or later.
+%
+-spec h5fstart_swmr_write( file_handle() ) -> 'ok' | error().
+h5fstart_swmr_write( _Handle ) ->
+	nif_error( ?LINE ).
+
+
+
+% Opens, read-only and fully in memory, the HDF5 file whose image is specified
+% (ex: as returned by h5f_get_image/1 on another node); no disk I/O is done.
+%
+-spec h5f_open_image( Image::binary() ) -> { 'ok', file_handle() } | error().
+h5f_open_image( _Image ) ->
+	nif_error( ?LINE ).
+
+
+
+% Opens in memory the HDF5 file whose image is specified, either read-only
+% ('H5F_ACC_RDONLY') or read-write ('H5F_ACC_RDWR'); the binary is copied, so
+% that changes do not affect it.
+%
+-spec h5f_open_image( Image::binary(), access_flags() ) ->
+							{ 'ok', file_handle() } | error().
+h5f_open_image( _Image, _Flag ) ->
+	nif_error( ?LINE ).
+
+
+
+% Returns the image of specified open file, as a binary (typically for a file
+% created in memory, see h5pset_fapl_core/3).
+%
+-spec h5f_get_image( file_handle() ) -> { 'ok', Image::binary() } | error().
+h5f_get_image( _Handle ) ->
+	nif_error( ?LINE ).
+
+
+
 
 
 % H5S section: about dataspaces.
@@ -213,6 +457,17 @@ h5screate_simple( _Rank, _Dimensions ) ->
 
 
 
+% Creates a dataspace whose maximum dimensions are specified as well; a
+% dimension may be 'H5S_UNLIMITED', in which case a dataset created with this
+% dataspace can be extended along it (see h5dappend/2).
+%
+-spec h5screate_simple( rank(), dimensions(), max_dimensions() ) ->
+							  { 'ok', dataspace_handle() } | error().
+h5screate_simple( _Rank, _Dimensions, _MaxDimensions ) ->
+	nif_error( ?LINE ).
+
+
+
 % Closes a dataspace.
 %
 -spec h5sclose( dataspace_handle() ) -> 'ok' | error().
@@ -224,7 +479,7 @@ h5sclose( _Handle ) ->
 % Returns the dimension size and maximum size of specified dataspace.
 %
 -spec h5sget_simple_extent_dims( dataspace_handle(), rank() ) ->
-		 { 'ok', Dims::list(), MaxDims::list() } | error().
+		 { 'ok', Dims::[ size() ], MaxDims::[ max_dimension() ] } | error().
 h5sget_simple_extent_dims( _Handle, _Rank ) ->
 	nif_error( ?LINE ).
 
@@ -255,6 +510,16 @@ h5sselect_hyperslab( _DataspaceHandle, _SelectionOperator, _Offset, _Stride,
 
 
 
+% Selects in specified dataspace the (possibly scattered) points whose
+% coordinates are specified, in a single call whatever their number.
+%
+-spec h5sselect_elements( dataspace_handle(), point_selection_operator(),
+						  coordinates() ) -> 'ok' | error().
+h5sselect_elements( _DataspaceHandle, _SelectionOperator, _Coords ) ->
+	nif_error( ?LINE ).
+
+
+
 
 % H5P section: about property lists.
 
@@ -277,12 +542,185 @@ h5pclose( _Handle ) ->
 
 
 
+% Sets the size of the chunks used to store a dataset created with specified
+% dataset creation property list.
+%
+% Chunking is required for extendible datasets; if none is set, h5dcreate/5
+% chooses by default chunks of whole rows, of about 64 KiB.
+%
+-spec h5pset_chunk( dataset_creation_proplist(), rank(),
+					ChunkDims::size_tuple() ) -> 'ok' | error().
+h5pset_chunk( _Handle, _Rank, _ChunkDims ) ->
+	nif_error( ?LINE ).
+
+
+
+% Filters below are applied, in the order they are set, to each chunk of the
+% datasets created with specified property list; if no chunking has been set,
+% h5dcreate/5 chooses a default one.
+
+
+
+% Adds the deflate (gzip) compression filter, with specified level (from 0 to
+% 9).
+%
+-spec h5pset_deflate( dataset_creation_proplist(), Level::integer() ) ->
+							'ok' | error().
+h5pset_deflate( _Handle, _Level ) ->
+	nif_error( ?LINE ).
+
+
+
+% Adds the shuffle filter, which reorders the bytes of the cells so that a
+% subsequent compression filter (ex: deflate) is more efficient.
+%
+-spec h5pset_shuffle( dataset_creation_proplist() ) -> 'ok' | error().
+h5pset_shuffle( _Handle ) ->
+	nif_error( ?LINE ).
+
+
+
+% Adds the Fletcher32 checksum filter, to detect corrupted chunks.
+%
+-spec h5pset_fletcher32( dataset_creation_proplist() ) -> 'ok' | error().
+h5pset_fletcher32( _Handle ) ->
+	nif_error( ?LINE ).
+
+
+
+% Adds the N-Bit filter, which stores only the significant bits of the cells.
+%
+-spec h5pset_nbit( dataset_creation_proplist() ) -> 'ok' | error().
+h5pset_nbit( _Handle ) ->
+	nif_error( ?LINE ).
+
+
+
+% Adds the scale-offset filter; with 'H5Z_SO_FLOAT_DSCALE', Factor is the
+% number of decimal digits to keep (lossy compression of floating-point cells).
+%
+-spec h5pset_scaleoffset( dataset_creation_proplist(), scale_type(),
+						  Factor::integer() ) -> 'ok' | error().
+h5pset_scaleoffset( _Handle, _ScaleType, _Factor ) ->
+	nif_error( ?LINE ).
+
+
+
+% Sets the chunk cache of the datasets opened (see h5dopen/3) with specified
+% dataset access property list: number of hash slots (preferably a prime, about
+% 100 times the number of chunks that fit in the cache), size in bytes, and
+% preemption policy W0 in [0.0,1.0] (1.0 evicting first the chunks fully read
+% or written).
+%
+% The default cache (1 MiB) is often too small for random reads of compressed
+% datasets, each cache miss implying a chunk decompression.
+%
+-spec h5pset_chunk_cache( dataset_access_proplist(), Slots::size(),
+						  Bytes::size(), W0::float() ) -> 'ok' | error().
+h5pset_chunk_cache( _Handle, _Slots, _Bytes, _W0 ) ->
+	nif_error( ?LINE ).
+
+
+
+% Setters below apply to file access property lists (for h5fcreate/{3,4} and
+% h5fopen/3), unless stated otherwise.
+
+
+
+% Makes the files created or opened with specified file access property list
+% be held in memory (core driver), growing by Increment bytes when needed, and
+% being written to disk on closing only if BackingStore is true.
+%
+-spec h5pset_fapl_core( file_access_proplist(), Increment::size(),
+						BackingStore::boolean() ) -> 'ok' | error().
+h5pset_fapl_core( _Handle, _Increment, _BackingStore ) ->
+	nif_error( ?LINE ).
+
+
+
+% Sets the initial size of the metadata cache, and the bounds between which it
+% is then automatically resized (all in bytes).
+%
+-spec h5pset_mdc_size( file_access_proplist(), Initial::size(), Min::size(),
+					   Max::size() ) -> 'ok' | error().
+h5pset_mdc_size( _Handle, _Initial, _Min, _Max ) ->
+	nif_error( ?LINE ).
+
+
+
+% Sets the maximum size of the data sieve buffer (in bytes).
+%
+-spec h5pset_sieve_buf_size( file_access_proplist(), size() ) ->
+								   'ok' | error().
+h5pset_sieve_buf_size( _Handle, _Size ) ->
+	nif_error( ?LINE ).
+
+
+
+% Aligns on a multiple of Alignment bytes (ex: a RAID stripe) any file object
+% of at least Threshold bytes.
+%
+-spec h5pset_alignment( file_access_proplist(), Threshold::size(),
+						Alignment::size() ) -> 'ok' | error().
+h5pset_alignment( _Handle, _Threshold, _Alignment ) ->
+	nif_error( ?LINE ).
+
+
+
+% Sets the range of file format versions that may be used when writing objects;
+% a low bound of 'H5F_LIBVER_LATEST' selects the newest metadata structures
+% (faster on large files, but not readable by older libraries).
+%
+-spec h5pset_libver_bounds( file_access_proplist(), Low::libver(),
+							High::libver() ) -> 'ok' | error().
+h5pset_libver_bounds( _Handle, _Low, _High ) ->
+	nif_error( ?LINE ).
+
+
+
+% Sets the size of the page buffer (in bytes), and the minimum percentages of
+% it reserved for metadata and raw data pages.
+%
+% Only applies to files created with the 'H5F_FSPACE_STRATEGY_PAGE' strategy
+% (see h5pset_file_space_strategy/4); requires HDF5 1.10.1 or later.
+%
+-spec h5pset_page_buffer_size( file_access_proplist(), size(),
+	   MinMetaPercent::integer(), MinRawPercent::integer() ) -> 'ok' | error().
+h5pset_page_buffer_size( _Handle, _Size, _MinMetaPercent, _MinRawPercent ) ->
+	nif_error( ?LINE ).
+
+
+
+% Sets, on a file creation property list, the file space handling strategy,
+% whether free space is persisted, and the smallest free-space section tracked;
+% 'H5F_FSPACE_STRATEGY_PAGE' enables paged aggregation. Requires HDF5 1.10.1 or
+% later.
+%
+-spec h5pset_file_space_strategy( file_creation_proplist(),
+		  file_space_strategy(), Persist::boolean(), Threshold::size() ) ->
+										'ok' | error().
+h5pset_file_space_strategy( _Handle, _Strategy, _Persist, _Threshold ) ->
+	nif_error( ?LINE ).
+
+
+
+% Sets, on a file creation property list, the size of the file space pages (in
+% bytes), used by paged aggregation. Requires HDF5 1.10.1 or later.
+%
+-spec h5pset_file_space_page_size( file_creation_proplist(), size() ) ->
+										 'ok' | error().
+h5pset_file_space_page_size( _Handle, _Size ) ->
+	nif_error( ?LINE ).
+
+
+
 
 % H5T section: about datatypes.
 
 
-% Converts a data type, specified as an atom, to its handle (integer) HDF5
-% representation (without making a copy of it).
+% Converts a data type, specified as an atom, to its handle HDF5
+% representation (without making a copy of it; closing that handle has thus no
+% effect).
 %
 % (binding exported helper)
 %
@@ -358,9 +796,14 @@ h5dopen( _File, _Name ) ->
 
 
 
-% Opens an existing dataset with specified access property list.
+% Opens an existing dataset with specified access property list, as created by
+% h5pcreate( 'H5P_DATASET_ACCESS' ) (ex: to set a specific chunk cache, see
+% h5pset_chunk_cache/4).
+%
+% The property list remains owned by the caller, who may close it as soon as
+% this call returns.
 %
--spec h5dopen( file_handle(), dataset_name(), AccessPropList::any() ) ->
+-spec h5dopen( file_handle(), dataset_name(), dataset_access_proplist() ) ->
 					 { 'ok', dataset_handle() } | error().
 h5dopen( _File, _Name, _AccessPropList ) ->
 	nif_error( ?LINE ).
@@ -411,6 +854,382 @@ h5dwrite( _Dataset, _FileDataspace, _Data ) ->
 
 
 
+% Writes specified binary data into specified dataset.
+%
+% The binary must contain contiguous cells of the specified (native) type,
+% typically packed as <<X:64/float-native, ...>> for 'H5T_NATIVE_DOUBLE'; its
+% bytes are passed to HDF5 as they are, with no per-element conversion.
+%
+-spec h5dwrite_binary( dataset_handle(), CellType::datatype_name(),
+					   binary() ) -> 'ok' | error().
+h5dwrite_binary( _Dataset, _CellType, _Data ) ->
+	nif_error( ?LINE ).
+
+
+
+% Writes specified binary data into specified dataset, using specified
+% dataspace.
+%
+% Useful for partial file writing.
+%
+-spec h5dwrite_binary( dataset_handle(), dataspace_handle(),
+					   CellType::datatype_name(), binary() ) -> 'ok' | error().
+h5dwrite_binary( _Dataset, _FileDataspace, _CellType, _Data ) ->
+	nif_error( ?LINE ).
+
+
+
+% Reads the cells selected by specified file dataspace (or the full dataset, if
+% 'H5S_ALL' is specified) from specified dataset, and returns them as a flat
+% list, in the order of the selection.
+%
+% Only the selected elements are read, so that for example a single row can be
+% fetched from a large dataset. Supported cell types are the numeric ones (see
+% datatype_name()).
+%
+-spec h5dread( dataset_handle(), file_dataspace(),
+			   CellType::datatype_name() ) -> { 'ok', data() } | error().
+h5dread( _Dataset, _FileDataspace, _CellType ) ->
+	nif_error( ?LINE ).
+
+
+
+% Reads the cells selected by specified file dataspace (or the full dataset, if
+% 'H5S_ALL' is specified) from specified dataset, and returns them as a binary
+% of contiguous cells of the specified (native) type.
+%
+% No per-element term is created: for 'H5T_NATIVE_DOUBLE', the returned binary
+% is to be matched as <<X:64/float-native, ...>>.
+%
+-spec h5dread_binary( dataset_handle(), file_dataspace(),
+					  CellType::datatype_name() ) ->
+							{ 'ok', binary() } | error().
+h5dread_binary( _Dataset, _FileDataspace, _CellType ) ->
+	nif_error( ?LINE ).
+
+
+
+% Writes specified shaped binary at specified offset (a tuple having as many
+% elements as the dataset has dimensions) of specified dataset, whatever its
+% rank, the binary holding packed cells of specified type.
+%
+% Ex: h5dwrite_block(Stack, {Frame, 0, 0}, 'H5T_NATIVE_UINT16', {{1, H, W},
+% Pixels}) writes a single frame of an image stack.
+%
+-spec h5dwrite_block( dataset_handle(), Offset::size_tuple(),
+					  CellType::datatype_name(), shaped_binary() ) ->
+							'ok' | error().
+h5dwrite_block( _Dataset, _Offset, _CellType, _Block ) ->
+	nif_error( ?LINE ).
+
+
+
+% Reads the block of specified dimensions starting at specified offset of
+% specified dataset, whatever its rank, as a shaped binary of cells of
+% specified type.
+%
+-spec h5dread_block( dataset_handle(), Offset::size_tuple(),
+					 Dims::size_tuple(), CellType::datatype_name() ) ->
+						   { 'ok', shaped_binary() } | error().
+h5dread_block( _Dataset, _Offset, _Dims, _CellType ) ->
+	nif_error( ?LINE ).
+
+
+
+% Writes the packed cells of specified type at the scattered points of
+% specified dataset whose coordinates are specified (the n-th cell at the n-th
+% point), as a single I/O request.
+%
+-spec h5dwrite_points( dataset_handle(), coordinates(),
+					   CellType::datatype_name(), Values::binary() ) ->
+							 'ok' | error().
+h5dwrite_points( _Dataset, _Coords, _CellType, _Values ) ->
+	nif_error( ?LINE ).
+
+
+
+% Reads, as a single I/O request, the cells at the scattered points of
+% specified dataset whose coordinates are specified, returned as packed cells
+% of specified type, in the order of the points.
+%
+-spec h5dread_points( dataset_handle(), coordinates(),
+					  CellType::datatype_name() ) ->
+							{ 'ok', binary() } | error().
+h5dread_points( _Dataset, _Coords, _CellType ) ->
+	nif_error( ?LINE ).
+
+
+
+% Flushes the buffers of specified dataset, so that, in SWMR mode, readers can
+% see the rows written so far. Requires HDF5 1.10 or later.
+%
+-spec h5dflush( dataset_handle() ) -> 'ok' | error().
+h5dflush( _Dataset ) ->
+	nif_error( ?LINE ).
+
+
+
+% Refreshes the metadata of specified dataset, so that a SWMR reader sees the
+% rows appended since it opened (or last refreshed) it, with no need to reopen
+% the file. Requires HDF5 1.10 or later.
+%
+-spec h5drefresh( dataset_handle() ) -> 'ok' | error().
+h5drefresh( _Dataset ) ->
+	nif_error( ?LINE ).
+
+
+
+% Appends specified rows at the end of specified extendible dataset (i.e. along
+% its first dimension), extending it accordingly.
+%
+% Rows are specified like for h5dwrite/2, and must match the other dimensions of
+% the dataset; only the new rows are written, so the cost of an append does not
+% depend on the current size of the dataset. On failure the dataset is left
+% with its former extent.
+%
+-spec h5dappend( dataset_handle(), data() ) -> 'ok' | error().
+h5dappend( _Dataset, _Data ) ->
+	nif_error( ?LINE ).
+
+
+
+% Appends the rows packed in specified binary (of contiguous cells of the
+% specified native type) at the end of specified extendible dataset.
+%
+% The binary must contain a whole number of rows.
+%
+-spec h5dappend_binary( dataset_handle(), CellType::datatype_name(),
+						binary() ) -> 'ok' | error().
+h5dappend_binary( _Dataset, _CellType, _Data ) ->
+	nif_error( ?LINE ).
+
+
+
+% Prepares the repeated writing into specified dataset of blocks of specified
+% shape (a tuple having as many dimensions as the dataset) and cell type
+% (any numeric one, see datatype_name()), see h5d_exec_write/3.
+%
+% The returned plan holds the staging buffer, the memory dataspace and the file
+% selection, which are thus set up once rather than at each write.
+%
+-spec h5d_prepare_write( dataset_handle(), CellType::datatype_name(),
+						 Shape::dimensions() ) ->
+							   { 'ok', write_plan() } | error().
+h5d_prepare_write( _Dataset, _CellType, _Shape ) ->
+	nif_error( ?LINE ).
+
+
+
+% Writes specified block, according to specified plan, at specified offset (a
+% tuple of the coordinates of its first cell) in the dataset.
+%
+% The block is either a list (of cells or of tuples of cells, in row-major
+% order) or a binary of packed cells, holding exactly the cells of the shape of
+% the plan. The dataset may have been extended since the plan was prepared.
+%
+-spec h5d_exec_write( write_plan(), Offset::dimensions(), data() | binary() ) ->
+							'ok' | error().
+h5d_exec_write( _Plan, _Offset, _Data ) ->
+	nif_error( ?LINE ).
+
+
+
+% Creates a write-behind buffer appending rows at the end of specified
+% extendible dataset, as cells of specified type.
+%
+% Appended rows are only copied in memory, and are written in a single
+% extension and write of the dataset once the threshold is reached, once the
+% oldest of them has waited for MaxDelay milliseconds (unless 'infinity'), or
+% when explicitly flushed (see h5d_flush_buffer/1).
+%
+-spec h5d_create_buffer( dataset_handle(), CellType::datatype_name(),
+						 Threshold::buffer_threshold(),
+						 MaxDelay::non_neg_integer() | 'infinity' ) ->
+							   { 'ok', append_buffer() } | error().
+h5d_create_buffer( _Dataset, _CellType, _Threshold, _MaxDelay ) ->
+	nif_error( ?LINE ).
+
+
+
+% Appends specified rows (a list, like for h5dappend/2, or a binary of packed
+% rows) to specified buffer; any number of processes may append to the same
+% buffer.
+%
+% If the threshold of the buffer is reached, the whole buffer is written, and
+% the result of that write is returned.
+%
+% Lists are decoded before the buffer is locked; long ones are decoded on a
+% dirty CPU scheduler (when available).
+%
+-spec h5d_buffer_append( append_buffer(), data() | binary() ) ->
+							   'ok' | error().
+h5d_buffer_append( _Buffer, _Data ) ->
+	nif_error( ?LINE ).
+
+
+
+% Writes now the rows pending in specified buffer, if any.
+%
+% With no maximum delay, the rows still pending in a buffer once it is
+% garbage-collected are written later, in the background, and their errors
+% cannot be reported: a buffer should thus be flushed before being dropped.
+%
+-spec h5d_flush_buffer( append_buffer() ) -> 'ok' | error().
+h5d_flush_buffer( _Buffer ) ->
+	nif_error( ?LINE ).
+
+
+
+% Returns the occupancy of specified buffer ('rows' and 'bytes' pending, and
+% 'max_rows' of its threshold), and the outcome of its writes so far
+% ('flushes', 'written_rows' and 'failed_rows').
+%
+-spec h5d_buffer_info( append_buffer() ) ->
+							 { 'ok', [ { atom(), non_neg_integer() } ] }
+								 | error().
+h5d_buffer_info( _Buffer ) ->
+	nif_error( ?LINE ).
+
+
+
+% Computes, in a single streaming pass through a bounded buffer, the specified
+% aggregates of the cells selected in specified dataset (whose cells are read
+% as floats, whatever their type), and returns them as a map.
+%
+% NaN cells are only counted (by 'count' and 'nan_count'); 'min', 'max' and
+% 'mean' are 'undefined' if no other cell is selected.
+%
+% Ex: {ok, #{mean := Mean}} = h5d_aggregate(DS, DaySpace, [mean]).
+%
+-spec h5d_aggregate( dataset_handle(), file_dataspace(), [ aggregate() ] ) ->
+						   { 'ok', #{ aggregate() => aggregate_value() } }
+							   | error().
+h5d_aggregate( _Dataset, _FileDataspace, _Aggregates ) ->
+	nif_error( ?LINE ).
+
+
+
+% Counts, in a single streaming pass, the cells selected in specified dataset
+% in bins of equal width spanning [Low, High] (the last bin including High);
+% cells out of these bounds are counted as 'below' or 'above'.
+%
+-spec h5d_histogram( dataset_handle(), file_dataspace(), histogram_bins() ) ->
+						   { 'ok', #{ 'counts' => [ non_neg_integer() ],
+									  'below' => non_neg_integer(),
+									  'above' => non_neg_integer(),
+									  'nan_count' => non_neg_integer() } }
+							   | error().
+h5d_histogram( _Dataset, _FileDataspace, _Bins ) ->
+	nif_error( ?LINE ).
+
+
+
+% Builds, in a single streaming pass and in constant memory, the quantile
+% sketch of the cells selected in specified dataset, from which any quantile
+% can then be estimated within specified relative accuracy (ex: 0.01, i.e.
+% 1%, at least 1.0e-4).
+%
+% Ex: {ok, Sketch} = h5d_sketch(DS, 'H5S_ALL', 0.01),
+%     {ok, [P50, P99, P999]} = sketch_quantiles(Sketch, [0.5, 0.99, 0.999]).
+%
+-spec h5d_sketch( dataset_handle(), file_dataspace(),
+				  RelativeAccuracy::float() ) -> { 'ok', sketch() } | error().
+h5d_sketch( _Dataset, _FileDataspace, _RelativeAccuracy ) ->
+	nif_error( ?LINE ).
+
+
+
+% Merges specified sketches, of the same accuracy (ex: the ones of the same
+% dataset in several files), as if their cells had been sketched together.
+%
+-spec sketch_merge( [ sketch(), ... ] ) -> { 'ok', sketch() } | error().
+sketch_merge( _Sketches ) ->
+	nif_error( ?LINE ).
+
+
+
+% Returns the estimates of specified quantiles (each in [0,1]) of specified
+% sketch, in the same order ('undefined' if no cell was sketched).
+%
+-spec sketch_quantiles( sketch(), [ number() ] ) ->
+			{ 'ok', [ float() | 'inf' | 'undefined' ] } | error().
+sketch_quantiles( _Sketch, _Quantiles ) ->
+	nif_error( ?LINE ).
+
+
+
+% Reads, for plotting, a downsampled version of specified range of specified
+% series (a monodimensional dataset): the range is cut into Buckets buckets of
+% consecutive cells, each reduced to its minimum and maximum ('minmax', so that
+% no peak is lost), to its mean ('mean'), or to the cell best preserving the
+% shape of the series ('lttb', i.e. Largest-Triangle-Three-Buckets, the first
+% and last cells of the range being kept).
+%
+% The range is streamed chunk by chunk, and only the resulting {Index, Value}
+% points are returned, in index order; NaN cells are skipped.
+%
+-spec h5d_read_downsampled( dataset_handle(), series_range(),
+							Buckets::pos_integer(), downsampling_mode() ) ->
+		  { 'ok', [ { Index::size(), float() | 'inf' } ] } | error().
+h5d_read_downsampled( _Dataset, _Range, _Buckets, _Mode ) ->
+	nif_error( ?LINE ).
+
+
+
+% Scans specified range of specified series (a monodimensional dataset) for the
+% cells matching specified predicate, and returns their indexes, in increasing
+% order, as a binary of packed native unsigned 64-bit integers (hence directly
+% usable as coordinates by h5dread_points/3).
+%
+% The range is streamed chunk by chunk, so that only the matches are kept in
+% memory; if the series has a zone map (see h5d_create_zone_map/1), the chunks
+% that cannot match are skipped.
+%
+% Ex: {ok, Indexes} = h5d_scan(DS, all, {gt, 100.0}).
+%
+-spec h5d_scan( dataset_handle(), series_range(), predicate() ) ->
+		  { 'ok', binary() } | error().
+h5d_scan( _Dataset, _Range, _Predicate ) ->
+	nif_error( ?LINE ).
+
+
+
+% Same as h5d_scan/3, except that, with 'ranges', each run of consecutive
+% matching cells is reported as its first index followed by its length (both
+% packed like indexes), which is far more compact for clustered matches.
+%
+-spec h5d_scan( dataset_handle(), series_range(), predicate(),
+				scan_format() ) -> { 'ok', binary() } | error().
+h5d_scan( _Dataset, _Range, _Predicate, _Format ) ->
+	nif_error( ?LINE ).
+
+
+
+% Creates (or rebuilds) the zone map of specified chunked dataset: the summary
+% (minimum, maximum and count of non-NaN cells) of each of its zones, a zone
+% being a slab of rows as high as its chunks.
+%
+% The zone map is stored in a companion dataset, next to this one and named
+% after it (ex: "/series.zone_map" for "/series"); all subsequent writes to the
+% dataset (including appends, buffered ones and write plans) update the zones
+% they touch, and h5d_scan/{3,4} skip the zones that cannot match their
+% predicate, without reading (nor decompressing) their chunks.
+%
+-spec h5d_create_zone_map( dataset_handle() ) -> 'ok' | error().
+h5d_create_zone_map( _Dataset ) ->
+	nif_error( ?LINE ).
+
+
+
+% Returns the summaries of all the zones of specified dataset, which must have
+% a zone map (see h5d_create_zone_map/1).
+%
+-spec h5d_get_zone_map( dataset_handle() ) -> { 'ok', [ zone() ] } | error().
+h5d_get_zone_map( _Dataset ) ->
+	nif_error( ?LINE ).
+
+
+
 % Returns the amount of storage allocated for a dataset.
 %
 -spec h5d_get_storage_size( dataset_handle() ) ->
@@ -430,6 +1249,130 @@ h5dget_space( _Handle ) ->
 
 
 
+% Asynchronous section.
+%
+% Each call below is performed by the HDF5 executor (a dedicated OS thread
+% owning the HDF5 calls) instead of by a scheduler: it returns at once
+% { ok, Ref }, and the caller will be sent later a
+% { erlhdf5_reply, Ref, Result } message, Result being what the corresponding
+% synchronous call would have returned.
+
+
+
+% Closes asynchronously specified HDF5 file (see h5fclose/1).
+%
+-spec h5fclose_async( file_handle() ) -> async_result().
+h5fclose_async( _Handle ) ->
+	nif_error( ?LINE ).
+
+
+
+% Writes asynchronously specified data into specified dataset (see h5dwrite/2).
+%
+-spec h5dwrite_async( dataset_handle(), data() ) -> async_result().
+h5dwrite_async( _Dataset, _Data ) ->
+	nif_error( ?LINE ).
+
+
+
+% Writes asynchronously specified data into specified dataset, using specified
+% dataspace (see h5dwrite/3).
+%
+-spec h5dwrite_async( dataset_handle(), dataspace_handle(), data() ) ->
+							async_result().
+h5dwrite_async( _Dataset, _FileDataspace, _Data ) ->
+	nif_error( ?LINE ).
+
+
+
+% Writes asynchronously specified binary data into specified dataset (see
+% h5dwrite_binary/3).
+%
+-spec h5dwrite_binary_async( dataset_handle(), CellType::datatype_name(),
+							 binary() ) -> async_result().
+h5dwrite_binary_async( _Dataset, _CellType, _Data ) ->
+	nif_error( ?LINE ).
+
+
+
+% Writes asynchronously specified binary data into specified dataset, using
+% specified dataspace (see h5dwrite_binary/4).
+%
+-spec h5dwrite_binary_async( dataset_handle(), dataspace_handle(),
+							 CellType::datatype_name(), binary() ) ->
+								   async_result().
+h5dwrite_binary_async( _Dataset, _FileDataspace, _CellType, _Data ) ->
+	nif_error( ?LINE ).
+
+
+
+% Reads asynchronously a selection of specified dataset, as a list (see
+% h5dread/3).
+%
+-spec h5dread_async( dataset_handle(), file_dataspace(),
+					 CellType::datatype_name() ) -> async_result().
+h5dread_async( _Dataset, _FileDataspace, _CellType ) ->
+	nif_error( ?LINE ).
+
+
+
+% Reads asynchronously a selection of specified dataset, as a binary (see
+% h5dread_binary/3).
+%
+-spec h5dread_binary_async( dataset_handle(), file_dataspace(),
+							CellType::datatype_name() ) -> async_result().
+h5dread_binary_async( _Dataset, _FileDataspace, _CellType ) ->
+	nif_error( ?LINE ).
+
+
+
+% Reads asynchronously specified integer dataset from specified file (see
+% h5lt_read_dataset_int/2).
+%
+-spec h5lt_read_dataset_int_async( file_handle(), dataset_name() ) ->
+										 async_result().
+h5lt_read_dataset_int_async( _Handle, _DatasetName ) ->
+	nif_error( ?LINE ).
+
+
+
+% Reads asynchronously specified double dataset from specified file (see
+% h5lt_read_dataset_double/2).
+%
+-spec h5lt_read_dataset_double_async( file_handle(), dataset_name() ) ->
+											async_result().
+h5lt_read_dataset_double_async( _Handle, _DatasetName ) ->
+	nif_error( ?LINE ).
+
+
+
+% Waits (indefinitely) for the result of the asynchronous call identified by
+% specified reference.
+%
+-spec wait_reply( async_ref() ) -> any().
+wait_reply( Ref ) ->
+	wait_reply( Ref, infinity ).
+
+
+
+% Waits, up to specified duration (in milliseconds), for the result of the
+% asynchronous call identified by specified reference.
+%
+-spec wait_reply( async_ref(), timeout() ) -> any() | { 'error', 'timeout' }.
+wait_reply( Ref, Timeout ) ->
+	receive
+
+		{ erlhdf5_reply, Ref, Result } ->
+			Result
+
+	after Timeout ->
+			{ error, timeout }
+
+	end.
+
+
+
+
 % H5LT section: about HDF5 Lite.
 
 
@@ -30,7 +30,26 @@ all() ->
 	[
 	 h5_write,
 	 h5_read,
-	 h5_lite_write_read
+	 h5_lite_write_read,
+	 h5_binary_write,
+	 h5_append,
+	 h5_write_plan,
+	 h5_append_buffer,
+	 h5_numeric_types,
+	 h5_large_offsets,
+	 h5_rank_n,
+	 h5_points,
+	 h5_aggregate,
+	 h5_distribution,
+	 h5_downsampling,
+	 h5_scan,
+	 h5_zone_map,
+	 h5_list_decoding,
+	 h5_compressed,
+	 h5_file_access,
+	 h5_file_image,
+	 h5_swmr,
+	 h5_handles
 	 %% h5_lite_read
 	 %write_example
 	].
@@ -139,3 +158,976 @@ h5_read(_Config) ->
 	ok = erlhdf5:h5dclose(DS),
 	ok = erlhdf5:h5fclose(File),
 	ok.
+
+
+
+%%--------------------------------------------------------------------
+%% @doc
+%% Writes a packed binary of doubles, then reads it back through H5LT.
+%% @end
+%%--------------------------------------------------------------------
+h5_binary_write(_Config) ->
+	FileName = "hdf5_bin.h5",
+	DS_Name = "/dset_bin",
+	TestData = [ 0.5, 1.5, 2.5, 3.5, 4.5, 5.5 ],
+	Bin = << <<X:64/float-native>> || X <- TestData >>,
+
+	{ok, File} = erlhdf5:h5fcreate(FileName, 'H5F_ACC_TRUNC'),
+	{ok, Space} = erlhdf5:h5screate_simple(2, {2, 3}),
+	{ok, Dcpl} = erlhdf5:h5pcreate('H5P_DATASET_CREATE'),
+	{ok, Type} = erlhdf5:h5tcopy('H5T_NATIVE_DOUBLE'),
+	{ok, DS} = erlhdf5:h5dcreate(File, DS_Name, Type, Space, Dcpl),
+
+	%% size mismatches are rejected:
+	{error, _} = erlhdf5:h5dwrite_binary(DS, 'H5T_NATIVE_DOUBLE', <<1, 2, 3>>),
+
+	{ok, WriteRef} = erlhdf5:h5dwrite_binary_async(DS, 'H5T_NATIVE_DOUBLE', Bin),
+	ok = erlhdf5:wait_reply(WriteRef),
+	{ok, TestData} = erlhdf5:h5lt_read_dataset_double(File, DS_Name),
+	{ok, ReadRef} = erlhdf5:h5lt_read_dataset_double_async(File, DS_Name),
+	{ok, TestData} = erlhdf5:wait_reply(ReadRef, 5000),
+	{ok, Bin} = erlhdf5:h5dread_binary(DS, 'H5S_ALL', 'H5T_NATIVE_DOUBLE'),
+
+	%% second row only:
+	{ok, FileSpace} = erlhdf5:h5dget_space(DS),
+	ok = erlhdf5:h5sselect_hyperslab(FileSpace, 'H5S_SELECT_SET', {1, 0},
+									 {1, 1}, {1, 3}, {1, 1}),
+	{ok, <<3.5:64/float-native, 4.5:64/float-native, 5.5:64/float-native>>} =
+		erlhdf5:h5dread_binary(DS, FileSpace, 'H5T_NATIVE_DOUBLE'),
+	{ok, [3.5, 4.5, 5.5]} =
+		erlhdf5:h5dread(DS, FileSpace, 'H5T_NATIVE_DOUBLE'),
+	ok = erlhdf5:h5sclose(FileSpace),
+
+	ok = erlhdf5:h5dclose(DS),
+	ok = erlhdf5:h5tclose(Type),
+	ok = erlhdf5:h5pclose(Dcpl),
+	ok = erlhdf5:h5sclose(Space),
+	ok = erlhdf5:h5fclose(File),
+	ok.
+
+
+h5_append(_Config) ->
+	{ok, File} = erlhdf5:h5fcreate("hdf5_append.h5", 'H5F_ACC_TRUNC'),
+
+	%% initially empty, unbounded along the first dimension:
+	{ok, Space} = erlhdf5:h5screate_simple(2, {0, 3}, {'H5S_UNLIMITED', 3}),
+	{ok, [0, 3], ['H5S_UNLIMITED', 3]} =
+		erlhdf5:h5sget_simple_extent_dims(Space, 2),
+	{ok, Dcpl} = erlhdf5:h5pcreate('H5P_DATASET_CREATE'),
+	{ok, Type} = erlhdf5:h5tcopy('H5T_NATIVE_INT'),
+
+	%% no explicit chunking, default one applies:
+	{ok, DS} = erlhdf5:h5dcreate(File, "/series", Type, Space, Dcpl),
+
+	ok = erlhdf5:h5dappend(DS, [{1, 2, 3}, {4, 5, 6}]),
+	ok = erlhdf5:h5dappend_binary(DS, 'H5T_NATIVE_INT',
+		<< <<X:32/signed-native>> || X <- [7, 8, 9] >>),
+
+	%% mismatching rows are rejected, and leave the dataset unchanged:
+	{error, _} = erlhdf5:h5dappend(DS, [{1, 2}]),
+	{error, _} = erlhdf5:h5dappend_binary(DS, 'H5T_NATIVE_INT', <<1:32>>),
+
+	{ok, [1, 2, 3, 4, 5, 6, 7, 8, 9]} =
+		erlhdf5:h5dread(DS, 'H5S_ALL', 'H5T_NATIVE_INT'),
+
+	%% explicitly chunked, bounded dataset:
+	{ok, BoundedSpace} = erlhdf5:h5screate_simple(1, {0}, {2}),
+	ok = erlhdf5:h5pset_chunk(Dcpl, 1, {2}),
+	{ok, BoundedDS} = erlhdf5:h5dcreate(File, "/bounded", Type, BoundedSpace,
+										Dcpl),
+	ok = erlhdf5:h5dappend(BoundedDS, [1, 2]),
+	{error, _} = erlhdf5:h5dappend(BoundedDS, [3]),
+
+	ok = erlhdf5:h5dclose(BoundedDS),
+	ok = erlhdf5:h5sclose(BoundedSpace),
+	ok = erlhdf5:h5dclose(DS),
+	ok = erlhdf5:h5tclose(Type),
+	ok = erlhdf5:h5pclose(Dcpl),
+	ok = erlhdf5:h5sclose(Space),
+	ok = erlhdf5:h5fclose(File),
+	ok.
+
+
+h5_write_plan(_Config) ->
+	{ok, File} = erlhdf5:h5fcreate("hdf5_plan.h5", 'H5F_ACC_TRUNC'),
+	{ok, Space} = erlhdf5:h5screate_simple(2, {0, 3}, {'H5S_UNLIMITED', 3}),
+	{ok, Dcpl} = erlhdf5:h5pcreate('H5P_DATASET_CREATE'),
+	{ok, Type} = erlhdf5:h5tcopy('H5T_NATIVE_DOUBLE'),
+	{ok, DS} = erlhdf5:h5dcreate(File, "/samples", Type, Space, Dcpl),
+
+	{ok, Plan} = erlhdf5:h5d_prepare_write(DS, 'H5T_NATIVE_DOUBLE', {1, 3}),
+
+	% Writing past the extent of the dataset is rejected:
+	{error, _} = erlhdf5:h5d_exec_write(Plan, {0, 0}, [{1.0, 2.0, 3.0}]),
+
+	% The plan follows the extensions of the dataset:
+	ok = erlhdf5:h5dappend(DS, [{0.0, 0.0, 0.0}, {0.0, 0.0, 0.0}]),
+	ok = erlhdf5:h5d_exec_write(Plan, {0, 0}, [{1.0, 2.0, 3.0}]),
+	ok = erlhdf5:h5d_exec_write(Plan, {1, 0},
+								<<4.0:64/float-native, 5.0:64/float-native,
+								  6.0:64/float-native>>),
+
+	% Offsets so large that the end of the block would wrap are rejected:
+	{error, _} = erlhdf5:h5d_exec_write(Plan, {(1 bsl 64) - 1, 0},
+										[{1.0, 2.0, 3.0}]),
+
+	% Blocks must match the shape of the plan:
+	{error, _} = erlhdf5:h5d_exec_write(Plan, {0, 0}, [1.0, 2.0]),
+	{error, _} = erlhdf5:h5d_exec_write(Plan, {0}, [1.0, 2.0, 3.0]),
+
+	{ok, [1.0, 2.0, 3.0, 4.0, 5.0, 6.0]} =
+		erlhdf5:h5dread(DS, 'H5S_ALL', 'H5T_NATIVE_DOUBLE'),
+
+	ok = erlhdf5:h5dclose(DS),
+	{error, _} = erlhdf5:h5d_exec_write(Plan, {0, 0}, [1.0, 2.0, 3.0]),
+
+	ok = erlhdf5:h5tclose(Type),
+	ok = erlhdf5:h5pclose(Dcpl),
+	ok = erlhdf5:h5sclose(Space),
+	ok = erlhdf5:h5fclose(File),
+	ok.
+
+
+h5_append_buffer(_Config) ->
+	{ok, File} = erlhdf5:h5fcreate("hdf5_buffer.h5", 'H5F_ACC_TRUNC'),
+	{ok, Space} = erlhdf5:h5screate_simple(2, {0, 2}, {'H5S_UNLIMITED', 2}),
+	{ok, Dcpl} = erlhdf5:h5pcreate('H5P_DATASET_CREATE'),
+	{ok, Type} = erlhdf5:h5tcopy('H5T_NATIVE_INT'),
+	{ok, DS} = erlhdf5:h5dcreate(File, "/events", Type, Space, Dcpl),
+
+	%% appends from several processes, written by batches of 10 rows:
+	{ok, Buffer} = erlhdf5:h5d_create_buffer(DS, 'H5T_NATIVE_INT',
+											 {rows, 10}, infinity),
+	Self = self(),
+	[spawn(fun() ->
+				   [ok = erlhdf5:h5d_buffer_append(Buffer, [{P, I}])
+					|| I <- lists:seq(1, 5)],
+				   Self ! {done, P}
+		   end) || P <- lists:seq(1, 4)],
+	[receive {done, P} -> ok end || P <- lists:seq(1, 4)],
+	{ok, Info} = erlhdf5:h5d_buffer_info(Buffer),
+	20 = proplists:get_value(rows, Info)
+		+ proplists:get_value(written_rows, Info),
+	true = proplists:get_value(flushes, Info) >= 1,
+	ok = erlhdf5:h5d_flush_buffer(Buffer),
+	{ok, Cells} = erlhdf5:h5dread(DS, 'H5S_ALL', 'H5T_NATIVE_INT'),
+	40 = length(Cells),
+
+	%% below the threshold, rows stay pending until flushed:
+	ok = erlhdf5:h5d_buffer_append(Buffer,
+		<< <<X:32/signed-native>> || X <- [7, 8, 9, 10] >>),
+	{ok, Pending} = erlhdf5:h5d_buffer_info(Buffer),
+	2 = proplists:get_value(rows, Pending),
+	16 = proplists:get_value(bytes, Pending),
+	{error, _} = erlhdf5:h5d_buffer_append(Buffer, [{1, 2, 3}]),
+	{error, _} = erlhdf5:h5d_buffer_append(Buffer, [1, 2, 3]),
+	{error, _} = erlhdf5:h5d_buffer_append(Buffer, <<1:32/native>>),
+	ok = erlhdf5:h5d_flush_buffer(Buffer),
+	{ok, [7, 8, 9, 10]} = read_rows(DS, 20, 2),
+
+	%% or until their maximum delay expires:
+	{ok, Timed} = erlhdf5:h5d_create_buffer(DS, 'H5T_NATIVE_INT',
+											{bytes, 1 bsl 20}, 50),
+	ok = erlhdf5:h5d_buffer_append(Timed, [{11, 12}]),
+	timer:sleep(500),
+	{ok, TimedInfo} = erlhdf5:h5d_buffer_info(Timed),
+	1 = proplists:get_value(written_rows, TimedInfo),
+	{ok, [11, 12]} = read_rows(DS, 22, 1),
+
+	%% long lists are decoded off the normal schedulers, to the same effect:
+	{ok, Large} = erlhdf5:h5d_create_buffer(DS, 'H5T_NATIVE_INT',
+											{rows, 1 bsl 20}, infinity),
+	ok = erlhdf5:h5d_buffer_append(Large,
+		[{R, -R} || R <- lists:seq(1, 10000)]),
+	{ok, LargeInfo} = erlhdf5:h5d_buffer_info(Large),
+	10000 = proplists:get_value(rows, LargeInfo),
+	{error, _} = erlhdf5:h5d_buffer_append(Large,
+		lists:duplicate(5000, {1, 2}) ++ [{1}]),
+	ok = erlhdf5:h5d_flush_buffer(Large),
+	{ok, [10000, -10000]} = read_rows(DS, 10022, 1),
+
+	ok = erlhdf5:h5dclose(DS),
+	ok = erlhdf5:h5d_buffer_append(Buffer, [{1, 2}]),
+	{error, _} = erlhdf5:h5d_flush_buffer(Buffer),
+
+	ok = erlhdf5:h5tclose(Type),
+	ok = erlhdf5:h5pclose(Dcpl),
+	ok = erlhdf5:h5sclose(Space),
+	ok = erlhdf5:h5fclose(File),
+	ok.
+
+
+% Reads specified number of rows, starting at specified one, of specified
+% 2-column dataset.
+read_rows(DS, Start, Count) ->
+	{ok, FileSpace} = erlhdf5:h5dget_space(DS),
+	ok = erlhdf5:h5sselect_hyperslab(FileSpace, 'H5S_SELECT_SET',
+									 {Start, 0}, {1, 1}, {Count, 2}, {1, 1}),
+	Res = erlhdf5:h5dread(DS, FileSpace, 'H5T_NATIVE_INT'),
+	ok = erlhdf5:h5sclose(FileSpace),
+	Res.
+
+
+h5_numeric_types(_Config) ->
+	{ok, File} = erlhdf5:h5fcreate("hdf5_types.h5", 'H5F_ACC_TRUNC'),
+	{ok, Space} = erlhdf5:h5screate_simple(1, {4}),
+	{ok, Dcpl} = erlhdf5:h5pcreate('H5P_DATASET_CREATE'),
+
+	%% counters as uint16, checked against the range of their type:
+	{ok, U16} = erlhdf5:datatype_name_to_handle('H5T_NATIVE_UINT16'),
+	{ok, Counters} = erlhdf5:h5dcreate(File, "/counters", U16, Space, Dcpl),
+	{error, _} = erlhdf5:h5dwrite(Counters, [1, 2, 3, 65536]),
+	{error, _} = erlhdf5:h5dwrite(Counters, [1, 2, 3, -1]),
+	ok = erlhdf5:h5dwrite(Counters, [0, 1, 2, 65535]),
+	{ok, [0, 1, 2, 65535]} =
+		erlhdf5:h5dread(Counters, 'H5S_ALL', 'H5T_NATIVE_UINT16'),
+	{ok, 2} = erlhdf5:h5tget_size(U16),
+
+	%% readings as float32:
+	{ok, F32} = erlhdf5:datatype_name_to_handle('H5T_NATIVE_FLOAT'),
+	{ok, Readings} = erlhdf5:h5dcreate(File, "/readings", F32, Space, Dcpl),
+	{error, _} = erlhdf5:h5dwrite(Readings, [0.5, 1.0e300, 2.0, 3.0]),
+	ok = erlhdf5:h5dwrite(Readings, [0.5, -1.25, inf, 4]),
+	{ok, [0.5, -1.25, inf, 4.0]} =
+		erlhdf5:h5dread(Readings, 'H5S_ALL', 'H5T_NATIVE_FLOAT'),
+
+	%% 64-bit integers, beyond the range of native ints:
+	{ok, I64} = erlhdf5:datatype_name_to_handle('H5T_NATIVE_INT64'),
+	{ok, Big} = erlhdf5:h5dcreate(File, "/big", I64, Space, Dcpl),
+	BigValues = [-(1 bsl 63), -1, 1 bsl 40, (1 bsl 63) - 1],
+	ok = erlhdf5:h5dwrite(Big, BigValues),
+	{ok, BigValues} = erlhdf5:h5dread(Big, 'H5S_ALL', 'H5T_NATIVE_INT64'),
+
+	ok = erlhdf5:h5dclose(Counters),
+	ok = erlhdf5:h5dclose(Readings),
+	ok = erlhdf5:h5dclose(Big),
+	ok = erlhdf5:h5pclose(Dcpl),
+	ok = erlhdf5:h5sclose(Space),
+	ok = erlhdf5:h5fclose(File),
+	ok.
+
+
+h5_large_offsets(_Config) ->
+	{ok, File} = erlhdf5:h5fcreate("hdf5_large.h5", 'H5F_ACC_TRUNC'),
+
+	%% beyond 2^32 cells, only the written chunks being allocated:
+	Length = 5000000000,
+	Offset = (1 bsl 32) + 7,
+	{ok, Space} = erlhdf5:h5screate_simple(1, {Length}, {'H5S_UNLIMITED'}),
+	{ok, [Length], ['H5S_UNLIMITED']} =
+		erlhdf5:h5sget_simple_extent_dims(Space, 1),
+	{ok, Dcpl} = erlhdf5:h5pcreate('H5P_DATASET_CREATE'),
+	{ok, Type} = erlhdf5:h5tcopy('H5T_NATIVE_INT'),
+	{ok, DS} = erlhdf5:h5dcreate(File, "/sparse", Type, Space, Dcpl),
+
+	{ok, Plan} = erlhdf5:h5d_prepare_write(DS, 'H5T_NATIVE_INT', {3}),
+	ok = erlhdf5:h5d_exec_write(Plan, {Offset}, [1, 2, 3]),
+
+	{ok, FileSpace} = erlhdf5:h5dget_space(DS),
+	ok = erlhdf5:h5sselect_hyperslab(FileSpace, 'H5S_SELECT_SET', Offset, 1,
+									 3, 1),
+	{ok, [1, 2, 3]} = erlhdf5:h5dread(DS, FileSpace, 'H5T_NATIVE_INT'),
+	{error, _} = erlhdf5:h5sselect_hyperslab(FileSpace, 'H5S_SELECT_SET', -1,
+											 1, 3, 1),
+	ok = erlhdf5:h5sclose(FileSpace),
+
+	ok = erlhdf5:h5dclose(DS),
+	ok = erlhdf5:h5tclose(Type),
+	ok = erlhdf5:h5pclose(Dcpl),
+	ok = erlhdf5:h5sclose(Space),
+	ok = erlhdf5:h5fclose(File),
+	ok.
+
+
+h5_rank_n(_Config) ->
+	{ok, File} = erlhdf5:h5fcreate("hdf5_rank_n.h5", 'H5F_ACC_TRUNC'),
+
+	%% 4-D, cell values encoding their coordinates:
+	Dims = {2, 3, 4, 5},
+	{ok, Space} = erlhdf5:h5screate_simple(4, Dims),
+	{ok, [2, 3, 4, 5], _} = erlhdf5:h5sget_simple_extent_dims(Space, 4),
+	{ok, Dcpl} = erlhdf5:h5pcreate('H5P_DATASET_CREATE'),
+	{ok, Type} = erlhdf5:h5tcopy('H5T_NATIVE_UINT16'),
+	{ok, DS} = erlhdf5:h5dcreate(File, "/hyper", Type, Space, Dcpl),
+	Cell = fun(A, B, C, D) -> A * 1000 + B * 100 + C * 10 + D end,
+	All = << <<(Cell(A, B, C, D)):16/native>> || A <- lists:seq(0, 1),
+		B <- lists:seq(0, 2), C <- lists:seq(0, 3), D <- lists:seq(0, 4) >>,
+	ok = erlhdf5:h5dwrite_block(DS, {0, 0, 0, 0}, 'H5T_NATIVE_UINT16',
+								{Dims, All}),
+
+	%% a sub-block, in row-major order:
+	Sub = << <<(Cell(1, B, C, D)):16/native>> || B <- [1, 2], C <- [3],
+		D <- lists:seq(2, 4) >>,
+	{ok, {{1, 2, 1, 3}, Sub}} = erlhdf5:h5dread_block(DS, {1, 1, 3, 2},
+		{1, 2, 1, 3}, 'H5T_NATIVE_UINT16'),
+
+	%% the same through a rank-4 hyperslab:
+	{ok, FileSpace} = erlhdf5:h5dget_space(DS),
+	ok = erlhdf5:h5sselect_hyperslab(FileSpace, 'H5S_SELECT_SET',
+		{1, 1, 3, 2}, {1, 1, 1, 1}, {1, 2, 1, 3}, {1, 1, 1, 1}),
+	{ok, Sub} = erlhdf5:h5dread_binary(DS, FileSpace, 'H5T_NATIVE_UINT16'),
+	ok = erlhdf5:h5sclose(FileSpace),
+
+	%% blocks must fit in the dataset and match their binary:
+	{error, _} = erlhdf5:h5dread_block(DS, {1, 1, 3, 3}, {1, 2, 1, 3},
+		'H5T_NATIVE_UINT16'),
+	{error, _} = erlhdf5:h5dread_block(DS, {0, 0, 0}, {1, 1, 1},
+		'H5T_NATIVE_UINT16'),
+	{error, _} = erlhdf5:h5dwrite_block(DS, {0, 0, 0, 0}, 'H5T_NATIVE_UINT16',
+		{{1, 1, 1, 2}, <<1:16/native>>}),
+
+	%% an extendible image stack, appended frame by frame:
+	{ok, StackSpace} = erlhdf5:h5screate_simple(3, {0, 2, 2},
+		{'H5S_UNLIMITED', 2, 2}),
+	{ok, Stack} = erlhdf5:h5dcreate(File, "/stack", Type, StackSpace, Dcpl),
+	Frame = << <<X:16/native>> || X <- [1, 2, 3, 4] >>,
+	ok = erlhdf5:h5dappend_binary(Stack, 'H5T_NATIVE_UINT16', Frame),
+	ok = erlhdf5:h5dappend_binary(Stack, 'H5T_NATIVE_UINT16', Frame),
+	{ok, {{1, 2, 2}, Frame}} = erlhdf5:h5dread_block(Stack, {1, 0, 0},
+		{1, 2, 2}, 'H5T_NATIVE_UINT16'),
+
+	ok = erlhdf5:h5dclose(Stack),
+	ok = erlhdf5:h5sclose(StackSpace),
+	ok = erlhdf5:h5dclose(DS),
+	ok = erlhdf5:h5tclose(Type),
+	ok = erlhdf5:h5pclose(Dcpl),
+	ok = erlhdf5:h5sclose(Space),
+	ok = erlhdf5:h5fclose(File),
+	ok.
+
+
+h5_points(_Config) ->
+	{ok, File} = erlhdf5:h5fcreate("hdf5_points.h5", 'H5F_ACC_TRUNC'),
+	{ok, Space} = erlhdf5:h5screate_simple(2, {100, 10}),
+	{ok, Dcpl} = erlhdf5:h5pcreate('H5P_DATASET_CREATE'),
+	{ok, Type} = erlhdf5:h5tcopy('H5T_NATIVE_INT64'),
+	{ok, DS} = erlhdf5:h5dcreate(File, "/points", Type, Space, Dcpl),
+	All = << <<(R * 10 + C):64/signed-native>> || R <- lists:seq(0, 99),
+		C <- lists:seq(0, 9) >>,
+	ok = erlhdf5:h5dwrite_binary(DS, 'H5T_NATIVE_INT64', All),
+
+	%% scattered, unordered lookups, returned in the order of the points:
+	Points = [{97, 3}, {2, 9}, {50, 0}, {2, 9}],
+	Coords = << <<R:64/native, C:64/native>> || {R, C} <- Points >>,
+	Expected = << <<(R * 10 + C):64/signed-native>> || {R, C} <- Points >>,
+	{ok, Expected} = erlhdf5:h5dread_points(DS, Coords, 'H5T_NATIVE_INT64'),
+
+	%% scattered updates:
+	Updates = [{0, 0}, {99, 9}, {42, 5}],
+	UpdateCoords = << <<R:64/native, C:64/native>> || {R, C} <- Updates >>,
+	Values = << <<V:64/signed-native>> || V <- [-1, -2, -3] >>,
+	ok = erlhdf5:h5dwrite_points(DS, UpdateCoords, 'H5T_NATIVE_INT64', Values),
+	{ok, Values} = erlhdf5:h5dread_points(DS, UpdateCoords,
+		'H5T_NATIVE_INT64'),
+	{ok, <<1:64/signed-native>>} = erlhdf5:h5dread_points(DS,
+		<<0:64/native, 1:64/native>>, 'H5T_NATIVE_INT64'),
+
+	%% the same selection through a dataspace, in any cell type:
+	{ok, FileSpace} = erlhdf5:h5dget_space(DS),
+	ok = erlhdf5:h5sselect_elements(FileSpace, 'H5S_SELECT_SET',
+		<<50:64/native, 0:64/native>>),
+	ok = erlhdf5:h5sselect_elements(FileSpace, 'H5S_SELECT_APPEND',
+		<<97:64/native, 3:64/native>>),
+	{ok, <<500.0:64/float-native, 973.0:64/float-native>>} =
+		erlhdf5:h5dread_binary(DS, FileSpace, 'H5T_NATIVE_DOUBLE'),
+	ok = erlhdf5:h5sclose(FileSpace),
+
+	%% points must lie in the dataset and match their values:
+	{error, _} = erlhdf5:h5dread_points(DS, <<100:64/native, 0:64/native>>,
+		'H5T_NATIVE_INT64'),
+	{error, _} = erlhdf5:h5dread_points(DS, <<1:64/native>>,
+		'H5T_NATIVE_INT64'),
+	{error, _} = erlhdf5:h5dwrite_points(DS, UpdateCoords, 'H5T_NATIVE_INT64',
+		<<1:64/signed-native>>),
+
+	ok = erlhdf5:h5dclose(DS),
+	ok = erlhdf5:h5tclose(Type),
+	ok = erlhdf5:h5pclose(Dcpl),
+	ok = erlhdf5:h5sclose(Space),
+	ok = erlhdf5:h5fclose(File),
+	ok.
+
+
+h5_aggregate(_Config) ->
+	{ok, File} = erlhdf5:h5fcreate("hdf5_aggregate.h5", 'H5F_ACC_TRUNC'),
+
+	%% a chunked series spanning several scan buffers, with a NaN cell:
+	N = 200000,
+	{ok, Space} = erlhdf5:h5screate_simple(1, {N}),
+	{ok, Dcpl} = erlhdf5:h5pcreate('H5P_DATASET_CREATE'),
+	ok = erlhdf5:h5pset_chunk(Dcpl, 1, {10000}),
+	{ok, Type} = erlhdf5:h5tcopy('H5T_NATIVE_DOUBLE'),
+	{ok, DS} = erlhdf5:h5dcreate(File, "/series", Type, Space, Dcpl),
+	NaN = <<16#7FF8000000000000:64/native>>,
+	Series = << <<(case X of 100 -> NaN; _ -> <<X:64/float-native>> end)/binary>>
+				|| X <- lists:seq(0, N - 1) >>,
+	ok = erlhdf5:h5dwrite_binary(DS, 'H5T_NATIVE_DOUBLE', Series),
+
+	Sum = float(N * (N - 1) div 2 - 100),
+	{ok, #{sum := Sum, min := 0.0, max := 199999.0, count := N,
+		   nan_count := 1}} = erlhdf5:h5d_aggregate(DS, 'H5S_ALL',
+			   [sum, min, max, count, nan_count]),
+
+	%% only the requested aggregates are returned:
+	{ok, #{count := N} = Counts} = erlhdf5:h5d_aggregate(DS, 'H5S_ALL',
+		[count]),
+	1 = map_size(Counts),
+
+	%% over an hyperslab, not aligned on chunks:
+	{ok, FileSpace} = erlhdf5:h5dget_space(DS),
+	ok = erlhdf5:h5sselect_hyperslab(FileSpace, 'H5S_SELECT_SET', 9500, 1,
+		1000, 1),
+	{ok, #{sum := 9999500.0, mean := 9999.5, min := 9500.0,
+		   max := 10499.0}} = erlhdf5:h5d_aggregate(DS, FileSpace,
+			   [sum, mean, min, max]),
+
+	%% over points, only NaN ones then:
+	ok = erlhdf5:h5sselect_elements(FileSpace, 'H5S_SELECT_SET',
+		<<5:64/native, 7:64/native>>),
+	{ok, #{sum := 12.0, count := 2}} = erlhdf5:h5d_aggregate(DS, FileSpace,
+		[sum, count]),
+	ok = erlhdf5:h5sselect_elements(FileSpace, 'H5S_SELECT_SET',
+		<<100:64/native>>),
+	{ok, #{mean := undefined, min := undefined, nan_count := 1}} =
+		erlhdf5:h5d_aggregate(DS, FileSpace, [mean, min, nan_count]),
+	ok = erlhdf5:h5sclose(FileSpace),
+
+	{error, _} = erlhdf5:h5d_aggregate(DS, 'H5S_ALL', [median]),
+
+	%% integer cells are aggregated as well:
+	{ok, IntSpace} = erlhdf5:h5screate_simple(2, {3, 4}),
+	{ok, IntType} = erlhdf5:h5tcopy('H5T_NATIVE_INT32'),
+	{ok, IntDcpl} = erlhdf5:h5pcreate('H5P_DATASET_CREATE'),
+	{ok, IntDS} = erlhdf5:h5dcreate(File, "/ints", IntType, IntSpace, IntDcpl),
+	ok = erlhdf5:h5dwrite_binary(IntDS, 'H5T_NATIVE_INT32',
+		<< <<X:32/signed-native>> || X <- lists:seq(1, 12) >>),
+	{ok, #{sum := 78.0, max := 12.0, count := 12}} =
+		erlhdf5:h5d_aggregate(IntDS, 'H5S_ALL', [sum, max, count]),
+
+	ok = erlhdf5:h5dclose(IntDS),
+	ok = erlhdf5:h5pclose(IntDcpl),
+	ok = erlhdf5:h5tclose(IntType),
+	ok = erlhdf5:h5sclose(IntSpace),
+	ok = erlhdf5:h5dclose(DS),
+	ok = erlhdf5:h5tclose(Type),
+	ok = erlhdf5:h5pclose(Dcpl),
+	ok = erlhdf5:h5sclose(Space),
+	ok = erlhdf5:h5fclose(File),
+	ok.
+
+
+h5_distribution(_Config) ->
+	{ok, File} = erlhdf5:h5fcreate("hdf5_distribution.h5", 'H5F_ACC_TRUNC'),
+	N = 100000,
+	{ok, Space} = erlhdf5:h5screate_simple(1, {N}),
+	{ok, Dcpl} = erlhdf5:h5pcreate('H5P_DATASET_CREATE'),
+	{ok, Type} = erlhdf5:h5tcopy('H5T_NATIVE_DOUBLE'),
+	{ok, DS} = erlhdf5:h5dcreate(File, "/latencies", Type, Space, Dcpl),
+
+	%% latencies from 1 to N, with a NaN one:
+	NaN = <<16#7FF8000000000000:64/native>>,
+	ok = erlhdf5:h5dwrite_binary(DS, 'H5T_NATIVE_DOUBLE',
+		<< <<(case X of N -> NaN; _ -> <<X:64/float-native>> end)/binary>>
+		   || X <- lists:seq(1, N) >>),
+
+	{ok, #{counts := [25000, 25000, 25000, 24999], below := 0, above := 0,
+		   nan_count := 1}} = erlhdf5:h5d_histogram(DS, 'H5S_ALL',
+			   {1, 100001, 4}),
+	{ok, #{counts := [5, 5], below := 10, above := N - 21}} =
+		erlhdf5:h5d_histogram(DS, 'H5S_ALL', {11.0, 20.0, 2}),
+	{error, _} = erlhdf5:h5d_histogram(DS, 'H5S_ALL', {1, 1, 4}),
+
+	{ok, Sketch} = erlhdf5:h5d_sketch(DS, 'H5S_ALL', 0.01),
+	{ok, [Min, P50, P99, Max]} = erlhdf5:sketch_quantiles(Sketch,
+		[0, 0.5, 0.99, 1]),
+	%% within 1%, the minimum being exact (quantiles are clamped to extremes):
+	1.0 = Min,
+	true = abs(P50 - 50000) =< 500 andalso abs(P99 - 98999) =< 990
+		andalso abs(Max - (N - 1)) =< 1000,
+
+	%% sketches of two halves, merged, match the sketch of the whole:
+	{ok, FileSpace} = erlhdf5:h5dget_space(DS),
+	ok = erlhdf5:h5sselect_hyperslab(FileSpace, 'H5S_SELECT_SET', 0, 1,
+		N div 2, 1),
+	{ok, Low} = erlhdf5:h5d_sketch(DS, FileSpace, 0.01),
+	ok = erlhdf5:h5sselect_hyperslab(FileSpace, 'H5S_SELECT_SET', N div 2, 1,
+		N div 2, 1),
+	{ok, High} = erlhdf5:h5d_sketch(DS, FileSpace, 0.01),
+	ok = erlhdf5:h5sclose(FileSpace),
+	{ok, Sketch} = erlhdf5:sketch_merge([Low, High]),
+
+	{ok, Coarse} = erlhdf5:h5d_sketch(DS, 'H5S_ALL', 0.05),
+	{error, _} = erlhdf5:sketch_merge([Sketch, Coarse]),
+	{error, _} = erlhdf5:sketch_quantiles(<<"not a sketch">>, [0.5]),
+	{error, _} = erlhdf5:sketch_quantiles(Sketch, [1.5]),
+
+	%% tampered sketches are rejected, be their counts not summing to their
+	%% total or their (positive) store running past the 32-bit keys:
+	<<Header:12/binary, Total:64, Rest/binary>> = Sketch,
+	{error, _} = erlhdf5:sketch_quantiles(
+		<<Header/binary, (Total + 1):64, Rest/binary>>, [0.5]),
+	<<Stores:60/binary, _Offset:32, Buckets/binary>> = Sketch,
+	{error, _} = erlhdf5:sketch_quantiles(
+		<<Stores/binary, 16#7FFFFFFF:32, Buckets/binary>>, [0.5]),
+
+	ok = erlhdf5:h5dclose(DS),
+	ok = erlhdf5:h5tclose(Type),
+	ok = erlhdf5:h5pclose(Dcpl),
+	ok = erlhdf5:h5sclose(Space),
+	ok = erlhdf5:h5fclose(File),
+	ok.
+
+
+h5_downsampling(_Config) ->
+	{ok, File} = erlhdf5:h5fcreate("hdf5_downsampling.h5", 'H5F_ACC_TRUNC'),
+	N = 100000,
+	{ok, Space} = erlhdf5:h5screate_simple(1, {N}),
+	{ok, Dcpl} = erlhdf5:h5pcreate('H5P_DATASET_CREATE'),
+	ok = erlhdf5:h5pset_chunk(Dcpl, 1, {4096}),
+	{ok, Type} = erlhdf5:h5tcopy('H5T_NATIVE_DOUBLE'),
+	{ok, DS} = erlhdf5:h5dcreate(File, "/series", Type, Space, Dcpl),
+
+	%% a flat series with a single spike:
+	ok = erlhdf5:h5dwrite_binary(DS, 'H5T_NATIVE_DOUBLE',
+		<< <<(case X of 54321 -> 1000.0; _ -> float(X rem 10) end):64/float-native>>
+		   || X <- lists:seq(0, N - 1) >>),
+
+	%% the spike survives min/max downsampling, points being in index order:
+	{ok, MinMax} = erlhdf5:h5d_read_downsampled(DS, all, 100, minmax),
+	200 = length(MinMax),
+	true = lists:member({54321, 1000.0}, MinMax),
+	Indexes = [I || {I, _} <- MinMax],
+	Indexes = lists:sort(Indexes),
+
+	%% means of buckets of 1000 cells, over a range:
+	{ok, Means} = erlhdf5:h5d_read_downsampled(DS, {10000, 20000}, 20, mean),
+	20 = length(Means),
+	{10499, 4.5} = hd(Means),
+
+	%% LTTB keeps the ends of the range, and the spike:
+	{ok, Lttb} = erlhdf5:h5d_read_downsampled(DS, {50000, 10000}, 50, lttb),
+	50 = length(Lttb),
+	{50000, 0.0} = hd(Lttb),
+	{59999, 9.0} = lists:last(Lttb),
+	true = lists:member({54321, 1000.0}, Lttb),
+
+	%% short ranges are returned as such:
+	{ok, [{5, 5.0}, {6, 6.0}]} = erlhdf5:h5d_read_downsampled(DS, {5, 2}, 10,
+		lttb),
+	{ok, []} = erlhdf5:h5d_read_downsampled(DS, {0, 0}, 10, mean),
+
+	{error, _} = erlhdf5:h5d_read_downsampled(DS, {N - 1, 2}, 10, mean),
+	{error, _} = erlhdf5:h5d_read_downsampled(DS, all, 2, lttb),
+	{error, _} = erlhdf5:h5d_read_downsampled(DS, all, 10, median),
+
+	ok = erlhdf5:h5dclose(DS),
+	ok = erlhdf5:h5tclose(Type),
+	ok = erlhdf5:h5pclose(Dcpl),
+	ok = erlhdf5:h5sclose(Space),
+	ok = erlhdf5:h5fclose(File),
+	ok.
+
+
+h5_scan(_Config) ->
+	{ok, File} = erlhdf5:h5fcreate("hdf5_scan.h5", 'H5F_ACC_TRUNC'),
+	N = 10000,
+	{ok, Space} = erlhdf5:h5screate_simple(1, {N}),
+	{ok, Dcpl} = erlhdf5:h5pcreate('H5P_DATASET_CREATE'),
+	ok = erlhdf5:h5pset_chunk(Dcpl, 1, {1024}),
+	{ok, Type} = erlhdf5:h5tcopy('H5T_NATIVE_DOUBLE'),
+	{ok, DS} = erlhdf5:h5dcreate(File, "/series", Type, Space, Dcpl),
+
+	%% a sawtooth of period 100, with a NaN and an infinity:
+	NaN = <<16#7FF8000000000000:64/native>>,
+	Inf = <<16#7FF0000000000000:64/native>>,
+	ok = erlhdf5:h5dwrite_binary(DS, 'H5T_NATIVE_DOUBLE',
+		<< <<(case X of
+				  7 -> NaN;
+				  8 -> Inf;
+				  _ -> <<(X rem 100):64/float-native>>
+			  end)/binary>> || X <- lists:seq(0, N - 1) >>),
+	Unpack = fun(Bin) -> [I || <<I:64/native>> <= Bin] end,
+
+	%% indexes, in increasing order, usable as coordinates:
+	{ok, High} = erlhdf5:h5d_scan(DS, all, {ge, 98}),
+	[98, 99, 198, 199 | _] = Unpack(High),
+	200 = length(Unpack(High)),
+	{ok, <<98.0:64/float-native, 99.0:64/float-native, _/binary>>} =
+		erlhdf5:h5dread_points(DS, High, 'H5T_NATIVE_DOUBLE'),
+
+	%% within a range, indexes stay absolute:
+	{ok, Mids} = erlhdf5:h5d_scan(DS, {1000, 200}, {between, 10, 12}),
+	[1010, 1011, 1012, 1110, 1111, 1112] = Unpack(Mids),
+
+	%% runs of consecutive matches:
+	{ok, Runs} = erlhdf5:h5d_scan(DS, {0, 300}, {lt, 5}, ranges),
+	[0, 5, 100, 5, 200, 5] = Unpack(Runs),
+	{ok, Bad} = erlhdf5:h5d_scan(DS, all, not_finite, ranges),
+	[7, 2] = Unpack(Bad),
+
+	%% NaN matches no comparison, not even 'ne':
+	{ok, <<7:64/native>>} = erlhdf5:h5d_scan(DS, all, is_nan),
+	{ok, NotZero} = erlhdf5:h5d_scan(DS, {0, 100}, {ne, 0}),
+	98 = length(Unpack(NotZero)),
+	{ok, <<>>} = erlhdf5:h5d_scan(DS, {0, 0}, is_inf),
+
+	{error, _} = erlhdf5:h5d_scan(DS, {N, 1}, is_nan),
+	{error, _} = erlhdf5:h5d_scan(DS, all, {between, 1}),
+	{error, _} = erlhdf5:h5d_scan(DS, all, {gt, 1}, bitmap),
+
+	ok = erlhdf5:h5dclose(DS),
+	ok = erlhdf5:h5tclose(Type),
+	ok = erlhdf5:h5pclose(Dcpl),
+	ok = erlhdf5:h5sclose(Space),
+	ok = erlhdf5:h5fclose(File),
+	ok.
+
+
+h5_zone_map(_Config) ->
+	{ok, File} = erlhdf5:h5fcreate("hdf5_zone_map.h5", 'H5F_ACC_TRUNC'),
+	{ok, Space} = erlhdf5:h5screate_simple(1, {3000}, {'H5S_UNLIMITED'}),
+	{ok, Dcpl} = erlhdf5:h5pcreate('H5P_DATASET_CREATE'),
+	ok = erlhdf5:h5pset_chunk(Dcpl, 1, {1000}),
+	{ok, Type} = erlhdf5:h5tcopy('H5T_NATIVE_DOUBLE'),
+	{ok, DS} = erlhdf5:h5dcreate(File, "/sensor", Type, Space, Dcpl),
+
+	%% a quiet sensor, with a single excursion in its second chunk:
+	ok = erlhdf5:h5dwrite_binary(DS, 'H5T_NATIVE_DOUBLE',
+		<< <<(case X of 1500 -> 80.0; _ -> 20.0 end):64/float-native>>
+		   || X <- lists:seq(0, 2999) >>),
+	{error, _} = erlhdf5:h5d_get_zone_map(DS),
+	{ok, Other} = erlhdf5:h5dopen(File, "/sensor"),
+	ok = erlhdf5:h5d_create_zone_map(DS),
+	{ok, [{20.0, 20.0, 1000}, {20.0, 80.0, 1000}, {20.0, 20.0, 1000}]} =
+		erlhdf5:h5d_get_zone_map(DS),
+	{ok, <<1500:64/native>>} = erlhdf5:h5d_scan(DS, all, {gt, 50}),
+
+	%% writes and appends keep the zones up to date, including through the
+	%% handles opened before the zone map was created:
+	{ok, FileSpace} = erlhdf5:h5dget_space(DS),
+	ok = erlhdf5:h5sselect_hyperslab(FileSpace, 'H5S_SELECT_SET', {1500}, {1},
+									 {1}, {1}),
+	ok = erlhdf5:h5dwrite(DS, FileSpace, [21.0]),
+	ok = erlhdf5:h5dappend(Other, [-5.0, 20.0]),
+	{ok, [{20.0, 20.0, 1000}, {20.0, 21.0, 1000}, {20.0, 20.0, 1000},
+		  {-5.0, 20.0, 2}]} = erlhdf5:h5d_get_zone_map(DS),
+
+	%% appended rows are folded into the summary of their (partial) zone:
+	ok = erlhdf5:h5dappend(DS, [35.5]),
+	{ok, [_, _, _, {-5.0, 35.5, 3}]} = erlhdf5:h5d_get_zone_map(DS),
+
+	%% scans skip the zones that cannot match, with the same results:
+	{ok, <<>>} = erlhdf5:h5d_scan(DS, all, {gt, 50}),
+	{ok, <<3000:64/native, 1:64/native>>} =
+		erlhdf5:h5d_scan(DS, {10, 2992}, {lt, 0}, ranges),
+	{ok, <<1500:64/native>>} = erlhdf5:h5d_scan(DS, all, {between, 20.5, 22}),
+
+	%% contiguous datasets have no zones:
+	{ok, FixedSpace} = erlhdf5:h5screate_simple(1, {10}),
+	{ok, FixedDcpl} = erlhdf5:h5pcreate('H5P_DATASET_CREATE'),
+	{ok, Contiguous} = erlhdf5:h5dcreate(File, "/contiguous", Type, FixedSpace,
+										 FixedDcpl),
+	{error, _} = erlhdf5:h5d_create_zone_map(Contiguous),
+
+	ok = erlhdf5:h5dclose(Contiguous),
+	ok = erlhdf5:h5pclose(FixedDcpl),
+	ok = erlhdf5:h5sclose(FixedSpace),
+	ok = erlhdf5:h5sclose(FileSpace),
+	ok = erlhdf5:h5dclose(Other),
+	ok = erlhdf5:h5dclose(DS),
+	ok = erlhdf5:h5tclose(Type),
+	ok = erlhdf5:h5pclose(Dcpl),
+	ok = erlhdf5:h5sclose(Space),
+	ok = erlhdf5:h5fclose(File),
+	ok.
+
+
+h5_list_decoding(_Config) ->
+	{ok, File} = erlhdf5:h5fcreate("hdf5_decoding.h5", 'H5F_ACC_TRUNC'),
+	{ok, Dcpl} = erlhdf5:h5pcreate('H5P_DATASET_CREATE'),
+	{ok, Type} = erlhdf5:h5tcopy('H5T_NATIVE_DOUBLE'),
+
+	%% many more cells than the initial decoding buffer holds:
+	Count = 100000,
+	{ok, Space} = erlhdf5:h5screate_simple(2, {Count, 2}),
+	{ok, DS} = erlhdf5:h5dcreate(File, "/pairs", Type, Space, Dcpl),
+	Pairs = [{float(X), X} || X <- lists:seq(1, Count)],
+	ok = erlhdf5:h5dwrite(DS, Pairs),
+	{ok, Cells} = erlhdf5:h5dread(DS, 'H5S_ALL', 'H5T_NATIVE_DOUBLE'),
+	Cells = lists:append([[float(X), float(X)] || X <- lists:seq(1, Count)]),
+
+	%% each element is checked, not only the first one:
+	Bad = fun(Pos, Elem) ->
+			  lists:sublist(Pairs, Pos - 1) ++ [Elem]
+				  ++ lists:nthtail(Pos, Pairs)
+		  end,
+	{error, _} = erlhdf5:h5dwrite(DS, Bad(Count, {1.0, 2.0, 3.0})),
+	{error, _} = erlhdf5:h5dwrite(DS, Bad(Count div 2, {1.0, foo})),
+	{error, _} = erlhdf5:h5dwrite(DS, Bad(2, 3.0)),
+	{error, _} = erlhdf5:h5dwrite(DS, Pairs ++ [{1.0, 2.0}]),
+	{error, _} = erlhdf5:h5dwrite(DS, [{1.0, 2.0} | {3.0, 4.0}]),
+	{error, _} = erlhdf5:h5dwrite(DS, [{}]),
+	{error, _} = erlhdf5:h5dwrite(DS, []),
+
+	ok = erlhdf5:h5dclose(DS),
+	ok = erlhdf5:h5sclose(Space),
+
+	%% bare cells, mixing integers, floats and non-finite atoms:
+	{ok, FlatSpace} = erlhdf5:h5screate_simple(1, {4}),
+	{ok, Flat} = erlhdf5:h5dcreate(File, "/flat", Type, FlatSpace, Dcpl),
+	ok = erlhdf5:h5dwrite(Flat, [1, 2.5, inf, nan]),
+	{ok, [1.0, 2.5, inf, nan]} =
+		erlhdf5:h5dread(Flat, 'H5S_ALL', 'H5T_NATIVE_DOUBLE'),
+	{error, _} = erlhdf5:h5dwrite(Flat, [1, 2.5, foo, 4]),
+
+	ok = erlhdf5:h5dclose(Flat),
+	ok = erlhdf5:h5sclose(FlatSpace),
+	ok = erlhdf5:h5tclose(Type),
+	ok = erlhdf5:h5pclose(Dcpl),
+	ok = erlhdf5:h5fclose(File),
+	ok.
+
+
+h5_compressed(_Config) ->
+	{ok, File} = erlhdf5:h5fcreate("hdf5_compressed.h5", 'H5F_ACC_TRUNC'),
+	Rows = 1000,
+	{ok, Space} = erlhdf5:h5screate_simple(2, {Rows, 3}),
+	{ok, Dcpl} = erlhdf5:h5pcreate('H5P_DATASET_CREATE'),
+	ok = erlhdf5:h5pset_chunk(Dcpl, 2, {100, 3}),
+	ok = erlhdf5:h5pset_shuffle(Dcpl),
+	ok = erlhdf5:h5pset_deflate(Dcpl, 6),
+	ok = erlhdf5:h5pset_fletcher32(Dcpl),
+	{error, _} = erlhdf5:h5pset_deflate(Dcpl, 10),
+	{error, _} = erlhdf5:h5pset_scaleoffset(Dcpl, 'H5Z_SO_NONE', 2),
+	{ok, Type} = erlhdf5:h5tcopy('H5T_NATIVE_DOUBLE'),
+	{ok, DS} = erlhdf5:h5dcreate(File, "/sensor", Type, Space, Dcpl),
+
+	%% mostly-repeating values:
+	Data = [ {20.5, 1.0, float(N rem 4)} || N <- lists:seq(1, Rows) ],
+	ok = erlhdf5:h5dwrite(DS, Data),
+
+	{ok, Size} = erlhdf5:h5d_get_storage_size(DS),
+	ct:log("compressed size: ~p bytes", [Size]),
+	true = Size < Rows * 3 * 8,
+
+	Expected = lists:append([ tuple_to_list(T) || T <- Data ]),
+	{ok, Expected} = erlhdf5:h5dread(DS, 'H5S_ALL', 'H5T_NATIVE_DOUBLE'),
+
+	%% filters without explicit chunking, then a default one is chosen:
+	{ok, Dcpl2} = erlhdf5:h5pcreate('H5P_DATASET_CREATE'),
+	ok = erlhdf5:h5pset_scaleoffset(Dcpl2, 'H5Z_SO_FLOAT_DSCALE', 2),
+	{ok, DS2} = erlhdf5:h5dcreate(File, "/sensor_lossy", Type, Space, Dcpl2),
+	ok = erlhdf5:h5dwrite(DS2, Data),
+
+	%% reopening with a larger chunk cache:
+	{ok, Dapl} = erlhdf5:h5pcreate('H5P_DATASET_ACCESS'),
+	ok = erlhdf5:h5pset_chunk_cache(Dapl, 12421, 16 * 1024 * 1024, 0.75),
+	{error, _} = erlhdf5:h5pset_chunk_cache(Dapl, 521, 1024, 2.0),
+	{error, _} = erlhdf5:h5dopen(File, "/sensor", Dcpl),
+	{ok, CachedDS} = erlhdf5:h5dopen(File, "/sensor", Dapl),
+	ok = erlhdf5:h5pclose(Dapl),
+	{ok, Expected} = erlhdf5:h5dread(CachedDS, 'H5S_ALL', 'H5T_NATIVE_DOUBLE'),
+	ok = erlhdf5:h5dclose(CachedDS),
+
+	ok = erlhdf5:h5dclose(DS2),
+	ok = erlhdf5:h5pclose(Dcpl2),
+	ok = erlhdf5:h5dclose(DS),
+	ok = erlhdf5:h5tclose(Type),
+	ok = erlhdf5:h5pclose(Dcpl),
+	ok = erlhdf5:h5sclose(Space),
+	ok = erlhdf5:h5fclose(File),
+	ok.
+
+
+h5_file_access(_Config) ->
+	FileName = "hdf5_paged.h5",
+
+	%% paged aggregation, with 4 KiB pages:
+	{ok, Fcpl} = erlhdf5:h5pcreate('H5P_FILE_CREATE'),
+	ok = erlhdf5:h5pset_file_space_strategy(Fcpl, 'H5F_FSPACE_STRATEGY_PAGE',
+											false, 1),
+	ok = erlhdf5:h5pset_file_space_page_size(Fcpl, 4096),
+
+	{ok, Fapl} = erlhdf5:h5pcreate('H5P_FILE_ACCESS'),
+	ok = erlhdf5:h5pset_alignment(Fapl, 4096, 4096),
+	ok = erlhdf5:h5pset_sieve_buf_size(Fapl, 256 * 1024),
+	ok = erlhdf5:h5pset_mdc_size(Fapl, 4 * 1024 * 1024, 1024 * 1024,
+								 32 * 1024 * 1024),
+	{error, _} = erlhdf5:h5pset_mdc_size(Fapl, 1, 1024, 2048),
+	ok = erlhdf5:h5pset_libver_bounds(Fapl, 'H5F_LIBVER_LATEST',
+									  'H5F_LIBVER_LATEST'),
+	ok = erlhdf5:h5pset_page_buffer_size(Fapl, 64 * 4096, 20, 20),
+
+	%% wrong property list classes are rejected:
+	{error, _} = erlhdf5:h5pset_alignment(Fcpl, 4096, 4096),
+	{error, _} = erlhdf5:h5fcreate(FileName, 'H5F_ACC_TRUNC', Fapl, Fcpl),
+
+	{ok, File} = erlhdf5:h5fcreate(FileName, 'H5F_ACC_TRUNC', Fcpl, Fapl),
+	{ok, Space} = erlhdf5:h5screate_simple(2, {4, 2}),
+	{ok, Dcpl} = erlhdf5:h5pcreate('H5P_DATASET_CREATE'),
+	{ok, Type} = erlhdf5:h5tcopy('H5T_NATIVE_INT'),
+	{ok, DS} = erlhdf5:h5dcreate(File, "/paged", Type, Space, Dcpl),
+	ok = erlhdf5:h5dwrite(DS, [{1, 2}, {3, 4}, {5, 6}, {7, 8}]),
+	ok = erlhdf5:h5dclose(DS),
+	ok = erlhdf5:h5fclose(File),
+
+	{ok, File2} = erlhdf5:h5fopen(FileName, 'H5F_ACC_RDONLY', Fapl),
+	{ok, [1, 2, 3, 4, 5, 6, 7, 8]} =
+		erlhdf5:h5lt_read_dataset_int(File2, "/paged"),
+	ok = erlhdf5:h5fclose(File2),
+
+	ok = erlhdf5:h5tclose(Type),
+	ok = erlhdf5:h5pclose(Dcpl),
+	ok = erlhdf5:h5sclose(Space),
+	ok = erlhdf5:h5pclose(Fapl),
+	ok = erlhdf5:h5pclose(Fcpl),
+	ok.
+
+
+h5_file_image(_Config) ->
+	FileName = "hdf5_in_memory.h5",
+
+	%% built in RAM only, with no backing store:
+	{ok, Fapl} = erlhdf5:h5pcreate('H5P_FILE_ACCESS'),
+	ok = erlhdf5:h5pset_fapl_core(Fapl, 64 * 1024, false),
+	{ok, File} = erlhdf5:h5fcreate(FileName, 'H5F_ACC_TRUNC', Fapl),
+	ok = erlhdf5:h5pclose(Fapl),
+
+	{ok, Space} = erlhdf5:h5screate_simple(2, {2, 2}),
+	{ok, Dcpl} = erlhdf5:h5pcreate('H5P_DATASET_CREATE'),
+	{ok, Type} = erlhdf5:h5tcopy('H5T_NATIVE_INT'),
+	{ok, DS} = erlhdf5:h5dcreate(File, "/image", Type, Space, Dcpl),
+	ok = erlhdf5:h5dwrite(DS, [{1, 2}, {3, 4}]),
+	ok = erlhdf5:h5dclose(DS),
+
+	{ok, Image} = erlhdf5:h5f_get_image(File),
+	ok = erlhdf5:h5fclose(File),
+	false = filelib:is_file(FileName),
+
+	{error, _} = erlhdf5:h5f_open_image(<<"not an HDF5 image">>),
+	{ok, ImageFile} = erlhdf5:h5f_open_image(Image),
+	{ok, [1, 2, 3, 4]} = erlhdf5:h5lt_read_dataset_int(ImageFile, "/image"),
+	ok = erlhdf5:h5fclose(ImageFile),
+
+	ok = erlhdf5:h5tclose(Type),
+	ok = erlhdf5:h5pclose(Dcpl),
+	ok = erlhdf5:h5sclose(Space),
+	ok.
+
+
+h5_swmr(_Config) ->
+	FileName = "hdf5_swmr.h5",
+	{ok, Fapl} = erlhdf5:h5pcreate('H5P_FILE_ACCESS'),
+	ok = erlhdf5:h5pset_libver_bounds(Fapl, 'H5F_LIBVER_LATEST',
+									  'H5F_LIBVER_LATEST'),
+
+	{ok, File} = erlhdf5:h5fcreate(FileName, 'H5F_ACC_TRUNC', Fapl),
+	{ok, Space} = erlhdf5:h5screate_simple(1, {0}, {'H5S_UNLIMITED'}),
+	{ok, Dcpl} = erlhdf5:h5pcreate('H5P_DATASET_CREATE'),
+	{ok, Type} = erlhdf5:h5tcopy('H5T_NATIVE_INT'),
+	{ok, DS} = erlhdf5:h5dcreate(File, "/log", Type, Space, Dcpl),
+	ok = erlhdf5:h5fstart_swmr_write(File),
+
+	%% a reader opens the file while the writer still has it open:
+	{ok, Reader} = erlhdf5:h5fopen(FileName,
+					  ['H5F_ACC_RDONLY', 'H5F_ACC_SWMR_READ'], Fapl),
+	{ok, ReaderDS} = erlhdf5:h5dopen(Reader, "/log"),
+	{ok, [0], _} = reader_extent(ReaderDS),
+
+	%% and sees, once refreshed, the rows appended and flushed since:
+	ok = erlhdf5:h5dappend(DS, [1, 2, 3]),
+	ok = erlhdf5:h5dflush(DS),
+	ok = erlhdf5:h5drefresh(ReaderDS),
+	{ok, [3], _} = reader_extent(ReaderDS),
+	{ok, [1, 2, 3]} = erlhdf5:h5dread(ReaderDS, 'H5S_ALL', 'H5T_NATIVE_INT'),
+
+	ok = erlhdf5:h5dappend(DS, [4]),
+	ok = erlhdf5:h5dflush(DS),
+	ok = erlhdf5:h5drefresh(ReaderDS),
+	{ok, [4], _} = reader_extent(ReaderDS),
+	{ok, [1, 2, 3, 4]} = erlhdf5:h5dread(ReaderDS, 'H5S_ALL', 'H5T_NATIVE_INT'),
+
+	ok = erlhdf5:h5dclose(ReaderDS),
+	ok = erlhdf5:h5fclose(Reader),
+	ok = erlhdf5:h5dclose(DS),
+	ok = erlhdf5:h5fclose(File),
+
+	{error, _} = erlhdf5:h5fopen(FileName, ['H5F_ACC_RDONLY', not_a_flag]),
+	{error, _} = erlhdf5:h5fopen(FileName,
+					  ['H5F_ACC_RDONLY' | 'H5F_ACC_SWMR_READ']),
+
+	ok = erlhdf5:h5tclose(Type),
+	ok = erlhdf5:h5pclose(Dcpl),
+	ok = erlhdf5:h5sclose(Space),
+	ok = erlhdf5:h5pclose(Fapl),
+	ok.
+
+
+%% Returns the current extent of specified dataset, as seen by this handle.
+reader_extent(DS) ->
+	{ok, Space} = erlhdf5:h5dget_space(DS),
+	Extent = erlhdf5:h5sget_simple_extent_dims(Space, 1),
+	ok = erlhdf5:h5sclose(Space),
+	Extent.
+
+
+%%--------------------------------------------------------------------
+%% @doc
+%% Handles are typed, cannot be used once closed, and are closed on garbage
+%% collection.
+%% @end
+%%--------------------------------------------------------------------
+h5_handles(_Config) ->
+	FileName = "hdf5_handles.h5",
+	{ok, File} = erlhdf5:h5fcreate(FileName, 'H5F_ACC_TRUNC'),
+	{ok, Space} = erlhdf5:h5screate_simple(1, {4}),
+
+	%% A handle of the wrong kind is rejected:
+	{error, _} = erlhdf5:h5sclose(File),
+	{error, _} = erlhdf5:h5dopen(Space, "/dset"),
+
+	%% Closing a predefined datatype has no effect:
+	{ok, NativeInt} = erlhdf5:datatype_name_to_handle('H5T_NATIVE_INT'),
+	ok = erlhdf5:h5tclose(NativeInt),
+	{ok, _Class} = erlhdf5:h5tget_class(NativeInt),
+
+	%% Objects left open by a crashed process are closed on garbage collection:
+	{Pid, MonitorRef} = spawn_monitor(fun() ->
+		{ok, Dcpl} = erlhdf5:h5pcreate('H5P_DATASET_CREATE'),
+		{ok, Type} = erlhdf5:h5tcopy('H5T_NATIVE_INT'),
+		{ok, DS} = erlhdf5:h5dcreate(File, "/dset", Type, Space, Dcpl),
+		ok = erlhdf5:h5dwrite(DS, [1, 2, 3, 4]),
+		exit(crashed)
+	end),
+	receive {'DOWN', MonitorRef, process, Pid, crashed} -> ok end,
+
+	{ok, DS} = erlhdf5:h5dopen(File, "/dset"),
+	{ok, [1, 2, 3, 4]} = erlhdf5:h5dread(DS, 'H5S_ALL', 'H5T_NATIVE_INT'),
+	ok = erlhdf5:h5dclose(DS),
+
+	%% A closed handle cannot be used anymore, nor closed again:
+	{error, _} = erlhdf5:h5dread(DS, 'H5S_ALL', 'H5T_NATIVE_INT'),
+	{error, _} = erlhdf5:h5dclose(DS),
+
+	ok = erlhdf5:h5sclose(Space),
+	ok = erlhdf5:h5fclose(File),
+
+	%% HDF5 keeps a file open as long as any of its objects is, and refuses to
+	%% truncate an open file: this succeeds only once the dataset left open by
+	%% the crashed process has really been closed.
+	ok = recreate_file(FileName, 100),
+	ok.
+
+
+%% Re-creates (truncates) specified file, retrying for a while, as handles are
+%% closed only once garbage-collected.
+recreate_file(FileName, Attempts) ->
+	case erlhdf5:h5fcreate(FileName, 'H5F_ACC_TRUNC') of
+		{ok, File} ->
+			erlhdf5:h5fclose(File);
+		{error, _} when Attempts > 1 ->
+			timer:sleep(10),
+			recreate_file(FileName, Attempts - 1);
+		Error ->
+			Error
+	end.